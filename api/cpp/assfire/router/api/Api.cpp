@@ -1,4 +1,5 @@
 #include "GeoPoint.hpp"
+#include "Isochrone.hpp"
 #include "Route.hpp"
 #include "RouteInfo.hpp"
 #include "RouteMatrix.hpp"
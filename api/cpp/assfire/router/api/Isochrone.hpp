@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+#include "GeoPoint.hpp"
+#include "RouteInfo.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief This class represents area reachable from origin within max travel time as a set of road network points
+     * with route summaries of reaching them from origin
+     */
+    class Isochrone
+    {
+    public:
+        struct Point
+        {
+            GeoPoint location;
+            RouteInfo route_info;
+
+            bool operator==(const Point &rhs) const = default;
+        };
+
+        using Points = std::vector<Point>;
+
+        Isochrone() = default;
+        Isochrone(const GeoPoint &origin, RouteInfo::Seconds max_travel_time_seconds) : _origin(origin),
+                                                                                       _max_travel_time_seconds(max_travel_time_seconds)
+        {
+        }
+
+        Isochrone(const GeoPoint &origin, RouteInfo::Seconds max_travel_time_seconds, Points &&points) : _origin(origin),
+                                                                                                        _max_travel_time_seconds(max_travel_time_seconds),
+                                                                                                        _points(std::move(points))
+        {
+        }
+
+        bool operator==(const Isochrone &rhs) const = default;
+        bool operator!=(const Isochrone &rhs) const = default;
+
+        const GeoPoint &origin() const
+        {
+            return _origin;
+        }
+
+        RouteInfo::Seconds max_travel_time_seconds() const
+        {
+            return _max_travel_time_seconds;
+        }
+
+        const Points &points() const
+        {
+            return _points;
+        }
+
+        void add_point(const GeoPoint &location, const RouteInfo &route_info)
+        {
+            _points.push_back(Point{location, route_info});
+        }
+
+    private:
+        GeoPoint _origin;
+        RouteInfo::Seconds _max_travel_time_seconds = 0;
+        Points _points;
+    };
+}
@@ -2,9 +2,12 @@
 
 #include "assfire/api/v1/router/router.pb.h"
 #include "assfire/router/api/GeoPoint.hpp"
+#include "assfire/router/api/Isochrone.hpp"
 #include "assfire/router/api/RouteInfo.hpp"
 #include "assfire/router/api/Route.hpp"
 
+#include <vector>
+
 namespace assfire::router
 {
     GeoPoint parse_geo_point(const assfire::api::v1::router::GeoPoint &gp)
@@ -12,6 +15,19 @@ namespace assfire::router
         return GeoPoint(gp.lat(), gp.lon());
     }
 
+    /**
+     * \brief Parses all points at once into a contiguous buffer. Buffer is cleared but keeps its capacity so it may be reused between calls
+     */
+    void parse_geo_points(const google::protobuf::RepeatedPtrField<assfire::api::v1::router::GeoPoint> &gps, std::vector<GeoPoint> &out_result)
+    {
+        out_result.clear();
+        out_result.reserve(gps.size());
+        for (const assfire::api::v1::router::GeoPoint &gp : gps)
+        {
+            out_result.emplace_back(gp.lat(), gp.lon());
+        }
+    }
+
     void to_proto(const GeoPoint &gp, assfire::api::v1::router::GeoPoint *out_result)
     {
         out_result->set_lat(gp.lat());
@@ -69,4 +85,15 @@ namespace assfire::router
         to_proto(r, &result);
         return result;
     }
+
+    void to_proto(const Isochrone &isochrone, assfire::api::v1::router::GetIsochroneResponse *out_result)
+    {
+        out_result->mutable_points()->Reserve(isochrone.points().size());
+        for (const Isochrone::Point &point : isochrone.points())
+        {
+            assfire::api::v1::router::IsochronePoint *out_point = out_result->add_points();
+            to_proto(point.location, out_point->mutable_location());
+            to_proto(point.route_info, out_point->mutable_route_info());
+        }
+    }
 }
\ No newline at end of file
@@ -1,17 +1,58 @@
 
 #include "BasicRoutingStrategyProvider.hpp"
 #include "algorithms/CrowflightRoutingStrategy.hpp"
+#include "algorithms/GraphRoutingStrategy.hpp"
 #include <stdexcept>
 
 namespace assfire::router
 {
     std::string BasicRoutingStrategyProvider::CROWFLIGHT = "Crowflight";
+    std::string BasicRoutingStrategyProvider::GRAPH = "Graph";
+    std::string BasicRoutingStrategyProvider::HUB_LABELS = "HubLabels";
 
-    BasicRoutingStrategyProvider::BasicRoutingStrategyProvider()
+    BasicRoutingStrategyProvider::BasicRoutingStrategyProvider() : BasicRoutingStrategyProvider(std::string())
+    {
+    }
+
+    BasicRoutingStrategyProvider::BasicRoutingStrategyProvider(const std::string &road_graph_path)
+        : BasicRoutingStrategyProvider(road_graph_path, std::string())
+    {
+    }
+
+    BasicRoutingStrategyProvider::BasicRoutingStrategyProvider(const std::string &road_graph_path, const std::string &hub_labels_path)
     {
         strategies.emplace(CROWFLIGHT, std::make_shared<CrowflightRoutingStrategy>());
 
         available_strategies.push_back(RoutingStrategyId(CROWFLIGHT));
+
+        if (!road_graph_path.empty())
+        {
+            std::shared_ptr<const RoadGraph> graph = std::make_shared<RoadGraph>(road_graph_path);
+            std::shared_ptr<const EdgeSpatialIndex> index = std::make_shared<EdgeSpatialIndex>(graph);
+            std::shared_ptr<CchMetricCache> hierarchy = CchTopology::is_present(*graph)
+                                                            ? std::make_shared<CchMetricCache>(std::make_shared<CchTopology>(graph))
+                                                            : nullptr;
+            std::shared_ptr<const HubLabels> labels = !hub_labels_path.empty() ? std::make_shared<HubLabels>(graph, hub_labels_path) : nullptr;
+            for (const std::string &metric : graph->get_metrics())
+            {
+                std::shared_ptr<GraphRoutingStrategy> strategy = std::make_shared<GraphRoutingStrategy>(
+                    graph, index, metric, GraphRoutingStrategy::DEFAULT_MAX_SNAPPING_DISTANCE_METERS, hierarchy,
+                    labels && labels->get_metric() == metric ? labels : nullptr);
+                strategy->customize(TransportProfile()); // Unlimited speed metrics are customized on start, others on first use
+                if (!strategies.contains(GRAPH))
+                {
+                    strategies.emplace(GRAPH, strategy);
+                    available_strategies.push_back(RoutingStrategyId(GRAPH));
+                }
+                strategies.emplace(GRAPH + "/" + metric, strategy);
+                available_strategies.push_back(RoutingStrategyId(GRAPH + "/" + metric));
+                if (labels && labels->get_metric() == metric)
+                {
+                    strategies.emplace(HUB_LABELS, strategy);
+                    available_strategies.push_back(RoutingStrategyId(HUB_LABELS));
+                }
+            }
+        }
     }
 
     std::shared_ptr<RoutingStrategy> BasicRoutingStrategyProvider::get_routing_strategy(const RoutingStrategyId &id) const
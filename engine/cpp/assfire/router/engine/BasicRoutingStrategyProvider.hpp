@@ -10,8 +10,27 @@ namespace assfire::router
     {
     public:
         static std::string CROWFLIGHT;
+        static std::string GRAPH;
+        static std::string HUB_LABELS;
 
         BasicRoutingStrategyProvider();
+
+        /**
+         * \brief Construct a new BasicRoutingStrategyProvider object additionally providing graph strategies over road graph file at specified path.
+         * Graph strategy for each metric of the graph is available as "Graph/<metric>", plain "Graph" refers to the first metric.
+         * If graph file contains contraction hierarchy topology, all graph strategies share it and its customized metrics
+         *
+         * \param road_graph_path Path to road graph file produced by graph builder tool. Graph strategies are not provided if path is empty
+         */
+        explicit BasicRoutingStrategyProvider(const std::string &road_graph_path);
+
+        /**
+         * \brief Construct a new BasicRoutingStrategyProvider object additionally using hub labels for the graph strategy of their metric.
+         * That strategy is also available as "HubLabels"
+         *
+         * \param hub_labels_path Path to hub labels file of the road graph. Labels are not used if path is empty
+         */
+        BasicRoutingStrategyProvider(const std::string &road_graph_path, const std::string &hub_labels_path);
         std::shared_ptr<RoutingStrategy> get_routing_strategy(const RoutingStrategyId &id) const override;
         const std::vector<RoutingStrategyId>& get_available_strategies() const override;
 
@@ -24,4 +24,13 @@ namespace assfire::router
     {
         return available_profiles;
     }
-}
\ No newline at end of file
+
+    void BasicTransportProfileProvider::add_transport_profile(const TransportProfileId &id, const TransportProfile &profile)
+    {
+        if (!transport_profiles.contains(id.value()))
+        {
+            available_profiles.push_back(id);
+        }
+        transport_profiles.insert_or_assign(id.value(), profile);
+    }
+}
@@ -12,6 +12,12 @@ namespace assfire::router
         TransportProfile get_transport_profile(const TransportProfileId &id) const override;
         const std::vector<TransportProfileId> &get_available_profiles() const override;
 
+        /**
+         * \brief Adds profile or replaces profile with the same id. Graph strategies customize their weights for new profiles on first use.
+         * Not thread-safe, so profiles should be added before provider is shared
+         */
+        void add_transport_profile(const TransportProfileId &id, const TransportProfile &profile);
+
     private:
         std::vector<TransportProfileId> available_profiles;
         std::unordered_map<std::string, TransportProfile> transport_profiles;
@@ -3,128 +3,299 @@
 namespace assfire::router
 {
     RouterEngine::RouterEngine(std::shared_ptr<RoutingStrategyProvider> routing_strategy_provider, std::shared_ptr<TransportProfileProvider> transport_profile_provider)
-        : routing_strategy_provider(routing_strategy_provider),
-          transport_profile_provider(transport_profile_provider)
+        : registry(std::make_shared<RoutingRegistry>(routing_strategy_provider, transport_profile_provider))
+    {
+    }
+
+    RouterEngine::RouterEngine(std::shared_ptr<RoutingRegistry> registry) : registry(registry)
     {
     }
 
     Route RouterEngine::calculate_route(const GeoPoint &origin, const GeoPoint &destination, const RoutingStrategyId &strategy) const
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_route(origin, destination, transport_profile_provider->get_transport_profile(TransportProfileId()));
+        RoutingRegistry::Resolution routing = registry->resolve(TransportProfileId(), strategy);
+        return routing.strategy().calculate_route(origin, destination, routing.profile());
     }
 
     Route RouterEngine::calculate_route(const GeoPoint &origin, const GeoPoint &destination, const TransportProfileId &profile, const RoutingStrategyId &strategy) const
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_route(origin, destination, transport_profile_provider->get_transport_profile(profile));
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        return routing.strategy().calculate_route(origin, destination, routing.profile());
     }
 
     RouteInfo RouterEngine::calculate_route_info(const GeoPoint &origin, const GeoPoint &destination, const RoutingStrategyId &strategy) const
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_route_info(origin, destination, transport_profile_provider->get_transport_profile(TransportProfileId()));
+        RoutingRegistry::Resolution routing = registry->resolve(TransportProfileId(), strategy);
+        return routing.strategy().calculate_route_info(origin, destination, routing.profile());
     }
 
     RouteInfo RouterEngine::calculate_route_info(const GeoPoint &origin, const GeoPoint &destination, const TransportProfileId &profile, const RoutingStrategyId &strategy) const
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_route_info(origin, destination, transport_profile_provider->get_transport_profile(profile));
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        return routing.strategy().calculate_route_info(origin, destination, routing.profile());
     }
 
     RouteInfo::Meters RouterEngine::calculate_distance_meters(const GeoPoint &origin, const GeoPoint &destination, const RoutingStrategyId &strategy) const
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_distance_meters(origin, destination, transport_profile_provider->get_transport_profile(TransportProfileId()));
+        RoutingRegistry::Resolution routing = registry->resolve(TransportProfileId(), strategy);
+        return routing.strategy().calculate_distance_meters(origin, destination, routing.profile());
     }
 
     RouteInfo::Meters RouterEngine::calculate_distance_meters(const GeoPoint &origin, const GeoPoint &destination, const TransportProfileId &profile, const RoutingStrategyId &strategy) const
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_distance_meters(origin, destination, transport_profile_provider->get_transport_profile(profile));
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        return routing.strategy().calculate_distance_meters(origin, destination, routing.profile());
     }
 
     RouteInfo::Seconds RouterEngine::calculate_travel_time_seconds(const GeoPoint &origin, const GeoPoint &destination, const RoutingStrategyId &strategy) const
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_travel_time_seconds(origin, destination, transport_profile_provider->get_transport_profile(TransportProfileId()));
+        RoutingRegistry::Resolution routing = registry->resolve(TransportProfileId(), strategy);
+        return routing.strategy().calculate_travel_time_seconds(origin, destination, routing.profile());
     }
 
     RouteInfo::Seconds RouterEngine::calculate_travel_time_seconds(const GeoPoint &origin, const GeoPoint &destination, const TransportProfileId &profile, const RoutingStrategyId &strategy) const
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_travel_time_seconds(origin, destination, transport_profile_provider->get_transport_profile(profile));
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        return routing.strategy().calculate_travel_time_seconds(origin, destination, routing.profile());
     }
 
     RouterEngine::MatrixPtr RouterEngine::calculate_route_matrix(const Waypoints &waypoints, const RoutingStrategyId &strategy) const
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_route_matrix(waypoints, transport_profile_provider->get_transport_profile(TransportProfileId()));
+        RoutingRegistry::Resolution routing = registry->resolve(TransportProfileId(), strategy);
+        return routing.strategy().calculate_route_matrix(waypoints, routing.profile());
     }
 
     RouterEngine::MatrixPtr RouterEngine::calculate_route_matrix(const Waypoints &waypoints, const TransportProfileId &profile, const RoutingStrategyId &strategy) const
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_route_matrix(waypoints, transport_profile_provider->get_transport_profile(profile));
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        return routing.strategy().calculate_route_matrix(waypoints, routing.profile());
     }
 
     RouterEngine::MatrixPtr RouterEngine::calculate_route_matrix(WaypointsSupplier waypoints, const RoutingStrategyId &strategy) const
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_route_matrix(waypoints, transport_profile_provider->get_transport_profile(TransportProfileId()));
+        RoutingRegistry::Resolution routing = registry->resolve(TransportProfileId(), strategy);
+        return routing.strategy().calculate_route_matrix(waypoints, routing.profile());
     }
 
     RouterEngine::MatrixPtr RouterEngine::calculate_route_matrix(WaypointsSupplier waypoints, const TransportProfileId &profile, const RoutingStrategyId &strategy) const
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_route_matrix(waypoints, transport_profile_provider->get_transport_profile(profile));
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        return routing.strategy().calculate_route_matrix(waypoints, routing.profile());
     }
 
     RouterEngine::MatrixPtr RouterEngine::calculate_route_matrix(const Waypoints &origins, const Waypoints &destinations, const RoutingStrategyId &strategy) const
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_route_matrix(origins, destinations, transport_profile_provider->get_transport_profile(TransportProfileId()));
+        RoutingRegistry::Resolution routing = registry->resolve(TransportProfileId(), strategy);
+        return routing.strategy().calculate_route_matrix(origins, destinations, routing.profile());
     }
 
     RouterEngine::MatrixPtr RouterEngine::calculate_route_matrix(const Waypoints &origins, const Waypoints &destinations, const TransportProfileId &profile, const RoutingStrategyId &strategy) const
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_route_matrix(origins, destinations, transport_profile_provider->get_transport_profile(profile));
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        return routing.strategy().calculate_route_matrix(origins, destinations, routing.profile());
     }
 
     RouterEngine::MatrixPtr RouterEngine::calculate_route_matrix(WaypointsSupplier origins, WaypointsSupplier destinations, const RoutingStrategyId &strategy) const
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_route_matrix(origins, destinations, transport_profile_provider->get_transport_profile(TransportProfileId()));
+        RoutingRegistry::Resolution routing = registry->resolve(TransportProfileId(), strategy);
+        return routing.strategy().calculate_route_matrix(origins, destinations, routing.profile());
     }
 
     RouterEngine::MatrixPtr RouterEngine::calculate_route_matrix(WaypointsSupplier origins, WaypointsSupplier destinations, const TransportProfileId &profile, const RoutingStrategyId &strategy) const
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_route_matrix(origins, destinations, transport_profile_provider->get_transport_profile(profile));
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        return routing.strategy().calculate_route_matrix(origins, destinations, routing.profile());
+    }
+
+    RouterEngine::MatrixPtr RouterEngine::calculate_route_matrix(WaypointsView origins, WaypointsView destinations, const TransportProfileId &profile, const RoutingStrategyId &strategy) const
+    {
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        return routing.strategy().calculate_route_matrix(origins, destinations, routing.profile());
+    }
+
+    RouterEngine::MatrixPtr RouterEngine::calculate_route_matrix(WaypointsView waypoints, const TransportProfileId &profile, const RoutingStrategyId &strategy) const
+    {
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        return routing.strategy().calculate_route_matrix(waypoints, routing.profile());
+    }
+
+    RouterEngine::LazyMatrixPtr RouterEngine::create_lazy_route_matrix(WaypointsView origins, WaypointsView destinations, const TransportProfileId &profile,
+                                                                       const RoutingStrategyId &strategy, bool prefetch_rows) const
+    {
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        return std::make_shared<LazyRouteMatrix>(origins, destinations, routing.strategy_ptr(), routing.profile(), prefetch_rows);
+    }
+
+    RouterEngine::MappedMatrixPtr RouterEngine::open_route_matrix(const std::string &path, bool preload) const
+    {
+        MappedMatrixPtr matrix = std::make_shared<MappedRouteMatrix>(path, preload);
+        RoutingRegistry::Resolution routing = registry->resolve(matrix->get_transport_profile_id(), matrix->get_strategy_id());
+        matrix->set_strategy(routing.strategy_ptr(), routing.profile());
+        return matrix;
+    }
+
+    RouterEngine::SparseMatrixPtr RouterEngine::calculate_sparse_route_matrix(WaypointsView waypoints, const SparseRouteMatrix::Bounds &bounds,
+                                                                               const TransportProfileId &profile, const RoutingStrategyId &strategy,
+                                                                               bool calculate_missing_routes) const
+    {
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        return SparseRouteMatrix::calculate_nearest(routing.strategy(), routing.profile(), waypoints, bounds,
+                                                    calculate_missing_routes ? routing.strategy_ptr() : nullptr);
+    }
+
+    RouterEngine::SparseMatrixPtr RouterEngine::calculate_bounded_route_matrix(WaypointsView origins, WaypointsView destinations,
+                                                                                RouteInfo::Seconds max_travel_time_seconds, const TransportProfileId &profile,
+                                                                                const RoutingStrategyId &strategy) const
+    {
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        return SparseRouteMatrix::calculate_bounded(routing.strategy(), routing.profile(), origins, destinations, max_travel_time_seconds);
+    }
+
+    std::vector<RouterEngine::MatrixPtr> RouterEngine::calculate_route_matrices(WaypointsView origins, WaypointsView destinations,
+                                                                              std::span<const TransportProfile::Timestamp> departure_times,
+                                                                              const TransportProfileId &profile, const RoutingStrategyId &strategy) const
+    {
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        return routing.strategy().calculate_route_matrices(origins, destinations, departure_times, routing.profile());
+    }
+
+    Route RouterEngine::calculate_route(const GeoPoint &origin, const GeoPoint &destination, const TransportProfileId &profile, const RoutingStrategyId &strategy,
+                                        std::optional<TransportProfile::Timestamp> departure_time, RouteInfo::Meters geometry_tolerance_meters) const
+    {
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        return routing.strategy().calculate_route(origin, destination, get_transport_profile(routing, departure_time, geometry_tolerance_meters));
+    }
+
+    RouteInfo RouterEngine::calculate_route_info(const GeoPoint &origin, const GeoPoint &destination, const TransportProfileId &profile, const RoutingStrategyId &strategy,
+                                                 std::optional<TransportProfile::Timestamp> departure_time) const
+    {
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        return routing.strategy().calculate_route_info(origin, destination, get_transport_profile(routing, departure_time));
+    }
+
+    void RouterEngine::calculate_routes_vector(const Waypoints &waypoints, std::function<void(Route)> consume_route, const TransportProfileId &profile,
+                                               const RoutingStrategyId &strategy, std::optional<TransportProfile::Timestamp> departure_time,
+                                               RouteInfo::Meters geometry_tolerance_meters)
+    {
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        routing.strategy().calculate_routes_vector(waypoints, consume_route, get_transport_profile(routing, departure_time, geometry_tolerance_meters));
+    }
+
+    void RouterEngine::calculate_route_infos_vector(const Waypoints &waypoints, std::function<void(RouteInfo)> consume_route_info, const TransportProfileId &profile,
+                                                    const RoutingStrategyId &strategy, std::optional<TransportProfile::Timestamp> departure_time)
+    {
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        routing.strategy().calculate_route_infos_vector(waypoints, consume_route_info, get_transport_profile(routing, departure_time));
     }
 
     std::vector<Route> RouterEngine::calculate_routes_vector(const Waypoints &waypoints, const RoutingStrategyId &strategy)
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_routes_vector(waypoints, transport_profile_provider->get_transport_profile(TransportProfileId()));
+        RoutingRegistry::Resolution routing = registry->resolve(TransportProfileId(), strategy);
+        return routing.strategy().calculate_routes_vector(waypoints, routing.profile());
     }
 
     std::vector<Route> RouterEngine::calculate_routes_vector(const Waypoints &waypoints, const TransportProfileId &profile, const RoutingStrategyId &strategy)
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_routes_vector(waypoints, transport_profile_provider->get_transport_profile(profile));
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        return routing.strategy().calculate_routes_vector(waypoints, routing.profile());
     }
 
     void RouterEngine::calculate_routes_vector(const Waypoints &waypoints, std::function<void(Route)> consume_route, const RoutingStrategyId &strategy)
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_routes_vector(waypoints, consume_route, transport_profile_provider->get_transport_profile(TransportProfileId()));
+        RoutingRegistry::Resolution routing = registry->resolve(TransportProfileId(), strategy);
+        return routing.strategy().calculate_routes_vector(waypoints, consume_route, routing.profile());
     }
 
     void RouterEngine::calculate_routes_vector(const Waypoints &waypoints, std::function<void(Route)> consume_route, const TransportProfileId &profile, const RoutingStrategyId &strategy)
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_routes_vector(waypoints, consume_route, transport_profile_provider->get_transport_profile(profile));
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        return routing.strategy().calculate_routes_vector(waypoints, consume_route, routing.profile());
     }
 
     std::vector<RouteInfo> RouterEngine::calculate_route_infos_vector(const Waypoints &waypoints, const RoutingStrategyId &strategy)
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_route_infos_vector(waypoints, transport_profile_provider->get_transport_profile(TransportProfileId()));
+        RoutingRegistry::Resolution routing = registry->resolve(TransportProfileId(), strategy);
+        return routing.strategy().calculate_route_infos_vector(waypoints, routing.profile());
     }
 
     std::vector<RouteInfo> RouterEngine::calculate_route_infos_vector(const Waypoints &waypoints, const TransportProfileId &profile, const RoutingStrategyId &strategy)
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_route_infos_vector(waypoints, transport_profile_provider->get_transport_profile(profile));
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        return routing.strategy().calculate_route_infos_vector(waypoints, routing.profile());
     }
 
     void RouterEngine::calculate_route_infos_vector(const Waypoints &waypoints, std::function<void(RouteInfo)> consume_route_info, const RoutingStrategyId &strategy)
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_route_infos_vector(waypoints, consume_route_info, transport_profile_provider->get_transport_profile(TransportProfileId()));
+        RoutingRegistry::Resolution routing = registry->resolve(TransportProfileId(), strategy);
+        return routing.strategy().calculate_route_infos_vector(waypoints, consume_route_info, routing.profile());
     }
 
     void RouterEngine::calculate_route_infos_vector(const Waypoints &waypoints, std::function<void(RouteInfo)> consume_route_info, const TransportProfileId &profile, const RoutingStrategyId &strategy)
     {
-        return routing_strategy_provider->get_routing_strategy(strategy)->calculate_route_infos_vector(waypoints, consume_route_info, transport_profile_provider->get_transport_profile(profile));
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        return routing.strategy().calculate_route_infos_vector(waypoints, consume_route_info, routing.profile());
+    }
+
+    RouteInfo RouterEngine::calculate_routes_vector_total(WaypointsView waypoints, const TransportProfileId &profile, const RoutingStrategyId &strategy,
+                                                          std::optional<TransportProfile::Timestamp> departure_time) const
+    {
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        return routing.strategy().calculate_routes_vector_total(waypoints, get_transport_profile(routing, departure_time));
+    }
+
+    std::vector<RouteInfo> RouterEngine::evaluate_tours(WaypointsView waypoints, std::span<const RouteMatrix::GeopointId> tours,
+                                                        std::span<const std::uint32_t> tour_sizes, const TransportProfileId &profile,
+                                                        const RoutingStrategyId &strategy) const
+    {
+        MatrixPtr matrix = calculate_route_matrix(waypoints, profile, strategy);
+        return RouteMatrixPlanes(*matrix, waypoints.size()).evaluate_tours(tours, tour_sizes);
+    }
+
+    std::vector<RouteMatrixPlanes::Insertion> RouterEngine::find_best_insertions(WaypointsView waypoints, std::span<const RouteMatrix::GeopointId> stops,
+                                                                                 std::span<const RouteMatrix::GeopointId> routes,
+                                                                                 std::span<const std::uint32_t> route_sizes, const TransportProfileId &profile,
+                                                                                 const RoutingStrategyId &strategy) const
+    {
+        MatrixPtr matrix = calculate_route_matrix(waypoints, profile, strategy);
+        return RouteMatrixPlanes(*matrix, waypoints.size()).find_best_insertions(stops, routes, route_sizes);
+    }
+
+    Isochrone RouterEngine::calculate_isochrone(const GeoPoint &origin, RouteInfo::Seconds max_travel_time_seconds, const TransportProfileId &profile,
+                                                const RoutingStrategyId &strategy) const
+    {
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        return routing.strategy().calculate_isochrone(origin, max_travel_time_seconds, routing.profile());
+    }
+
+    RouterEngine::ExtendableMatrixPtr RouterEngine::calculate_extendable_route_matrix(const Waypoints &waypoints, const RoutingStrategyId &strategy) const
+    {
+        return calculate_extendable_route_matrix(waypoints, TransportProfileId(), strategy);
+    }
+
+    RouterEngine::ExtendableMatrixPtr RouterEngine::calculate_extendable_route_matrix(const Waypoints &waypoints, const TransportProfileId &profile, const RoutingStrategyId &strategy) const
+    {
+        RoutingRegistry::Resolution routing = registry->resolve(profile, strategy);
+        ExtendableMatrixPtr result = std::make_shared<ExtendableRouteMatrix>(routing.strategy_ptr(), routing.profile());
+        result->extend(waypoints);
+        return result;
+    }
+
+    RouterEngine::GeopointIds RouterEngine::extend_route_matrix(ExtendableRouteMatrix &existing, const Waypoints &new_points) const
+    {
+        return existing.extend(new_points);
+    }
+
+    void RouterEngine::remove_from_route_matrix(ExtendableRouteMatrix &existing, const GeopointIds &ids) const
+    {
+        existing.remove(ids);
+    }
+
+    TransportProfile RouterEngine::get_transport_profile(const RoutingRegistry::Resolution &routing, std::optional<TransportProfile::Timestamp> departure_time,
+                                                         RouteInfo::Meters geometry_tolerance_meters)
+    {
+        TransportProfile result = routing.profile();
+        result.set_departure_time(departure_time);
+        result.set_geometry_tolerance_meters(geometry_tolerance_meters);
+        return result;
     }
 }
\ No newline at end of file
@@ -1,17 +1,48 @@
 #pragma once
 
 #include <memory>
+#include <optional>
+#include <span>
+#include <vector>
 #include "assfire/router/api/RoutesProvider.hpp"
-#include "RoutingStrategyProvider.hpp"
-#include "TransportProfileProvider.hpp"
+#include "RoutingRegistry.hpp"
+#include "assfire/router/engine/matrix/ExtendableRouteMatrix.hpp"
+#include "assfire/router/engine/matrix/LazyRouteMatrix.hpp"
+#include "assfire/router/engine/matrix/MappedRouteMatrix.hpp"
+#include "assfire/router/engine/matrix/RouteMatrixPlanes.hpp"
+#include "assfire/router/engine/matrix/SparseRouteMatrix.hpp"
 
 namespace assfire::router
 {
     class RouterEngine : public RoutesProvider
     {
     public:
+        using ExtendableMatrixPtr = std::shared_ptr<ExtendableRouteMatrix>;
+        using GeopointIds = ExtendableRouteMatrix::GeopointIds;
+        using WaypointsView = RoutingStrategy::WaypointsView;
+        using SparseMatrixPtr = std::shared_ptr<SparseRouteMatrix>;
+        using LazyMatrixPtr = std::shared_ptr<LazyRouteMatrix>;
+        using MappedMatrixPtr = std::shared_ptr<MappedRouteMatrix>;
+
+        /**
+         * \brief Construct a new RouterEngine object. Strategies and profiles of providers are interned into routing registry, so each call
+         * resolves its ids once and shares strategy and profile instead of copying them
+         */
         RouterEngine(std::shared_ptr <RoutingStrategyProvider> routingStrategyProvider, std::shared_ptr <TransportProfileProvider> transportProfileProvider);
 
+        /**
+         * \brief Construct a new RouterEngine object over registry that may be shared, e.g. with a service that reloads it
+         */
+        explicit RouterEngine(std::shared_ptr<RoutingRegistry> registry);
+
+        /**
+         * \brief Registry that resolves strategy and profile ids. Profiles updated and providers reloaded in it are used by calls started after the update
+         */
+        const std::shared_ptr<RoutingRegistry> &get_registry() const
+        {
+            return registry;
+        }
+
         virtual Route calculate_route(const GeoPoint &origin, const GeoPoint &destination, const RoutingStrategyId &strategy = RoutingStrategyId()) const override;
         virtual Route calculate_route(const GeoPoint &origin, const GeoPoint &destination, const TransportProfileId &profile = TransportProfileId(), const RoutingStrategyId &strategy = RoutingStrategyId()) const override;
 
@@ -48,8 +79,207 @@ namespace assfire::router
         virtual void calculate_route_infos_vector(const Waypoints &waypoints, std::function<void(RouteInfo)> consume_route_info, const RoutingStrategyId &strategy = RoutingStrategyId()) override;
         virtual void calculate_route_infos_vector(const Waypoints &waypoints, std::function<void(RouteInfo)> consume_route_info, const TransportProfileId &profile = TransportProfileId(), const RoutingStrategyId &strategy = RoutingStrategyId()) override;
 
+        /**
+         * \brief Calculates route matrix between origins and destinations passed as views, e.g. over parts of a bigger already parsed buffer, so no waypoints are copied
+         *
+         * \param origins Origin waypoints
+         * \param destinations Destination waypoints
+         * \param profile Id of transport profile to use for routing
+         * \param strategy Id of routing strategy to use for routing
+         *
+         * \return Route matrix between origins and destinations
+         */
+        MatrixPtr calculate_route_matrix(WaypointsView origins, WaypointsView destinations, const TransportProfileId &profile, const RoutingStrategyId &strategy) const;
+
+        /**
+         * \brief Calculates route matrix between all pairs of waypoints, so symmetric strategies only calculate its upper triangle
+         *
+         * \param waypoints Origins and destinations
+         * \param profile Id of transport profile to use for routing
+         * \param strategy Id of routing strategy to use for routing
+         *
+         * \return Square route matrix between waypoints
+         */
+        MatrixPtr calculate_route_matrix(WaypointsView waypoints, const TransportProfileId &profile, const RoutingStrategyId &strategy) const;
+
+        /**
+         * \brief Creates route matrix between origins and destinations that calculates routes on first access, e.g. for solvers that only read
+         * routes between nearby waypoints. Strategy and profile are resolved once and kept by the matrix (see LazyRouteMatrix)
+         *
+         * \param origins Origin waypoints
+         * \param destinations Destination waypoints
+         * \param profile Id of transport profile to use for routing
+         * \param strategy Id of routing strategy to use for routing
+         * \param prefetch_rows If set, rest of each accessed row is calculated in background
+         *
+         * \return Lazy route matrix
+         */
+        LazyMatrixPtr create_lazy_route_matrix(WaypointsView origins, WaypointsView destinations, const TransportProfileId &profile,
+                                               const RoutingStrategyId &strategy, bool prefetch_rows = false) const;
+
+        /**
+         * \brief Opens route matrix file written by MappedRouteMatrix::write. Routes between not indexed locations are calculated by strategy
+         * and profile the matrix was written with, resolved by their ids stored in the file
+         *
+         * \param path Path to the file
+         * \param preload If true, the whole file is read into page cache in background instead of on first access
+         *
+         * \return Memory mapped route matrix
+         */
+        MappedMatrixPtr open_route_matrix(const std::string &path, bool preload = false) const;
+
+        /**
+         * \brief Calculates sparse route matrix keeping only routes from each waypoint to its nearest waypoints by travel time, e.g. for problems
+         * too big for dense matrices. Candidates are prefiltered by crowflight bounds over a spatial grid if strategy allows (see SparseRouteMatrix::calculate_nearest)
+         *
+         * \param waypoints Waypoints of matrix
+         * \param bounds Count of nearest waypoints and max travel time of kept routes
+         * \param profile Id of transport profile to use for routing
+         * \param strategy Id of routing strategy to use for routing
+         * \param calculate_missing_routes If set, routes that are not kept are calculated by the strategy on access, otherwise they are infinite
+         *
+         * \return Sparse route matrix
+         */
+        SparseMatrixPtr calculate_sparse_route_matrix(WaypointsView waypoints, const SparseRouteMatrix::Bounds &bounds, const TransportProfileId &profile,
+                                                      const RoutingStrategyId &strategy, bool calculate_missing_routes = false) const;
+
+        /**
+         * \brief Calculates route matrix between origins and destinations where routes taking longer than max travel time are infinite. Routes that
+         * can't be fast enough by crowflight bound are not calculated if strategy allows (see SparseRouteMatrix::calculate_bounded)
+         *
+         * \param origins Origin waypoints
+         * \param destinations Destination waypoints
+         * \param max_travel_time_seconds Max travel time of calculated routes
+         * \param profile Id of transport profile to use for routing
+         * \param strategy Id of routing strategy to use for routing
+         *
+         * \return Bounded route matrix
+         */
+        SparseMatrixPtr calculate_bounded_route_matrix(WaypointsView origins, WaypointsView destinations, RouteInfo::Seconds max_travel_time_seconds,
+                                                       const TransportProfileId &profile, const RoutingStrategyId &strategy) const;
+
+        /**
+         * \brief Calculates stack of route matrices between the same origins and destinations, one for each departure time, sharing work between them
+         *
+         * \param origins Origin waypoints
+         * \param destinations Destination waypoints
+         * \param departure_times Departure times of matrices, seconds since Unix epoch
+         * \param profile Id of transport profile to use for routing
+         * \param strategy Id of routing strategy to use for routing
+         *
+         * \return Route matrix for each departure time in the same order
+         */
+        std::vector<MatrixPtr> calculate_route_matrices(WaypointsView origins, WaypointsView destinations, std::span<const TransportProfile::Timestamp> departure_times,
+                                                        const TransportProfileId &profile, const RoutingStrategyId &strategy) const;
+
+        /**
+         * \brief Departure-aware versions of single route and routes vector calculations. Strategies with time-dependent travel times route vehicle
+         * departing at specified time, legs of routes vectors depart when previous legs arrive. Empty departure time means time-independent routing.
+         * Waypoints of routes are simplified to geometry tolerance if it is positive (see TransportProfile::geometry_tolerance_meters)
+         */
+        Route calculate_route(const GeoPoint &origin, const GeoPoint &destination, const TransportProfileId &profile, const RoutingStrategyId &strategy,
+                              std::optional<TransportProfile::Timestamp> departure_time, RouteInfo::Meters geometry_tolerance_meters = 0) const;
+        RouteInfo calculate_route_info(const GeoPoint &origin, const GeoPoint &destination, const TransportProfileId &profile, const RoutingStrategyId &strategy,
+                                       std::optional<TransportProfile::Timestamp> departure_time) const;
+        void calculate_routes_vector(const Waypoints &waypoints, std::function<void(Route)> consume_route, const TransportProfileId &profile,
+                                     const RoutingStrategyId &strategy, std::optional<TransportProfile::Timestamp> departure_time,
+                                     RouteInfo::Meters geometry_tolerance_meters = 0);
+        void calculate_route_infos_vector(const Waypoints &waypoints, std::function<void(RouteInfo)> consume_route_info, const TransportProfileId &profile,
+                                          const RoutingStrategyId &strategy, std::optional<TransportProfile::Timestamp> departure_time);
+
+        /**
+         * \brief Calculates total distance and travel time of routes vector without calculating route infos of its legs, e.g. to evaluate candidate tours.
+         * Total of a tour with an unreachable leg is infinite (see RouteTotal)
+         *
+         * \param waypoints Tour waypoints, legs go between consecutive ones
+         * \param profile Id of transport profile to use for routing
+         * \param strategy Id of routing strategy to use for routing
+         * \param departure_time Departure time of the first leg, the rest depart when previous ones arrive. Empty means time-independent routing
+         *
+         * \return Total of tour legs
+         */
+        RouteInfo calculate_routes_vector_total(WaypointsView waypoints, const TransportProfileId &profile, const RoutingStrategyId &strategy,
+                                                std::optional<TransportProfile::Timestamp> departure_time = std::nullopt) const;
+
+        /**
+         * \brief Evaluates batch of candidate tours over the same waypoints, e.g. proposed by local search. Route matrix of waypoints is calculated
+         * once and tour legs are summed over its compact copy (see RouteMatrixPlanes)
+         *
+         * \param waypoints Waypoints tours go through
+         * \param tours Indices of waypoints of all tours stored one after another
+         * \param tour_sizes Count of indices of each tour
+         * \param profile Id of transport profile to use for routing
+         * \param strategy Id of routing strategy to use for routing
+         *
+         * \return Total of each tour in the same order
+         */
+        std::vector<RouteInfo> evaluate_tours(WaypointsView waypoints, std::span<const RouteMatrix::GeopointId> tours, std::span<const std::uint32_t> tour_sizes,
+                                              const TransportProfileId &profile, const RoutingStrategyId &strategy) const;
+
+        /**
+         * \brief Finds cheapest insertion of each candidate stop into each route over the same waypoints, e.g. for insertion heuristics. Route matrix
+         * of waypoints is calculated once and insertion deltas are evaluated over its compact copy (see RouteMatrixPlanes::find_best_insertions)
+         *
+         * \param waypoints Waypoints stops and routes refer to
+         * \param stops Indices of waypoints to insert
+         * \param routes Indices of waypoints of all routes stored one after another
+         * \param route_sizes Count of indices of each route
+         * \param profile Id of transport profile to use for routing
+         * \param strategy Id of routing strategy to use for routing
+         *
+         * \return Cheapest insertion for each pair of stop and route, by stop then by route
+         */
+        std::vector<RouteMatrixPlanes::Insertion> find_best_insertions(WaypointsView waypoints, std::span<const RouteMatrix::GeopointId> stops,
+                                                                       std::span<const RouteMatrix::GeopointId> routes, std::span<const std::uint32_t> route_sizes,
+                                                                       const TransportProfileId &profile, const RoutingStrategyId &strategy) const;
+
+        /**
+         * \brief Calculates points reachable from origin within max travel time, e.g. to find customers a depot can serve
+         *
+         * \param origin Origin point
+         * \param max_travel_time_seconds Max travel time to reachable points
+         * \param profile Id of transport profile to use for routing
+         * \param strategy Id of routing strategy to use for routing. Throws std::invalid_argument if strategy doesn't support isochrones
+         *
+         * \return Isochrone of origin
+         */
+        Isochrone calculate_isochrone(const GeoPoint &origin, RouteInfo::Seconds max_travel_time_seconds, const TransportProfileId &profile = TransportProfileId(),
+                                      const RoutingStrategyId &strategy = RoutingStrategyId()) const;
+
+        /**
+         * \brief Calculates route matrix for specified waypoints that can be extended with new waypoints or reduced later without full recalculation
+         *
+         * \param waypoints Initial waypoints. They get ids from 0 to waypoints.size() - 1
+         * \param profile Id of transport profile to use for routing
+         * \param strategy Id of routing strategy to use for routing
+         *
+         * \return Extendable route matrix
+         */
+        ExtendableMatrixPtr calculate_extendable_route_matrix(const Waypoints &waypoints, const RoutingStrategyId &strategy = RoutingStrategyId()) const;
+        ExtendableMatrixPtr calculate_extendable_route_matrix(const Waypoints &waypoints, const TransportProfileId &profile = TransportProfileId(), const RoutingStrategyId &strategy = RoutingStrategyId()) const;
+
+        /**
+         * \brief Adds waypoints to existing matrix calculating only new rows and columns
+         *
+         * \param existing Matrix previously created with calculate_extendable_route_matrix()
+         * \param new_points Waypoints to add
+         *
+         * \return Ids assigned to the added waypoints
+         */
+        GeopointIds extend_route_matrix(ExtendableRouteMatrix &existing, const Waypoints &new_points) const;
+
+        /**
+         * \brief Removes waypoints from existing matrix. Storage of removed waypoints is reused by later extensions and is periodically compacted
+         *
+         * \param existing Matrix previously created with calculate_extendable_route_matrix()
+         * \param ids Ids of waypoints to remove
+         */
+        void remove_from_route_matrix(ExtendableRouteMatrix &existing, const GeopointIds &ids) const;
+
     private:
-        std::shared_ptr<RoutingStrategyProvider> routing_strategy_provider;
-        std::shared_ptr<TransportProfileProvider> transport_profile_provider;
+        static TransportProfile get_transport_profile(const RoutingRegistry::Resolution &routing, std::optional<TransportProfile::Timestamp> departure_time,
+                                                      RouteInfo::Meters geometry_tolerance_meters = 0);
+
+        std::shared_ptr<RoutingRegistry> registry;
     };
 }
\ No newline at end of file
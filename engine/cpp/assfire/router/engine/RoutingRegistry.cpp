@@ -0,0 +1,290 @@
+#include "RoutingRegistry.hpp"
+
+#include <stdexcept>
+
+namespace assfire::router
+{
+    namespace
+    {
+        struct CachedSnapshot
+        {
+            std::uint64_t registry_id = 0;
+            std::uint64_t generation = 0;
+            std::shared_ptr<const RoutingRegistry::Snapshot> snapshot;
+        };
+
+        std::atomic<std::uint64_t> next_registry_id = 1;
+        thread_local CachedSnapshot cached_snapshot;
+    }
+
+    RoutingRegistry::RoutingRegistry(std::shared_ptr<RoutingStrategyProvider> routing_strategy_provider,
+                                     std::shared_ptr<TransportProfileProvider> transport_profile_provider)
+        : routing_strategy_provider(routing_strategy_provider),
+          transport_profile_provider(transport_profile_provider),
+          instance_id(next_registry_id.fetch_add(1, std::memory_order_relaxed))
+    {
+        std::shared_ptr<Snapshot> initial = std::make_shared<Snapshot>();
+        resolve_strategies(*initial, nullptr, *routing_strategy_provider);
+        resolve_profiles(*initial, nullptr, *transport_profile_provider);
+        snapshot = std::move(initial);
+    }
+
+    std::shared_ptr<const RoutingRegistry::Snapshot> RoutingRegistry::get_snapshot() const
+    {
+        CachedSnapshot &cached = cached_snapshot;
+        if (cached.registry_id != instance_id || cached.generation != generation.load(std::memory_order_acquire))
+        {
+            std::lock_guard<std::mutex> lock(update_mutex);
+            cached.registry_id = instance_id;
+            cached.generation = generation.load(std::memory_order_relaxed);
+            // Copies of cached snapshot share control block of this thread that owns a single reference to the published snapshot
+            cached.snapshot = std::shared_ptr<const Snapshot>(std::make_shared<std::shared_ptr<const Snapshot>>(snapshot), snapshot.get());
+        }
+        return cached.snapshot;
+    }
+
+    void RoutingRegistry::publish(std::shared_ptr<const Snapshot> updated)
+    {
+        snapshot = std::move(updated);
+        generation.fetch_add(1, std::memory_order_release);
+    }
+
+    RoutingRegistry::Handle RoutingRegistry::get_strategy_handle(const RoutingStrategyId &id)
+    {
+        if (id.value().empty())
+        {
+            return DEFAULT_HANDLE;
+        }
+        std::shared_ptr<const Snapshot> current = get_snapshot();
+        auto iter = current->strategy_handles.find(id.value());
+        return iter != current->strategy_handles.end() && current->strategies[iter->second] ? iter->second : intern_strategy(id);
+    }
+
+    RoutingRegistry::Handle RoutingRegistry::get_profile_handle(const TransportProfileId &id)
+    {
+        if (id.value().empty())
+        {
+            return DEFAULT_HANDLE;
+        }
+        std::shared_ptr<const Snapshot> current = get_snapshot();
+        auto iter = current->profile_handles.find(id.value());
+        return iter != current->profile_handles.end() && current->profiles[iter->second] ? iter->second : intern_profile(id);
+    }
+
+    RoutingRegistry::Resolution RoutingRegistry::resolve(const TransportProfileId &profile, const RoutingStrategyId &strategy)
+    {
+        std::shared_ptr<const Snapshot> current = get_snapshot();
+        Handle profile_handle = DEFAULT_HANDLE;
+        Handle strategy_handle = DEFAULT_HANDLE;
+        bool interned = false;
+        if (!profile.value().empty())
+        {
+            auto iter = current->profile_handles.find(profile.value());
+            if (iter != current->profile_handles.end() && current->profiles[iter->second])
+            {
+                profile_handle = iter->second;
+            }
+            else
+            {
+                profile_handle = intern_profile(profile);
+                interned = true;
+            }
+        }
+        if (!strategy.value().empty())
+        {
+            auto iter = current->strategy_handles.find(strategy.value());
+            if (iter != current->strategy_handles.end() && current->strategies[iter->second])
+            {
+                strategy_handle = iter->second;
+            }
+            else
+            {
+                strategy_handle = intern_strategy(strategy);
+                interned = true;
+            }
+        }
+        if (interned)
+        {
+            return resolve(profile_handle, strategy_handle); // Interned ids are only present in newer snapshot
+        }
+        return Resolution(std::move(current), profile_handle, strategy_handle);
+    }
+
+    RoutingRegistry::Resolution RoutingRegistry::resolve(Handle profile, Handle strategy) const
+    {
+        std::shared_ptr<const Snapshot> current = get_snapshot();
+        if (profile >= current->profiles.size() || strategy >= current->strategies.size() || !current->profiles[profile] || !current->strategies[strategy])
+        {
+            throw std::out_of_range("Unknown routing registry handle");
+        }
+        return Resolution(std::move(current), profile, strategy);
+    }
+
+    void RoutingRegistry::set_transport_profile(const TransportProfileId &id, const TransportProfile &profile)
+    {
+        std::lock_guard<std::mutex> lock(update_mutex);
+        std::shared_ptr<Snapshot> updated = std::make_shared<Snapshot>(*snapshot);
+        std::shared_ptr<const TransportProfile> value = std::make_shared<const TransportProfile>(profile);
+        if (id.value().empty())
+        {
+            updated->profiles[DEFAULT_HANDLE] = value;
+        }
+        else if (auto iter = updated->profile_handles.find(id.value()); iter != updated->profile_handles.end())
+        {
+            if (!updated->profiles[iter->second])
+            {
+                updated->available_profiles.push_back(id);
+            }
+            updated->profiles[iter->second] = value;
+        }
+        else
+        {
+            updated->profile_handles.emplace(id.value(), updated->profiles.size());
+            updated->profiles.push_back(value);
+            updated->available_profiles.push_back(id);
+        }
+        publish(std::move(updated));
+    }
+
+    void RoutingRegistry::reload(std::shared_ptr<RoutingStrategyProvider> new_routing_strategy_provider,
+                                 std::shared_ptr<TransportProfileProvider> new_transport_profile_provider)
+    {
+        std::lock_guard<std::mutex> lock(update_mutex);
+        const std::shared_ptr<const Snapshot> &current = snapshot;
+        std::shared_ptr<Snapshot> updated = std::make_shared<Snapshot>(*current);
+        // New snapshot is resolved completely before it is published, so a failed reload changes nothing
+        if (new_routing_strategy_provider)
+        {
+            resolve_strategies(*updated, current.get(), *new_routing_strategy_provider);
+        }
+        if (new_transport_profile_provider)
+        {
+            resolve_profiles(*updated, current.get(), *new_transport_profile_provider);
+        }
+        ++updated->version;
+
+        if (new_routing_strategy_provider)
+        {
+            routing_strategy_provider = std::move(new_routing_strategy_provider);
+        }
+        if (new_transport_profile_provider)
+        {
+            transport_profile_provider = std::move(new_transport_profile_provider);
+        }
+        publish(std::move(updated));
+    }
+
+    void RoutingRegistry::resolve_strategies(Snapshot &snapshot, const Snapshot *previous, RoutingStrategyProvider &provider)
+    {
+        snapshot.strategies.assign(previous ? previous->strategies.size() : 1, nullptr);
+        snapshot.strategy_handles.clear();
+        snapshot.strategies[DEFAULT_HANDLE] = provider.get_routing_strategy(RoutingStrategyId());
+        if (previous)
+        {
+            for (const auto &[id, handle] : previous->strategy_handles)
+            {
+                snapshot.strategy_handles.emplace(id, handle); // Ids not supported anymore keep their handles in case they are supported again
+                try
+                {
+                    snapshot.strategies[handle] = provider.get_routing_strategy(RoutingStrategyId(id));
+                }
+                catch (const std::invalid_argument &)
+                {
+                }
+            }
+        }
+        snapshot.available_strategies = provider.get_available_strategies();
+        for (const RoutingStrategyId &id : snapshot.available_strategies)
+        {
+            auto [iter, inserted] = snapshot.strategy_handles.emplace(id.value(), snapshot.strategies.size());
+            if (inserted)
+            {
+                snapshot.strategies.push_back(provider.get_routing_strategy(id));
+            }
+            else if (!snapshot.strategies[iter->second])
+            {
+                snapshot.strategies[iter->second] = provider.get_routing_strategy(id);
+            }
+        }
+    }
+
+    void RoutingRegistry::resolve_profiles(Snapshot &snapshot, const Snapshot *previous, TransportProfileProvider &provider)
+    {
+        snapshot.profiles.assign(previous ? previous->profiles.size() : 1, nullptr);
+        snapshot.profile_handles.clear();
+        snapshot.profiles[DEFAULT_HANDLE] = std::make_shared<const TransportProfile>(provider.get_transport_profile(TransportProfileId()));
+        if (previous)
+        {
+            for (const auto &[id, handle] : previous->profile_handles)
+            {
+                snapshot.profile_handles.emplace(id, handle);
+                try
+                {
+                    snapshot.profiles[handle] = std::make_shared<const TransportProfile>(provider.get_transport_profile(TransportProfileId(id)));
+                }
+                catch (const std::invalid_argument &)
+                {
+                }
+            }
+        }
+        snapshot.available_profiles = provider.get_available_profiles();
+        for (const TransportProfileId &id : snapshot.available_profiles)
+        {
+            auto [iter, inserted] = snapshot.profile_handles.emplace(id.value(), snapshot.profiles.size());
+            if (inserted)
+            {
+                snapshot.profiles.push_back(std::make_shared<const TransportProfile>(provider.get_transport_profile(id)));
+            }
+            else if (!snapshot.profiles[iter->second])
+            {
+                snapshot.profiles[iter->second] = std::make_shared<const TransportProfile>(provider.get_transport_profile(id));
+            }
+        }
+    }
+
+    RoutingRegistry::Handle RoutingRegistry::intern_strategy(const RoutingStrategyId &id)
+    {
+        std::lock_guard<std::mutex> lock(update_mutex);
+        const std::shared_ptr<const Snapshot> &current = snapshot;
+        auto iter = current->strategy_handles.find(id.value());
+        if (iter != current->strategy_handles.end() && current->strategies[iter->second])
+        {
+            return iter->second; // Interned by concurrent writer
+        }
+        std::shared_ptr<RoutingStrategy> strategy = routing_strategy_provider->get_routing_strategy(id);
+
+        std::shared_ptr<Snapshot> updated = std::make_shared<Snapshot>(*current);
+        Handle result = iter != current->strategy_handles.end() ? iter->second : updated->strategies.size();
+        if (result == updated->strategies.size())
+        {
+            updated->strategy_handles.emplace(id.value(), result);
+            updated->strategies.push_back(nullptr);
+        }
+        updated->strategies[result] = std::move(strategy);
+        publish(std::move(updated));
+        return result;
+    }
+
+    RoutingRegistry::Handle RoutingRegistry::intern_profile(const TransportProfileId &id)
+    {
+        std::lock_guard<std::mutex> lock(update_mutex);
+        const std::shared_ptr<const Snapshot> &current = snapshot;
+        auto iter = current->profile_handles.find(id.value());
+        if (iter != current->profile_handles.end() && current->profiles[iter->second])
+        {
+            return iter->second;
+        }
+        std::shared_ptr<const TransportProfile> profile = std::make_shared<const TransportProfile>(transport_profile_provider->get_transport_profile(id));
+
+        std::shared_ptr<Snapshot> updated = std::make_shared<Snapshot>(*current);
+        Handle result = iter != current->profile_handles.end() ? iter->second : updated->profiles.size();
+        if (result == updated->profiles.size())
+        {
+            updated->profile_handles.emplace(id.value(), result);
+            updated->profiles.push_back(nullptr);
+        }
+        updated->profiles[result] = std::move(profile);
+        publish(std::move(updated));
+        return result;
+    }
+}
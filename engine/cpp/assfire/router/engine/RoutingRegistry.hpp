@@ -0,0 +1,152 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "RoutingStrategyProvider.hpp"
+#include "TransportProfileProvider.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief Routing strategies and transport profiles of providers interned by dense integer handles, so a request resolves its string ids once
+     * and then uses strategy and profile shared by all requests instead of looking them up and copying the profile on every call.
+     *
+     * \details Interned strategies and profiles form an immutable snapshot published with read-copy-update: writers copy it, change the copy
+     * and publish it by incrementing an atomic generation counter. Each thread caches the snapshot it last loaded together with its generation,
+     * so readers only load the counter and reuse their own copy while nothing is published, without taking locks or touching reference counters
+     * shared with other threads. Thread revalidates its cached snapshot under writer mutex once after each publish, and keeps the previous
+     * snapshot alive until then. Requests keep the snapshot they resolved ids from until they finish. Ids unknown to the snapshot are resolved by providers once and interned. Handle of an id never changes,
+     * so handles stay valid across updates. Empty ids have DEFAULT_HANDLE and are resolved without hashing.
+     *
+     * Providers may be replaced while requests are served (see reload), e.g. to load new graph weights: strategies and profiles are resolved
+     * from new providers into a new snapshot, which is published at once. Strategies that new provider shares with the old one keep their
+     * warm caches. Registry is thread-safe
+     */
+    class RoutingRegistry
+    {
+    public:
+        using Handle = std::uint32_t;
+
+        static constexpr Handle DEFAULT_HANDLE = 0;
+
+        struct Snapshot
+        {
+            std::vector<std::shared_ptr<RoutingStrategy>> strategies;      // By strategy handle, null for ids removed by reload
+            std::vector<std::shared_ptr<const TransportProfile>> profiles; // By profile handle, null for ids removed by reload
+            std::unordered_map<std::string, Handle> strategy_handles;
+            std::unordered_map<std::string, Handle> profile_handles;
+            std::vector<RoutingStrategyId> available_strategies;
+            std::vector<TransportProfileId> available_profiles;
+            std::uint64_t version = 0; // Incremented by each reload
+        };
+
+        /**
+         * \brief Strategy and profile resolved for a request. Keeps the snapshot they belong to alive
+         */
+        class Resolution
+        {
+        public:
+            Resolution(std::shared_ptr<const Snapshot> snapshot, Handle profile_handle, Handle strategy_handle)
+                : snapshot(std::move(snapshot)), profile_handle(profile_handle), strategy_handle(strategy_handle)
+            {
+            }
+
+            RoutingStrategy &strategy() const
+            {
+                return *snapshot->strategies[strategy_handle];
+            }
+
+            const std::shared_ptr<RoutingStrategy> &strategy_ptr() const
+            {
+                return snapshot->strategies[strategy_handle];
+            }
+
+            const TransportProfile &profile() const
+            {
+                return *snapshot->profiles[profile_handle];
+            }
+
+            Handle get_profile_handle() const
+            {
+                return profile_handle;
+            }
+
+            Handle get_strategy_handle() const
+            {
+                return strategy_handle;
+            }
+
+        private:
+            std::shared_ptr<const Snapshot> snapshot;
+            Handle profile_handle;
+            Handle strategy_handle;
+        };
+
+        /**
+         * \brief Construct a new RoutingRegistry object interning all available ids of providers
+         */
+        RoutingRegistry(std::shared_ptr<RoutingStrategyProvider> routing_strategy_provider, std::shared_ptr<TransportProfileProvider> transport_profile_provider);
+
+        /**
+         * \brief Returns handle of strategy id, interning the id if it is new. Throws whatever provider throws for unsupported ids
+         */
+        Handle get_strategy_handle(const RoutingStrategyId &id);
+
+        /**
+         * \brief Returns handle of profile id, interning the id if it is new. Throws whatever provider throws for unsupported ids
+         */
+        Handle get_profile_handle(const TransportProfileId &id);
+
+        /**
+         * \brief Resolves ids of a request. Known ids are resolved with a single snapshot load and a lookup per non-empty id
+         */
+        Resolution resolve(const TransportProfileId &profile, const RoutingStrategyId &strategy);
+
+        /**
+         * \brief Resolves handles previously returned by registry. Throws std::out_of_range if handle is unknown or its id was removed by reload
+         */
+        Resolution resolve(Handle profile, Handle strategy) const;
+
+        /**
+         * \brief Adds profile or replaces profile with the same id while requests are served. Requests that already resolved the profile
+         * finish with its previous version. Strategies customize their weights for new profiles on first use
+         */
+        void set_transport_profile(const TransportProfileId &id, const TransportProfile &profile);
+
+        /**
+         * \brief Replaces providers and publishes snapshot resolved from them. Interned ids keep their handles, ids new providers don't support
+         * (throw std::invalid_argument for) are removed. If new providers throw anything else, registry keeps its current snapshot and providers.
+         * Requests that already resolved ids finish with strategies and profiles of the previous snapshot
+         *
+         * \param routing_strategy_provider New strategy provider. If null, current provider and interned strategies are kept
+         * \param transport_profile_provider New profile provider. If null, current provider and interned profiles, including ones set
+         * with set_transport_profile, are kept
+         */
+        void reload(std::shared_ptr<RoutingStrategyProvider> routing_strategy_provider, std::shared_ptr<TransportProfileProvider> transport_profile_provider);
+
+        /**
+         * \brief Returns current snapshot. Snapshot is shared with other calls of the same thread, so only the first call after publish takes a lock
+         */
+        std::shared_ptr<const Snapshot> get_snapshot() const;
+
+    private:
+        static void resolve_strategies(Snapshot &snapshot, const Snapshot *previous, RoutingStrategyProvider &provider);
+        static void resolve_profiles(Snapshot &snapshot, const Snapshot *previous, TransportProfileProvider &provider);
+
+        Handle intern_strategy(const RoutingStrategyId &id);
+        Handle intern_profile(const TransportProfileId &id);
+        void publish(std::shared_ptr<const Snapshot> updated); // Requires update_mutex
+
+        std::shared_ptr<RoutingStrategyProvider> routing_strategy_provider;
+        std::shared_ptr<TransportProfileProvider> transport_profile_provider;
+        std::uint64_t instance_id; // Distinguishes registries in thread caches, unlike addresses it is never reused
+        mutable std::mutex update_mutex; // Serializes writers and revalidation of thread caches
+        std::shared_ptr<const Snapshot> snapshot; // Guarded by update_mutex
+        std::atomic<std::uint64_t> generation = 0; // Incremented by each publish
+    };
+}
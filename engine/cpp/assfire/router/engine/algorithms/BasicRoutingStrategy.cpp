@@ -1,8 +1,126 @@
 #include "BasicRoutingStrategy.hpp"
+#include "assfire/router/engine/common/ParallelWorkers.hpp"
+#include "assfire/router/engine/common/RouteTotal.hpp"
 #include "assfire/router/engine/matrix/ImmutableRouteMatrix.hpp"
+#include "assfire/router/engine/matrix/TriangularRouteMatrix.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
 
 namespace assfire::router
 {
+    namespace
+    {
+        void advance_departure_time(TransportProfile &profile, RouteInfo::Seconds travel_time_seconds)
+        {
+            if (profile.departure_time() && travel_time_seconds < RouteInfo::INFINITE_TRAVEL_TIME)
+            {
+                profile.set_departure_time(*profile.departure_time() + travel_time_seconds);
+            }
+        }
+
+        /**
+         * Calculates legs on workers and moves them to consumer on the calling thread in order, each as soon as it and all previous legs are ready.
+         * Workers take legs in order, so calculated legs wait for delivery only while earlier legs are still calculated. The calling thread
+         * calculates legs too while the next one to consume isn't ready
+         */
+        template <typename Leg, typename Calculate, typename Consume>
+        void calculate_legs_in_parallel(std::size_t legs_count, std::size_t workers_count, const Calculate &calculate, const Consume &consume)
+        {
+            std::vector<std::optional<Leg>> legs(legs_count);
+            std::atomic<std::size_t> next_leg = 0;
+            std::atomic<bool> stopped = false;
+            std::mutex mutex;
+            std::condition_variable leg_ready;
+            std::exception_ptr error;
+
+            auto calculate_next_leg = [&]()
+            {
+                std::size_t i = next_leg++;
+                if (i >= legs_count || stopped)
+                {
+                    return false;
+                }
+                try
+                {
+                    Leg leg = calculate(i);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    legs[i].emplace(std::move(leg));
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error)
+                    {
+                        error = std::current_exception();
+                    }
+                    stopped = true;
+                }
+                leg_ready.notify_one();
+                return true;
+            };
+
+            auto is_ready = [&](std::size_t i)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                return legs[i] || error;
+            };
+
+            auto consume_legs = [&]()
+            {
+                try
+                {
+                    for (std::size_t i = 0; i < legs_count; ++i)
+                    {
+                        // Calculate legs while the next one isn't ready, then wait for workers that took the remaining ones
+                        while (!is_ready(i) && calculate_next_leg())
+                        {
+                        }
+                        std::optional<Leg> leg;
+                        {
+                            std::unique_lock<std::mutex> lock(mutex);
+                            leg_ready.wait(lock, [&]()
+                                           { return legs[i] || error; });
+                            if (!legs[i])
+                            {
+                                return;
+                            }
+                            leg.swap(legs[i]);
+                        }
+                        consume(std::move(*leg));
+                    }
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    error = std::current_exception(); // Consumer error wins, worker errors are only reported before it
+                    stopped = true;
+                }
+            };
+
+            ParallelWorkers::run(workers_count, [&](std::size_t worker_index)
+                                 {
+                                     if (worker_index == 0)
+                                     {
+                                         consume_legs();
+                                         return;
+                                     }
+                                     while (calculate_next_leg())
+                                     {
+                                     }
+                                 });
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
     RouteInfo::Meters BasicRoutingStrategy::calculate_distance_meters(const GeoPoint &origin, const GeoPoint &destination, const TransportProfile &profile) const
     {
         return calculate_route_info(origin, destination, profile).distance_meters();
@@ -13,8 +131,18 @@ namespace assfire::router
         return calculate_route_info(origin, destination, profile).travel_time_seconds();
     }
 
-    RoutingStrategy::MatrixPtr BasicRoutingStrategy::calculate_route_matrix(const Waypoints &waypoints, const TransportProfile &profile) const
+    RoutingStrategy::MatrixPtr BasicRoutingStrategy::calculate_route_matrix(WaypointsView waypoints, const TransportProfile &profile) const
     {
+        if (is_symmetric())
+        {
+            return std::make_shared<TriangularRouteMatrix>(
+                waypoints.size(),
+                [&](auto origin, auto destination)
+                {
+                    return calculate_route_info(waypoints[origin], waypoints[destination], profile);
+                },
+                clone(), profile);
+        }
         return calculate_route_matrix(waypoints, waypoints, profile);
     }
 
@@ -25,10 +153,10 @@ namespace assfire::router
         {
             waypoints_vector.push_back(*waypoint);
         }
-        return calculate_route_matrix(waypoints_vector, waypoints_vector, profile);
+        return calculate_route_matrix(waypoints_vector, profile);
     }
 
-    RoutingStrategy::MatrixPtr BasicRoutingStrategy::calculate_route_matrix(const Waypoints &origins, const Waypoints &destinations, const TransportProfile &profile) const
+    RoutingStrategy::MatrixPtr BasicRoutingStrategy::calculate_route_matrix(WaypointsView origins, WaypointsView destinations, const TransportProfile &profile) const
     {
         return std::make_shared<ImmutableRouteMatrix>(
             origins.size(), destinations.size(),
@@ -54,40 +182,133 @@ namespace assfire::router
         return calculate_route_matrix(origins_vector, destinations_vector, profile);
     }
 
-    std::vector<Route> BasicRoutingStrategy::calculate_routes_vector(const Waypoints &waypoints, const TransportProfile &profile)
+    std::vector<Route> BasicRoutingStrategy::calculate_routes_vector(WaypointsView waypoints, const TransportProfile &profile)
     {
         std::vector<Route> result;
         calculate_routes_vector(
-            waypoints, [&](auto route)
-            { result.emplace_back(route); },
+            waypoints, [&](Route route)
+            { result.push_back(std::move(route)); },
             profile);
         return result;
     }
 
-    void BasicRoutingStrategy::calculate_routes_vector(const Waypoints &waypoints, std::function<void(Route)> consume_route, const TransportProfile &profile)
+    void BasicRoutingStrategy::calculate_routes_vector(WaypointsView waypoints, std::function<void(Route)> consume_route, const TransportProfile &profile)
     {
-        for (int i = 0; i < waypoints.size() - 1; ++i)
+        if (std::size_t threads_count = get_legs_threads_count(waypoints, profile); threads_count > 1)
+        {
+            calculate_legs_in_parallel<Route>(
+                waypoints.size() - 1, threads_count, [&](std::size_t i)
+                { return calculate_route(waypoints[i], waypoints[i + 1], profile); },
+                consume_route);
+            return;
+        }
+
+        TransportProfile leg_profile = profile;
+        for (std::size_t i = 0; i + 1 < waypoints.size(); ++i)
         {
-            consume_route(calculate_route(waypoints[i], waypoints[i + 1], profile));
+            Route route = calculate_route(waypoints[i], waypoints[i + 1], leg_profile);
+            advance_departure_time(leg_profile, route.travel_time_seconds());
+            consume_route(std::move(route));
         }
     }
     
-    std::vector<RouteInfo> BasicRoutingStrategy::calculate_route_infos_vector(const Waypoints &waypoints, const TransportProfile &profile)
+    std::vector<RouteInfo> BasicRoutingStrategy::calculate_route_infos_vector(WaypointsView waypoints, const TransportProfile &profile)
     {
         std::vector<RouteInfo> result;
         calculate_route_infos_vector(
-            waypoints, [&](auto route)
-            { result.emplace_back(route); },
+            waypoints, [&](RouteInfo route_info)
+            { result.push_back(route_info); },
             profile);
         return result;
     }
     
-    void BasicRoutingStrategy::calculate_route_infos_vector(const Waypoints &waypoints, std::function<void(RouteInfo)> consume_route_info, const TransportProfile &profile)
+    void BasicRoutingStrategy::calculate_route_infos_vector(WaypointsView waypoints, std::function<void(RouteInfo)> consume_route_info, const TransportProfile &profile)
+    {
+        if (std::size_t threads_count = get_legs_threads_count(waypoints, profile); threads_count > 1)
+        {
+            calculate_legs_in_parallel<RouteInfo>(
+                waypoints.size() - 1, threads_count, [&](std::size_t i)
+                { return calculate_route_info(waypoints[i], waypoints[i + 1], profile); },
+                consume_route_info);
+            return;
+        }
+
+        TransportProfile leg_profile = profile;
+        for (std::size_t i = 0; i + 1 < waypoints.size(); ++i)
+        {
+            RouteInfo route_info = calculate_route_info(waypoints[i], waypoints[i + 1], leg_profile);
+            advance_departure_time(leg_profile, route_info.travel_time_seconds());
+            consume_route_info(route_info);
+        }
+    }
+
+    RouteInfo BasicRoutingStrategy::calculate_routes_vector_total(WaypointsView waypoints, const TransportProfile &profile) const
+    {
+        std::size_t legs_count = waypoints.size() < 2 ? 0 : waypoints.size() - 1;
+        if (std::size_t threads_count = get_legs_threads_count(waypoints, profile); threads_count > 1)
+        {
+            // Each worker sums legs it takes, partial sums are added when all legs are done
+            std::vector<RouteTotal> totals(threads_count);
+            std::atomic<std::size_t> next_leg = 0;
+            ParallelWorkers::run(threads_count, [&](std::size_t t)
+                                 {
+                                     try
+                                     {
+                                         for (std::size_t i = next_leg++; i < legs_count; i = next_leg++)
+                                         {
+                                             totals[t].add(calculate_route_info(waypoints[i], waypoints[i + 1], profile));
+                                         }
+                                     }
+                                     catch (...)
+                                     {
+                                         next_leg = legs_count;
+                                         throw;
+                                     }
+                                 });
+            RouteTotal result;
+            for (const RouteTotal &total : totals)
+            {
+                result.add(total);
+            }
+            return result.get();
+        }
+
+        RouteTotal result;
+        TransportProfile leg_profile = profile;
+        for (std::size_t i = 0; i < legs_count; ++i)
+        {
+            RouteInfo route_info = calculate_route_info(waypoints[i], waypoints[i + 1], leg_profile);
+            advance_departure_time(leg_profile, route_info.travel_time_seconds());
+            result.add(route_info);
+        }
+        return result.get();
+    }
+
+    std::size_t BasicRoutingStrategy::get_legs_threads_count(WaypointsView waypoints, const TransportProfile &profile) const
+    {
+        if (!has_costly_legs() || profile.departure_time() || waypoints.size() < 2)
+        {
+            return 1; // Legs of time-dependent vectors depend on arrival times of previous ones
+        }
+        return std::min<std::size_t>(ParallelWorkers::get_max_workers_count(), (waypoints.size() - 1) / MIN_PARALLEL_LEGS_PER_THREAD);
+    }
+
+    std::vector<RoutingStrategy::MatrixPtr> BasicRoutingStrategy::calculate_route_matrices(WaypointsView origins, WaypointsView destinations,
+                                                                                         std::span<const TransportProfile::Timestamp> departure_times,
+                                                                                         const TransportProfile &profile) const
     {
-        for (int i = 0; i < waypoints.size() - 1; ++i)
+        std::vector<MatrixPtr> result;
+        TransportProfile slice_profile = profile;
+        for (TransportProfile::Timestamp departure_time : departure_times)
         {
-            consume_route_info(calculate_route_info(waypoints[i], waypoints[i + 1], profile));
+            slice_profile.set_departure_time(departure_time);
+            result.push_back(calculate_route_matrix(origins, destinations, slice_profile));
         }
+        return result;
     }
 
+    Isochrone BasicRoutingStrategy::calculate_isochrone(const GeoPoint &, RouteInfo::Seconds, const TransportProfile &) const
+    {
+        throw std::invalid_argument("Routing strategy doesn't support isochrones");
+    }
 }
\ No newline at end of file
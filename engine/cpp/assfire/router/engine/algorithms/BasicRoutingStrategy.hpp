@@ -7,22 +7,49 @@ namespace assfire::router
     /**
      * \brief This class implements common methods for basic routing strategies only able to calculate single routes (like crowflight, euclidean etc.)
      *
+     * \details If transport profile has departure time, each leg of routes vector departs when the previous one arrives.
+     * Otherwise legs of long routes vectors of strategies with costly legs are calculated on several threads and delivered in order
      */
     class BasicRoutingStrategy : public RoutingStrategy
     {
     public:
+        static constexpr std::size_t MIN_PARALLEL_LEGS_PER_THREAD = 8;
+
         virtual RouteInfo::Meters calculate_distance_meters(const GeoPoint &origin, const GeoPoint &destination, const TransportProfile &profile) const override;
         virtual RouteInfo::Seconds calculate_travel_time_seconds(const GeoPoint &origin, const GeoPoint &destination, const TransportProfile &profile) const override;
-        virtual MatrixPtr calculate_route_matrix(const Waypoints &waypoints, const TransportProfile &profile) const override;
+        virtual MatrixPtr calculate_route_matrix(WaypointsView waypoints, const TransportProfile &profile) const override;
         virtual MatrixPtr calculate_route_matrix(WaypointsSupplier waypoints, const TransportProfile &profile) const override;
-        virtual MatrixPtr calculate_route_matrix(const Waypoints &origins, const Waypoints &destinations, const TransportProfile &profile) const override;
+        virtual MatrixPtr calculate_route_matrix(WaypointsView origins, WaypointsView destinations, const TransportProfile &profile) const override;
         virtual MatrixPtr calculate_route_matrix(WaypointsSupplier origins, WaypointsSupplier destinations, const TransportProfile &profile) const override;
-        virtual std::vector<Route> calculate_routes_vector(const Waypoints &waypoints, const TransportProfile &profile) override;
-        virtual void calculate_routes_vector(const Waypoints &waypoints, std::function<void(Route)> consume_route, const TransportProfile &profile) override;
-        virtual std::vector<RouteInfo> calculate_route_infos_vector(const Waypoints &waypoints, const TransportProfile &profile) override;
-        virtual void calculate_route_infos_vector(const Waypoints &waypoints, std::function<void(RouteInfo)> consume_route_info, const TransportProfile &profile) override;
+        virtual std::vector<Route> calculate_routes_vector(WaypointsView waypoints, const TransportProfile &profile) override;
+        virtual void calculate_routes_vector(WaypointsView waypoints, std::function<void(Route)> consume_route, const TransportProfile &profile) override;
+        virtual std::vector<RouteInfo> calculate_route_infos_vector(WaypointsView waypoints, const TransportProfile &profile) override;
+        virtual void calculate_route_infos_vector(WaypointsView waypoints, std::function<void(RouteInfo)> consume_route_info, const TransportProfile &profile) override;
+        virtual RouteInfo calculate_routes_vector_total(WaypointsView waypoints, const TransportProfile &profile) const override;
+
+        /**
+         * \brief Calculates matrix for each departure time separately unless overridden
+         */
+        virtual std::vector<MatrixPtr> calculate_route_matrices(WaypointsView origins, WaypointsView destinations,
+                                                                std::span<const TransportProfile::Timestamp> departure_times, const TransportProfile &profile) const override;
+
+        /**
+         * \brief Basic strategies have no set of points to reach, so this method throws std::invalid_argument unless overridden
+         */
+        virtual Isochrone calculate_isochrone(const GeoPoint &origin, RouteInfo::Seconds max_travel_time_seconds, const TransportProfile &profile) const override;
+
+    protected:
+        /**
+         * \brief Tells if single routes take long enough to calculate for legs of routes vectors to be worth calculating in parallel
+         */
+        virtual bool has_costly_legs() const
+        {
+            return false;
+        }
 
     private:
+        std::size_t get_legs_threads_count(WaypointsView waypoints, const TransportProfile &profile) const;
+
         /**
          * \brief Derived classes should implement this method to produce a copy of themselves to be passed down to route matrix
          *
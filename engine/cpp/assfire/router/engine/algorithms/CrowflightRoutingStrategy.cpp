@@ -24,6 +24,16 @@ namespace assfire::router
         return RouteInfo(distance_meters, travel_time_seconds);
     }
 
+    bool CrowflightRoutingStrategy::is_symmetric() const
+    {
+        return true;
+    }
+
+    bool CrowflightRoutingStrategy::is_bounded_by_crowflight() const
+    {
+        return true;
+    }
+
     std::shared_ptr<RoutingStrategy> CrowflightRoutingStrategy::clone() const
     {
         return std::make_shared<CrowflightRoutingStrategy>();
@@ -9,6 +9,8 @@ namespace assfire::router
     public:
         virtual Route calculate_route(const GeoPoint &origin, const GeoPoint &destination, const TransportProfile &profile) const override;
         virtual RouteInfo calculate_route_info(const GeoPoint &origin, const GeoPoint &destination, const TransportProfile &profile) const override;
+        virtual bool is_symmetric() const override;
+        virtual bool is_bounded_by_crowflight() const override;
         virtual std::shared_ptr<RoutingStrategy> clone() const override;
     };
 }
\ No newline at end of file
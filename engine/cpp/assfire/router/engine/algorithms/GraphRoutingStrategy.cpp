@@ -0,0 +1,869 @@
+#include "GraphRoutingStrategy.hpp"
+#include "WaypointsSimplification.hpp"
+#include "assfire/router/engine/matrix/ImmutableRouteMatrix.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace assfire::router
+{
+    namespace
+    {
+        RouteInfo unreachable_route_info()
+        {
+            return RouteInfo(RouteInfo::INFINITE_DISTANCE, RouteInfo::INFINITE_TRAVEL_TIME);
+        }
+
+        template <typename T>
+        T part_of(T value, double fraction)
+        {
+            return static_cast<T>(std::lround(value * fraction));
+        }
+    }
+
+    /**
+     * Per-thread state of searches computing several departure slices at once. Node state is reset lazily: it belongs to the current search only
+     * if node stamp matches search stamp
+     */
+    struct GraphRoutingStrategy::SliceSearchWorkspace
+    {
+        std::vector<std::uint32_t> stamps;
+        std::vector<Weight> weights;              // By node, then by slice
+        std::vector<std::uint64_t> lengths;       // By node, then by slice
+        std::vector<std::uint64_t> dirty_slices;  // Bit mask of slices improved since node was last scanned
+        std::vector<std::uint32_t> target_stamps; // Nodes marked as targets of the current search
+        std::uint32_t stamp = 0;
+        std::size_t slices_count = 0;
+        RadixHeap<NodeId> queue;
+
+        static SliceSearchWorkspace &acquire(std::size_t nodes_count, std::size_t slices_count)
+        {
+            thread_local SliceSearchWorkspace workspace;
+            if (workspace.stamps.size() != nodes_count || workspace.slices_count != slices_count || ++workspace.stamp == 0)
+            {
+                workspace.stamps.assign(nodes_count, 0);
+                workspace.target_stamps.assign(nodes_count, 0);
+                workspace.weights.resize(nodes_count * slices_count);
+                workspace.lengths.resize(nodes_count * slices_count);
+                workspace.dirty_slices.resize(nodes_count);
+                workspace.slices_count = slices_count;
+                workspace.stamp = 1;
+            }
+            workspace.queue.clear();
+            return workspace;
+        }
+
+        void touch(NodeId node)
+        {
+            if (stamps[node] != stamp)
+            {
+                stamps[node] = stamp;
+                std::fill_n(weights.begin() + node * slices_count, slices_count, RoadGraph::INFINITE_WEIGHT);
+                dirty_slices[node] = 0;
+            }
+        }
+
+        Weight get_weight(NodeId node, std::size_t slice) const
+        {
+            return stamps[node] == stamp ? weights[node * slices_count + slice] : RoadGraph::INFINITE_WEIGHT;
+        }
+
+        bool is_target(NodeId node) const
+        {
+            return target_stamps[node] == stamp;
+        }
+    };
+
+    GraphRoutingStrategy::GraphRoutingStrategy(std::shared_ptr<const RoadGraph> graph,
+                                               std::shared_ptr<const EdgeSpatialIndex> index,
+                                               const std::string &metric,
+                                               RouteInfo::Meters max_snapping_distance_meters,
+                                               std::shared_ptr<CchMetricCache> hierarchy,
+                                               std::shared_ptr<const HubLabels> labels) : graph(graph),
+                                                                                          index(index),
+                                                                                          max_snapping_distance_meters(max_snapping_distance_meters),
+                                                                                          hierarchy(hierarchy),
+                                                                                          labels(labels),
+                                                                                          route_cache(std::make_shared<TimeBucketedRouteCache>())
+    {
+        if (!graph || !index || &index->graph() != graph.get())
+        {
+            throw std::invalid_argument("Graph routing strategy requires road graph and spatial index over it");
+        }
+        if (hierarchy && &hierarchy->topology().graph() != graph.get())
+        {
+            throw std::invalid_argument("Graph routing strategy requires contraction hierarchy over its road graph");
+        }
+        if (labels && &labels->graph() != graph.get())
+        {
+            throw std::invalid_argument("Graph routing strategy requires hub labels of its road graph");
+        }
+        for (const std::string &name : graph->get_metrics())
+        {
+            metrics.push_back(MetricEntry{name, graph->get_weights(name),
+                                          TrafficWeights::is_present(*graph, name) ? std::make_optional<TrafficWeights>(*graph, name) : std::nullopt});
+        }
+        graph->get_weights(metric); // Validates metric
+        default_metric = std::find_if(metrics.begin(), metrics.end(), [&](const MetricEntry &entry)
+                                      { return entry.name == metric; }) - metrics.begin();
+    }
+
+    GraphRoutingStrategy::GraphRoutingStrategy(std::shared_ptr<const RoadGraph> graph, const std::string &metric)
+        : GraphRoutingStrategy(graph, std::make_shared<EdgeSpatialIndex>(graph), metric, DEFAULT_MAX_SNAPPING_DISTANCE_METERS,
+                               graph && CchTopology::is_present(*graph) ? std::make_shared<CchMetricCache>(std::make_shared<CchTopology>(graph)) : nullptr)
+    {
+    }
+
+    Route GraphRoutingStrategy::calculate_route(const GeoPoint &origin, const GeoPoint &destination, const TransportProfile &profile) const
+    {
+        Snap origin_snap = index->snap(origin, max_snapping_distance_meters);
+        Snap destination_snap = index->snap(destination, max_snapping_distance_meters);
+        if (!origin_snap.is_valid() || !destination_snap.is_valid())
+        {
+            return fallback_strategy.calculate_route(origin, destination, profile);
+        }
+
+        EdgeCosts costs = get_edge_costs(profile);
+        Route::Waypoints waypoints;
+        RouteInfo route_info = calculate(make_origin_anchor(origin, origin_snap, costs), make_destination_anchor(destination, destination_snap, costs),
+                                         profile, costs, &waypoints);
+        return Route(std::move(route_info), std::move(waypoints));
+    }
+
+    RouteInfo GraphRoutingStrategy::calculate_route_info(const GeoPoint &origin, const GeoPoint &destination, const TransportProfile &profile) const
+    {
+        EdgeCosts costs = get_edge_costs(profile);
+        std::optional<TimeBucketedRouteCache::Key> cache_key;
+        if (costs.traffic)
+        {
+            cache_key = TimeBucketedRouteCache::Key{origin, destination, costs.metric, std::max(profile.speed_meters_per_second(), 0.0), costs.departure};
+            if (std::optional<RouteInfo> cached = route_cache->get(*cache_key))
+            {
+                return *cached;
+            }
+        }
+
+        Snap origin_snap = index->snap(origin, max_snapping_distance_meters);
+        Snap destination_snap = index->snap(destination, max_snapping_distance_meters);
+        RouteInfo result = origin_snap.is_valid() && destination_snap.is_valid()
+                               ? calculate(make_origin_anchor(origin, origin_snap, costs), make_destination_anchor(destination, destination_snap, costs),
+                                           profile, costs, nullptr)
+                               : fallback_strategy.calculate_route_info(origin, destination, profile);
+        if (cache_key)
+        {
+            route_cache->put(*cache_key, result);
+        }
+        return result;
+    }
+
+    RoutingStrategy::MatrixPtr GraphRoutingStrategy::calculate_route_matrix(WaypointsView origins, WaypointsView destinations, const TransportProfile &profile) const
+    {
+        EdgeCosts costs = get_edge_costs(profile);
+        if (costs.traffic)
+        {
+            return calculate_route_matrices(origins, destinations, std::span<const TransportProfile::Timestamp>(&*profile.departure_time(), 1), profile).front();
+        }
+
+        std::vector<Snap> origin_snaps = index->snap(origins, max_snapping_distance_meters);
+        std::vector<Snap> destination_snaps = index->snap(destinations, max_snapping_distance_meters);
+
+        std::vector<Anchor> origin_anchors;
+        std::vector<Anchor> destination_anchors;
+        origin_anchors.reserve(origins.size());
+        destination_anchors.reserve(destinations.size());
+        for (std::size_t i = 0; i < origins.size(); ++i)
+        {
+            origin_anchors.push_back(make_origin_anchor(origins[i], origin_snaps[i], costs));
+        }
+        for (std::size_t j = 0; j < destinations.size(); ++j)
+        {
+            destination_anchors.push_back(make_destination_anchor(destinations[j], destination_snaps[j], costs));
+        }
+
+        std::vector<RouteInfo> route_infos(origins.size() * destinations.size());
+        auto fill_route_infos = [&](auto &&find_path)
+        {
+            for (std::size_t i = 0; i < origins.size(); ++i)
+            {
+                for (std::size_t j = 0; j < destinations.size(); ++j)
+                {
+                    route_infos[i * destinations.size() + j] = origin_snaps[i].is_valid() && destination_snaps[j].is_valid()
+                                                                   ? make_route_info(origin_anchors[i], destination_anchors[j], find_path(i, j), {}, profile, costs, nullptr)
+                                                                   : fallback_strategy.calculate_route_info(origins[i], destinations[j], profile);
+                }
+            }
+        };
+
+        bool is_one_to_many = destinations.size() >= CchMetric::ONE_TO_MANY_TARGETS_THRESHOLD;
+        std::shared_ptr<const CchMetric> cch_metric = !is_labeled(profile, costs) || is_one_to_many ? get_cch_metric(profile, costs) : nullptr;
+        if (cch_metric)
+        {
+            // Anchors of waypoints that are not snapped have no endpoints, so they are neither searched from nor searched for
+            std::vector<std::span<const Endpoint>> sources;
+            std::vector<std::span<const Endpoint>> targets;
+            for (const Anchor &anchor : origin_anchors)
+            {
+                sources.emplace_back(anchor.endpoints, anchor.endpoints_count);
+            }
+            for (const Anchor &anchor : destination_anchors)
+            {
+                targets.emplace_back(anchor.endpoints, anchor.endpoints_count);
+            }
+
+            std::vector<Path> paths = cch_metric->find_paths(sources, targets);
+            fill_route_infos([&](std::size_t i, std::size_t j)
+                             { return paths[i * destinations.size() + j]; });
+        }
+        else if (is_labeled(profile, costs))
+        {
+            fill_route_infos([&](std::size_t i, std::size_t j)
+                             { return labels->find_path(std::span<const Endpoint>(origin_anchors[i].endpoints, origin_anchors[i].endpoints_count),
+                                                        std::span<const Endpoint>(destination_anchors[j].endpoints, destination_anchors[j].endpoints_count)); });
+        }
+        else
+        {
+            std::vector<NodeId> targets;
+            for (const Anchor &anchor : destination_anchors)
+            {
+                for (std::size_t k = 0; k < anchor.endpoints_count; ++k)
+                {
+                    targets.push_back(anchor.endpoints[k].node);
+                }
+            }
+
+            // Rows are filled origin by origin, so the workspace holds search of the current origin
+            SearchWorkspace *workspace = nullptr;
+            std::size_t searched_origin = origins.size();
+            fill_route_infos([&](std::size_t i, std::size_t j)
+                             {
+                                 if (searched_origin != i)
+                                 {
+                                     workspace = &SearchWorkspace::acquire(graph->nodes_count());
+                                     search(origin_anchors[i], targets, costs, *workspace);
+                                     searched_origin = i;
+                                 }
+                                 return unpack(origin_anchors[i], destination_anchors[j], *workspace, nullptr); });
+        }
+
+        return std::make_shared<ImmutableRouteMatrix>(
+            origins.size(), destinations.size(),
+            [&](auto origin, auto destination)
+            {
+                return route_infos[origin * destinations.size() + destination];
+            },
+            clone(), profile);
+    }
+
+    std::vector<RoutingStrategy::MatrixPtr> GraphRoutingStrategy::calculate_route_matrices(WaypointsView origins, WaypointsView destinations,
+                                                                                         std::span<const TransportProfile::Timestamp> departure_times,
+                                                                                         const TransportProfile &profile) const
+    {
+        if (departure_times.size() > MAX_DEPARTURE_SLICES)
+        {
+            throw std::invalid_argument("Too many departure times, at most " + std::to_string(MAX_DEPARTURE_SLICES) + " are supported");
+        }
+        if (departure_times.empty())
+        {
+            return {};
+        }
+        if (!metrics[get_metric_index(profile)].traffic)
+        {
+            // Travel times don't depend on departure time, so every slice is the same matrix
+            TransportProfile static_profile = profile;
+            static_profile.set_departure_time(std::nullopt);
+            return std::vector<MatrixPtr>(departure_times.size(), calculate_route_matrix(origins, destinations, static_profile));
+        }
+
+        std::size_t slices_count = departure_times.size();
+        std::vector<Snap> origin_snaps = index->snap(origins, max_snapping_distance_meters);
+        std::vector<Snap> destination_snaps = index->snap(destinations, max_snapping_distance_meters);
+
+        std::vector<TransportProfile> slice_profiles;
+        std::vector<EdgeCosts> slice_costs;
+        for (TransportProfile::Timestamp departure_time : departure_times)
+        {
+            slice_profiles.push_back(profile);
+            slice_profiles.back().set_departure_time(departure_time);
+            slice_costs.push_back(get_edge_costs(slice_profiles.back()));
+        }
+
+        // Anchors depend on travel times of snapped edges, so they are made for each slice
+        std::vector<Anchor> origin_anchors;      // By origin, then by slice
+        std::vector<Anchor> destination_anchors; // By destination, then by slice
+        for (std::size_t i = 0; i < origins.size(); ++i)
+        {
+            for (const EdgeCosts &costs : slice_costs)
+            {
+                origin_anchors.push_back(make_origin_anchor(origins[i], origin_snaps[i], costs));
+            }
+        }
+        std::vector<NodeId> targets;
+        for (std::size_t j = 0; j < destinations.size(); ++j)
+        {
+            for (const EdgeCosts &costs : slice_costs)
+            {
+                destination_anchors.push_back(make_destination_anchor(destinations[j], destination_snaps[j], costs));
+            }
+            for (std::size_t k = 0; k < destination_anchors.back().endpoints_count; ++k)
+            {
+                targets.push_back(destination_anchors.back().endpoints[k].node);
+            }
+        }
+
+        std::vector<RouteInfo> route_infos(slices_count * origins.size() * destinations.size()); // By slice, then by origin, then by destination
+        auto get_cell = [&](std::size_t slice, std::size_t origin, std::size_t destination) -> RouteInfo &
+        {
+            return route_infos[(slice * origins.size() + origin) * destinations.size() + destination];
+        };
+
+        for (std::size_t i = 0; i < origins.size(); ++i)
+        {
+            SliceSearchWorkspace *workspace = nullptr;
+            if (origin_snaps[i].is_valid())
+            {
+                workspace = &SliceSearchWorkspace::acquire(graph->nodes_count(), slices_count);
+                search_slices(std::span<const Anchor>(origin_anchors).subspan(i * slices_count, slices_count), targets, slice_costs, *workspace);
+            }
+
+            for (std::size_t j = 0; j < destinations.size(); ++j)
+            {
+                for (std::size_t slice = 0; slice < slices_count; ++slice)
+                {
+                    if (!workspace || !destination_snaps[j].is_valid())
+                    {
+                        get_cell(slice, i, j) = fallback_strategy.calculate_route_info(origins[i], destinations[j], slice_profiles[slice]);
+                        continue;
+                    }
+
+                    const Anchor &destination_anchor = destination_anchors[j * slices_count + slice];
+                    Path path;
+                    for (std::size_t k = 0; k < destination_anchor.endpoints_count; ++k)
+                    {
+                        const Endpoint &endpoint = destination_anchor.endpoints[k];
+                        Weight weight = workspace->get_weight(endpoint.node, slice);
+                        if (weight != RoadGraph::INFINITE_WEIGHT && weight + std::uint64_t(endpoint.weight) < path.weight)
+                        {
+                            path = Path{weight + std::uint64_t(endpoint.weight), workspace->lengths[endpoint.node * slices_count + slice] + endpoint.length};
+                        }
+                    }
+                    get_cell(slice, i, j) = make_route_info(origin_anchors[i * slices_count + slice], destination_anchor, path, {},
+                                                            slice_profiles[slice], slice_costs[slice], nullptr);
+                }
+            }
+        }
+
+        std::vector<MatrixPtr> result;
+        for (std::size_t slice = 0; slice < slices_count; ++slice)
+        {
+            result.push_back(std::make_shared<ImmutableRouteMatrix>(
+                origins.size(), destinations.size(),
+                [&](auto origin, auto destination)
+                {
+                    return get_cell(slice, origin, destination);
+                },
+                clone(), slice_profiles[slice]));
+        }
+        return result;
+    }
+
+    Isochrone GraphRoutingStrategy::calculate_isochrone(const GeoPoint &origin, RouteInfo::Seconds max_travel_time_seconds, const TransportProfile &profile) const
+    {
+        Isochrone result(origin, max_travel_time_seconds);
+        Snap snap = index->snap(origin, max_snapping_distance_meters);
+        if (!snap.is_valid())
+        {
+            return result;
+        }
+
+        EdgeCosts costs = get_edge_costs(profile);
+        Anchor anchor = make_origin_anchor(origin, snap, costs);
+        RouteInfo::Seconds access_time = profile.speed_meters_per_second() > 0 ? profile.calculate_time_to_travel_seconds(snap.distance_meters) : 0;
+        double max_weight = (double(max_travel_time_seconds) - access_time) * graph_format::WEIGHT_UNITS_PER_SECOND;
+        if (max_weight < 0)
+        {
+            return result;
+        }
+
+        auto add_reached_point = [&](NodeId node, const Path &path)
+        {
+            result.add_point(graph->get_node_location(node),
+                             RouteInfo(RouteInfo::Meters(path.length) / graph_format::LENGTH_UNITS_PER_METER + snap.distance_meters,
+                                       static_cast<RouteInfo::Seconds>(std::lround(double(path.weight) / graph_format::WEIGHT_UNITS_PER_SECOND)) + access_time));
+        };
+
+        // Intersection expanded by turns is reached at each of its nodes, only the fastest of them makes a point
+        std::unordered_map<NodeId, std::pair<NodeId, Path>> intersection_points;
+        auto add_point = [&](NodeId node, const Path &path)
+        {
+            if (!path.exists() || path.weight > max_weight)
+            {
+                return;
+            }
+            if (!graph->is_turn_expanded())
+            {
+                add_reached_point(node, path);
+                return;
+            }
+            auto [point, is_inserted] = intersection_points.try_emplace(graph->get_original_node(node), node, path);
+            if (!is_inserted && path.weight < point->second.second.weight)
+            {
+                point->second = {node, path};
+            }
+        };
+        auto add_intersection_points = [&]()
+        {
+            std::vector<std::pair<NodeId, Path>> points;
+            for (const auto &[original_node, point] : intersection_points)
+            {
+                points.push_back(point);
+            }
+            std::sort(points.begin(), points.end(), [](const auto &lhs, const auto &rhs)
+                      { return lhs.first < rhs.first; });
+            for (const auto &[node, path] : points)
+            {
+                add_reached_point(node, path);
+            }
+        };
+
+        if (std::shared_ptr<const CchMetric> cch_metric = get_cch_metric(profile, costs))
+        {
+            std::vector<Path> paths = cch_metric->find_paths_to_all(std::span<const Endpoint>(anchor.endpoints, anchor.endpoints_count));
+            for (NodeId node = 0; node < paths.size(); ++node)
+            {
+                add_point(node, paths[node]);
+            }
+            add_intersection_points();
+            return result;
+        }
+
+        // Nodes are settled after their parents, so path lengths are accumulated in settling order
+        std::vector<NodeId> settled_nodes;
+        SearchWorkspace &workspace = SearchWorkspace::acquire(graph->nodes_count());
+        search(anchor, {}, costs, workspace, static_cast<Weight>(std::min<double>(max_weight, RoadGraph::INFINITE_WEIGHT - 1)), &settled_nodes);
+        std::unordered_map<NodeId, std::uint64_t> lengths;
+        for (NodeId node : settled_nodes)
+        {
+            std::uint64_t length = 0;
+            if (workspace.get_parent_node(node) != RoadGraph::NO_NODE)
+            {
+                length = lengths.at(workspace.get_parent_node(node)) + graph->get_edge_length(workspace.get_parent_edge(node));
+            }
+            else
+            {
+                for (std::size_t i = 0; i < anchor.endpoints_count; ++i)
+                {
+                    if (anchor.endpoints[i].node == node && anchor.endpoints[i].weight == workspace.get_weight(node))
+                    {
+                        length = anchor.endpoints[i].length;
+                        break;
+                    }
+                }
+            }
+            lengths.emplace(node, length);
+            add_point(node, Path{workspace.get_weight(node), length});
+        }
+        add_intersection_points();
+        return result;
+    }
+
+    void GraphRoutingStrategy::customize(const TransportProfile &profile) const
+    {
+        if (hierarchy)
+        {
+            hierarchy->get(get_metric(profile), profile.speed_meters_per_second());
+        }
+    }
+
+    std::shared_ptr<RoutingStrategy> GraphRoutingStrategy::clone() const
+    {
+        return std::make_shared<GraphRoutingStrategy>(*this); // Copy shares route cache
+    }
+
+    bool GraphRoutingStrategy::is_bounded_by_crowflight() const
+    {
+        return true;
+    }
+
+    bool GraphRoutingStrategy::has_costly_legs() const
+    {
+        return true;
+    }
+
+    std::uint32_t GraphRoutingStrategy::get_metric_index(const TransportProfile &profile) const
+    {
+        if (profile.metric().empty())
+        {
+            return default_metric;
+        }
+        // Graphs have few metrics, so comparing names is cheaper than hashing them
+        for (std::uint32_t i = 0; i < metrics.size(); ++i)
+        {
+            if (metrics[i].name == profile.metric())
+            {
+                return i;
+            }
+        }
+        throw std::invalid_argument("Unknown road graph metric: " + profile.metric());
+    }
+
+    const std::string &GraphRoutingStrategy::get_metric(const TransportProfile &profile) const
+    {
+        return metrics[get_metric_index(profile)].name;
+    }
+
+    bool GraphRoutingStrategy::is_labeled(const TransportProfile &profile, const EdgeCosts &costs) const
+    {
+        return labels && !costs.traffic && labels->get_metric() == get_metric(profile) && labels->get_max_speed_meters_per_second() == std::max(profile.speed_meters_per_second(), 0.0);
+    }
+
+    std::shared_ptr<const CchMetric> GraphRoutingStrategy::get_cch_metric(const TransportProfile &profile, const EdgeCosts &costs) const
+    {
+        return hierarchy && !costs.traffic ? hierarchy->get(get_metric(profile), profile.speed_meters_per_second()) : nullptr;
+    }
+
+    GraphRoutingStrategy::EdgeCosts GraphRoutingStrategy::get_edge_costs(const TransportProfile &profile) const
+    {
+        std::uint32_t metric = get_metric_index(profile);
+        EdgeCosts costs{metric, metrics[metric].weights, profile.speed_meters_per_second(), std::nullopt, 0};
+        if (profile.departure_time() && metrics[metric].traffic)
+        {
+            TransportProfile::Timestamp departure = *profile.departure_time();
+            departure -= (departure % DEPARTURE_BUCKET_SECONDS + DEPARTURE_BUCKET_SECONDS) % DEPARTURE_BUCKET_SECONDS;
+            costs.traffic = metrics[metric].traffic;
+            costs.departure = departure * graph_format::WEIGHT_UNITS_PER_SECOND;
+        }
+        return costs;
+    }
+
+    GraphRoutingStrategy::Weight GraphRoutingStrategy::get_edge_weight(EdgeId edge, const EdgeCosts &costs, Weight entered_after) const
+    {
+        Weight weight = costs.traffic ? costs.traffic->get_weight(edge, costs.departure + entered_after) : costs.weights[edge];
+        return RoadGraph::limit_by_speed(weight, graph->get_edge_length(edge), costs.max_speed_meters_per_second);
+    }
+
+    GraphRoutingStrategy::Anchor GraphRoutingStrategy::make_origin_anchor(const GeoPoint &point, const Snap &snap, const EdgeCosts &costs) const
+    {
+        Anchor anchor{point, snap, {}, 0};
+        if (!snap.is_valid())
+        {
+            return anchor;
+        }
+
+        // Snapped point is left either along the edge to its target or along the reverse edge to its source
+        anchor.endpoints[anchor.endpoints_count++] = Endpoint{graph->get_edge_target(snap.edge),
+                                                              part_of(get_edge_weight(snap.edge, costs), 1 - snap.fraction),
+                                                              part_of(graph->get_edge_length(snap.edge), 1 - snap.fraction)};
+        EdgeId reverse_edge = graph->get_reverse_edge(snap.edge);
+        if (reverse_edge != RoadGraph::NO_EDGE)
+        {
+            anchor.endpoints[anchor.endpoints_count++] = Endpoint{graph->get_edge_target(reverse_edge),
+                                                                  part_of(get_edge_weight(reverse_edge, costs), snap.fraction),
+                                                                  part_of(graph->get_edge_length(reverse_edge), snap.fraction)};
+        }
+        else if (snap.fraction == 0)
+        {
+            anchor.endpoints[anchor.endpoints_count++] = Endpoint{graph->get_edge_source(snap.edge), 0, 0}; // Point is exactly at source node of one-way road
+        }
+        return anchor;
+    }
+
+    GraphRoutingStrategy::Anchor GraphRoutingStrategy::make_destination_anchor(const GeoPoint &point, const Snap &snap, const EdgeCosts &costs) const
+    {
+        Anchor anchor{point, snap, {}, 0};
+        if (!snap.is_valid())
+        {
+            return anchor;
+        }
+
+        // Snapped point is reached either from edge source along the edge or from edge target along the reverse edge
+        anchor.endpoints[anchor.endpoints_count++] = Endpoint{graph->get_edge_source(snap.edge),
+                                                              part_of(get_edge_weight(snap.edge, costs), snap.fraction),
+                                                              part_of(graph->get_edge_length(snap.edge), snap.fraction)};
+        EdgeId reverse_edge = graph->get_reverse_edge(snap.edge);
+        if (reverse_edge != RoadGraph::NO_EDGE)
+        {
+            anchor.endpoints[anchor.endpoints_count++] = Endpoint{graph->get_edge_target(snap.edge),
+                                                                  part_of(get_edge_weight(reverse_edge, costs), 1 - snap.fraction),
+                                                                  part_of(graph->get_edge_length(reverse_edge), 1 - snap.fraction)};
+        }
+        else if (snap.fraction == 1)
+        {
+            anchor.endpoints[anchor.endpoints_count++] = Endpoint{graph->get_edge_target(snap.edge), 0, 0}; // Point is exactly at target node of one-way road
+        }
+        return anchor;
+    }
+
+    RouteInfo GraphRoutingStrategy::calculate(const Anchor &origin, const Anchor &destination, const TransportProfile &profile, const EdgeCosts &costs,
+                                              Route::Waypoints *waypoints) const
+    {
+        Path path;
+        std::vector<NodeId> nodes;
+        if (!waypoints && is_labeled(profile, costs))
+        {
+            path = labels->find_path(std::span<const Endpoint>(origin.endpoints, origin.endpoints_count),
+                                     std::span<const Endpoint>(destination.endpoints, destination.endpoints_count));
+        }
+        else if (std::shared_ptr<const CchMetric> cch_metric = get_cch_metric(profile, costs))
+        {
+            path = cch_metric->find_path(std::span<const Endpoint>(origin.endpoints, origin.endpoints_count),
+                                         std::span<const Endpoint>(destination.endpoints, destination.endpoints_count),
+                                         waypoints ? &nodes : nullptr, profile.geometry_tolerance_meters());
+        }
+        else
+        {
+            NodeId targets[2];
+            for (std::size_t i = 0; i < destination.endpoints_count; ++i)
+            {
+                targets[i] = destination.endpoints[i].node;
+            }
+
+            SearchWorkspace &workspace = SearchWorkspace::acquire(graph->nodes_count());
+            search(origin, std::span<const NodeId>(targets, destination.endpoints_count), costs, workspace);
+            path = unpack(origin, destination, workspace, waypoints ? &nodes : nullptr);
+        }
+        return make_route_info(origin, destination, path, nodes, profile, costs, waypoints);
+    }
+
+    void GraphRoutingStrategy::search(const Anchor &origin, std::span<const NodeId> targets, const EdgeCosts &costs, SearchWorkspace &workspace,
+                                      Weight max_weight, std::vector<NodeId> *settled_nodes) const
+    {
+        RadixHeap<NodeId> &queue = workspace.queue();
+
+        std::size_t targets_left = 0;
+        for (NodeId target : targets)
+        {
+            if (workspace.mark_target(target))
+            {
+                ++targets_left;
+            }
+        }
+
+        for (std::size_t i = 0; i < origin.endpoints_count; ++i)
+        {
+            const Endpoint &endpoint = origin.endpoints[i];
+            if (endpoint.weight < workspace.get_weight(endpoint.node))
+            {
+                workspace.set_weight(endpoint.node, endpoint.weight, RoadGraph::NO_NODE, RoadGraph::NO_EDGE);
+                queue.push(endpoint.weight, endpoint.node);
+            }
+        }
+
+        // Search that collects settled nodes doesn't stop at targets, only at max weight
+        while (!queue.empty() && (targets_left > 0 || settled_nodes))
+        {
+            auto [weight, node] = queue.pop();
+            if (weight > workspace.get_weight(node))
+            {
+                continue; // Outdated queue item
+            }
+            if (weight > max_weight)
+            {
+                break;
+            }
+            if (settled_nodes)
+            {
+                settled_nodes->push_back(node);
+            }
+            if (workspace.unmark_target(node))
+            {
+                --targets_left;
+            }
+
+            for (EdgeId edge = graph->edges_begin(node); edge < graph->edges_end(node); ++edge)
+            {
+                NodeId target = graph->get_edge_target(edge);
+                Weight target_weight = weight + get_edge_weight(edge, costs, weight);
+                if (target_weight < workspace.get_weight(target))
+                {
+                    workspace.set_weight(target, target_weight, node, edge);
+                    queue.push(target_weight, target);
+                }
+            }
+        }
+    }
+
+    void GraphRoutingStrategy::search_slices(std::span<const Anchor> origin_by_slice, std::span<const NodeId> targets, std::span<const EdgeCosts> costs_by_slice,
+                                             SliceSearchWorkspace &workspace) const
+    {
+        std::size_t slices_count = costs_by_slice.size();
+        RadixHeap<NodeId> &queue = workspace.queue;
+
+        // Search stops when every slice of every target is reached and queue holds only weights above the largest target weight ever set
+        std::size_t unreached_count = 0;
+        std::uint64_t targets_bound = 0;
+        for (NodeId target : targets)
+        {
+            if (!workspace.is_target(target))
+            {
+                workspace.target_stamps[target] = workspace.stamp;
+                unreached_count += slices_count;
+            }
+        }
+
+        auto improve = [&](NodeId node, std::size_t slice, Weight weight, std::uint64_t length)
+        {
+            workspace.touch(node);
+            Weight &node_weight = workspace.weights[node * slices_count + slice];
+            if (weight >= node_weight)
+            {
+                return false;
+            }
+            if (workspace.is_target(node))
+            {
+                unreached_count -= node_weight == RoadGraph::INFINITE_WEIGHT;
+                targets_bound = std::max<std::uint64_t>(targets_bound, weight);
+            }
+            node_weight = weight;
+            workspace.lengths[node * slices_count + slice] = length;
+            workspace.dirty_slices[node] |= std::uint64_t(1) << slice;
+            return true;
+        };
+
+        for (std::size_t slice = 0; slice < slices_count; ++slice)
+        {
+            for (std::size_t i = 0; i < origin_by_slice[slice].endpoints_count; ++i)
+            {
+                const Endpoint &endpoint = origin_by_slice[slice].endpoints[i];
+                if (improve(endpoint.node, slice, endpoint.weight, endpoint.length))
+                {
+                    queue.push(endpoint.weight, endpoint.node);
+                }
+            }
+        }
+
+        // Slices have different travel times, so node may be scanned again after a slice of it improves. Node is queued with the least improved
+        // weight of its slices, so queue keys never decrease and a slice is final once the popped key exceeds it
+        while (!queue.empty())
+        {
+            auto [key, node] = queue.pop();
+            if (unreached_count == 0 && key > targets_bound)
+            {
+                break;
+            }
+            std::uint64_t dirty_slices = workspace.dirty_slices[node];
+            if (dirty_slices == 0)
+            {
+                continue; // Outdated queue item
+            }
+            workspace.dirty_slices[node] = 0;
+
+            for (EdgeId edge = graph->edges_begin(node); edge < graph->edges_end(node); ++edge)
+            {
+                NodeId target = graph->get_edge_target(edge);
+                Weight min_improved_weight = RoadGraph::INFINITE_WEIGHT;
+                for (std::uint64_t slices = dirty_slices; slices != 0; slices &= slices - 1)
+                {
+                    std::size_t slice = std::countr_zero(slices);
+                    Weight weight = workspace.weights[node * slices_count + slice];
+                    Weight target_weight = weight + get_edge_weight(edge, costs_by_slice[slice], weight);
+                    if (improve(target, slice, target_weight, workspace.lengths[node * slices_count + slice] + graph->get_edge_length(edge)))
+                    {
+                        min_improved_weight = std::min(min_improved_weight, target_weight);
+                    }
+                }
+                if (min_improved_weight != RoadGraph::INFINITE_WEIGHT)
+                {
+                    queue.push(min_improved_weight, target);
+                }
+            }
+        }
+    }
+
+    GraphRoutingStrategy::Path GraphRoutingStrategy::unpack(const Anchor &origin, const Anchor &destination, const SearchWorkspace &workspace,
+                                                            std::vector<NodeId> *nodes) const
+    {
+        const Endpoint *best_endpoint = nullptr;
+        Path path;
+        for (std::size_t i = 0; i < destination.endpoints_count; ++i)
+        {
+            const Endpoint &endpoint = destination.endpoints[i];
+            if (workspace.get_weight(endpoint.node) != RoadGraph::INFINITE_WEIGHT && workspace.get_weight(endpoint.node) + std::uint64_t(endpoint.weight) < path.weight)
+            {
+                best_endpoint = &endpoint;
+                path.weight = workspace.get_weight(endpoint.node) + std::uint64_t(endpoint.weight);
+            }
+        }
+        if (!best_endpoint)
+        {
+            return path;
+        }
+
+        NodeId node = best_endpoint->node;
+        for (; workspace.get_parent_node(node) != RoadGraph::NO_NODE; node = workspace.get_parent_node(node))
+        {
+            path.length += graph->get_edge_length(workspace.get_parent_edge(node));
+            if (nodes)
+            {
+                nodes->push_back(node);
+            }
+        }
+        if (nodes)
+        {
+            nodes->push_back(node);
+            std::reverse(nodes->begin(), nodes->end());
+        }
+
+        for (std::size_t i = 0; i < origin.endpoints_count; ++i)
+        {
+            if (origin.endpoints[i].node == node && origin.endpoints[i].weight == workspace.get_weight(node))
+            {
+                path.length += origin.endpoints[i].length;
+                break;
+            }
+        }
+        path.length += best_endpoint->length;
+        return path;
+    }
+
+    RouteInfo GraphRoutingStrategy::make_route_info(const Anchor &origin, const Anchor &destination, Path path, const std::vector<NodeId> &nodes,
+                                                    const TransportProfile &profile, const EdgeCosts &costs, Route::Waypoints *waypoints) const
+    {
+        bool is_same_edge = origin.snap.edge == destination.snap.edge && origin.snap.fraction <= destination.snap.fraction;
+        Weight same_edge_weight = is_same_edge ? part_of(get_edge_weight(origin.snap.edge, costs), destination.snap.fraction - origin.snap.fraction) : 0;
+        bool is_along_same_edge = is_same_edge && same_edge_weight <= path.weight;
+        if (is_along_same_edge)
+        {
+            // Destination is ahead on the same road, so no graph nodes are passed
+            path = Path{same_edge_weight, part_of(graph->get_edge_length(origin.snap.edge), destination.snap.fraction - origin.snap.fraction)};
+        }
+        else if (!path.exists())
+        {
+            return unreachable_route_info();
+        }
+
+        RouteInfo::Meters access_distance = origin.snap.distance_meters + destination.snap.distance_meters;
+        RouteInfo::Seconds access_time = profile.speed_meters_per_second() > 0 ? profile.calculate_time_to_travel_seconds(access_distance) : 0;
+
+        if (waypoints)
+        {
+            waypoints->push_back(origin.point);
+            waypoints->push_back(origin.snap.location);
+            if (!is_along_same_edge)
+            {
+                NodeId previous_node = RoadGraph::NO_NODE;
+                for (NodeId node : nodes)
+                {
+                    // Turn of expanded intersection passes two nodes of the same intersection
+                    if (graph->get_original_node(node) != previous_node)
+                    {
+                        waypoints->push_back(graph->get_node_location(node));
+                    }
+                    previous_node = graph->get_original_node(node);
+                }
+            }
+            waypoints->push_back(destination.snap.location);
+            waypoints->push_back(destination.point);
+            if (profile.geometry_tolerance_meters() > 0)
+            {
+                // Hierarchy leaves out shortcuts within tolerance while unpacking, the rest of the nodes is simplified here
+                *waypoints = simplify_waypoints(*waypoints, profile.geometry_tolerance_meters());
+            }
+        }
+
+        return RouteInfo(RouteInfo::Meters(path.length) / graph_format::LENGTH_UNITS_PER_METER + access_distance,
+                         static_cast<RouteInfo::Seconds>(std::lround(double(path.weight) / graph_format::WEIGHT_UNITS_PER_SECOND)) + access_time);
+    }
+}
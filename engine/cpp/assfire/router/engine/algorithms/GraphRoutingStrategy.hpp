@@ -0,0 +1,185 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "BasicRoutingStrategy.hpp"
+#include "CrowflightRoutingStrategy.hpp"
+#include "TimeBucketedRouteCache.hpp"
+#include "assfire/router/engine/graph/CchMetricCache.hpp"
+#include "assfire/router/engine/graph/HubLabels.hpp"
+#include "assfire/router/engine/graph/RoadGraph.hpp"
+#include "assfire/router/engine/graph/EdgeSpatialIndex.hpp"
+#include "assfire/router/engine/graph/SearchWorkspace.hpp"
+#include "assfire/router/engine/graph/TrafficWeights.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief This strategy calculates shortest travel time routes over memory mapped road graph. Waypoints are snapped to the nearest road segment,
+     * routes start and end at the snapped points. Waypoints with no road within max snapping distance are routed with crowflight strategy.
+     * If transport profile has positive speed, it limits travel time of each edge from below (vehicle can't go faster than its speed).
+     * If transport profile specifies graph metric, its travel times are used instead of the ones of the strategy metric.
+     *
+     * If contraction hierarchy is provided, queries run over hierarchy metric customized for the transport profile. Otherwise searches are
+     * Dijkstra searches that use workspace of the calling thread, so repeated queries don't allocate per-node state.
+     *
+     * If hub labels are provided, route infos and matrices for transport profiles matching metric and speed of the labels are calculated
+     * with label intersections, which don't touch the graph. Routes with waypoints still need a search
+     *
+     * If transport profile has departure time and graph has time-dependent travel times for its metric, queries are time-dependent Dijkstra searches
+     * that enter each edge at the time it is reached. Departure time is rounded down to DEPARTURE_BUCKET_SECONDS and route infos are cached per bucket.
+     * Partial edges at destinations are entered at departure time, which is exact enough for edges waypoints are snapped to.
+     * Hierarchy and labels describe static travel times only, so they are not used by time-dependent queries
+     *
+     * Graphs with turn restrictions and costs need no special handling: their intersections are already split into nodes connected by turn edges.
+     * Route waypoints and isochrone points are reported once per intersection.
+     *
+     * Route waypoints are simplified to geometry tolerance of transport profile, if it has one. Legs of long routes vectors are calculated in parallel
+     */
+    class GraphRoutingStrategy : public BasicRoutingStrategy
+    {
+    public:
+        static constexpr RouteInfo::Meters DEFAULT_MAX_SNAPPING_DISTANCE_METERS = 1000;
+        static constexpr TransportProfile::Timestamp DEPARTURE_BUCKET_SECONDS = 300;
+        static constexpr std::size_t MAX_DEPARTURE_SLICES = 64;
+
+        /**
+         * \brief Construct a new GraphRoutingStrategy object
+         *
+         * \param graph Road graph to route over
+         * \param index Spatial index over the same graph. May be shared between strategies for different metrics
+         * \param metric Name of graph metric to use edge travel times of
+         * \param max_snapping_distance_meters Max distance from waypoint to the road it is snapped to
+         * \param hierarchy Customized metrics of graph contraction hierarchy. May be shared between strategies. If null, Dijkstra searches are used
+         * \param labels Hub labels of the graph. May be null
+         */
+        GraphRoutingStrategy(std::shared_ptr<const RoadGraph> graph,
+                             std::shared_ptr<const EdgeSpatialIndex> index,
+                             const std::string &metric,
+                             RouteInfo::Meters max_snapping_distance_meters = DEFAULT_MAX_SNAPPING_DISTANCE_METERS,
+                             std::shared_ptr<CchMetricCache> hierarchy = nullptr,
+                             std::shared_ptr<const HubLabels> labels = nullptr);
+
+        /**
+         * \brief Construct a new GraphRoutingStrategy object with its own spatial index, default snapping distance
+         * and contraction hierarchy if graph file contains its topology
+         */
+        GraphRoutingStrategy(std::shared_ptr<const RoadGraph> graph, const std::string &metric);
+
+        using BasicRoutingStrategy::calculate_route_matrix;
+
+        /**
+         * \brief Travel times are bounded by crowflight since edges are never traveled faster than profile speed
+         */
+        virtual bool is_bounded_by_crowflight() const override;
+
+        virtual Route calculate_route(const GeoPoint &origin, const GeoPoint &destination, const TransportProfile &profile) const override;
+        virtual RouteInfo calculate_route_info(const GeoPoint &origin, const GeoPoint &destination, const TransportProfile &profile) const override;
+
+        /**
+         * \brief Calculates matrix running single search from each origin that stops when all destinations are reached. All waypoints are snapped in one batch.
+         * With contraction hierarchy, matrices with many destinations are calculated by downward sweeps over ancestors of destinations
+         * for several origins at once, which is faster than hub label intersections per cell
+         */
+        virtual MatrixPtr calculate_route_matrix(WaypointsView origins, WaypointsView destinations, const TransportProfile &profile) const override;
+
+        /**
+         * \brief Calculates matrices for up to MAX_DEPARTURE_SLICES departure times snapping waypoints once. With time-dependent travel times, a single search
+         * from each origin computes all slices at once: it keeps travel time of each slice per node and scans node once for all slices improved since the last scan.
+         * Without them, all slices are the same matrix. Throws std::invalid_argument if there are too many departure times
+         */
+        virtual std::vector<MatrixPtr> calculate_route_matrices(WaypointsView origins, WaypointsView destinations,
+                                                                std::span<const TransportProfile::Timestamp> departure_times, const TransportProfile &profile) const override;
+
+        /**
+         * \brief Calculates graph nodes reachable from snapped origin within max travel time with a single sweep over contraction hierarchy
+         * or a bounded Dijkstra search if strategy has no hierarchy. Isochrone of origin with no road within max snapping distance is empty
+         */
+        virtual Isochrone calculate_isochrone(const GeoPoint &origin, RouteInfo::Seconds max_travel_time_seconds, const TransportProfile &profile) const override;
+
+        /**
+         * \brief Customizes contraction hierarchy for transport profile ahead of its first query. Does nothing if strategy has no hierarchy
+         */
+        void customize(const TransportProfile &profile) const;
+
+    private:
+        using NodeId = RoadGraph::NodeId;
+        using EdgeId = RoadGraph::EdgeId;
+        using Weight = RoadGraph::Weight;
+        using Snap = EdgeSpatialIndex::Snap;
+        using Path = CchMetric::Path;
+
+        /**
+         * Part of snapped edge between snapped point and one of edge nodes
+         */
+        using Endpoint = CchMetric::Seed;
+
+        /**
+         * Graph metric with its travel times looked up once, so requests resolve metric of transport profile by index without building section names
+         */
+        struct MetricEntry
+        {
+            std::string name;
+            std::span<const Weight> weights;
+            std::optional<TrafficWeights> traffic; // Only for metrics with time-dependent travel times
+        };
+
+        /**
+         * Edge travel times of the metric transport profile uses and its speed limit
+         */
+        struct EdgeCosts
+        {
+            std::uint32_t metric; // Index in metrics
+            std::span<const Weight> weights;
+            double max_speed_meters_per_second;
+            std::optional<TrafficWeights> traffic; // Only for profiles with departure time
+            std::int64_t departure = 0;            // Deciseconds since Unix epoch, rounded down to departure bucket
+        };
+
+        struct SliceSearchWorkspace;
+
+        /**
+         * Snapped waypoint with nodes it can be left through (for origins) or reached through (for destinations)
+         */
+        struct Anchor
+        {
+            GeoPoint point;
+            Snap snap;
+            Endpoint endpoints[2];
+            std::size_t endpoints_count = 0;
+        };
+
+        virtual std::shared_ptr<RoutingStrategy> clone() const override;
+        virtual bool has_costly_legs() const override;
+
+        std::uint32_t get_metric_index(const TransportProfile &profile) const;
+        const std::string &get_metric(const TransportProfile &profile) const;
+        bool is_labeled(const TransportProfile &profile, const EdgeCosts &costs) const;
+        std::shared_ptr<const CchMetric> get_cch_metric(const TransportProfile &profile, const EdgeCosts &costs) const;
+        EdgeCosts get_edge_costs(const TransportProfile &profile) const;
+        Weight get_edge_weight(EdgeId edge, const EdgeCosts &costs, Weight entered_after = 0) const;
+        Anchor make_origin_anchor(const GeoPoint &point, const Snap &snap, const EdgeCosts &costs) const;
+        Anchor make_destination_anchor(const GeoPoint &point, const Snap &snap, const EdgeCosts &costs) const;
+        RouteInfo calculate(const Anchor &origin, const Anchor &destination, const TransportProfile &profile, const EdgeCosts &costs,
+                            Route::Waypoints *waypoints) const;
+        void search(const Anchor &origin, std::span<const NodeId> targets, const EdgeCosts &costs, SearchWorkspace &workspace,
+                    Weight max_weight = RoadGraph::INFINITE_WEIGHT, std::vector<NodeId> *settled_nodes = nullptr) const;
+        void search_slices(std::span<const Anchor> origin_by_slice, std::span<const NodeId> targets, std::span<const EdgeCosts> costs_by_slice,
+                           SliceSearchWorkspace &workspace) const;
+        Path unpack(const Anchor &origin, const Anchor &destination, const SearchWorkspace &workspace, std::vector<NodeId> *nodes) const;
+        RouteInfo make_route_info(const Anchor &origin, const Anchor &destination, Path path, const std::vector<NodeId> &nodes,
+                                  const TransportProfile &profile, const EdgeCosts &costs, Route::Waypoints *waypoints) const;
+
+        std::shared_ptr<const RoadGraph> graph;
+        std::shared_ptr<const EdgeSpatialIndex> index;
+        std::vector<MetricEntry> metrics;
+        std::uint32_t default_metric;
+        RouteInfo::Meters max_snapping_distance_meters;
+        std::shared_ptr<CchMetricCache> hierarchy;
+        std::shared_ptr<const HubLabels> labels;
+        std::shared_ptr<TimeBucketedRouteCache> route_cache;
+        CrowflightRoutingStrategy fallback_strategy;
+    };
+}
@@ -7,11 +7,21 @@ namespace assfire::router
         return Route(calculate_route_info(origin, destination, profile));
     }
 
-    RouteInfo InfinityRoutingStrategy::calculate_route_info(const GeoPoint &origin, const GeoPoint &destination, const TransportProfile &profile) const
+    RouteInfo InfinityRoutingStrategy::calculate_route_info(const GeoPoint &, const GeoPoint &, const TransportProfile &) const
     {
         return RouteInfo(RouteInfo::INFINITE_DISTANCE, RouteInfo::INFINITE_TRAVEL_TIME);
     }
 
+    bool InfinityRoutingStrategy::is_symmetric() const
+    {
+        return true;
+    }
+
+    bool InfinityRoutingStrategy::is_bounded_by_crowflight() const
+    {
+        return true;
+    }
+
     std::shared_ptr<RoutingStrategy> InfinityRoutingStrategy::clone() const
     {
         return std::make_shared<InfinityRoutingStrategy>();
@@ -0,0 +1,54 @@
+#include "TimeBucketedRouteCache.hpp"
+
+#include <algorithm>
+#include <functional>
+
+namespace assfire::router
+{
+    TimeBucketedRouteCache::TimeBucketedRouteCache(std::size_t capacity) : capacity(std::max<std::size_t>(capacity, 1))
+    {
+    }
+
+    std::optional<RouteInfo> TimeBucketedRouteCache::get(const Key &key)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto iter = entry_by_key.find(key);
+        if (iter == entry_by_key.end())
+        {
+            return std::nullopt;
+        }
+        entries.splice(entries.begin(), entries, iter->second);
+        return iter->second->second;
+    }
+
+    void TimeBucketedRouteCache::put(const Key &key, const RouteInfo &route_info)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto iter = entry_by_key.find(key);
+        if (iter != entry_by_key.end())
+        {
+            iter->second->second = route_info;
+            entries.splice(entries.begin(), entries, iter->second);
+            return;
+        }
+
+        if (entries.size() >= capacity)
+        {
+            entry_by_key.erase(entries.back().first);
+            entries.pop_back();
+        }
+        entries.emplace_front(key, route_info);
+        entry_by_key.emplace(key, entries.begin());
+    }
+
+    std::size_t TimeBucketedRouteCache::KeyHash::operator()(const Key &key) const
+    {
+        std::size_t result = key.metric;
+        for (std::int64_t value : {std::int64_t(key.origin.lat()), std::int64_t(key.origin.lon()), std::int64_t(key.destination.lat()),
+                                   std::int64_t(key.destination.lon()), key.bucket, std::int64_t(key.max_speed_meters_per_second * 1000)})
+        {
+            result = result * 31 + std::hash<std::int64_t>()(value);
+        }
+        return result;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include "assfire/router/api/GeoPoint.hpp"
+#include "assfire/router/api/RouteInfo.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief Route infos of time-dependent queries keyed by waypoints, vehicle (graph metric index and speed limit) and departure time bucket. Departure times within a bucket
+     * are routed as departure at the bucket start, so all of them share one cached route info.
+     *
+     * \details When cache is full, the least recently used route info is evicted. Cache is thread-safe
+     */
+    class TimeBucketedRouteCache
+    {
+    public:
+        static constexpr std::size_t DEFAULT_CAPACITY = 65536;
+
+        struct Key
+        {
+            GeoPoint origin;
+            GeoPoint destination;
+            std::uint32_t metric; // Index of road graph metric
+            double max_speed_meters_per_second;
+            std::int64_t bucket;
+
+            bool operator==(const Key &rhs) const = default;
+        };
+
+        explicit TimeBucketedRouteCache(std::size_t capacity = DEFAULT_CAPACITY);
+
+        std::optional<RouteInfo> get(const Key &key);
+        void put(const Key &key, const RouteInfo &route_info);
+
+    private:
+        struct KeyHash
+        {
+            std::size_t operator()(const Key &key) const;
+        };
+
+        using Entries = std::list<std::pair<Key, RouteInfo>>; // Most recently used first
+
+        std::size_t capacity;
+        std::mutex mutex;
+        Entries entries;
+        std::unordered_map<Key, Entries::iterator, KeyHash> entry_by_key;
+    };
+}
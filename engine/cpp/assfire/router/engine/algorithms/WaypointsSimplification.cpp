@@ -0,0 +1,83 @@
+#include "WaypointsSimplification.hpp"
+#include "CrowflightCalculator.hpp"
+
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace assfire::router
+{
+    namespace
+    {
+        struct Point
+        {
+            double x;
+            double y;
+        };
+
+        double get_distance_to_segment(const Point &point, const Point &begin, const Point &end)
+        {
+            double dx = end.x - begin.x;
+            double dy = end.y - begin.y;
+            double squared_length = dx * dx + dy * dy;
+            double fraction = squared_length > 0 ? ((point.x - begin.x) * dx + (point.y - begin.y) * dy) / squared_length : 0;
+            fraction = std::min(std::max(fraction, 0.0), 1.0);
+            return std::hypot(point.x - begin.x - fraction * dx, point.y - begin.y - fraction * dy);
+        }
+    }
+
+    Route::Waypoints simplify_waypoints(std::span<const GeoPoint> waypoints, RouteInfo::Meters tolerance_meters)
+    {
+        if (tolerance_meters <= 0 || waypoints.size() <= 2)
+        {
+            return Route::Waypoints(waypoints.begin(), waypoints.end());
+        }
+
+        constexpr double METERS_PER_DEGREE = CrowflightCalculator::EARTH_RADIUS * CrowflightCalculator::PI / 180;
+        double meters_per_lon_degree = METERS_PER_DEGREE * std::cos(waypoints.front().lat() / 1e6 * CrowflightCalculator::PI / 180);
+        std::vector<Point> points;
+        points.reserve(waypoints.size());
+        for (const GeoPoint &waypoint : waypoints)
+        {
+            points.push_back(Point{waypoint.lon() / 1e6 * meters_per_lon_degree, waypoint.lat() / 1e6 * METERS_PER_DEGREE});
+        }
+
+        // Ranges are split at their farthest point until all points of a range are within tolerance from its chord
+        std::vector<bool> is_kept(points.size(), false);
+        is_kept.front() = is_kept.back() = true;
+        std::vector<std::pair<std::size_t, std::size_t>> ranges = {{0, points.size() - 1}};
+        while (!ranges.empty())
+        {
+            auto [first, last] = ranges.back();
+            ranges.pop_back();
+
+            double max_distance = tolerance_meters;
+            std::size_t farthest = first;
+            for (std::size_t i = first + 1; i < last; ++i)
+            {
+                double distance = get_distance_to_segment(points[i], points[first], points[last]);
+                if (distance > max_distance)
+                {
+                    max_distance = distance;
+                    farthest = i;
+                }
+            }
+            if (farthest != first)
+            {
+                is_kept[farthest] = true;
+                ranges.emplace_back(first, farthest);
+                ranges.emplace_back(farthest, last);
+            }
+        }
+
+        Route::Waypoints result;
+        for (std::size_t i = 0; i < waypoints.size(); ++i)
+        {
+            if (is_kept[i])
+            {
+                result.push_back(waypoints[i]);
+            }
+        }
+        return result;
+    }
+}
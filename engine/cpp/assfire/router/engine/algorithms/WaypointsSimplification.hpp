@@ -0,0 +1,15 @@
+#pragma once
+
+#include <span>
+#include "assfire/router/api/Route.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief Simplifies route geometry with Douglas-Peucker algorithm: keeps its first and last waypoints and every waypoint that deviates
+     * by more than tolerance from the simplified line. Distances are measured on local equirectangular projection, which is exact enough at route scale
+     *
+     * \param tolerance_meters Max distance from removed waypoints to the simplified line. Zero keeps all waypoints
+     */
+    Route::Waypoints simplify_waypoints(std::span<const GeoPoint> waypoints, RouteInfo::Meters tolerance_meters);
+}
@@ -0,0 +1,87 @@
+#include "ParallelWorkers.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace assfire::router
+{
+    namespace
+    {
+        std::atomic<std::size_t> extra_threads_count = 0; // Extra threads currently run by all calls
+
+        /**
+         * Reserves up to requested count of extra threads within the cap
+         */
+        std::size_t acquire_extra_threads(std::size_t requested)
+        {
+            std::size_t cap = ParallelWorkers::get_max_workers_count();
+            std::size_t used = extra_threads_count.load();
+            std::size_t granted;
+            do
+            {
+                granted = std::min(requested, used < cap ? cap - used : 0);
+            } while (granted > 0 && !extra_threads_count.compare_exchange_weak(used, used + granted));
+            return granted;
+        }
+    }
+
+    std::size_t ParallelWorkers::get_max_workers_count()
+    {
+        static const std::size_t count = std::max(std::thread::hardware_concurrency(), 1u);
+        return count;
+    }
+
+    void ParallelWorkers::run(std::size_t workers_count, const std::function<void(std::size_t)> &work)
+    {
+        std::size_t extra_count = workers_count > 1 ? acquire_extra_threads(workers_count - 1) : 0;
+
+        std::mutex mutex;
+        std::exception_ptr error;
+        auto run_worker = [&](std::size_t worker_index)
+        {
+            try
+            {
+                work(worker_index);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(extra_count);
+        try
+        {
+            for (std::size_t t = 1; t <= extra_count; ++t)
+            {
+                threads.emplace_back(run_worker, t);
+            }
+        }
+        catch (...)
+        {
+            // Threads that failed to start are not waited for, their items are taken by started workers
+            extra_threads_count -= extra_count - threads.size();
+            extra_count = threads.size();
+        }
+        run_worker(0);
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+        extra_threads_count -= extra_count;
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace assfire::router
+{
+    /**
+     * \brief Runs parallel parts of engine requests on bounded count of threads. Extra threads of all concurrent calls are limited by one
+     * process-wide cap equal to hardware concurrency, so concurrent requests don't oversubscribe the CPU
+     */
+    class ParallelWorkers
+    {
+    public:
+        /**
+         * \brief Returns the largest count of workers one call may get
+         */
+        static std::size_t get_max_workers_count();
+
+        /**
+         * \brief Runs work(worker_index) on the calling thread as worker 0 and on extra threads as workers 1, 2, ... Fewer workers than requested
+         * run when the cap is reached, so work must take its items from a shared counter rather than depend on workers count. Waits for all workers,
+         * then rethrows the first exception thrown by any of them
+         *
+         * \param workers_count Requested count of workers including the calling thread
+         * \param work Function run by each worker. Workers that throw should make the rest stop taking items
+         */
+        static void run(std::size_t workers_count, const std::function<void(std::size_t)> &work);
+    };
+}
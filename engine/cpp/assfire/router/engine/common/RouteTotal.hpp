@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include "assfire/router/api/RouteInfo.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief Sum of route infos of tour legs. Tour with an unreachable leg is unreachable, so its total is infinite distance and travel time.
+     * Partial totals of disjoint parts of a tour may be added in any order
+     */
+    class RouteTotal
+    {
+    public:
+        RouteTotal() = default;
+
+        /**
+         * \brief Construct a new RouteTotal object from sums of distances and travel times of reachable legs, e.g. computed by vector instructions
+         */
+        RouteTotal(RouteInfo::Meters meters, std::int64_t seconds, bool unreachable) : meters(meters), seconds(seconds), unreachable(unreachable)
+        {
+        }
+
+        void add(const RouteInfo &leg)
+        {
+            if (leg.travel_time_seconds() >= RouteInfo::INFINITE_TRAVEL_TIME)
+            {
+                unreachable = true;
+            }
+            else
+            {
+                meters += leg.distance_meters();
+                seconds += leg.travel_time_seconds();
+            }
+        }
+
+        void add(const RouteTotal &rhs)
+        {
+            meters += rhs.meters;
+            seconds += rhs.seconds;
+            unreachable = unreachable || rhs.unreachable;
+        }
+
+        RouteInfo get() const
+        {
+            if (unreachable)
+            {
+                return RouteInfo(RouteInfo::INFINITE_DISTANCE, RouteInfo::INFINITE_TRAVEL_TIME);
+            }
+            return RouteInfo(meters, RouteInfo::Seconds(std::min<std::int64_t>(seconds, RouteInfo::INFINITE_TRAVEL_TIME)));
+        }
+
+    private:
+        RouteInfo::Meters meters = 0;
+        std::int64_t seconds = 0; // Wide, so long tours don't overflow
+        bool unreachable = false;
+    };
+}
@@ -4,6 +4,8 @@
 #include <functional>
 #include <vector>
 #include <memory>
+#include <span>
+#include "assfire/router/api/Isochrone.hpp"
 #include "assfire/router/api/Route.hpp"
 #include "assfire/router/api/RouteMatrix.hpp"
 #include "TransportProfile.hpp"
@@ -15,21 +17,58 @@ namespace assfire::router
     public:
         using MatrixPtr = std::shared_ptr<RouteMatrix>;
         using Waypoints = std::vector<GeoPoint>;
+        // Strategies only read waypoints sequentially so they accept views over any contiguous storage (vectors, parts of request buffers etc.)
+        using WaypointsView = std::span<const GeoPoint>;
         using WaypointsSupplier = std::function<std::optional<GeoPoint>()>;
 
         virtual ~RoutingStrategy() = default;
 
+        /**
+         * \brief Tells if route from A to B is always the same as route from B to A for this strategy, so square matrices may be calculated for a half of cells
+         */
+        virtual bool is_symmetric() const
+        {
+            return false;
+        }
+
+        /**
+         * \brief Tells if travel time of routes is never less than time to travel crowflight distance at profile speed, so routes that can't be short enough
+         * may be skipped by crowflight bounds (see WaypointsGrid) without calculation
+         */
+        virtual bool is_bounded_by_crowflight() const
+        {
+            return false;
+        }
+
         virtual Route calculate_route(const GeoPoint &origin, const GeoPoint &destination, const TransportProfile &profile) const = 0;
         virtual RouteInfo calculate_route_info(const GeoPoint &origin, const GeoPoint &destination, const TransportProfile &profile) const = 0;
         virtual RouteInfo::Meters calculate_distance_meters(const GeoPoint &origin, const GeoPoint &destination, const TransportProfile &profile) const = 0;
         virtual RouteInfo::Seconds calculate_travel_time_seconds(const GeoPoint &origin, const GeoPoint &destination, const TransportProfile &profile) const = 0;
-        virtual MatrixPtr calculate_route_matrix(const Waypoints &waypoints, const TransportProfile &profile) const = 0;
+        virtual MatrixPtr calculate_route_matrix(WaypointsView waypoints, const TransportProfile &profile) const = 0;
         virtual MatrixPtr calculate_route_matrix(WaypointsSupplier waypoints, const TransportProfile &profile) const = 0;
-        virtual MatrixPtr calculate_route_matrix(const Waypoints &origins, const Waypoints &destinations, const TransportProfile &profile) const = 0;
+        virtual MatrixPtr calculate_route_matrix(WaypointsView origins, WaypointsView destinations, const TransportProfile &profile) const = 0;
         virtual MatrixPtr calculate_route_matrix(WaypointsSupplier origins, WaypointsSupplier destinations, const TransportProfile &profile) const = 0;
-        virtual std::vector<Route> calculate_routes_vector(const Waypoints &waypoints, const TransportProfile &profile) = 0;
-        virtual void calculate_routes_vector(const Waypoints &waypoints, std::function<void(Route)> consume_route, const TransportProfile &profile) = 0;
-        virtual std::vector<RouteInfo> calculate_route_infos_vector(const Waypoints &waypoints, const TransportProfile &profile) = 0;
-        virtual void calculate_route_infos_vector(const Waypoints &waypoints, std::function<void(RouteInfo)> consume_route_info, const TransportProfile &profile) = 0;
+        virtual std::vector<Route> calculate_routes_vector(WaypointsView waypoints, const TransportProfile &profile) = 0;
+        virtual void calculate_routes_vector(WaypointsView waypoints, std::function<void(Route)> consume_route, const TransportProfile &profile) = 0;
+        virtual std::vector<RouteInfo> calculate_route_infos_vector(WaypointsView waypoints, const TransportProfile &profile) = 0;
+        virtual void calculate_route_infos_vector(WaypointsView waypoints, std::function<void(RouteInfo)> consume_route_info, const TransportProfile &profile) = 0;
+
+        /**
+         * \brief Calculates total distance and travel time of legs between consecutive waypoints without materializing route infos of legs (see RouteTotal).
+         * Legs depart the same way as legs of routes vectors do
+         */
+        virtual RouteInfo calculate_routes_vector_total(WaypointsView waypoints, const TransportProfile &profile) const = 0;
+
+        /**
+         * \brief Calculates stack of matrices between the same origins and destinations, one for each departure time (departure time of profile is ignored).
+         * Strategies may share work between departure slices, e.g. snap waypoints once or run one search per origin for all slices
+         */
+        virtual std::vector<MatrixPtr> calculate_route_matrices(WaypointsView origins, WaypointsView destinations,
+                                                                std::span<const TransportProfile::Timestamp> departure_times, const TransportProfile &profile) const = 0;
+
+        /**
+         * \brief Calculates points reachable from origin within max travel time. Throws std::invalid_argument if strategy can't enumerate reachable points
+         */
+        virtual Isochrone calculate_isochrone(const GeoPoint &origin, RouteInfo::Seconds max_travel_time_seconds, const TransportProfile &profile) const = 0;
     };
 }
\ No newline at end of file
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstdint>
+#include <optional>
+#include <string>
 #include "assfire/router/api/RouteInfo.hpp"
 
 namespace assfire::router
@@ -8,6 +11,7 @@ namespace assfire::router
     {
     public:
         using MetersPerSecond = RouteInfo::Meters;
+        using Timestamp = std::int64_t; // Seconds since Unix epoch
 
         TransportProfile() = default;
 
@@ -15,6 +19,16 @@ namespace assfire::router
         {
         }
 
+        /**
+         * \brief Construct a new TransportProfile object
+         *
+         * \param speed_meters_per_second Max speed of represented vehicle
+         * \param metric Name of road graph metric (edge travel times) represented vehicle uses. Empty name means the default metric of routing strategy
+         */
+        TransportProfile(MetersPerSecond speed_meters_per_second, std::string metric) : _speed(speed_meters_per_second), _metric(std::move(metric))
+        {
+        }
+
         TransportProfile(const TransportProfile& rhs) = default;
         TransportProfile(TransportProfile&& rhs) = default;
 
@@ -33,6 +47,44 @@ namespace assfire::router
             this->_speed = speed;
         }
 
+        const std::string &metric() const
+        {
+            return _metric;
+        }
+
+        void set_metric(std::string metric)
+        {
+            this->_metric = std::move(metric);
+        }
+
+        /**
+         * \brief Time represented vehicle departs at. Strategies with time-dependent travel times use it, the rest ignore it.
+         * Profiles provided by TransportProfileProvider have no departure time, it is set per request
+         */
+        const std::optional<Timestamp> &departure_time() const
+        {
+            return _departure_time;
+        }
+
+        void set_departure_time(std::optional<Timestamp> departure_time)
+        {
+            this->_departure_time = departure_time;
+        }
+
+        /**
+         * \brief Max distance route waypoints may deviate from road geometry, e.g. for map previews. Strategies with detailed geometry
+         * simplify waypoints to it, zero keeps full detail. Profiles provided by TransportProfileProvider keep full detail, tolerance is set per request
+         */
+        RouteInfo::Meters geometry_tolerance_meters() const
+        {
+            return _geometry_tolerance_meters;
+        }
+
+        void set_geometry_tolerance_meters(RouteInfo::Meters tolerance_meters)
+        {
+            this->_geometry_tolerance_meters = tolerance_meters;
+        }
+
         /**
          * \brief Calculates time needed to travel specified distance using represented vehicle
          *
@@ -46,5 +98,8 @@ namespace assfire::router
 
     private:
         MetersPerSecond _speed = 0;
+        std::string _metric;
+        std::optional<Timestamp> _departure_time;
+        RouteInfo::Meters _geometry_tolerance_meters = 0;
     };
 }
\ No newline at end of file
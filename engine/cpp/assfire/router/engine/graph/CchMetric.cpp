@@ -0,0 +1,541 @@
+#include "CchMetric.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+
+namespace assfire::router
+{
+    namespace
+    {
+        constexpr std::uint32_t NO_POSITION = std::numeric_limits<std::uint32_t>::max();
+
+        /**
+         * Distance from point to segment on local equirectangular projection, which is exact enough at shortcut scale
+         */
+        float get_deviation_meters(const GeoPoint &point, const GeoPoint &begin, const GeoPoint &end)
+        {
+            constexpr double METERS_PER_DEGREE = 6371000.0 * 3.14159265359 / 180;
+            double meters_per_lat_unit = METERS_PER_DEGREE / 1e6;
+            double meters_per_lon_unit = meters_per_lat_unit * std::cos(begin.lat() / 1e6 * 3.14159265359 / 180);
+            double dx = double(end.lon() - begin.lon()) * meters_per_lon_unit;
+            double dy = double(end.lat() - begin.lat()) * meters_per_lat_unit;
+            double px = double(point.lon() - begin.lon()) * meters_per_lon_unit;
+            double py = double(point.lat() - begin.lat()) * meters_per_lat_unit;
+            double squared_length = dx * dx + dy * dy;
+            double fraction = squared_length > 0 ? std::clamp((px * dx + py * dy) / squared_length, 0.0, 1.0) : 0;
+            return float(std::hypot(px - fraction * dx, py - fraction * dy));
+        }
+    }
+
+    /**
+     * Per-rank search labels of the current thread reused between queries. Only ranks of the current search chains are initialized
+     */
+    struct CchMetric::QueryWorkspace
+    {
+        static QueryWorkspace &acquire(std::size_t ranks_count)
+        {
+            thread_local QueryWorkspace workspace;
+            if (workspace.marks.size() < ranks_count)
+            {
+                workspace.forward.resize(ranks_count);
+                workspace.backward.resize(ranks_count);
+                workspace.marks.resize(ranks_count, 0);
+                workspace.positions.resize(ranks_count, NO_POSITION);
+            }
+            return workspace;
+        }
+
+        std::vector<Label> forward;
+        std::vector<Label> backward;
+        std::vector<std::uint8_t> marks;        // Always cleared after use
+        std::vector<std::uint32_t> positions; // Positions of ranks in sweep selection, always reset after use
+        std::vector<Rank> forward_chain;
+        std::vector<Rank> backward_chain;
+    };
+
+    CchMetric::CchMetric(std::shared_ptr<const CchTopology> topology, const std::string &metric, double max_speed_meters_per_second, std::size_t threads_count)
+        : _topology(topology),
+          metric(metric),
+          max_speed_meters_per_second(std::max(max_speed_meters_per_second, 0.0)),
+          geometry_cache(std::make_unique<ShortcutGeometryCache>())
+    {
+        if (!topology)
+        {
+            throw std::invalid_argument("Contraction hierarchy metric requires topology");
+        }
+        const RoadGraph &graph = topology->graph();
+        if (graph.edges_count() >= EDGE_VIA_FLAG)
+        {
+            throw std::invalid_argument("Road graph " + graph.path() + " has too many edges for contraction hierarchy");
+        }
+
+        std::span<const Weight> weights = graph.get_weights(metric);
+        upward.resize(topology->arcs_count());
+        downward.resize(topology->arcs_count());
+        for (NodeId node = 0; node < graph.nodes_count(); ++node)
+        {
+            for (EdgeId edge = graph.edges_begin(node); edge < graph.edges_end(node); ++edge)
+            {
+                ArcId arc = topology->get_edge_arc(edge);
+                if (arc == CchTopology::NO_ARC)
+                {
+                    continue;
+                }
+                ArcPath &path = topology->get_rank(node) < topology->get_rank(graph.get_edge_target(edge)) ? upward[arc] : downward[arc];
+                Weight weight = RoadGraph::limit_by_speed(weights[edge], graph.get_edge_length(edge), this->max_speed_meters_per_second);
+                if (weight < path.weight) // Parallel edges are reduced to the fastest one
+                {
+                    path = ArcPath{weight, graph.get_edge_length(edge), edge | EDGE_VIA_FLAG};
+                }
+            }
+        }
+
+        topology->for_each_rank_by_levels(false, threads_count, [this](Rank rank)
+                                          { customize_rank(rank); });
+    }
+
+    std::uint64_t CchMetric::get_fingerprint() const
+    {
+        // FNV-1a
+        std::uint64_t result = 14695981039346656037ull;
+        auto add = [&](std::uint32_t value)
+        {
+            for (int byte = 0; byte < 4; ++byte)
+            {
+                result = (result ^ ((value >> (8 * byte)) & 0xFF)) * 1099511628211ull;
+            }
+        };
+        add(_topology->ranks_count());
+        for (ArcId arc = 0; arc < _topology->arcs_count(); ++arc)
+        {
+            add(_topology->get_arc_head(arc));
+            add(upward[arc].weight);
+            add(upward[arc].length);
+            add(downward[arc].weight);
+            add(downward[arc].length);
+        }
+        return result;
+    }
+
+    void CchMetric::customize_rank(Rank rank)
+    {
+        const CchTopology &topology = *_topology;
+        for (ArcId lower_arc : topology.get_down_arcs(rank))
+        {
+            const ArcPath &to_lower = downward[lower_arc];
+            const ArcPath &from_lower = upward[lower_arc];
+            Rank lower = topology.get_arc_tail(lower_arc);
+
+            // Arcs of the lower rank following the one to this rank lead to higher ranks, which are all upper neighbors of this rank too
+            ArcId arc = topology.up_arcs_begin(rank);
+            for (ArcId lower_upper_arc = lower_arc + 1; lower_upper_arc < topology.up_arcs_end(lower); ++lower_upper_arc)
+            {
+                while (topology.get_arc_head(arc) < topology.get_arc_head(lower_upper_arc))
+                {
+                    ++arc;
+                }
+
+                const ArcPath &lower_to_upper = upward[lower_upper_arc];
+                const ArcPath &upper_to_lower = downward[lower_upper_arc];
+                // Path through the lower rank stays within deviation of its halves from the line through the lower rank,
+                // which is in turn within distance of the lower rank from the line between ends of the arc
+                auto get_middle_deviation_meters = [&]
+                {
+                    const RoadGraph &graph = topology.graph();
+                    return get_deviation_meters(graph.get_node_location(topology.get_node(lower)), graph.get_node_location(topology.get_node(rank)),
+                                                graph.get_node_location(topology.get_node(topology.get_arc_head(arc))));
+                };
+                if (to_lower.weight != RoadGraph::INFINITE_WEIGHT && lower_to_upper.weight != RoadGraph::INFINITE_WEIGHT &&
+                    std::uint64_t(to_lower.weight) + lower_to_upper.weight < upward[arc].weight)
+                {
+                    upward[arc] = ArcPath{to_lower.weight + lower_to_upper.weight, to_lower.length + lower_to_upper.length, lower,
+                                          std::max(to_lower.deviation_meters, lower_to_upper.deviation_meters) + get_middle_deviation_meters()};
+                }
+                if (upper_to_lower.weight != RoadGraph::INFINITE_WEIGHT && from_lower.weight != RoadGraph::INFINITE_WEIGHT &&
+                    std::uint64_t(upper_to_lower.weight) + from_lower.weight < downward[arc].weight)
+                {
+                    downward[arc] = ArcPath{upper_to_lower.weight + from_lower.weight, upper_to_lower.length + from_lower.length, lower,
+                                            std::max(upper_to_lower.deviation_meters, from_lower.deviation_meters) + get_middle_deviation_meters()};
+                }
+            }
+        }
+    }
+
+    void CchMetric::sweep(std::span<const Seed> seeds, bool is_forward, std::vector<Rank> &chain, std::vector<Label> &labels, std::vector<std::uint8_t> &marks) const
+    {
+        const CchTopology &topology = *_topology;
+
+        // Search space of a rank is the chain of its ancestors in elimination tree: all its upper neighbors are there
+        chain.clear();
+        for (const Seed &seed : seeds)
+        {
+            for (Rank rank = topology.get_rank(seed.node); rank != CchTopology::NO_RANK && !marks[rank]; rank = topology.get_parent(rank))
+            {
+                marks[rank] = 1;
+                chain.push_back(rank);
+            }
+        }
+        for (Rank rank : chain)
+        {
+            marks[rank] = 0;
+            labels[rank] = Label{RoadGraph::INFINITE_WEIGHT, 0, CchTopology::NO_ARC};
+        }
+        std::sort(chain.begin(), chain.end());
+
+        for (const Seed &seed : seeds)
+        {
+            Label &label = labels[topology.get_rank(seed.node)];
+            if (seed.weight < label.weight)
+            {
+                label = Label{seed.weight, seed.length, CchTopology::NO_ARC};
+            }
+        }
+
+        const std::vector<ArcPath> &paths = is_forward ? upward : downward;
+        for (Rank rank : chain)
+        {
+            const Label label = labels[rank];
+            if (label.weight == RoadGraph::INFINITE_WEIGHT)
+            {
+                continue;
+            }
+            for (ArcId arc = topology.up_arcs_begin(rank); arc < topology.up_arcs_end(rank); ++arc)
+            {
+                if (paths[arc].weight == RoadGraph::INFINITE_WEIGHT)
+                {
+                    continue;
+                }
+                Label &head_label = labels[topology.get_arc_head(arc)];
+                if (label.weight + paths[arc].weight < head_label.weight)
+                {
+                    head_label = Label{label.weight + paths[arc].weight, label.length + paths[arc].length, arc};
+                }
+            }
+        }
+    }
+
+    void CchMetric::get_search_space(NodeId node, bool is_forward, std::vector<SearchSpaceEntry> &result) const
+    {
+        QueryWorkspace &workspace = QueryWorkspace::acquire(_topology->ranks_count());
+        std::vector<Label> &labels = is_forward ? workspace.forward : workspace.backward;
+        std::vector<Rank> &chain = is_forward ? workspace.forward_chain : workspace.backward_chain;
+        Seed seed{node, 0, 0};
+        sweep(std::span<const Seed>(&seed, 1), is_forward, chain, labels, workspace.marks);
+
+        result.clear();
+        for (Rank rank : chain)
+        {
+            if (labels[rank].weight < RoadGraph::INFINITE_WEIGHT)
+            {
+                result.push_back(SearchSpaceEntry{rank, Weight(labels[rank].weight), Length(labels[rank].length)});
+            }
+        }
+    }
+
+    CchMetric::Path CchMetric::find_path(std::span<const Seed> sources, std::span<const Seed> targets, std::vector<NodeId> *nodes, double tolerance_meters) const
+    {
+        const CchTopology &topology = *_topology;
+        QueryWorkspace &workspace = QueryWorkspace::acquire(topology.ranks_count());
+        sweep(sources, true, workspace.forward_chain, workspace.forward, workspace.marks);
+        sweep(targets, false, workspace.backward_chain, workspace.backward, workspace.marks);
+
+        // Paths meet at a common ancestor of source and target ranks
+        Path result;
+        Rank meeting_rank = CchTopology::NO_RANK;
+        for (Rank rank : workspace.forward_chain)
+        {
+            workspace.marks[rank] = 1;
+        }
+        for (Rank rank : workspace.backward_chain)
+        {
+            const Label &forward = workspace.forward[rank];
+            const Label &backward = workspace.backward[rank];
+            if (workspace.marks[rank] && forward.weight != RoadGraph::INFINITE_WEIGHT && backward.weight != RoadGraph::INFINITE_WEIGHT &&
+                forward.weight + backward.weight < result.weight)
+            {
+                result = Path{forward.weight + backward.weight, forward.length + backward.length};
+                meeting_rank = rank;
+            }
+        }
+        for (Rank rank : workspace.forward_chain)
+        {
+            workspace.marks[rank] = 0;
+        }
+
+        if (nodes && result.exists())
+        {
+            std::vector<ArcId> forward_arcs;
+            Rank rank = meeting_rank;
+            for (; workspace.forward[rank].arc != CchTopology::NO_ARC; rank = topology.get_arc_tail(workspace.forward[rank].arc))
+            {
+                forward_arcs.push_back(workspace.forward[rank].arc);
+            }
+            nodes->push_back(topology.get_node(rank));
+            for (auto iter = forward_arcs.rbegin(); iter != forward_arcs.rend(); ++iter)
+            {
+                unpack_arc(*iter, true, tolerance_meters, *nodes);
+            }
+            for (rank = meeting_rank; workspace.backward[rank].arc != CchTopology::NO_ARC; rank = topology.get_arc_tail(workspace.backward[rank].arc))
+            {
+                unpack_arc(workspace.backward[rank].arc, false, tolerance_meters, *nodes);
+            }
+        }
+        return result;
+    }
+
+    std::vector<CchMetric::Path> CchMetric::find_paths(std::span<const std::span<const Seed>> sources, std::span<const std::span<const Seed>> targets) const
+    {
+        if (targets.size() >= ONE_TO_MANY_TARGETS_THRESHOLD)
+        {
+            return find_paths_by_sweep(sources, targets);
+        }
+
+        struct SpaceEntry
+        {
+            Rank rank;
+            std::uint64_t weight;
+            std::uint64_t length;
+        };
+
+        QueryWorkspace &workspace = QueryWorkspace::acquire(_topology->ranks_count());
+
+        std::vector<std::vector<SpaceEntry>> target_spaces(targets.size());
+        for (std::size_t j = 0; j < targets.size(); ++j)
+        {
+            sweep(targets[j], false, workspace.backward_chain, workspace.backward, workspace.marks);
+            for (Rank rank : workspace.backward_chain)
+            {
+                if (workspace.backward[rank].weight != RoadGraph::INFINITE_WEIGHT)
+                {
+                    target_spaces[j].push_back(SpaceEntry{rank, workspace.backward[rank].weight, workspace.backward[rank].length});
+                }
+            }
+        }
+
+        std::vector<Path> result(sources.size() * targets.size());
+        for (std::size_t i = 0; i < sources.size(); ++i)
+        {
+            sweep(sources[i], true, workspace.forward_chain, workspace.forward, workspace.marks);
+            for (Rank rank : workspace.forward_chain)
+            {
+                workspace.marks[rank] = workspace.forward[rank].weight != RoadGraph::INFINITE_WEIGHT;
+            }
+
+            for (std::size_t j = 0; j < targets.size(); ++j)
+            {
+                Path &path = result[i * targets.size() + j];
+                for (const SpaceEntry &entry : target_spaces[j])
+                {
+                    if (workspace.marks[entry.rank] && workspace.forward[entry.rank].weight + entry.weight < path.weight)
+                    {
+                        path = Path{workspace.forward[entry.rank].weight + entry.weight, workspace.forward[entry.rank].length + entry.length};
+                    }
+                }
+            }
+
+            for (Rank rank : workspace.forward_chain)
+            {
+                workspace.marks[rank] = 0;
+            }
+        }
+        return result;
+    }
+
+    std::vector<CchMetric::Path> CchMetric::find_paths_to_all(std::span<const Seed> sources) const
+    {
+        const CchTopology &topology = *_topology;
+        QueryWorkspace &workspace = QueryWorkspace::acquire(topology.ranks_count());
+        sweep(sources, true, workspace.forward_chain, workspace.forward, workspace.marks);
+
+        std::vector<Path> paths(topology.ranks_count());
+        for (Rank rank : workspace.forward_chain)
+        {
+            if (workspace.forward[rank].weight != RoadGraph::INFINITE_WEIGHT)
+            {
+                paths[rank] = Path{workspace.forward[rank].weight, workspace.forward[rank].length};
+            }
+        }
+
+        // Upper neighbors of a rank are final when the sweep reaches it, as paths to them only go down from the upward search space
+        for (Rank rank = topology.ranks_count(); rank-- > 0;)
+        {
+            Path &path = paths[rank];
+            for (ArcId arc = topology.up_arcs_begin(rank); arc < topology.up_arcs_end(rank); ++arc)
+            {
+                const Path &head_path = paths[topology.get_arc_head(arc)];
+                if (head_path.exists() && downward[arc].weight != RoadGraph::INFINITE_WEIGHT && head_path.weight + downward[arc].weight < path.weight)
+                {
+                    path = Path{head_path.weight + downward[arc].weight, head_path.length + downward[arc].length};
+                }
+            }
+        }
+
+        std::vector<Path> result(topology.ranks_count());
+        for (Rank rank = 0; rank < topology.ranks_count(); ++rank)
+        {
+            result[topology.get_node(rank)] = paths[rank];
+        }
+        return result;
+    }
+
+    void CchMetric::select_sweep(std::span<const std::span<const Seed>> targets, SweepSelection &selection, std::vector<std::uint32_t> &positions) const
+    {
+        const CchTopology &topology = *_topology;
+
+        // Upper neighbors of a rank are its ancestors, so every downward arc leading to a selected rank starts at a selected rank
+        selection.ranks.clear();
+        for (std::span<const Seed> group : targets)
+        {
+            for (const Seed &seed : group)
+            {
+                for (Rank rank = topology.get_rank(seed.node); rank != CchTopology::NO_RANK && positions[rank] == NO_POSITION; rank = topology.get_parent(rank))
+                {
+                    positions[rank] = 0;
+                    selection.ranks.push_back(rank);
+                }
+            }
+        }
+        std::sort(selection.ranks.begin(), selection.ranks.end(), std::greater<Rank>());
+
+        selection.arcs_offsets.clear();
+        selection.arcs.clear();
+        for (std::uint32_t position = 0; position < selection.ranks.size(); ++position)
+        {
+            Rank rank = selection.ranks[position];
+            positions[rank] = position;
+            selection.arcs_offsets.push_back(selection.arcs.size());
+            for (ArcId arc = topology.up_arcs_begin(rank); arc < topology.up_arcs_end(rank); ++arc)
+            {
+                if (downward[arc].weight != RoadGraph::INFINITE_WEIGHT)
+                {
+                    selection.arcs.push_back(SweepArc{positions[topology.get_arc_head(arc)], downward[arc].weight, downward[arc].length});
+                }
+            }
+        }
+        selection.arcs_offsets.push_back(selection.arcs.size());
+    }
+
+    std::vector<CchMetric::Path> CchMetric::find_paths_by_sweep(std::span<const std::span<const Seed>> sources, std::span<const std::span<const Seed>> targets) const
+    {
+        const CchTopology &topology = *_topology;
+        QueryWorkspace &workspace = QueryWorkspace::acquire(topology.ranks_count());
+        SweepSelection selection;
+        select_sweep(targets, selection, workspace.positions);
+
+        std::vector<Weight> weights(selection.ranks.size() * SWEEP_LANES);
+        std::vector<Length> lengths(selection.ranks.size() * SWEEP_LANES);
+        std::vector<Path> result(sources.size() * targets.size());
+        for (std::size_t first_source = 0; first_source < sources.size(); first_source += SWEEP_LANES)
+        {
+            std::size_t lanes_count = std::min(SWEEP_LANES, sources.size() - first_source);
+            std::fill(weights.begin(), weights.end(), RoadGraph::INFINITE_WEIGHT);
+            std::fill(lengths.begin(), lengths.end(), 0);
+            for (std::size_t lane = 0; lane < lanes_count; ++lane)
+            {
+                sweep(sources[first_source + lane], true, workspace.forward_chain, workspace.forward, workspace.marks);
+                for (Rank rank : workspace.forward_chain)
+                {
+                    std::uint32_t position = workspace.positions[rank];
+                    if (position != NO_POSITION && workspace.forward[rank].weight < RoadGraph::INFINITE_WEIGHT)
+                    {
+                        weights[position * SWEEP_LANES + lane] = Weight(workspace.forward[rank].weight);
+                        lengths[position * SWEEP_LANES + lane] = Length(workspace.forward[rank].length);
+                    }
+                }
+            }
+
+            for (std::size_t position = 0; position < selection.ranks.size(); ++position)
+            {
+                // Lanes of the current rank are kept in locals, so the compiler knows they don't alias lanes of upper ranks
+                Weight rank_weights[SWEEP_LANES];
+                Length rank_lengths[SWEEP_LANES];
+                std::copy_n(&weights[position * SWEEP_LANES], SWEEP_LANES, rank_weights);
+                std::copy_n(&lengths[position * SWEEP_LANES], SWEEP_LANES, rank_lengths);
+                for (std::uint32_t i = selection.arcs_offsets[position]; i < selection.arcs_offsets[position + 1]; ++i)
+                {
+                    const SweepArc &arc = selection.arcs[i];
+                    const Weight *head_weights = &weights[arc.head * SWEEP_LANES];
+                    const Length *head_lengths = &lengths[arc.head * SWEEP_LANES];
+                    for (std::size_t lane = 0; lane < SWEEP_LANES; ++lane)
+                    {
+                        Weight weight = head_weights[lane] + arc.weight;
+                        weight = weight < head_weights[lane] ? RoadGraph::INFINITE_WEIGHT : weight; // Saturates on overflow of infinite weight
+                        bool is_shorter = weight < rank_weights[lane];
+                        rank_weights[lane] = is_shorter ? weight : rank_weights[lane];
+                        rank_lengths[lane] = is_shorter ? head_lengths[lane] + arc.length : rank_lengths[lane];
+                    }
+                }
+                std::copy_n(rank_weights, SWEEP_LANES, &weights[position * SWEEP_LANES]);
+                std::copy_n(rank_lengths, SWEEP_LANES, &lengths[position * SWEEP_LANES]);
+            }
+
+            for (std::size_t j = 0; j < targets.size(); ++j)
+            {
+                for (const Seed &seed : targets[j])
+                {
+                    std::uint32_t position = workspace.positions[topology.get_rank(seed.node)];
+                    for (std::size_t lane = 0; lane < lanes_count; ++lane)
+                    {
+                        Weight weight = weights[position * SWEEP_LANES + lane];
+                        Path &path = result[(first_source + lane) * targets.size() + j];
+                        if (weight != RoadGraph::INFINITE_WEIGHT && std::uint64_t(weight) + seed.weight < path.weight)
+                        {
+                            path = Path{std::uint64_t(weight) + seed.weight, std::uint64_t(lengths[position * SWEEP_LANES + lane]) + seed.length};
+                        }
+                    }
+                }
+            }
+        }
+
+        for (Rank rank : selection.ranks)
+        {
+            workspace.positions[rank] = NO_POSITION;
+        }
+        return result;
+    }
+
+    void CchMetric::unpack_arc(ArcId arc, bool is_upward, double tolerance_meters, std::vector<NodeId> &nodes) const
+    {
+        const ArcPath &path = is_upward ? upward[arc] : downward[arc];
+        if (path.via & EDGE_VIA_FLAG)
+        {
+            nodes.push_back(_topology->graph().get_edge_target(path.via & ~EDGE_VIA_FLAG));
+            return;
+        }
+        if (tolerance_meters > 0 && path.deviation_meters <= tolerance_meters)
+        {
+            // Whole shortcut is close enough to the line between its ends, so only its last node is kept
+            nodes.push_back(_topology->get_node(is_upward ? _topology->get_arc_head(arc) : _topology->get_arc_tail(arc)));
+            return;
+        }
+        if (ShortcutGeometryCache::Nodes cached = geometry_cache->get(arc, is_upward))
+        {
+            nodes.insert(nodes.end(), cached->begin(), cached->end());
+            return;
+        }
+        std::size_t unpacked_begin = nodes.size();
+
+        // Shortcut goes through the middle rank of a lower triangle
+        Rank middle = path.via;
+        ArcId tail_arc = _topology->find_arc(middle, _topology->get_arc_tail(arc));
+        ArcId head_arc = _topology->find_arc(middle, _topology->get_arc_head(arc));
+        if (is_upward)
+        {
+            unpack_arc(tail_arc, false, tolerance_meters, nodes);
+            unpack_arc(head_arc, true, tolerance_meters, nodes);
+        }
+        else
+        {
+            unpack_arc(head_arc, false, tolerance_meters, nodes);
+            unpack_arc(tail_arc, true, tolerance_meters, nodes);
+        }
+
+        // Only complete geometry is cached, simplified one depends on tolerance
+        if (tolerance_meters <= 0 && nodes.size() - unpacked_begin >= ShortcutGeometryCache::MIN_CACHED_NODES)
+        {
+            geometry_cache->put(arc, is_upward, std::make_shared<const std::vector<NodeId>>(nodes.begin() + unpacked_begin, nodes.end()));
+        }
+    }
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+#include "CchTopology.hpp"
+#include "ShortcutGeometryCache.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief Arc weights of contraction hierarchy topology customized for one graph metric and vehicle speed limit, and shortest path queries over them.
+     *
+     * \details Customization processes ranks bottom-up by elimination tree levels: each arc is relaxed through the lower triangles it closes.
+     * Ranks of one level don't depend on each other, so they are customized in parallel. Customized metric takes a few arrays per arc
+     * and shares topology with all other metrics of the same graph.
+     *
+     * Queries are elimination tree searches: each direction scans ancestors of its seed ranks without priority queue.
+     * One-to-many queries scan ancestors of the sources upwards and then sweep ranks downwards in a single linear pass (PHAST),
+     * restricted to ancestors of the targets when targets are known (RPHAST).
+     * Nodes of unpacked long shortcuts are cached, so paths with nodes don't unpack the top of the hierarchy again and again.
+     * Metric is immutable after construction apart from the thread-safe cache, so it may be used from any number of threads
+     */
+    class CchMetric
+    {
+    public:
+        using NodeId = RoadGraph::NodeId;
+        using EdgeId = RoadGraph::EdgeId;
+        using Weight = RoadGraph::Weight;
+        using Length = RoadGraph::Length;
+        using Rank = CchTopology::Rank;
+        using ArcId = CchTopology::ArcId;
+
+        /**
+         * \brief Min count of target groups many-to-many queries switch from searches per target to a downward sweep over their ancestors
+         */
+        static constexpr std::size_t ONE_TO_MANY_TARGETS_THRESHOLD = 128;
+
+        /**
+         * \brief Graph node a search starts from or ends at with initial weight and length, e.g. of the part of road between waypoint and the node
+         */
+        struct Seed
+        {
+            NodeId node;
+            Weight weight;
+            Length length;
+        };
+
+        /**
+         * \brief Shortest path summary. Weight is RoadGraph::INFINITE_WEIGHT if path doesn't exist
+         */
+        struct Path
+        {
+            std::uint64_t weight = RoadGraph::INFINITE_WEIGHT;
+            std::uint64_t length = 0;
+
+            bool exists() const
+            {
+                return weight != RoadGraph::INFINITE_WEIGHT;
+            }
+        };
+
+        /**
+         * \brief Rank reached by elimination tree search with weight and length of the path found to or from it
+         */
+        struct SearchSpaceEntry
+        {
+            Rank rank;
+            Weight weight;
+            Length length;
+        };
+
+        /**
+         * \brief Customizes topology for the metric
+         *
+         * \param topology Contraction hierarchy topology of the graph
+         * \param metric Name of graph metric to use edge travel times of
+         * \param max_speed_meters_per_second Speed limiting edge travel times from below. Zero doesn't limit travel times
+         * \param threads_count Count of threads to customize with. Zero means hardware concurrency
+         */
+        CchMetric(std::shared_ptr<const CchTopology> topology, const std::string &metric, double max_speed_meters_per_second, std::size_t threads_count = 0);
+
+        CchMetric(const CchMetric &rhs) = delete;
+        CchMetric &operator=(const CchMetric &rhs) = delete;
+
+        /**
+         * \brief Finds shortest path from any source to any target. Path weight and length include ones of the seeds it starts and ends with
+         *
+         * \param nodes If not null, receives graph nodes of the path from its source seed node to its target seed node
+         * \param tolerance_meters Max distance from nodes that may be left out to the line of the nodes kept. Shortcuts whose geometry deviates from
+         * the line between their end nodes by no more than tolerance are not unpacked, so previews of long routes are cheap. Zero unpacks all nodes
+         */
+        Path find_path(std::span<const Seed> sources, std::span<const Seed> targets, std::vector<NodeId> *nodes, double tolerance_meters = 0) const;
+
+        /**
+         * \brief Finds shortest paths from each group of sources to each group of targets. Result is ordered by source group first.
+         * Searches run once per group, so this is much faster than finding each path separately. With many target groups paths are found by sweeping
+         * ancestors of all targets downwards for several source groups at a time
+         */
+        std::vector<Path> find_paths(std::span<const std::span<const Seed>> sources, std::span<const std::span<const Seed>> targets) const;
+
+        /**
+         * \brief Finds shortest paths from any source to every graph node with a single downward sweep over all ranks. Result is indexed by node
+         */
+        std::vector<Path> find_paths_to_all(std::span<const Seed> sources) const;
+
+        /**
+         * \brief Returns ranks reached by elimination tree search from (forward) or to (backward) specified node ordered by rank.
+         * Paths to the ranks that are the highest on shortest paths from or to the node are shortest ones, the rest may be longer
+         */
+        void get_search_space(NodeId node, bool is_forward, std::vector<SearchSpaceEntry> &result) const;
+
+        const CchTopology &topology() const
+        {
+            return *_topology;
+        }
+
+        const std::string &get_metric() const
+        {
+            return metric;
+        }
+
+        double get_max_speed_meters_per_second() const
+        {
+            return max_speed_meters_per_second;
+        }
+
+        /**
+         * \brief Returns hash of topology arcs and their customized weights and lengths. Equal fingerprints identify the same customization
+         * of the same graph, e.g. to tell if data derived from a metric by an interrupted preprocessing run may be reused
+         */
+        std::uint64_t get_fingerprint() const;
+
+    private:
+        static constexpr std::uint32_t EDGE_VIA_FLAG = std::uint32_t(1) << 31;
+        static constexpr std::uint32_t NO_VIA = std::numeric_limits<std::uint32_t>::max();
+
+        /**
+         * Customized shortest path along an arc in one direction. Via is either original edge id marked with EDGE_VIA_FLAG
+         * or the middle rank of the lower triangle the path goes through. Deviation is an upper bound of distance from nodes of the path
+         * to the line between its end nodes
+         */
+        struct ArcPath
+        {
+            Weight weight = RoadGraph::INFINITE_WEIGHT;
+            Length length = 0;
+            std::uint32_t via = NO_VIA;
+            float deviation_meters = 0;
+        };
+
+        /**
+         * Best known path between search seeds and a rank, ending with specified arc
+         */
+        struct Label
+        {
+            std::uint64_t weight;
+            std::uint64_t length;
+            ArcId arc;
+        };
+
+        /**
+         * Count of source groups downward sweep processes at once. Per-rank weights and lengths of all groups are adjacent, so each arc is relaxed
+         * for all of them with vector instructions
+         */
+        static constexpr std::size_t SWEEP_LANES = 8;
+
+        /**
+         * Downward arc of sweep selection with its head renumbered to position in the selection
+         */
+        struct SweepArc
+        {
+            std::uint32_t head;
+            Weight weight;
+            Length length;
+        };
+
+        /**
+         * Ranks downward sweep passes in descending order with their finite downward arcs grouped by rank
+         */
+        struct SweepSelection
+        {
+            std::vector<Rank> ranks;
+            std::vector<std::uint32_t> arcs_offsets;
+            std::vector<SweepArc> arcs;
+        };
+
+        struct QueryWorkspace;
+
+        void customize_rank(Rank rank);
+        void select_sweep(std::span<const std::span<const Seed>> targets, SweepSelection &selection, std::vector<std::uint32_t> &positions) const;
+        std::vector<Path> find_paths_by_sweep(std::span<const std::span<const Seed>> sources, std::span<const std::span<const Seed>> targets) const;
+        void sweep(std::span<const Seed> seeds, bool is_forward, std::vector<Rank> &chain, std::vector<Label> &labels, std::vector<std::uint8_t> &marks) const;
+        void unpack_arc(ArcId arc, bool is_upward, double tolerance_meters, std::vector<NodeId> &nodes) const;
+
+        std::shared_ptr<const CchTopology> _topology;
+        std::string metric;
+        double max_speed_meters_per_second;
+        std::vector<ArcPath> upward;   // From tail to head of each arc
+        std::vector<ArcPath> downward; // From head to tail of each arc
+        std::unique_ptr<ShortcutGeometryCache> geometry_cache;
+    };
+}
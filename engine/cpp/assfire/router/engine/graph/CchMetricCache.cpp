@@ -0,0 +1,63 @@
+#include "CchMetricCache.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace assfire::router
+{
+    CchMetricCache::CchMetricCache(std::shared_ptr<const CchTopology> topology, std::size_t capacity) : _topology(topology),
+                                                                                                        capacity(std::max<std::size_t>(capacity, 1))
+    {
+        if (!topology)
+        {
+            throw std::invalid_argument("Contraction hierarchy metric cache requires topology");
+        }
+    }
+
+    std::shared_ptr<const CchMetric> CchMetricCache::get(const std::string &metric, double max_speed_meters_per_second)
+    {
+        Key key(metric, std::max(max_speed_meters_per_second, 0.0));
+        std::promise<std::shared_ptr<const CchMetric>> promise;
+        std::shared_future<std::shared_ptr<const CchMetric>> future;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto iter = entries.find(key);
+            if (iter != entries.end())
+            {
+                iter->second.last_use = ++uses_count;
+                future = iter->second.metric;
+            }
+            else
+            {
+                if (entries.size() >= capacity)
+                {
+                    entries.erase(std::min_element(entries.begin(), entries.end(), [](const auto &lhs, const auto &rhs)
+                                                   { return lhs.second.last_use < rhs.second.last_use; }));
+                }
+                entries.emplace(key, Entry{promise.get_future().share(), ++uses_count});
+            }
+        }
+
+        if (future.valid())
+        {
+            return future.get();
+        }
+
+        // Customization runs outside of the lock, so queries of already customized metrics are not blocked by it
+        try
+        {
+            std::shared_ptr<const CchMetric> result = std::make_shared<CchMetric>(_topology, key.first, key.second);
+            promise.set_value(result);
+            return result;
+        }
+        catch (...)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                entries.erase(key);
+            }
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include "CchMetric.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief Customized metrics of one contraction hierarchy topology keyed by graph metric and vehicle speed limit, so transport profiles
+     * that route over the same graph share topology and each distinct profile is customized only once, on its first use.
+     *
+     * \details Concurrent requests of the same metric wait for a single customization. When there are more metrics than cache capacity,
+     * the least recently used one is evicted - it stays alive while queries running over it hold it. Cache is thread-safe
+     */
+    class CchMetricCache
+    {
+    public:
+        static constexpr std::size_t DEFAULT_CAPACITY = 16;
+
+        explicit CchMetricCache(std::shared_ptr<const CchTopology> topology, std::size_t capacity = DEFAULT_CAPACITY);
+
+        /**
+         * \brief Returns topology customized for specified graph metric and speed limit (see CchMetric), customizing it if it is not cached.
+         * Throws std::invalid_argument if graph has no such metric
+         */
+        std::shared_ptr<const CchMetric> get(const std::string &metric, double max_speed_meters_per_second);
+
+        const CchTopology &topology() const
+        {
+            return *_topology;
+        }
+
+    private:
+        using Key = std::pair<std::string, double>;
+
+        struct Entry
+        {
+            std::shared_future<std::shared_ptr<const CchMetric>> metric;
+            std::uint64_t last_use;
+        };
+
+        std::shared_ptr<const CchTopology> _topology;
+        std::size_t capacity;
+        std::mutex mutex;
+        std::map<Key, Entry> entries;
+        std::uint64_t uses_count = 0;
+    };
+}
@@ -0,0 +1,504 @@
+#include "CchTopology.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <bit>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace assfire::router
+{
+    namespace
+    {
+        using NodeId = CchTopology::NodeId;
+        using Rank = CchTopology::Rank;
+
+        // Parts of the graph this small are not dissected further: their fill-in is negligible
+        constexpr std::size_t MIN_DISSECTED_PART_SIZE = 8;
+
+        // Levels with fewer ranks are processed by a single thread: splitting them costs more than it saves
+        constexpr std::size_t PARALLEL_LEVEL_SIZE_THRESHOLD = 256;
+
+        // Parts smaller than this are dissected and eliminated by the thread that reached them
+        constexpr std::size_t PARALLEL_PART_SIZE_THRESHOLD = 1 << 14;
+
+        // Count of mutexes guarding upper neighbors of separator ranks that are filled from parallel parts
+        constexpr std::size_t SEPARATOR_LOCKS_COUNT = 1024;
+
+        /**
+         * Part of the graph produced by nested dissection. Its ranks are [begin, end): ranks of its two halves followed by ranks of its separator,
+         * which are [separator_begin, end). Parts that are not dissected have no halves and consist of their separator only
+         */
+        struct DissectionPart
+        {
+            Rank begin;
+            Rank separator_begin;
+            Rank end;
+            std::unique_ptr<DissectionPart> halves[2];
+        };
+
+        /**
+         * Computes nested dissection order by recursive coordinate bisection: each part is split at the median of its wider extent
+         * and the smaller side of the cut boundary becomes the separator that is ranked above both halves.
+         * Halves of large parts are dissected in parallel. Each part writes its nodes into its own range of the order and marks its nodes
+         * with its own tag, so parts dissected in parallel don't interfere
+         */
+        class NestedDissection
+        {
+        public:
+            NestedDissection(std::span<const graph_format::NodeLocation> node_locations,
+                             const std::vector<std::uint32_t> &neighbor_offsets,
+                             const std::vector<NodeId> &neighbors,
+                             std::size_t parallel_depth) : node_locations(node_locations),
+                                                           neighbor_offsets(neighbor_offsets),
+                                                           neighbors(neighbors),
+                                                           parallel_depth(parallel_depth),
+                                                           tags(node_locations.size()),
+                                                           nodes(node_locations.size())
+            {
+            }
+
+            std::unique_ptr<DissectionPart> order(std::vector<NodeId> &result)
+            {
+                std::vector<NodeId> part(node_locations.size());
+                for (NodeId node = 0; node < part.size(); ++node)
+                {
+                    part[node] = node;
+                }
+                std::unique_ptr<DissectionPart> root = dissect(std::move(part), 0, 0);
+                result = std::move(nodes);
+                return root;
+            }
+
+        private:
+            static constexpr std::uint32_t SEPARATOR_SIDE = 0;
+            static constexpr std::uint32_t FIRST_SIDE = 1;
+            static constexpr std::uint32_t SECOND_SIDE = 2;
+            static constexpr std::uint32_t SIDES_COUNT = 3;
+
+            std::unique_ptr<DissectionPart> dissect(std::vector<NodeId> part, Rank begin, std::size_t depth)
+            {
+                auto result = std::make_unique<DissectionPart>(DissectionPart{begin, begin, Rank(begin + part.size()), {}});
+                if (part.size() <= MIN_DISSECTED_PART_SIZE)
+                {
+                    std::copy(part.begin(), part.end(), nodes.begin() + begin);
+                    return result;
+                }
+
+                std::int32_t min_lat = std::numeric_limits<std::int32_t>::max(), max_lat = std::numeric_limits<std::int32_t>::min();
+                std::int32_t min_lon = min_lat, max_lon = max_lat;
+                for (NodeId node : part)
+                {
+                    min_lat = std::min(min_lat, node_locations[node].lat);
+                    max_lat = std::max(max_lat, node_locations[node].lat);
+                    min_lon = std::min(min_lon, node_locations[node].lon);
+                    max_lon = std::max(max_lon, node_locations[node].lon);
+                }
+                bool by_lat = std::int64_t(max_lat) - min_lat >= std::int64_t(max_lon) - min_lon;
+                auto middle = part.begin() + part.size() / 2;
+                std::nth_element(part.begin(), middle, part.end(), [&](NodeId lhs, NodeId rhs)
+                                 { return by_lat ? node_locations[lhs].lat < node_locations[rhs].lat : node_locations[lhs].lon < node_locations[rhs].lon; });
+
+                std::uint32_t tag = next_tag.fetch_add(SIDES_COUNT, std::memory_order_relaxed);
+                for (auto iter = part.begin(); iter != part.end(); ++iter)
+                {
+                    tags[*iter].store(tag + (iter < middle ? FIRST_SIDE : SECOND_SIDE), std::memory_order_relaxed);
+                }
+                auto get_side = [&](NodeId node)
+                {
+                    std::uint32_t node_tag = tags[node].load(std::memory_order_relaxed);
+                    return node_tag >= tag && node_tag < tag + SIDES_COUNT ? node_tag - tag : SEPARATOR_SIDE;
+                };
+
+                // Boundary nodes of either side separate the halves, the smaller boundary is taken
+                std::vector<NodeId> boundaries[2];
+                for (NodeId node : part)
+                {
+                    std::uint32_t side = get_side(node);
+                    for (std::uint32_t i = neighbor_offsets[node]; i < neighbor_offsets[node + 1]; ++i)
+                    {
+                        std::uint32_t neighbor_side = get_side(neighbors[i]);
+                        if (neighbor_side != SEPARATOR_SIDE && neighbor_side != side)
+                        {
+                            boundaries[side - 1].push_back(node);
+                            break;
+                        }
+                    }
+                }
+                std::vector<NodeId> &separator = boundaries[boundaries[0].size() <= boundaries[1].size() ? 0 : 1];
+
+                for (NodeId node : separator)
+                {
+                    tags[node].store(tag + SEPARATOR_SIDE, std::memory_order_relaxed);
+                }
+                std::vector<NodeId> halves[2];
+                for (NodeId node : part)
+                {
+                    std::uint32_t side = get_side(node);
+                    if (side != SEPARATOR_SIDE)
+                    {
+                        halves[side - 1].push_back(node);
+                    }
+                }
+                part.clear();
+                part.shrink_to_fit();
+
+                result->separator_begin = result->end - separator.size();
+                std::copy(separator.begin(), separator.end(), nodes.begin() + result->separator_begin);
+                Rank second_begin = begin + halves[0].size();
+                if (depth < parallel_depth && halves[0].size() >= PARALLEL_PART_SIZE_THRESHOLD)
+                {
+                    std::future<std::unique_ptr<DissectionPart>> first = std::async(std::launch::async, [&]()
+                                                                                     { return dissect(std::move(halves[0]), begin, depth + 1); });
+                    result->halves[1] = dissect(std::move(halves[1]), second_begin, depth + 1);
+                    result->halves[0] = first.get();
+                }
+                else
+                {
+                    result->halves[0] = dissect(std::move(halves[0]), begin, depth + 1);
+                    result->halves[1] = dissect(std::move(halves[1]), second_begin, depth + 1);
+                }
+                return result;
+            }
+
+            std::span<const graph_format::NodeLocation> node_locations;
+            const std::vector<std::uint32_t> &neighbor_offsets;
+            const std::vector<NodeId> &neighbors;
+            std::size_t parallel_depth;
+            std::vector<std::atomic<std::uint32_t>> tags; // Tag of the part a node was last split in plus its side in that part
+            std::atomic<std::uint32_t> next_tag = SIDES_COUNT;
+            std::vector<NodeId> nodes;
+        };
+
+        void sort_unique(std::vector<Rank> &values)
+        {
+            std::sort(values.begin(), values.end());
+            values.erase(std::unique(values.begin(), values.end()), values.end());
+        }
+
+        /**
+         * Eliminates ranks of the part after ranks of its halves. Halves have no arcs between each other, so they are eliminated in parallel.
+         * Upper neighbors passed to parents inside the part are only touched by the thread eliminating the part, parents outside of it are
+         * separator ranks of enclosing parts that both halves may pass neighbors to, so they are locked
+         */
+        void eliminate(const DissectionPart &part, std::size_t depth, std::size_t parallel_depth, std::vector<std::vector<Rank>> &upper_neighbors,
+                       std::vector<Rank> &parents, std::vector<std::mutex> &separator_locks)
+        {
+            if (part.halves[0])
+            {
+                if (depth < parallel_depth && part.halves[0]->end - part.halves[0]->begin >= PARALLEL_PART_SIZE_THRESHOLD)
+                {
+                    std::future<void> first = std::async(std::launch::async, [&]()
+                                                         { eliminate(*part.halves[0], depth + 1, parallel_depth, upper_neighbors, parents, separator_locks); });
+                    eliminate(*part.halves[1], depth + 1, parallel_depth, upper_neighbors, parents, separator_locks);
+                    first.get();
+                }
+                else
+                {
+                    eliminate(*part.halves[0], depth + 1, parallel_depth, upper_neighbors, parents, separator_locks);
+                    eliminate(*part.halves[1], depth + 1, parallel_depth, upper_neighbors, parents, separator_locks);
+                }
+            }
+
+            for (Rank rank = part.separator_begin; rank < part.end; ++rank)
+            {
+                std::vector<Rank> &upper = upper_neighbors[rank];
+                sort_unique(upper);
+                if (upper.empty())
+                {
+                    continue;
+                }
+
+                Rank parent = upper.front();
+                parents[rank] = parent;
+                std::vector<Rank> &parent_upper = upper_neighbors[parent];
+                if (parent < part.end)
+                {
+                    parent_upper.insert(parent_upper.end(), upper.begin() + 1, upper.end());
+                }
+                else
+                {
+                    std::lock_guard lock(separator_locks[parent % separator_locks.size()]);
+                    parent_upper.insert(parent_upper.end(), upper.begin() + 1, upper.end());
+                }
+            }
+        }
+    }
+
+    CchTopology::CchTopology(std::shared_ptr<const RoadGraph> graph) : _graph(graph)
+    {
+        if (!graph)
+        {
+            throw std::invalid_argument("Contraction hierarchy topology requires road graph");
+        }
+
+        ranks = graph->get_section<Rank>(graph_format::CCH_RANKS_SECTION);
+        nodes = graph->get_section<NodeId>(graph_format::CCH_NODES_SECTION);
+        parents = graph->get_section<Rank>(graph_format::CCH_PARENTS_SECTION);
+        up_offsets = graph->get_section<ArcId>(graph_format::CCH_UP_OFFSETS_SECTION);
+        up_heads = graph->get_section<Rank>(graph_format::CCH_UP_HEADS_SECTION);
+        down_offsets = graph->get_section<std::uint32_t>(graph_format::CCH_DOWN_OFFSETS_SECTION);
+        down_arcs = graph->get_section<ArcId>(graph_format::CCH_DOWN_ARCS_SECTION);
+        edge_arcs = graph->get_section<ArcId>(graph_format::CCH_EDGE_ARCS_SECTION);
+
+        std::size_t n = graph->nodes_count();
+        if (ranks.size() != n || nodes.size() != n || parents.size() != n || up_offsets.size() != n + 1 || down_offsets.size() != n + 1 ||
+            up_offsets.back() != up_heads.size() || down_offsets.back() != down_arcs.size() || down_arcs.size() != up_heads.size() ||
+            edge_arcs.size() != graph->edges_count())
+        {
+            throw std::runtime_error("Invalid road graph file " + graph->path() + ": inconsistent contraction hierarchy sections");
+        }
+
+        // Height of a rank in elimination tree is greater than heights of all its descendants, which are the only ranks its arcs depend on
+        std::vector<std::uint32_t> heights(n, 0);
+        std::uint32_t max_height = 0;
+        for (Rank rank = 0; rank < n; ++rank)
+        {
+            if (parents[rank] != NO_RANK)
+            {
+                if (parents[rank] <= rank || parents[rank] >= n)
+                {
+                    throw std::runtime_error("Invalid road graph file " + graph->path() + ": invalid elimination tree");
+                }
+                heights[parents[rank]] = std::max(heights[parents[rank]], heights[rank] + 1);
+            }
+            max_height = std::max(max_height, heights[rank]);
+        }
+        levels.resize(n > 0 ? max_height + 1 : 0);
+        for (Rank rank = 0; rank < n; ++rank)
+        {
+            levels[heights[rank]].push_back(rank);
+        }
+    }
+
+    bool CchTopology::is_present(const RoadGraph &graph)
+    {
+        return graph.has_section(graph_format::CCH_RANKS_SECTION);
+    }
+
+    CchTopology::Rank CchTopology::get_arc_tail(ArcId arc) const
+    {
+        return std::upper_bound(up_offsets.begin(), up_offsets.end(), arc) - up_offsets.begin() - 1;
+    }
+
+    CchTopology::ArcId CchTopology::find_arc(Rank first, Rank second) const
+    {
+        Rank tail = std::min(first, second);
+        Rank head = std::max(first, second);
+        auto begin = up_heads.begin() + up_offsets[tail];
+        auto end = up_heads.begin() + up_offsets[tail + 1];
+        auto iter = std::lower_bound(begin, end, head);
+        return iter != end && *iter == head ? ArcId(iter - up_heads.begin()) : NO_ARC;
+    }
+
+    void CchTopology::for_each_rank_by_levels(bool is_top_down, std::size_t threads_count, const std::function<void(Rank)> &function,
+                                              std::size_t first_level, const std::function<void(std::size_t)> &on_level_done) const
+    {
+        if (threads_count == 0)
+        {
+            threads_count = std::max(1u, std::thread::hardware_concurrency());
+        }
+        auto get_level = [&](std::size_t index) -> const std::vector<Rank> &
+        {
+            return levels[is_top_down ? levels.size() - 1 - index : index];
+        };
+
+        if (threads_count == 1)
+        {
+            for (std::size_t index = first_level; index < levels.size(); ++index)
+            {
+                for (Rank rank : get_level(index))
+                {
+                    function(rank);
+                }
+                if (on_level_done)
+                {
+                    on_level_done(index + 1);
+                }
+            }
+            return;
+        }
+
+        // Completion of a barrier phase runs on one thread after all of them finished the level and before any starts the next one
+        std::size_t levels_done = first_level;
+        std::exception_ptr error;
+        auto complete_level = [&]() noexcept
+        {
+            ++levels_done;
+            if (on_level_done && !error)
+            {
+                try
+                {
+                    on_level_done(levels_done);
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+            }
+        };
+        std::barrier level_barrier(threads_count, complete_level);
+        auto process_levels = [&](std::size_t thread_index)
+        {
+            for (std::size_t index = first_level; index < levels.size() && !error; ++index)
+            {
+                const std::vector<Rank> &level = get_level(index);
+                std::size_t parts = level.size() >= PARALLEL_LEVEL_SIZE_THRESHOLD ? threads_count : 1;
+                if (thread_index < parts)
+                {
+                    for (std::size_t i = level.size() * thread_index / parts; i < level.size() * (thread_index + 1) / parts; ++i)
+                    {
+                        function(level[i]);
+                    }
+                }
+                level_barrier.arrive_and_wait();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (std::size_t t = 1; t < threads_count; ++t)
+        {
+            threads.emplace_back(process_levels, t);
+        }
+        process_levels(0);
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    void CchTopology::build(std::span<const graph_format::NodeLocation> node_locations,
+                            std::span<const EdgeId> edge_offsets,
+                            std::span<const NodeId> edge_targets,
+                            RoadGraphFileWriter &writer,
+                            std::size_t threads_count)
+    {
+        std::size_t n = node_locations.size();
+        if (threads_count == 0)
+        {
+            threads_count = std::max(1u, std::thread::hardware_concurrency());
+        }
+        std::size_t parallel_depth = std::bit_width(threads_count - 1); // Enough levels of halves for every thread to get one
+
+        // Undirected adjacency without loops: order and topology don't depend on edge directions
+        std::vector<std::uint32_t> neighbor_offsets(n + 1, 0);
+        for (NodeId node = 0; node < n; ++node)
+        {
+            for (EdgeId edge = edge_offsets[node]; edge < edge_offsets[node + 1]; ++edge)
+            {
+                if (edge_targets[edge] != node)
+                {
+                    ++neighbor_offsets[node + 1];
+                    ++neighbor_offsets[edge_targets[edge] + 1];
+                }
+            }
+        }
+        for (std::size_t node = 0; node < n; ++node)
+        {
+            neighbor_offsets[node + 1] += neighbor_offsets[node];
+        }
+        std::vector<NodeId> neighbors(neighbor_offsets.back());
+        std::vector<std::uint32_t> next_position(neighbor_offsets.begin(), neighbor_offsets.end() - 1);
+        for (NodeId node = 0; node < n; ++node)
+        {
+            for (EdgeId edge = edge_offsets[node]; edge < edge_offsets[node + 1]; ++edge)
+            {
+                if (edge_targets[edge] != node)
+                {
+                    neighbors[next_position[node]++] = edge_targets[edge];
+                    neighbors[next_position[edge_targets[edge]]++] = node;
+                }
+            }
+        }
+
+        std::vector<NodeId> nodes;
+        std::unique_ptr<DissectionPart> root = NestedDissection(node_locations, neighbor_offsets, neighbors, parallel_depth).order(nodes);
+        std::vector<Rank> ranks(n);
+        for (Rank rank = 0; rank < n; ++rank)
+        {
+            ranks[nodes[rank]] = rank;
+        }
+
+        // Eliminating ranks in order connects all upper neighbors of each rank into a clique. As they are ancestors of the rank,
+        // it is enough to pass them to the lowest of them - its parent - which will connect the rest when it is eliminated itself
+        std::vector<std::vector<Rank>> upper_neighbors(n);
+        for (Rank rank = 0; rank < n; ++rank)
+        {
+            NodeId node = nodes[rank];
+            for (std::uint32_t i = neighbor_offsets[node]; i < neighbor_offsets[node + 1]; ++i)
+            {
+                if (ranks[neighbors[i]] > rank)
+                {
+                    upper_neighbors[rank].push_back(ranks[neighbors[i]]);
+                }
+            }
+        }
+        neighbors.clear();
+        neighbors.shrink_to_fit();
+
+        std::vector<Rank> parents(n, NO_RANK);
+        std::vector<std::mutex> separator_locks(SEPARATOR_LOCKS_COUNT);
+        eliminate(*root, 0, parallel_depth, upper_neighbors, parents, separator_locks);
+        root.reset();
+
+        std::vector<ArcId> up_offsets(n + 1, 0);
+        std::vector<std::uint32_t> down_offsets(n + 1, 0);
+        for (Rank rank = 0; rank < n; ++rank)
+        {
+            up_offsets[rank + 1] = up_offsets[rank] + upper_neighbors[rank].size();
+            for (Rank head : upper_neighbors[rank])
+            {
+                ++down_offsets[head + 1];
+            }
+        }
+        for (std::size_t rank = 0; rank < n; ++rank)
+        {
+            down_offsets[rank + 1] += down_offsets[rank];
+        }
+
+        std::vector<Rank> up_heads;
+        up_heads.reserve(up_offsets.back());
+        std::vector<ArcId> down_arcs(up_offsets.back());
+        std::vector<std::uint32_t> next_down_position(down_offsets.begin(), down_offsets.end() - 1);
+        for (Rank rank = 0; rank < n; ++rank)
+        {
+            for (Rank head : upper_neighbors[rank])
+            {
+                down_arcs[next_down_position[head]++] = up_heads.size(); // Tails are visited in ascending order
+                up_heads.push_back(head);
+            }
+            upper_neighbors[rank] = std::vector<Rank>();
+        }
+
+        std::vector<ArcId> edge_arcs(edge_targets.size(), NO_ARC);
+        for (NodeId node = 0; node < n; ++node)
+        {
+            for (EdgeId edge = edge_offsets[node]; edge < edge_offsets[node + 1]; ++edge)
+            {
+                Rank tail = std::min(ranks[node], ranks[edge_targets[edge]]);
+                Rank head = std::max(ranks[node], ranks[edge_targets[edge]]);
+                if (tail != head)
+                {
+                    edge_arcs[edge] = std::lower_bound(up_heads.begin() + up_offsets[tail], up_heads.begin() + up_offsets[tail + 1], head) - up_heads.begin();
+                }
+            }
+        }
+
+        writer.add_section(graph_format::CCH_RANKS_SECTION, ranks);
+        writer.add_section(graph_format::CCH_NODES_SECTION, nodes);
+        writer.add_section(graph_format::CCH_PARENTS_SECTION, parents);
+        writer.add_section(graph_format::CCH_UP_OFFSETS_SECTION, up_offsets);
+        writer.add_section(graph_format::CCH_UP_HEADS_SECTION, up_heads);
+        writer.add_section(graph_format::CCH_DOWN_OFFSETS_SECTION, down_offsets);
+        writer.add_section(graph_format::CCH_DOWN_ARCS_SECTION, down_arcs);
+        writer.add_section(graph_format::CCH_EDGE_ARCS_SECTION, edge_arcs);
+    }
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <span>
+#include <vector>
+#include "RoadGraph.hpp"
+#include "RoadGraphFileWriter.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief Metric-independent part of customizable contraction hierarchy (CCH): nested dissection node order and the chordal supergraph it induces.
+     *
+     * \details Topology is computed once by offline preprocessing and memory mapped from the graph file. Any number of metrics (see CchMetric) may be
+     * customized over the same topology, so adding a transport profile costs only a customization pass and the memory of its arc weights.
+     *
+     * Nodes of the hierarchy are identified by their rank. Every arc connects lower rank to higher rank and upper neighbors of every rank form a clique,
+     * so the lowest upper neighbor of a rank is its parent in the elimination tree and all upper neighbors are its ancestors
+     */
+    class CchTopology
+    {
+    public:
+        using NodeId = RoadGraph::NodeId;
+        using EdgeId = RoadGraph::EdgeId;
+        using Rank = std::uint32_t;
+        using ArcId = std::uint32_t;
+
+        static constexpr Rank NO_RANK = std::numeric_limits<Rank>::max();
+        static constexpr ArcId NO_ARC = std::numeric_limits<ArcId>::max();
+
+        /**
+         * \brief Opens topology stored in the graph file. Throws std::runtime_error if graph has no or invalid topology sections
+         */
+        explicit CchTopology(std::shared_ptr<const RoadGraph> graph);
+
+        /**
+         * \brief Tells if graph file contains topology sections
+         */
+        static bool is_present(const RoadGraph &graph);
+
+        /**
+         * \brief Computes nested dissection order and its chordal supergraph over graph arrays and adds topology sections to the writer.
+         * Halves of dissected parts don't depend on each other, so they are ordered and eliminated in parallel
+         *
+         * \param threads_count Count of threads to use. Zero means hardware concurrency
+         */
+        static void build(std::span<const graph_format::NodeLocation> node_locations,
+                          std::span<const EdgeId> edge_offsets,
+                          std::span<const NodeId> edge_targets,
+                          RoadGraphFileWriter &writer,
+                          std::size_t threads_count = 0);
+
+        const RoadGraph &graph() const
+        {
+            return *_graph;
+        }
+
+        std::size_t ranks_count() const
+        {
+            return nodes.size();
+        }
+
+        std::size_t arcs_count() const
+        {
+            return up_heads.size();
+        }
+
+        Rank get_rank(NodeId node) const
+        {
+            return ranks[node];
+        }
+
+        NodeId get_node(Rank rank) const
+        {
+            return nodes[rank];
+        }
+
+        Rank get_parent(Rank rank) const
+        {
+            return parents[rank];
+        }
+
+        ArcId up_arcs_begin(Rank rank) const
+        {
+            return up_offsets[rank];
+        }
+
+        ArcId up_arcs_end(Rank rank) const
+        {
+            return up_offsets[rank + 1];
+        }
+
+        Rank get_arc_head(ArcId arc) const
+        {
+            return up_heads[arc];
+        }
+
+        /**
+         * \brief Returns lower rank of the arc. Arc tails are not stored, so this takes logarithmic time
+         */
+        Rank get_arc_tail(ArcId arc) const;
+
+        /**
+         * \brief Returns arcs ending at specified rank ordered by their lower ranks
+         */
+        std::span<const ArcId> get_down_arcs(Rank rank) const
+        {
+            return down_arcs.subspan(down_offsets[rank], down_offsets[rank + 1] - down_offsets[rank]);
+        }
+
+        /**
+         * \brief Returns arc between 2 ranks in any order or NO_ARC if ranks are not adjacent
+         */
+        ArcId find_arc(Rank first, Rank second) const;
+
+        /**
+         * \brief Returns arc graph edge is mapped to or NO_ARC for loops
+         */
+        ArcId get_edge_arc(EdgeId edge) const
+        {
+            return edge_arcs[edge];
+        }
+
+        /**
+         * \brief Returns ranks grouped by elimination tree height: leaves first. Arcs of ranks from the same group don't depend on each other during customization
+         */
+        const std::vector<std::vector<Rank>> &get_levels() const
+        {
+            return levels;
+        }
+
+        /**
+         * \brief Calls function for every rank level by level, so that function is called for all descendants (bottom-up) or all ancestors (top-down)
+         * of a rank before the rank itself. Ranks of the same level are processed in parallel
+         *
+         * \param threads_count Count of threads to use. Zero means hardware concurrency
+         * \param first_level Count of levels to skip in processing order, e.g. ones processed before an interruption
+         * \param on_level_done If set, called by one thread after each level with count of levels processed so far, including skipped ones,
+         * while the other threads wait. If it throws, processing stops and the exception is rethrown
+         */
+        void for_each_rank_by_levels(bool is_top_down, std::size_t threads_count, const std::function<void(Rank)> &function,
+                                     std::size_t first_level = 0, const std::function<void(std::size_t)> &on_level_done = {}) const;
+
+    private:
+        std::shared_ptr<const RoadGraph> _graph;
+        std::span<const Rank> ranks;
+        std::span<const NodeId> nodes;
+        std::span<const Rank> parents;
+        std::span<const ArcId> up_offsets;
+        std::span<const Rank> up_heads;
+        std::span<const std::uint32_t> down_offsets;
+        std::span<const ArcId> down_arcs;
+        std::span<const ArcId> edge_arcs;
+        std::vector<std::vector<Rank>> levels;
+    };
+}
@@ -0,0 +1,281 @@
+#include "EdgeSpatialIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+namespace assfire::router
+{
+    namespace
+    {
+        // Meters in one fixed point degree unit along meridian
+        constexpr double METERS_PER_UNIT = 6371000.0 * std::numbers::pi / 180 / 1e6;
+
+        // Grid is coarsened until it has no more cells than this count per edge to keep sparse continent-sized graphs compact
+        constexpr std::int64_t MAX_CELLS_PER_EDGE = 4;
+
+        std::int64_t cell_coordinate(std::int32_t value, std::int32_t min_value, std::uint32_t cell_size)
+        {
+            std::int64_t offset = std::int64_t(value) - min_value;
+            return offset >= 0 ? offset / cell_size : (offset - std::int64_t(cell_size) + 1) / cell_size;
+        }
+
+        std::uint64_t point_key(const GeoPoint &point)
+        {
+            return (std::uint64_t(std::uint32_t(point.lat())) << 32) | std::uint32_t(point.lon());
+        }
+    }
+
+    EdgeSpatialIndex::EdgeSpatialIndex(std::shared_ptr<const RoadGraph> graph) : _graph(graph)
+    {
+        if (!graph)
+        {
+            throw std::invalid_argument("Spatial index requires road graph");
+        }
+
+        if (graph->has_section(graph_format::GRID_SECTION))
+        {
+            std::span<const graph_format::GridHeader> headers = graph->get_section<graph_format::GridHeader>(graph_format::GRID_SECTION);
+            if (headers.size() != 1)
+            {
+                throw std::runtime_error("Invalid road graph file " + graph->path() + ": invalid grid header");
+            }
+            header = headers[0];
+            cell_offsets = graph->get_section<std::uint32_t>(graph_format::GRID_CELL_OFFSETS_SECTION);
+            cell_edges = graph->get_section<EdgeId>(graph_format::GRID_CELL_EDGES_SECTION);
+        }
+        else
+        {
+            owned_grid = build_grid(graph->get_section<graph_format::NodeLocation>(graph_format::NODE_LOCATIONS_SECTION),
+                                    graph->get_section<EdgeId>(graph_format::EDGE_OFFSETS_SECTION),
+                                    graph->get_section<NodeId>(graph_format::EDGE_TARGETS_SECTION));
+            header = owned_grid.header;
+            cell_offsets = owned_grid.cell_offsets;
+            cell_edges = owned_grid.cell_edges;
+        }
+
+        if (cell_offsets.size() != std::size_t(header.rows) * header.columns + 1 || cell_offsets.back() != cell_edges.size() || header.cell_size == 0)
+        {
+            throw std::runtime_error("Invalid road graph file " + graph->path() + ": inconsistent grid sections");
+        }
+    }
+
+    EdgeSpatialIndex::Snap EdgeSpatialIndex::snap(const GeoPoint &point, RouteInfo::Meters max_distance_meters) const
+    {
+        Snap best;
+        best.distance_meters = max_distance_meters;
+
+        std::int64_t point_row = cell_coordinate(point.lat(), header.min_lat, header.cell_size);
+        std::int64_t point_column = cell_coordinate(point.lon(), header.min_lon, header.cell_size);
+        std::int64_t max_ring = std::max({std::abs(point_row), std::abs(point_row - header.rows + 1),
+                                          std::abs(point_column), std::abs(point_column - header.columns + 1)});
+        // Lower bound of distance to the cells of the next ring is taken along parallel where cells are narrower
+        double ring_width_meters = header.cell_size * METERS_PER_UNIT * std::max(std::cos(point.lat_double() * std::numbers::pi / 180), 0.01);
+
+        for (std::int64_t ring = 0; ring <= max_ring; ++ring)
+        {
+            std::int64_t min_row = std::max<std::int64_t>(point_row - ring, 0);
+            std::int64_t max_row = std::min<std::int64_t>(point_row + ring, std::int64_t(header.rows) - 1);
+            for (std::int64_t row = min_row; row <= max_row; ++row)
+            {
+                bool is_ring_border_row = row == point_row - ring || row == point_row + ring;
+                std::int64_t column_step = is_ring_border_row ? 1 : std::max<std::int64_t>(2 * ring, 1);
+                for (std::int64_t column = point_column - ring; column <= point_column + ring; column += column_step)
+                {
+                    if (column < 0 || column >= header.columns)
+                    {
+                        continue;
+                    }
+                    std::size_t cell = row * header.columns + column;
+                    for (std::uint32_t i = cell_offsets[cell]; i < cell_offsets[cell + 1]; ++i)
+                    {
+                        snap_to_edge(point, cell_edges[i], best);
+                    }
+                }
+            }
+
+            double next_ring_distance = ring * ring_width_meters;
+            if (next_ring_distance > max_distance_meters || (best.is_valid() && best.distance_meters <= next_ring_distance))
+            {
+                break;
+            }
+        }
+
+        return best;
+    }
+
+    std::vector<EdgeSpatialIndex::Snap> EdgeSpatialIndex::snap(std::span<const GeoPoint> points, RouteInfo::Meters max_distance_meters) const
+    {
+        std::vector<std::size_t> unique_index_by_point(points.size());
+        std::vector<GeoPoint> unique_points;
+        std::unordered_map<std::uint64_t, std::size_t> unique_index_by_key;
+        unique_index_by_key.reserve(points.size());
+        for (std::size_t i = 0; i < points.size(); ++i)
+        {
+            auto [iter, inserted] = unique_index_by_key.emplace(point_key(points[i]), unique_points.size());
+            if (inserted)
+            {
+                unique_points.push_back(points[i]);
+            }
+            unique_index_by_point[i] = iter->second;
+        }
+
+        std::vector<Snap> unique_snaps(unique_points.size());
+        auto snap_range = [&](std::size_t from, std::size_t to)
+        {
+            for (std::size_t i = from; i < to; ++i)
+            {
+                unique_snaps[i] = snap(unique_points[i], max_distance_meters);
+            }
+        };
+
+        std::size_t threads_count = std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1u),
+                                                          unique_points.size() / PARALLEL_SNAPPING_THRESHOLD);
+        if (threads_count <= 1)
+        {
+            snap_range(0, unique_points.size());
+        }
+        else
+        {
+            std::vector<std::thread> threads;
+            std::size_t chunk_size = (unique_points.size() + threads_count - 1) / threads_count;
+            for (std::size_t from = chunk_size; from < unique_points.size(); from += chunk_size)
+            {
+                threads.emplace_back(snap_range, from, std::min(from + chunk_size, unique_points.size()));
+            }
+            snap_range(0, chunk_size);
+            for (std::thread &thread : threads)
+            {
+                thread.join();
+            }
+        }
+
+        std::vector<Snap> result;
+        result.reserve(points.size());
+        for (std::size_t unique_index : unique_index_by_point)
+        {
+            result.push_back(unique_snaps[unique_index]);
+        }
+        return result;
+    }
+
+    void EdgeSpatialIndex::build(std::span<const graph_format::NodeLocation> node_locations,
+                                 std::span<const EdgeId> edge_offsets,
+                                 std::span<const NodeId> edge_targets,
+                                 RoadGraphFileWriter &writer)
+    {
+        Grid grid = build_grid(node_locations, edge_offsets, edge_targets);
+        writer.add_section(graph_format::GRID_SECTION, std::span<const graph_format::GridHeader>(&grid.header, 1));
+        writer.add_section(graph_format::GRID_CELL_OFFSETS_SECTION, grid.cell_offsets);
+        writer.add_section(graph_format::GRID_CELL_EDGES_SECTION, grid.cell_edges);
+    }
+
+    EdgeSpatialIndex::Grid EdgeSpatialIndex::build_grid(std::span<const graph_format::NodeLocation> node_locations,
+                                                        std::span<const EdgeId> edge_offsets,
+                                                        std::span<const NodeId> edge_targets)
+    {
+        Grid grid;
+        grid.header = graph_format::GridHeader{0, 0, DEFAULT_CELL_SIZE, 1, 1, 0};
+
+        std::int32_t min_lat = std::numeric_limits<std::int32_t>::max();
+        std::int32_t min_lon = std::numeric_limits<std::int32_t>::max();
+        std::int32_t max_lat = std::numeric_limits<std::int32_t>::min();
+        std::int32_t max_lon = std::numeric_limits<std::int32_t>::min();
+        for (const graph_format::NodeLocation &location : node_locations)
+        {
+            min_lat = std::min(min_lat, location.lat);
+            min_lon = std::min(min_lon, location.lon);
+            max_lat = std::max(max_lat, location.lat);
+            max_lon = std::max(max_lon, location.lon);
+        }
+
+        if (!node_locations.empty())
+        {
+            std::int64_t max_cells = std::max<std::int64_t>(MAX_CELLS_PER_EDGE * edge_targets.size(), 1);
+            std::int64_t cell_size = DEFAULT_CELL_SIZE;
+            while (((std::int64_t(max_lat) - min_lat) / cell_size + 1) * ((std::int64_t(max_lon) - min_lon) / cell_size + 1) > max_cells)
+            {
+                cell_size *= 2;
+            }
+            grid.header = graph_format::GridHeader{min_lat, min_lon, std::uint32_t(cell_size),
+                                                   std::uint32_t((std::int64_t(max_lat) - min_lat) / cell_size + 1),
+                                                   std::uint32_t((std::int64_t(max_lon) - min_lon) / cell_size + 1), 0};
+        }
+
+        const graph_format::GridHeader &header = grid.header;
+        auto for_each_edge_cell = [&](auto consume)
+        {
+            for (NodeId source = 0; source + 1 < edge_offsets.size(); ++source)
+            {
+                for (EdgeId edge = edge_offsets[source]; edge < edge_offsets[source + 1]; ++edge)
+                {
+                    const graph_format::NodeLocation &from = node_locations[source];
+                    const graph_format::NodeLocation &to = node_locations[edge_targets[edge]];
+                    if (from.lat == to.lat && from.lon == to.lon)
+                    {
+                        continue; // Points are snapped to roads, not to turns within expanded intersections or other zero length edges
+                    }
+                    std::int64_t min_row = cell_coordinate(std::min(from.lat, to.lat), header.min_lat, header.cell_size);
+                    std::int64_t max_row = cell_coordinate(std::max(from.lat, to.lat), header.min_lat, header.cell_size);
+                    std::int64_t min_column = cell_coordinate(std::min(from.lon, to.lon), header.min_lon, header.cell_size);
+                    std::int64_t max_column = cell_coordinate(std::max(from.lon, to.lon), header.min_lon, header.cell_size);
+                    for (std::int64_t row = min_row; row <= max_row; ++row)
+                    {
+                        for (std::int64_t column = min_column; column <= max_column; ++column)
+                        {
+                            consume(row * header.columns + column, edge);
+                        }
+                    }
+                }
+            }
+        };
+
+        grid.cell_offsets.assign(std::size_t(header.rows) * header.columns + 1, 0);
+        for_each_edge_cell([&](std::size_t cell, EdgeId)
+                           { ++grid.cell_offsets[cell + 1]; });
+        for (std::size_t cell = 0; cell + 1 < grid.cell_offsets.size(); ++cell)
+        {
+            grid.cell_offsets[cell + 1] += grid.cell_offsets[cell];
+        }
+
+        grid.cell_edges.resize(grid.cell_offsets.back());
+        std::vector<std::uint32_t> next_position(grid.cell_offsets.begin(), grid.cell_offsets.end() - 1);
+        for_each_edge_cell([&](std::size_t cell, EdgeId edge)
+                           { grid.cell_edges[next_position[cell]++] = edge; });
+
+        return grid;
+    }
+
+    void EdgeSpatialIndex::snap_to_edge(const GeoPoint &point, EdgeId edge, Snap &best) const
+    {
+        // Segment is projected to local plane around the snapped point where fixed point units are scaled to meters
+        double lon_scale = std::cos(point.lat_double() * std::numbers::pi / 180);
+        GeoPoint from = _graph->get_node_location(_graph->get_edge_source(edge));
+        GeoPoint to = _graph->get_node_location(_graph->get_edge_target(edge));
+
+        double from_x = (double(from.lon()) - point.lon()) * lon_scale * METERS_PER_UNIT;
+        double from_y = (double(from.lat()) - point.lat()) * METERS_PER_UNIT;
+        double to_x = (double(to.lon()) - point.lon()) * lon_scale * METERS_PER_UNIT;
+        double to_y = (double(to.lat()) - point.lat()) * METERS_PER_UNIT;
+
+        double segment_x = to_x - from_x;
+        double segment_y = to_y - from_y;
+        double segment_length_squared = segment_x * segment_x + segment_y * segment_y;
+        double fraction = segment_length_squared > 0 ? std::clamp(-(from_x * segment_x + from_y * segment_y) / segment_length_squared, 0.0, 1.0) : 0.0;
+
+        double x = from_x + segment_x * fraction;
+        double y = from_y + segment_y * fraction;
+        double distance = std::sqrt(x * x + y * y);
+        if (distance < best.distance_meters || (!best.is_valid() && distance <= best.distance_meters))
+        {
+            best.edge = edge;
+            best.fraction = fraction;
+            best.distance_meters = distance;
+            best.location = GeoPoint(GeoPoint::FixedPointCoordinate(std::lround(from.lat() + (double(to.lat()) - from.lat()) * fraction)),
+                                     GeoPoint::FixedPointCoordinate(std::lround(from.lon() + (double(to.lon()) - from.lon()) * fraction)));
+        }
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <memory>
+#include <span>
+#include <vector>
+#include "assfire/router/api/GeoPoint.hpp"
+#include "assfire/router/api/RouteInfo.hpp"
+#include "RoadGraph.hpp"
+#include "RoadGraphFileWriter.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief Uniform grid over road graph edges used to snap points to the nearest road segment.
+     *
+     * \details Grid is normally precomputed by graph builder and stored in the graph file, so it is memory mapped together with the graph.
+     * For graph files without grid sections it is built in memory on construction. Index is immutable and may be used from any number of threads
+     */
+    class EdgeSpatialIndex
+    {
+    public:
+        using NodeId = RoadGraph::NodeId;
+        using EdgeId = RoadGraph::EdgeId;
+
+        /**
+         * \brief Default grid cell size in fixed point degrees (~500m along meridian)
+         */
+        static constexpr std::uint32_t DEFAULT_CELL_SIZE = 5000;
+
+        /**
+         * \brief Count of unique points starting from which batched snapping is split between threads
+         */
+        static constexpr std::size_t PARALLEL_SNAPPING_THRESHOLD = 512;
+
+        /**
+         * \brief Location on the road network: point at specified fraction of the edge from its source node
+         */
+        struct Snap
+        {
+            EdgeId edge = RoadGraph::NO_EDGE;
+            double fraction = 0;
+            GeoPoint location;
+            RouteInfo::Meters distance_meters = 0; // Distance from snapped point to the road
+
+            bool is_valid() const
+            {
+                return edge != RoadGraph::NO_EDGE;
+            }
+        };
+
+        explicit EdgeSpatialIndex(std::shared_ptr<const RoadGraph> graph);
+
+        /**
+         * \brief Finds the nearest point on the road network
+         *
+         * \param point Point to snap
+         * \param max_distance_meters Max distance to the road. Invalid snap is returned if there is no road closer than that
+         */
+        Snap snap(const GeoPoint &point, RouteInfo::Meters max_distance_meters) const;
+
+        /**
+         * \brief Snaps all points of the batch. Repeated points are snapped only once and big batches are processed in parallel
+         *
+         * \return std::vector<Snap> Snaps in order of passed points
+         */
+        std::vector<Snap> snap(std::span<const GeoPoint> points, RouteInfo::Meters max_distance_meters) const;
+
+        const RoadGraph &graph() const
+        {
+            return *_graph;
+        }
+
+        /**
+         * \brief Builds grid over graph arrays and adds its sections to the writer
+         */
+        static void build(std::span<const graph_format::NodeLocation> node_locations,
+                          std::span<const EdgeId> edge_offsets,
+                          std::span<const NodeId> edge_targets,
+                          RoadGraphFileWriter &writer);
+
+    private:
+        struct Grid
+        {
+            graph_format::GridHeader header;
+            std::vector<std::uint32_t> cell_offsets;
+            std::vector<EdgeId> cell_edges;
+        };
+
+        static Grid build_grid(std::span<const graph_format::NodeLocation> node_locations,
+                               std::span<const EdgeId> edge_offsets,
+                               std::span<const NodeId> edge_targets);
+
+        void snap_to_edge(const GeoPoint &point, EdgeId edge, Snap &best) const;
+
+        std::shared_ptr<const RoadGraph> _graph;
+        Grid owned_grid; // Is only filled when graph file has no grid
+        graph_format::GridHeader header;
+        std::span<const std::uint32_t> cell_offsets;
+        std::span<const EdgeId> cell_edges;
+    };
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace assfire::router::hub_label_format
+{
+    /**
+     * \brief Layout of binary hub labels file. File has the same section table as road graph file (see RoadGraphFormat.hpp) with its own magic.
+     *
+     * \details Every node has forward label (hubs reachable from the node) and backward label (hubs the node is reachable from). Hubs are contraction
+     * hierarchy ranks. Label is a LabelHeader followed by sorted uint32 hubs and arrays of weights and lengths of paths to them. Each value array is
+     * 16-bit if all its values fit, otherwise 32-bit, which shrinks labels of most nodes as pruned labels mostly keep nearby hubs.
+     * Labels start at LABEL_ALIGNMENT boundary and hub arrays are padded to it, so hubs are loaded by aligned vector instructions
+     */
+    constexpr char MAGIC[8] = {'A', 'S', 'F', 'R', 'H', 'L', 'B', 'L'};
+    constexpr std::uint32_t VERSION = 1;
+    constexpr std::size_t LABEL_ALIGNMENT = 16;
+
+    constexpr const char *HEADER_SECTION = "header";                     // LabelsHeader[1]
+    constexpr const char *METRIC_SECTION = "metric";                     // char[], name of graph metric labels are computed for
+    constexpr const char *FORWARD_OFFSETS_SECTION = "forward/offsets";   // uint64[nodes_count + 1], byte offsets of forward labels
+    constexpr const char *FORWARD_LABELS_SECTION = "forward/labels";     // Forward labels of all nodes
+    constexpr const char *BACKWARD_OFFSETS_SECTION = "backward/offsets"; // uint64[nodes_count + 1], byte offsets of backward labels
+    constexpr const char *BACKWARD_LABELS_SECTION = "backward/labels";   // Backward labels of all nodes
+
+    constexpr std::uint32_t WIDE_WEIGHTS_FLAG = 1;
+    constexpr std::uint32_t WIDE_LENGTHS_FLAG = 2;
+
+    struct LabelsHeader
+    {
+        std::uint64_t nodes_count;
+        std::uint64_t edges_count;
+        double max_speed_meters_per_second;
+    };
+
+    /**
+     * \brief Checkpoint of interrupted labels computation has the same layout with its own magic and header. It stores labels of the ranks of elimination
+     * tree levels processed so far (top-down), listed in RANKS_SECTION, with offsets following the order of that list
+     */
+    constexpr char CHECKPOINT_MAGIC[8] = {'A', 'S', 'F', 'R', 'H', 'L', 'C', 'P'};
+    constexpr const char *RANKS_SECTION = "ranks"; // uint32[], ranks labels are stored for
+
+    struct CheckpointHeader
+    {
+        std::uint64_t nodes_count;
+        std::uint64_t edges_count;
+        std::uint64_t metric_fingerprint; // See CchMetric::get_fingerprint
+        std::uint64_t levels_count;       // Count of elimination tree levels processed top-down
+    };
+
+    struct LabelHeader
+    {
+        std::uint32_t hubs_count;
+        std::uint32_t flags;
+        std::uint32_t reserved[2];
+    };
+}
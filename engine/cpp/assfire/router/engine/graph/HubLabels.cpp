@@ -0,0 +1,431 @@
+#include "HubLabels.hpp"
+#include "RoadGraphFileWriter.hpp"
+
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define ASSFIRE_HUB_LABELS_SSE2
+#endif
+
+namespace assfire::router
+{
+    namespace
+    {
+        using Rank = CchTopology::Rank;
+        using Weight = RoadGraph::Weight;
+        using Length = RoadGraph::Length;
+
+        struct LabelEntry
+        {
+            Rank hub;
+            Weight weight;
+            Length length;
+        };
+
+        std::size_t align(std::size_t size)
+        {
+            return (size + hub_label_format::LABEL_ALIGNMENT - 1) / hub_label_format::LABEL_ALIGNMENT * hub_label_format::LABEL_ALIGNMENT;
+        }
+
+        std::uint32_t read_value(const std::byte *values, bool is_wide, std::size_t index)
+        {
+            if (is_wide)
+            {
+                std::uint32_t value;
+                std::memcpy(&value, values + index * sizeof(value), sizeof(value));
+                return value;
+            }
+            std::uint16_t value;
+            std::memcpy(&value, values + index * sizeof(value), sizeof(value));
+            return value;
+        }
+
+        template <typename T>
+        void append(std::vector<std::byte> &data, T value)
+        {
+            const std::byte *bytes = reinterpret_cast<const std::byte *>(&value);
+            data.insert(data.end(), bytes, bytes + sizeof(value));
+        }
+
+        void append_label(const std::vector<LabelEntry> &label, std::vector<std::byte> &data, std::vector<std::uint64_t> &offsets)
+        {
+            offsets.push_back(data.size());
+
+            hub_label_format::LabelHeader header{std::uint32_t(label.size()), 0, {0, 0}};
+            for (const LabelEntry &entry : label)
+            {
+                header.flags |= entry.weight > std::numeric_limits<std::uint16_t>::max() ? hub_label_format::WIDE_WEIGHTS_FLAG : 0;
+                header.flags |= entry.length > std::numeric_limits<std::uint16_t>::max() ? hub_label_format::WIDE_LENGTHS_FLAG : 0;
+            }
+            append(data, header);
+
+            for (const LabelEntry &entry : label)
+            {
+                append(data, entry.hub);
+            }
+            data.resize(align(data.size()));
+            for (const LabelEntry &entry : label)
+            {
+                header.flags & hub_label_format::WIDE_WEIGHTS_FLAG ? append(data, entry.weight) : append(data, std::uint16_t(entry.weight));
+            }
+            for (const LabelEntry &entry : label)
+            {
+                header.flags & hub_label_format::WIDE_LENGTHS_FLAG ? append(data, entry.length) : append(data, std::uint16_t(entry.length));
+            }
+            data.resize(align(data.size()));
+        }
+
+        std::vector<LabelEntry> read_label(std::span<const std::byte> labels, std::uint64_t offset)
+        {
+            hub_label_format::LabelHeader header;
+            std::memcpy(&header, labels.data() + offset, sizeof(header));
+            const std::byte *hubs = labels.data() + offset + sizeof(header);
+            const std::byte *weights = labels.data() + offset + align(sizeof(header) + header.hubs_count * sizeof(Rank));
+            const std::byte *lengths = weights + header.hubs_count * (header.flags & hub_label_format::WIDE_WEIGHTS_FLAG ? sizeof(Weight) : sizeof(std::uint16_t));
+
+            std::vector<LabelEntry> label(header.hubs_count);
+            for (std::size_t i = 0; i < label.size(); ++i)
+            {
+                label[i] = LabelEntry{read_value(hubs, true, i),
+                                      read_value(weights, header.flags & hub_label_format::WIDE_WEIGHTS_FLAG, i),
+                                      read_value(lengths, header.flags & hub_label_format::WIDE_LENGTHS_FLAG, i)};
+            }
+            return label;
+        }
+
+        std::vector<Rank> get_ranks_of_levels(const CchTopology &topology, std::size_t levels_count)
+        {
+            const std::vector<std::vector<Rank>> &levels = topology.get_levels();
+            std::vector<Rank> result;
+            for (std::size_t index = 0; index < levels_count; ++index)
+            {
+                const std::vector<Rank> &level = levels[levels.size() - 1 - index];
+                result.insert(result.end(), level.begin(), level.end());
+            }
+            return result;
+        }
+
+        void write_checkpoint(const CchMetric &metric, std::uint64_t fingerprint, std::size_t levels_count, const std::string &path,
+                              const std::vector<std::vector<LabelEntry>> &forward, const std::vector<std::vector<LabelEntry>> &backward)
+        {
+            std::vector<Rank> ranks = get_ranks_of_levels(metric.topology(), levels_count);
+            std::vector<std::uint64_t> forward_offsets;
+            std::vector<std::byte> forward_data;
+            std::vector<std::uint64_t> backward_offsets;
+            std::vector<std::byte> backward_data;
+            for (Rank rank : ranks)
+            {
+                append_label(forward[rank], forward_data, forward_offsets);
+                append_label(backward[rank], backward_data, backward_offsets);
+            }
+            forward_offsets.push_back(forward_data.size());
+            backward_offsets.push_back(backward_data.size());
+
+            const RoadGraph &graph = metric.topology().graph();
+            RoadGraphFileWriter writer(hub_label_format::CHECKPOINT_MAGIC, hub_label_format::VERSION);
+            writer.add_section(hub_label_format::HEADER_SECTION, std::vector<hub_label_format::CheckpointHeader>{
+                                                                     {graph.nodes_count(), graph.edges_count(), fingerprint, levels_count}});
+            writer.add_section(hub_label_format::RANKS_SECTION, ranks);
+            writer.add_section(hub_label_format::FORWARD_OFFSETS_SECTION, forward_offsets);
+            writer.add_section(hub_label_format::FORWARD_LABELS_SECTION, forward_data);
+            writer.add_section(hub_label_format::BACKWARD_OFFSETS_SECTION, backward_offsets);
+            writer.add_section(hub_label_format::BACKWARD_LABELS_SECTION, backward_data);
+            writer.write(path);
+        }
+
+        /**
+         * Loads labels saved by write_checkpoint and returns count of levels they cover. Checkpoints of other graphs or metrics are ignored
+         */
+        std::size_t read_checkpoint(const CchMetric &metric, std::uint64_t fingerprint, const std::string &path,
+                                    std::vector<std::vector<LabelEntry>> &forward, std::vector<std::vector<LabelEntry>> &backward)
+        {
+            if (!std::filesystem::exists(path))
+            {
+                return 0;
+            }
+
+            SectionedFile file(path, hub_label_format::CHECKPOINT_MAGIC, hub_label_format::VERSION, "hub labels checkpoint", false);
+            std::span<const hub_label_format::CheckpointHeader> headers = file.get_section<hub_label_format::CheckpointHeader>(hub_label_format::HEADER_SECTION);
+            const RoadGraph &graph = metric.topology().graph();
+            if (headers.size() != 1 || headers[0].nodes_count != graph.nodes_count() || headers[0].edges_count != graph.edges_count() ||
+                headers[0].metric_fingerprint != fingerprint || headers[0].levels_count > metric.topology().get_levels().size())
+            {
+                return 0;
+            }
+
+            std::span<const Rank> ranks = file.get_section<Rank>(hub_label_format::RANKS_SECTION);
+            std::span<const std::uint64_t> forward_offsets = file.get_section<std::uint64_t>(hub_label_format::FORWARD_OFFSETS_SECTION);
+            std::span<const std::byte> forward_labels = file.get_section<std::byte>(hub_label_format::FORWARD_LABELS_SECTION);
+            std::span<const std::uint64_t> backward_offsets = file.get_section<std::uint64_t>(hub_label_format::BACKWARD_OFFSETS_SECTION);
+            std::span<const std::byte> backward_labels = file.get_section<std::byte>(hub_label_format::BACKWARD_LABELS_SECTION);
+            std::vector<Rank> expected_ranks = get_ranks_of_levels(metric.topology(), headers[0].levels_count);
+            if (!std::equal(ranks.begin(), ranks.end(), expected_ranks.begin(), expected_ranks.end()) ||
+                forward_offsets.size() != ranks.size() + 1 || forward_offsets.back() != forward_labels.size() ||
+                backward_offsets.size() != ranks.size() + 1 || backward_offsets.back() != backward_labels.size())
+            {
+                throw std::runtime_error("Invalid hub labels checkpoint " + path + ": inconsistent sections");
+            }
+
+            for (std::size_t i = 0; i < ranks.size(); ++i)
+            {
+                forward[ranks[i]] = read_label(forward_labels, forward_offsets[i]);
+                backward[ranks[i]] = read_label(backward_labels, backward_offsets[i]);
+            }
+            return headers[0].levels_count;
+        }
+
+        /**
+         * Computes label of the rank from its elimination tree search space: hub is kept only if the path found to it is not longer
+         * than the one through hubs common with the already computed opposite label of the hub
+         */
+        std::vector<LabelEntry> build_label(const CchMetric &metric, Rank rank, bool is_forward, const std::vector<std::vector<LabelEntry>> &opposite_labels)
+        {
+            thread_local std::vector<CchMetric::SearchSpaceEntry> search_space;
+            thread_local std::vector<std::uint64_t> weights; // Search space weights by rank, infinite outside of the search space
+            if (weights.size() < metric.topology().ranks_count())
+            {
+                weights.resize(metric.topology().ranks_count(), RoadGraph::INFINITE_WEIGHT);
+            }
+
+            metric.get_search_space(metric.topology().get_node(rank), is_forward, search_space);
+            for (const CchMetric::SearchSpaceEntry &entry : search_space)
+            {
+                weights[entry.rank] = entry.weight;
+            }
+
+            std::vector<LabelEntry> label;
+            for (const CchMetric::SearchSpaceEntry &entry : search_space)
+            {
+                bool is_shortest = true;
+                if (entry.rank != rank)
+                {
+                    for (const LabelEntry &opposite : opposite_labels[entry.rank])
+                    {
+                        if (weights[opposite.hub] + opposite.weight < entry.weight)
+                        {
+                            is_shortest = false;
+                            break;
+                        }
+                    }
+                }
+                if (is_shortest)
+                {
+                    label.push_back(LabelEntry{entry.rank, entry.weight, entry.length});
+                }
+            }
+
+            for (const CchMetric::SearchSpaceEntry &entry : search_space)
+            {
+                weights[entry.rank] = RoadGraph::INFINITE_WEIGHT;
+            }
+            return label;
+        }
+
+        /**
+         * Calls on_match(i, j) for every pair of equal values of two sorted arrays
+         */
+        template <typename OnMatch>
+        void intersect_sorted(const std::uint32_t *lhs, std::size_t lhs_count, const std::uint32_t *rhs, std::size_t rhs_count, OnMatch &&on_match)
+        {
+            std::size_t i = 0;
+            std::size_t j = 0;
+#ifdef ASSFIRE_HUB_LABELS_SSE2
+            // Blocks of 4 values are compared all-to-all by comparing with 4 rotations of the other block
+            while (i + 4 <= lhs_count && j + 4 <= rhs_count)
+            {
+                __m128i lhs_block = _mm_load_si128(reinterpret_cast<const __m128i *>(lhs + i));
+                __m128i rhs_block = _mm_load_si128(reinterpret_cast<const __m128i *>(rhs + j));
+                for (std::size_t rotation = 0; rotation < 4; ++rotation)
+                {
+                    unsigned mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(lhs_block, rhs_block)));
+                    for (; mask != 0; mask &= mask - 1)
+                    {
+                        std::size_t lane = std::countr_zero(mask);
+                        on_match(i + lane, j + (lane + rotation) % 4);
+                    }
+                    rhs_block = _mm_shuffle_epi32(rhs_block, _MM_SHUFFLE(0, 3, 2, 1));
+                }
+
+                std::uint32_t lhs_max = lhs[i + 3];
+                std::uint32_t rhs_max = rhs[j + 3];
+                i += lhs_max <= rhs_max ? 4 : 0;
+                j += rhs_max <= lhs_max ? 4 : 0;
+            }
+#endif
+            while (i < lhs_count && j < rhs_count)
+            {
+                if (lhs[i] < rhs[j])
+                {
+                    ++i;
+                }
+                else if (rhs[j] < lhs[i])
+                {
+                    ++j;
+                }
+                else
+                {
+                    on_match(i++, j++);
+                }
+            }
+        }
+    }
+
+    HubLabels::HubLabels(std::shared_ptr<const RoadGraph> graph, const std::string &path, bool preload)
+        : _graph(graph),
+          file(path, hub_label_format::MAGIC, hub_label_format::VERSION, "hub labels", preload)
+    {
+        if (!graph)
+        {
+            throw std::invalid_argument("Hub labels require road graph");
+        }
+
+        std::span<const hub_label_format::LabelsHeader> headers = file.get_section<hub_label_format::LabelsHeader>(hub_label_format::HEADER_SECTION);
+        if (headers.size() != 1 || headers[0].nodes_count != graph->nodes_count() || headers[0].edges_count != graph->edges_count())
+        {
+            throw std::runtime_error("Hub labels file " + path + " doesn't match road graph " + graph->path());
+        }
+        max_speed_meters_per_second = headers[0].max_speed_meters_per_second;
+        std::span<const char> metric_name = file.get_section<char>(hub_label_format::METRIC_SECTION);
+        metric.assign(metric_name.begin(), metric_name.end());
+
+        forward_offsets = file.get_section<std::uint64_t>(hub_label_format::FORWARD_OFFSETS_SECTION);
+        forward_labels = file.get_section<std::byte>(hub_label_format::FORWARD_LABELS_SECTION);
+        backward_offsets = file.get_section<std::uint64_t>(hub_label_format::BACKWARD_OFFSETS_SECTION);
+        backward_labels = file.get_section<std::byte>(hub_label_format::BACKWARD_LABELS_SECTION);
+        if (forward_offsets.size() != graph->nodes_count() + 1 || forward_offsets.back() != forward_labels.size() ||
+            backward_offsets.size() != graph->nodes_count() + 1 || backward_offsets.back() != backward_labels.size())
+        {
+            throw std::runtime_error("Invalid hub labels file " + path + ": inconsistent section sizes");
+        }
+    }
+
+    void HubLabels::write(const CchMetric &metric, const std::string &path, std::size_t threads_count)
+    {
+        WriteOptions options;
+        options.threads_count = threads_count;
+        write(metric, path, options);
+    }
+
+    void HubLabels::write(const CchMetric &metric, const std::string &path, const WriteOptions &options)
+    {
+        const CchTopology &topology = metric.topology();
+        std::vector<std::vector<LabelEntry>> forward(topology.ranks_count());
+        std::vector<std::vector<LabelEntry>> backward(topology.ranks_count());
+
+        std::uint64_t fingerprint = options.checkpoint_path.empty() ? 0 : metric.get_fingerprint();
+        std::size_t first_level = options.checkpoint_path.empty() ? 0 : read_checkpoint(metric, fingerprint, options.checkpoint_path, forward, backward);
+        std::size_t ranks_done = get_ranks_of_levels(topology, first_level).size();
+        std::chrono::steady_clock::time_point last_checkpoint = std::chrono::steady_clock::now();
+        auto on_level_done = [&](std::size_t levels_done)
+        {
+            ranks_done += topology.get_levels()[topology.get_levels().size() - levels_done].size();
+            if (options.on_progress)
+            {
+                options.on_progress(ranks_done, topology.ranks_count());
+            }
+            if (!options.checkpoint_path.empty() && levels_done < topology.get_levels().size() &&
+                std::chrono::steady_clock::now() - last_checkpoint >= options.checkpoint_interval)
+            {
+                write_checkpoint(metric, fingerprint, levels_done, options.checkpoint_path, forward, backward);
+                last_checkpoint = std::chrono::steady_clock::now();
+            }
+        };
+
+        // Labels of a rank are pruned with labels of its ancestors, so ranks are processed top-down
+        topology.for_each_rank_by_levels(
+            true, options.threads_count, [&](Rank rank)
+            {
+                forward[rank] = build_label(metric, rank, true, backward);
+                backward[rank] = build_label(metric, rank, false, forward); },
+            first_level, on_level_done);
+
+        // Labels are released as soon as they are encoded, so memory doesn't hold both forms of all labels
+        std::vector<std::uint64_t> forward_offsets;
+        std::vector<std::byte> forward_data;
+        std::vector<std::uint64_t> backward_offsets;
+        std::vector<std::byte> backward_data;
+        for (NodeId node = 0; node < topology.ranks_count(); ++node)
+        {
+            append_label(forward[topology.get_rank(node)], forward_data, forward_offsets);
+            append_label(backward[topology.get_rank(node)], backward_data, backward_offsets);
+            forward[topology.get_rank(node)] = std::vector<LabelEntry>();
+            backward[topology.get_rank(node)] = std::vector<LabelEntry>();
+        }
+        forward_offsets.push_back(forward_data.size());
+        backward_offsets.push_back(backward_data.size());
+
+        const RoadGraph &graph = topology.graph();
+        RoadGraphFileWriter writer(hub_label_format::MAGIC, hub_label_format::VERSION);
+        writer.add_section(hub_label_format::HEADER_SECTION, std::vector<hub_label_format::LabelsHeader>{
+                                                                 {graph.nodes_count(), graph.edges_count(), metric.get_max_speed_meters_per_second()}});
+        writer.add_section(hub_label_format::METRIC_SECTION, std::vector<char>(metric.get_metric().begin(), metric.get_metric().end()));
+        writer.add_section(hub_label_format::FORWARD_OFFSETS_SECTION, forward_offsets);
+        writer.add_section(hub_label_format::FORWARD_LABELS_SECTION, forward_data);
+        writer.add_section(hub_label_format::BACKWARD_OFFSETS_SECTION, backward_offsets);
+        writer.add_section(hub_label_format::BACKWARD_LABELS_SECTION, backward_data);
+        writer.write(path);
+
+        if (!options.checkpoint_path.empty())
+        {
+            std::filesystem::remove(options.checkpoint_path);
+        }
+    }
+
+    HubLabels::Path HubLabels::find_path(std::span<const Seed> sources, std::span<const Seed> targets) const
+    {
+        Path result;
+        for (const Seed &source : sources)
+        {
+            LabelView forward = get_label(forward_offsets, forward_labels, source.node);
+            for (const Seed &target : targets)
+            {
+                Path path = intersect(forward, get_label(backward_offsets, backward_labels, target.node));
+                if (path.exists() && path.weight + source.weight + target.weight < result.weight)
+                {
+                    result = Path{path.weight + source.weight + target.weight, path.length + source.length + target.length};
+                }
+            }
+        }
+        return result;
+    }
+
+    HubLabels::LabelView HubLabels::get_label(std::span<const std::uint64_t> offsets, std::span<const std::byte> labels, NodeId node) const
+    {
+        const std::byte *data = labels.data() + offsets[node];
+        hub_label_format::LabelHeader header;
+        std::memcpy(&header, data, sizeof(header));
+
+        LabelView label;
+        label.hubs = reinterpret_cast<const std::uint32_t *>(data + sizeof(header));
+        label.weights = data + align(sizeof(header) + header.hubs_count * sizeof(std::uint32_t));
+        label.lengths = label.weights + header.hubs_count * (header.flags & hub_label_format::WIDE_WEIGHTS_FLAG ? sizeof(std::uint32_t) : sizeof(std::uint16_t));
+        label.hubs_count = header.hubs_count;
+        label.flags = header.flags;
+        return label;
+    }
+
+    HubLabels::Path HubLabels::intersect(const LabelView &forward, const LabelView &backward)
+    {
+        bool is_forward_weight_wide = forward.flags & hub_label_format::WIDE_WEIGHTS_FLAG;
+        bool is_forward_length_wide = forward.flags & hub_label_format::WIDE_LENGTHS_FLAG;
+        bool is_backward_weight_wide = backward.flags & hub_label_format::WIDE_WEIGHTS_FLAG;
+        bool is_backward_length_wide = backward.flags & hub_label_format::WIDE_LENGTHS_FLAG;
+
+        Path result;
+        intersect_sorted(forward.hubs, forward.hubs_count, backward.hubs, backward.hubs_count, [&](std::size_t i, std::size_t j)
+                         {
+                             std::uint64_t weight = std::uint64_t(read_value(forward.weights, is_forward_weight_wide, i)) +
+                                                    read_value(backward.weights, is_backward_weight_wide, j);
+                             if (weight < result.weight)
+                             {
+                                 result = Path{weight, std::uint64_t(read_value(forward.lengths, is_forward_length_wide, i)) +
+                                                           read_value(backward.lengths, is_backward_length_wide, j)};
+                             } });
+        return result;
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include "CchMetric.hpp"
+#include "HubLabelFormat.hpp"
+#include "SectionedFile.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief Hub labels of road graph for one customized metric, memory mapped from file produced by offline preprocessing.
+     *
+     * \details Labels are built from contraction hierarchy: label of a node consists of hubs its elimination tree search reaches by shortest paths,
+     * the rest are pruned. Shortest path between two nodes goes through a common hub of forward label of the first one and backward label
+     * of the second one, so a query is a single intersection of two sorted arrays that doesn't touch the graph.
+     * Labels are immutable, so they may be used from any number of threads
+     */
+    class HubLabels
+    {
+    public:
+        using NodeId = RoadGraph::NodeId;
+        using Seed = CchMetric::Seed;
+        using Path = CchMetric::Path;
+
+        static constexpr std::chrono::seconds DEFAULT_CHECKPOINT_INTERVAL = std::chrono::minutes(5);
+
+        struct WriteOptions
+        {
+            std::size_t threads_count = 0; // Zero means hardware concurrency
+            std::string checkpoint_path;   // If not empty, computed labels are saved there periodically and computation resumes from it when restarted
+            std::chrono::seconds checkpoint_interval = DEFAULT_CHECKPOINT_INTERVAL;
+            std::function<void(std::size_t ranks_done, std::size_t ranks_count)> on_progress; // Called after each elimination tree level
+        };
+
+        /**
+         * \brief Opens labels file. Throws std::runtime_error if file is invalid or doesn't match the graph
+         *
+         * \param preload If true, the whole file is read into page cache in background instead of on first access
+         */
+        HubLabels(std::shared_ptr<const RoadGraph> graph, const std::string &path, bool preload = true);
+
+        /**
+         * \brief Computes labels of all nodes for customized metric and writes labels file
+         *
+         * \param threads_count Count of threads to compute labels with. Zero means hardware concurrency
+         */
+        static void write(const CchMetric &metric, const std::string &path, std::size_t threads_count = 0);
+
+        /**
+         * \brief Computes labels of all nodes for customized metric and writes labels file. Labels computation may be interrupted and resumed
+         * from checkpoint if it was computed for the same metric fingerprint. Checkpoint is removed when labels file is written
+         */
+        static void write(const CchMetric &metric, const std::string &path, const WriteOptions &options);
+
+        /**
+         * \brief Finds shortest path from any source to any target. Path weight and length include ones of the seeds it starts and ends with
+         */
+        Path find_path(std::span<const Seed> sources, std::span<const Seed> targets) const;
+
+        const RoadGraph &graph() const
+        {
+            return *_graph;
+        }
+
+        const std::string &get_metric() const
+        {
+            return metric;
+        }
+
+        double get_max_speed_meters_per_second() const
+        {
+            return max_speed_meters_per_second;
+        }
+
+    private:
+        struct LabelView
+        {
+            const std::uint32_t *hubs;
+            const std::byte *weights;
+            const std::byte *lengths;
+            std::uint32_t hubs_count;
+            std::uint32_t flags;
+        };
+
+        LabelView get_label(std::span<const std::uint64_t> offsets, std::span<const std::byte> labels, NodeId node) const;
+        static Path intersect(const LabelView &forward, const LabelView &backward);
+
+        std::shared_ptr<const RoadGraph> _graph;
+        SectionedFile file;
+        std::string metric;
+        double max_speed_meters_per_second;
+        std::span<const std::uint64_t> forward_offsets;
+        std::span<const std::byte> forward_labels;
+        std::span<const std::uint64_t> backward_offsets;
+        std::span<const std::byte> backward_labels;
+    };
+}
@@ -0,0 +1,81 @@
+#include "MappedFile.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace assfire::router
+{
+    namespace
+    {
+        std::runtime_error make_error(const std::string &action, const std::string &path)
+        {
+            return std::runtime_error("Failed to " + action + " " + path + ": " + std::strerror(errno));
+        }
+
+        int to_advice(MappedFile::AccessPattern access_pattern)
+        {
+            switch (access_pattern)
+            {
+            case MappedFile::AccessPattern::RANDOM:
+                return MADV_RANDOM;
+            case MappedFile::AccessPattern::SEQUENTIAL:
+                return MADV_SEQUENTIAL;
+            default:
+                return MADV_NORMAL;
+            }
+        }
+    }
+
+    MappedFile::MappedFile(const std::string &path, AccessPattern access_pattern, bool preload) : _path(path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw make_error("open", path);
+        }
+
+        struct stat file_stat;
+        if (::fstat(fd, &file_stat) != 0)
+        {
+            std::runtime_error error = make_error("stat", path);
+            ::close(fd);
+            throw error;
+        }
+        _size = file_stat.st_size;
+        if (_size == 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("Failed to map " + path + ": file is empty");
+        }
+
+        void *mapping = ::mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            std::runtime_error error = make_error("map", path);
+            ::close(fd);
+            throw error;
+        }
+        ::close(fd); // Mapping stays valid after descriptor is closed
+        _data = static_cast<const std::byte *>(mapping);
+
+        // Advices are only hints, so their failures are ignored
+        ::madvise(mapping, _size, to_advice(access_pattern));
+        if (preload)
+        {
+            ::madvise(mapping, _size, MADV_WILLNEED);
+        }
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (_data)
+        {
+            ::munmap(const_cast<std::byte *>(_data), _size);
+        }
+    }
+}
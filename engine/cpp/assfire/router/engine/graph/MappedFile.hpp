@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace assfire::router
+{
+    /**
+     * \brief Read-only memory mapping of a whole file. Mapping is shared, so pages of the same file are shared by all processes that map it
+     * and are loaded lazily by the OS on first access
+     */
+    class MappedFile
+    {
+    public:
+        enum class AccessPattern
+        {
+            NORMAL,
+            RANDOM,
+            SEQUENTIAL
+        };
+
+        /**
+         * \brief Maps specified file into memory. Throws std::runtime_error if file can't be opened or mapped
+         *
+         * \param path Path to the file
+         * \param access_pattern Expected access pattern passed to the OS as a hint
+         * \param preload If true, OS is asked to start reading the whole file into page cache in background
+         */
+        MappedFile(const std::string &path, AccessPattern access_pattern = AccessPattern::NORMAL, bool preload = false);
+        ~MappedFile();
+
+        MappedFile(const MappedFile &rhs) = delete;
+        MappedFile &operator=(const MappedFile &rhs) = delete;
+
+        const std::byte *data() const
+        {
+            return _data;
+        }
+
+        std::size_t size() const
+        {
+            return _size;
+        }
+
+        const std::string &path() const
+        {
+            return _path;
+        }
+
+    private:
+        std::string _path;
+        const std::byte *_data = nullptr;
+        std::size_t _size = 0;
+    };
+}
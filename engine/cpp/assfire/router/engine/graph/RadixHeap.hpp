@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace assfire::router
+{
+    /**
+     * \brief Monotone priority queue with integer keys: a key pushed must not be less than the last popped one, which always holds for Dijkstra searches.
+     *
+     * \details Items are kept in buckets by the highest bit their key differs from the last popped key in, so each item is moved between buckets
+     * at most once per bit. Bucket storage is kept on clear(), so a heap reused for many searches stops allocating after the first ones
+     */
+    template <typename Value>
+    class RadixHeap
+    {
+    public:
+        using Key = std::uint32_t;
+        using Item = std::pair<Key, Value>;
+
+        void push(Key key, Value value)
+        {
+            buckets[bucket_index(key)].emplace_back(key, value);
+            ++_size;
+        }
+
+        /**
+         * \brief Removes and returns item with the minimal key. Heap must not be empty
+         */
+        Item pop()
+        {
+            if (buckets[0].empty())
+            {
+                std::size_t index = 1;
+                while (buckets[index].empty())
+                {
+                    ++index;
+                }
+
+                Key min_key = std::numeric_limits<Key>::max();
+                for (const Item &item : buckets[index])
+                {
+                    min_key = std::min(min_key, item.first);
+                }
+                last_key = min_key;
+
+                for (const Item &item : buckets[index])
+                {
+                    buckets[bucket_index(item.first)].push_back(item); // Always goes to a lower bucket
+                }
+                buckets[index].clear();
+            }
+
+            Item result = buckets[0].back();
+            buckets[0].pop_back();
+            --_size;
+            return result;
+        }
+
+        bool empty() const
+        {
+            return _size == 0;
+        }
+
+        std::size_t size() const
+        {
+            return _size;
+        }
+
+        void clear()
+        {
+            for (std::vector<Item> &bucket : buckets)
+            {
+                bucket.clear();
+            }
+            last_key = 0;
+            _size = 0;
+        }
+
+    private:
+        std::size_t bucket_index(Key key) const
+        {
+            return std::bit_width(key ^ last_key);
+        }
+
+        std::array<std::vector<Item>, std::numeric_limits<Key>::digits + 1> buckets;
+        Key last_key = 0;
+        std::size_t _size = 0;
+    };
+}
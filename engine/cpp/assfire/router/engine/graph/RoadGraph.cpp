@@ -0,0 +1,76 @@
+#include "RoadGraph.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace assfire::router
+{
+    RoadGraph::RoadGraph(const std::string &path, bool preload) : file(path, graph_format::MAGIC, graph_format::VERSION, "road graph", preload)
+    {
+        for (const std::string &name : file.get_section_names())
+        {
+            if (name.starts_with(graph_format::WEIGHTS_SECTION_PREFIX))
+            {
+                metrics.push_back(name.substr(std::strlen(graph_format::WEIGHTS_SECTION_PREFIX)));
+            }
+        }
+
+        node_locations = get_section<graph_format::NodeLocation>(graph_format::NODE_LOCATIONS_SECTION);
+        edge_offsets = get_section<EdgeId>(graph_format::EDGE_OFFSETS_SECTION);
+        edge_targets = get_section<NodeId>(graph_format::EDGE_TARGETS_SECTION);
+        edge_lengths = get_section<Length>(graph_format::EDGE_LENGTHS_SECTION);
+        if (has_section(graph_format::TURN_ORIGINAL_NODES_SECTION))
+        {
+            original_nodes = get_section<NodeId>(graph_format::TURN_ORIGINAL_NODES_SECTION);
+            reverse_edges = get_section<EdgeId>(graph_format::TURN_REVERSE_EDGES_SECTION);
+        }
+
+        // Only sizes are checked: validating contents would touch every page of the file and defeat lazy loading
+        if (edge_offsets.size() != node_locations.size() + 1 || edge_offsets.back() != edge_targets.size() || edge_lengths.size() != edge_targets.size() ||
+            (is_turn_expanded() && (original_nodes.size() != node_locations.size() || reverse_edges.size() != edge_targets.size())))
+        {
+            throw std::runtime_error("Invalid road graph file " + path + ": inconsistent section sizes");
+        }
+        for (const std::string &metric : metrics)
+        {
+            if (get_weights(metric).size() != edge_targets.size())
+            {
+                throw std::runtime_error("Invalid road graph file " + path + ": inconsistent size of weights for metric " + metric);
+            }
+        }
+    }
+
+    RoadGraph::NodeId RoadGraph::get_edge_source(EdgeId edge) const
+    {
+        return std::upper_bound(edge_offsets.begin(), edge_offsets.end(), edge) - edge_offsets.begin() - 1;
+    }
+
+    RoadGraph::EdgeId RoadGraph::get_reverse_edge(EdgeId edge) const
+    {
+        if (is_turn_expanded())
+        {
+            return reverse_edges[edge]; // Road ends at different nodes of expanded intersections, so the reverse edge is precomputed
+        }
+
+        NodeId source = get_edge_source(edge);
+        NodeId target = get_edge_target(edge);
+        for (EdgeId candidate = edges_begin(target); candidate < edges_end(target); ++candidate)
+        {
+            if (get_edge_target(candidate) == source)
+            {
+                return candidate;
+            }
+        }
+        return NO_EDGE;
+    }
+
+    std::span<const RoadGraph::Weight> RoadGraph::get_weights(const std::string &metric) const
+    {
+        if (!file.has_section(graph_format::WEIGHTS_SECTION_PREFIX + metric))
+        {
+            throw std::invalid_argument("Unknown road graph metric: " + metric);
+        }
+        return get_section<Weight>(graph_format::WEIGHTS_SECTION_PREFIX + metric);
+    }
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
+#include "assfire/router/api/GeoPoint.hpp"
+#include "RoadGraphFormat.hpp"
+#include "SectionedFile.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief Read-only road graph backed by memory mapped binary file produced by offline preprocessing (see RoadGraphFormat.hpp).
+     *
+     * \details Opening the graph only validates file structure - no arrays are copied or built, so graph is ready for queries right away
+     * and its pages are shared between all processes that opened the same file. Graph is immutable, so it may be used from any number of threads
+     */
+    class RoadGraph
+    {
+    public:
+        using NodeId = std::uint32_t;
+        using EdgeId = std::uint32_t;
+        using Weight = std::uint32_t; // Deciseconds
+        using Length = std::uint32_t; // Decimeters
+
+        static constexpr NodeId NO_NODE = std::numeric_limits<NodeId>::max();
+        static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+        static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::max();
+
+        /**
+         * \brief Opens graph file. Throws std::runtime_error if file can't be mapped or is not a valid graph file of supported version
+         *
+         * \param path Path to the graph file
+         * \param preload If true, the whole file is read into page cache in background instead of on first access
+         */
+        explicit RoadGraph(const std::string &path, bool preload = true);
+
+        RoadGraph(const RoadGraph &rhs) = delete;
+        RoadGraph &operator=(const RoadGraph &rhs) = delete;
+
+        std::size_t nodes_count() const
+        {
+            return node_locations.size();
+        }
+
+        std::size_t edges_count() const
+        {
+            return edge_targets.size();
+        }
+
+        GeoPoint get_node_location(NodeId node) const
+        {
+            return GeoPoint(node_locations[node].lat, node_locations[node].lon);
+        }
+
+        EdgeId edges_begin(NodeId node) const
+        {
+            return edge_offsets[node];
+        }
+
+        EdgeId edges_end(NodeId node) const
+        {
+            return edge_offsets[node + 1];
+        }
+
+        NodeId get_edge_target(EdgeId edge) const
+        {
+            return edge_targets[edge];
+        }
+
+        /**
+         * \brief Returns source node of the edge. Sources are not stored in CSR form, so this takes logarithmic time
+         */
+        NodeId get_edge_source(EdgeId edge) const;
+
+        /**
+         * \brief Returns edge going in the opposite direction along the same road or NO_EDGE if the road is one-way
+         */
+        EdgeId get_reverse_edge(EdgeId edge) const;
+
+        /**
+         * \brief Tells if some intersections are split into nodes per entering and leaving road to apply turn restrictions and costs (see RoadGraphFormat.hpp)
+         */
+        bool is_turn_expanded() const
+        {
+            return !original_nodes.empty();
+        }
+
+        /**
+         * \brief Returns node representing the whole intersection the node belongs to. Nodes of not expanded intersections represent themselves
+         */
+        NodeId get_original_node(NodeId node) const
+        {
+            return original_nodes.empty() ? node : original_nodes[node];
+        }
+
+        Length get_edge_length(EdgeId edge) const
+        {
+            return edge_lengths[edge];
+        }
+
+        /**
+         * \brief Returns names of metrics (e.g. per vehicle type travel times) that have edge weights stored in the file
+         */
+        const std::vector<std::string> &get_metrics() const
+        {
+            return metrics;
+        }
+
+        /**
+         * \brief Returns travel times of all edges for specified metric. Throws std::invalid_argument if there is no such metric
+         */
+        std::span<const Weight> get_weights(const std::string &metric) const;
+
+        /**
+         * \brief Returns travel time of the edge for vehicle that can't go faster than specified speed. Zero speed doesn't limit travel time
+         */
+        static Weight limit_by_speed(Weight weight, Length length, double max_speed_meters_per_second)
+        {
+            if (max_speed_meters_per_second > 0)
+            {
+                // Decimeters divided by meters per second give deciseconds
+                double min_weight = std::ceil(length / max_speed_meters_per_second);
+                weight = std::max<double>(weight, std::min<double>(min_weight, INFINITE_WEIGHT / 2));
+            }
+            return weight;
+        }
+
+        bool has_section(const std::string &name) const
+        {
+            return file.has_section(name);
+        }
+
+        /**
+         * \brief Returns names of all sections in order they are stored in the file
+         */
+        const std::vector<std::string> &get_section_names() const
+        {
+            return file.get_section_names();
+        }
+
+        /**
+         * \brief Returns contents of named section as array of values. Throws std::runtime_error if section is absent or its size doesn't fit value type
+         */
+        template <typename T>
+        std::span<const T> get_section(const std::string &name) const
+        {
+            return file.get_section<T>(name);
+        }
+
+        const std::string &path() const
+        {
+            return file.path();
+        }
+
+    private:
+        SectionedFile file;
+        std::vector<std::string> metrics;
+
+        std::span<const graph_format::NodeLocation> node_locations;
+        std::span<const EdgeId> edge_offsets;
+        std::span<const NodeId> edge_targets;
+        std::span<const Length> edge_lengths;
+        std::span<const NodeId> original_nodes;
+        std::span<const EdgeId> reverse_edges;
+    };
+}
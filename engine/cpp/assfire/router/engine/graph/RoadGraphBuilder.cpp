@@ -0,0 +1,368 @@
+#include "RoadGraphBuilder.hpp"
+#include "CchTopology.hpp"
+#include "EdgeSpatialIndex.hpp"
+#include "TrafficWeights.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace assfire::router
+{
+    namespace
+    {
+        template <typename T>
+        std::vector<T> permute(const std::vector<T> &values, const std::vector<std::size_t> &index_by_position)
+        {
+            std::vector<T> result(values.size());
+            for (std::size_t i = 0; i < index_by_position.size(); ++i)
+            {
+                result[i] = values[index_by_position[i]];
+            }
+            return result;
+        }
+
+        std::uint32_t to_units(double value, std::uint32_t units_per_value)
+        {
+            if (!(value >= 0)) // Also rejects NaN
+            {
+                throw std::invalid_argument("Road graph edge lengths and travel times must be non-negative");
+            }
+            return static_cast<std::uint32_t>(std::lround(value * units_per_value));
+        }
+
+        /**
+         * Graph arrays with intersections that have turn data split into a node per entering and leaving edge. Edges keep their numbers,
+         * turn edges are appended after them
+         */
+        struct TurnExpansion
+        {
+            std::vector<graph_format::NodeLocation> node_locations;
+            std::vector<RoadGraph::NodeId> edges_sources;
+            std::vector<RoadGraph::NodeId> edges_targets;
+            std::vector<RoadGraph::Length> edges_lengths;
+            std::vector<std::vector<RoadGraph::Weight>> edges_weights;
+            std::vector<RoadGraph::NodeId> original_nodes;
+            std::vector<RoadGraph::EdgeId> reverse_edges;
+        };
+
+        TurnExpansion expand_turns(const std::vector<graph_format::NodeLocation> &node_locations,
+                                   const std::vector<RoadGraph::NodeId> &edges_sources,
+                                   const std::vector<RoadGraph::NodeId> &edges_targets,
+                                   const std::vector<RoadGraph::Length> &edges_lengths,
+                                   const std::vector<std::vector<RoadGraph::Weight>> &edges_weights,
+                                   const std::map<std::pair<std::size_t, std::size_t>, std::vector<RoadGraph::Weight>> &turns)
+        {
+            TurnExpansion result{node_locations, edges_sources, edges_targets, edges_lengths, edges_weights, {}, {}};
+            std::size_t roads_count = edges_sources.size();
+
+            std::vector<bool> is_expanded(node_locations.size(), false);
+            for (const auto &[turn, costs] : turns)
+            {
+                is_expanded[edges_targets[turn.first]] = true;
+            }
+            std::unordered_map<RoadGraph::NodeId, std::pair<std::vector<std::size_t>, std::vector<std::size_t>>> intersection_edges; // Entering and leaving
+            for (std::size_t edge = 0; edge < roads_count; ++edge)
+            {
+                if (is_expanded[edges_targets[edge]])
+                {
+                    intersection_edges[edges_targets[edge]].first.push_back(edge);
+                }
+                if (is_expanded[edges_sources[edge]])
+                {
+                    intersection_edges[edges_sources[edge]].second.push_back(edge);
+                }
+            }
+
+            result.original_nodes.resize(node_locations.size());
+            for (RoadGraph::NodeId node = 0; node < node_locations.size(); ++node)
+            {
+                result.original_nodes[node] = node;
+            }
+
+            for (RoadGraph::NodeId node = 0; node < node_locations.size(); ++node)
+            {
+                if (!is_expanded[node])
+                {
+                    continue;
+                }
+
+                // The first node of intersection keeps its id, so ids of not expanded nodes don't change
+                bool is_first = true;
+                auto add_node = [&]()
+                {
+                    if (std::exchange(is_first, false))
+                    {
+                        return node;
+                    }
+                    result.node_locations.push_back(node_locations[node]);
+                    result.original_nodes.push_back(node);
+                    return RoadGraph::NodeId(result.node_locations.size() - 1);
+                };
+
+                const auto &[entering_edges, leaving_edges] = intersection_edges[node];
+                for (std::size_t edge : entering_edges)
+                {
+                    result.edges_targets[edge] = add_node();
+                }
+                for (std::size_t edge : leaving_edges)
+                {
+                    result.edges_sources[edge] = add_node();
+                }
+                for (std::size_t from_edge : entering_edges)
+                {
+                    for (std::size_t to_edge : leaving_edges)
+                    {
+                        auto turn = turns.find({from_edge, to_edge});
+                        if (turn != turns.end() && turn->second.empty())
+                        {
+                            continue; // Forbidden turn
+                        }
+                        result.edges_sources.push_back(result.edges_targets[from_edge]);
+                        result.edges_targets.push_back(result.edges_sources[to_edge]);
+                        result.edges_lengths.push_back(0);
+                        for (std::size_t m = 0; m < edges_weights.size(); ++m)
+                        {
+                            result.edges_weights[m].push_back(turn != turns.end() ? turn->second[m] : 0);
+                        }
+                    }
+                }
+            }
+
+            // Roads between expanded intersections end at different nodes in each direction, so reverse edges are found by original nodes
+            std::map<std::pair<RoadGraph::NodeId, RoadGraph::NodeId>, RoadGraph::EdgeId> road_by_nodes;
+            for (std::size_t edge = 0; edge < roads_count; ++edge)
+            {
+                road_by_nodes.emplace(std::make_pair(edges_sources[edge], edges_targets[edge]), edge);
+            }
+            result.reverse_edges.assign(result.edges_sources.size(), RoadGraph::NO_EDGE);
+            for (std::size_t edge = 0; edge < roads_count; ++edge)
+            {
+                auto reverse_edge = road_by_nodes.find({edges_targets[edge], edges_sources[edge]});
+                if (reverse_edge != road_by_nodes.end())
+                {
+                    result.reverse_edges[edge] = reverse_edge->second;
+                }
+            }
+            return result;
+        }
+    }
+
+    RoadGraphBuilder::RoadGraphBuilder(std::vector<std::string> metrics) : metrics(std::move(metrics)),
+                                                                           edges_weights(this->metrics.size()),
+                                                                           traffic_header{graph_format::FIRST_MONDAY_SECONDS, graph_format::WEEK_SECONDS, 0},
+                                                                           edges_traffic(this->metrics.size())
+    {
+    }
+
+    RoadGraphBuilder::NodeId RoadGraphBuilder::add_node(const GeoPoint &location)
+    {
+        node_locations.push_back(graph_format::NodeLocation{location.lat(), location.lon()});
+        return node_locations.size() - 1;
+    }
+
+    std::size_t RoadGraphBuilder::add_edge(NodeId from, NodeId to, RouteInfo::Meters length_meters, std::span<const double> travel_times_seconds)
+    {
+        if (from >= node_locations.size() || to >= node_locations.size())
+        {
+            throw std::invalid_argument("Road graph edge references unknown node");
+        }
+        if (travel_times_seconds.size() != metrics.size())
+        {
+            throw std::invalid_argument("Road graph edge must have travel time for each metric");
+        }
+
+        edges_sources.push_back(from);
+        edges_targets.push_back(to);
+        edges_lengths.push_back(to_units(length_meters, graph_format::LENGTH_UNITS_PER_METER));
+        for (std::size_t m = 0; m < metrics.size(); ++m)
+        {
+            edges_weights[m].push_back(to_units(travel_times_seconds[m], graph_format::WEIGHT_UNITS_PER_SECOND));
+        }
+        return edges_sources.size() - 1;
+    }
+
+    void RoadGraphBuilder::set_traffic_period(std::int64_t period_start, std::uint32_t period_seconds)
+    {
+        if (period_seconds == 0)
+        {
+            throw std::invalid_argument("Traffic period must be positive");
+        }
+        for (const auto &metric_traffic : edges_traffic)
+        {
+            for (const auto &[edge, points] : metric_traffic)
+            {
+                TrafficWeights::validate(points, period_seconds);
+            }
+        }
+        traffic_header.period_start = period_start;
+        traffic_header.period_seconds = period_seconds;
+    }
+
+    void RoadGraphBuilder::set_edge_traffic(std::size_t edge, const std::string &metric, std::span<const std::uint32_t> times_seconds, std::span<const double> travel_times_seconds)
+    {
+        auto metric_iter = std::find(metrics.begin(), metrics.end(), metric);
+        if (metric_iter == metrics.end())
+        {
+            throw std::invalid_argument("Unknown road graph metric " + metric);
+        }
+        if (edge >= edges_sources.size())
+        {
+            throw std::invalid_argument("Traffic references unknown road graph edge");
+        }
+        if (times_seconds.size() != travel_times_seconds.size())
+        {
+            throw std::invalid_argument("Traffic breakpoints must have travel time for each time");
+        }
+
+        std::vector<graph_format::TrafficPoint> points;
+        for (std::size_t i = 0; i < times_seconds.size(); ++i)
+        {
+            points.push_back(graph_format::TrafficPoint{times_seconds[i], to_units(travel_times_seconds[i], graph_format::WEIGHT_UNITS_PER_SECOND)});
+        }
+        TrafficWeights::validate(points, traffic_header.period_seconds);
+
+        auto &metric_traffic = edges_traffic[metric_iter - metrics.begin()];
+        if (points.empty())
+        {
+            metric_traffic.erase(edge);
+        }
+        else
+        {
+            metric_traffic[edge] = std::move(points);
+        }
+    }
+
+    void RoadGraphBuilder::add_turn_restriction(std::size_t from_edge, std::size_t to_edge)
+    {
+        validate_turn(from_edge, to_edge);
+        turns[{from_edge, to_edge}].clear();
+    }
+
+    void RoadGraphBuilder::add_turn_cost(std::size_t from_edge, std::size_t to_edge, std::span<const double> travel_times_seconds)
+    {
+        validate_turn(from_edge, to_edge);
+        if (travel_times_seconds.size() != metrics.size())
+        {
+            throw std::invalid_argument("Turn must have travel time for each metric");
+        }
+
+        std::vector<RoadGraph::Weight> costs;
+        for (double travel_time_seconds : travel_times_seconds)
+        {
+            costs.push_back(to_units(travel_time_seconds, graph_format::WEIGHT_UNITS_PER_SECOND));
+        }
+        auto turn = turns.find({from_edge, to_edge});
+        if (turn == turns.end() || !turn->second.empty()) // Restriction is not relaxed by a cost
+        {
+            turns[{from_edge, to_edge}] = std::move(costs);
+        }
+    }
+
+    void RoadGraphBuilder::validate_turn(std::size_t from_edge, std::size_t to_edge) const
+    {
+        if (from_edge >= edges_sources.size() || to_edge >= edges_sources.size())
+        {
+            throw std::invalid_argument("Turn references unknown road graph edge");
+        }
+        if (edges_targets[from_edge] != edges_sources[to_edge])
+        {
+            throw std::invalid_argument("Turn must connect edges meeting at the same node");
+        }
+    }
+
+    void RoadGraphBuilder::build(RoadGraphFileWriter &writer) const
+    {
+        std::optional<TurnExpansion> expansion;
+        if (!turns.empty())
+        {
+            expansion = expand_turns(node_locations, edges_sources, edges_targets, edges_lengths, edges_weights, turns);
+        }
+        const std::vector<graph_format::NodeLocation> &node_locations = expansion ? expansion->node_locations : this->node_locations;
+        const std::vector<NodeId> &edges_sources = expansion ? expansion->edges_sources : this->edges_sources;
+        const std::vector<NodeId> &edges_targets = expansion ? expansion->edges_targets : this->edges_targets;
+        const std::vector<RoadGraph::Length> &edges_lengths = expansion ? expansion->edges_lengths : this->edges_lengths;
+        const std::vector<std::vector<RoadGraph::Weight>> &edges_weights = expansion ? expansion->edges_weights : this->edges_weights;
+
+        // Counting sort by source node keeps edges of the same node in order of addition
+        std::vector<RoadGraph::EdgeId> offsets(node_locations.size() + 1, 0);
+        for (NodeId source : edges_sources)
+        {
+            ++offsets[source + 1];
+        }
+        for (std::size_t node = 0; node < node_locations.size(); ++node)
+        {
+            offsets[node + 1] += offsets[node];
+        }
+
+        std::vector<RoadGraph::EdgeId> next_position(offsets.begin(), offsets.end() - 1);
+        std::vector<std::size_t> edge_by_position(edges_sources.size());
+        for (std::size_t edge = 0; edge < edges_sources.size(); ++edge)
+        {
+            edge_by_position[next_position[edges_sources[edge]]++] = edge;
+        }
+
+        std::vector<NodeId> targets = permute(edges_targets, edge_by_position);
+        writer.add_section(graph_format::NODE_LOCATIONS_SECTION, node_locations);
+        writer.add_section(graph_format::EDGE_OFFSETS_SECTION, offsets);
+        writer.add_section(graph_format::EDGE_TARGETS_SECTION, targets);
+        writer.add_section(graph_format::EDGE_LENGTHS_SECTION, permute(edges_lengths, edge_by_position));
+        for (std::size_t m = 0; m < metrics.size(); ++m)
+        {
+            writer.add_section(graph_format::WEIGHTS_SECTION_PREFIX + metrics[m], permute(edges_weights[m], edge_by_position));
+        }
+        if (expansion)
+        {
+            std::vector<RoadGraph::EdgeId> position_by_edge(edge_by_position.size());
+            for (std::size_t position = 0; position < edge_by_position.size(); ++position)
+            {
+                position_by_edge[edge_by_position[position]] = position;
+            }
+            std::vector<RoadGraph::EdgeId> reverse_edges(edge_by_position.size());
+            for (std::size_t position = 0; position < edge_by_position.size(); ++position)
+            {
+                RoadGraph::EdgeId reverse_edge = expansion->reverse_edges[edge_by_position[position]];
+                reverse_edges[position] = reverse_edge != RoadGraph::NO_EDGE ? position_by_edge[reverse_edge] : RoadGraph::NO_EDGE;
+            }
+            writer.add_section(graph_format::TURN_ORIGINAL_NODES_SECTION, expansion->original_nodes);
+            writer.add_section(graph_format::TURN_REVERSE_EDGES_SECTION, reverse_edges);
+        }
+        for (std::size_t m = 0; m < metrics.size(); ++m)
+        {
+            if (edges_traffic[m].empty())
+            {
+                continue;
+            }
+
+            std::vector<std::uint32_t> traffic_offsets(edge_by_position.size() + 1, 0);
+            std::vector<graph_format::TrafficPoint> traffic_points;
+            for (std::size_t position = 0; position < edge_by_position.size(); ++position)
+            {
+                auto points = edges_traffic[m].find(edge_by_position[position]);
+                if (points != edges_traffic[m].end())
+                {
+                    traffic_points.insert(traffic_points.end(), points->second.begin(), points->second.end());
+                }
+                traffic_offsets[position + 1] = traffic_points.size();
+            }
+
+            std::string prefix = graph_format::TRAFFIC_SECTION_PREFIX + metrics[m];
+            writer.add_section(prefix, std::vector<graph_format::TrafficHeader>{traffic_header});
+            writer.add_section(prefix + graph_format::TRAFFIC_OFFSETS_SECTION_SUFFIX, traffic_offsets);
+            writer.add_section(prefix + graph_format::TRAFFIC_POINTS_SECTION_SUFFIX, traffic_points);
+        }
+        EdgeSpatialIndex::build(node_locations, offsets, targets, writer);
+        CchTopology::build(node_locations, offsets, targets, writer);
+    }
+
+    void RoadGraphBuilder::write(const std::string &path) const
+    {
+        RoadGraphFileWriter writer;
+        build(writer);
+        writer.write(path);
+    }
+}
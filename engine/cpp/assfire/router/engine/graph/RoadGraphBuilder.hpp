@@ -0,0 +1,109 @@
+#pragma once
+
+#include <map>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "assfire/router/api/GeoPoint.hpp"
+#include "assfire/router/api/RouteInfo.hpp"
+#include "RoadGraph.hpp"
+#include "RoadGraphFileWriter.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief Collects road network nodes and directed edges in arbitrary order and converts them into CSR arrays of the binary road graph file
+     */
+    class RoadGraphBuilder
+    {
+    public:
+        using NodeId = RoadGraph::NodeId;
+
+        /**
+         * \brief Construct a new RoadGraphBuilder object
+         *
+         * \param metrics Names of metrics every edge has travel time for
+         */
+        explicit RoadGraphBuilder(std::vector<std::string> metrics);
+
+        NodeId add_node(const GeoPoint &location);
+
+        /**
+         * \brief Adds directed edge. Two-way roads are represented by 2 edges
+         *
+         * \param from Source node
+         * \param to Target node
+         * \param length_meters Edge length
+         * \param travel_times_seconds Edge travel time for each metric in order of metrics passed to constructor
+         * \return Number of the edge in order of addition
+         */
+        std::size_t add_edge(NodeId from, NodeId to, RouteInfo::Meters length_meters, std::span<const double> travel_times_seconds);
+
+        /**
+         * \brief Sets period time-dependent travel times repeat with. By default they repeat weekly starting from Monday 00:00 UTC
+         *
+         * \param period_start Unix time of the start of any period, seconds
+         */
+        void set_traffic_period(std::int64_t period_start, std::uint32_t period_seconds);
+
+        /**
+         * \brief Sets time-dependent travel times of the edge for the metric, linearly interpolated between breakpoints and repeated every period.
+         * Throws std::invalid_argument if breakpoints are not sorted, don't fit the period or let vehicle leave the edge earlier by entering it later
+         *
+         * \param edge Number of the edge in order of addition
+         * \param times_seconds Times of breakpoints since period start
+         * \param travel_times_seconds Edge travel times at breakpoints
+         */
+        void set_edge_traffic(std::size_t edge, const std::string &metric, std::span<const std::uint32_t> times_seconds, std::span<const double> travel_times_seconds);
+
+        /**
+         * \brief Forbids turning from one edge into another one leaving target node of the first. Intersections with turn restrictions or costs
+         * are expanded into a node per entering and leaving edge when the graph is built, so turns are respected by all searches over the graph
+         *
+         * \param from_edge Number of edge entering the intersection in order of addition
+         * \param to_edge Number of edge leaving the intersection in order of addition
+         */
+        void add_turn_restriction(std::size_t from_edge, std::size_t to_edge);
+
+        /**
+         * \brief Sets travel time of turning from one edge into another one leaving target node of the first. Turns without costs are free
+         *
+         * \param travel_times_seconds Turn travel time for each metric in order of metrics passed to constructor
+         */
+        void add_turn_cost(std::size_t from_edge, std::size_t to_edge, std::span<const double> travel_times_seconds);
+
+        std::size_t nodes_count() const
+        {
+            return node_locations.size();
+        }
+
+        std::size_t edges_count() const
+        {
+            return edges_sources.size();
+        }
+
+        /**
+         * \brief Adds sections describing collected graph, its spatial index and contraction hierarchy topology to the writer
+         */
+        void build(RoadGraphFileWriter &writer) const;
+
+        /**
+         * \brief Writes collected graph to the file at specified path
+         */
+        void write(const std::string &path) const;
+
+    private:
+        void validate_turn(std::size_t from_edge, std::size_t to_edge) const;
+
+        std::vector<std::string> metrics;
+        std::vector<graph_format::NodeLocation> node_locations;
+        std::vector<NodeId> edges_sources;
+        std::vector<NodeId> edges_targets;
+        std::vector<RoadGraph::Length> edges_lengths;
+        std::vector<std::vector<RoadGraph::Weight>> edges_weights; // By metric
+        graph_format::TrafficHeader traffic_header;
+        std::vector<std::unordered_map<std::size_t, std::vector<graph_format::TrafficPoint>>> edges_traffic; // By metric, then by edge
+        std::map<std::pair<std::size_t, std::size_t>, std::vector<RoadGraph::Weight>> turns;                // Costs by metric, no costs for forbidden turns
+    };
+}
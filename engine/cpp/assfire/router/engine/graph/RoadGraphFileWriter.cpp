@@ -0,0 +1,91 @@
+#include "RoadGraphFileWriter.hpp"
+#include "RoadGraphFormat.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace assfire::router
+{
+    RoadGraphFileWriter::RoadGraphFileWriter() : RoadGraphFileWriter(graph_format::MAGIC, graph_format::VERSION)
+    {
+    }
+
+    RoadGraphFileWriter::RoadGraphFileWriter(const char (&magic)[8], std::uint32_t version) : version(version)
+    {
+        std::memcpy(this->magic, magic, sizeof(this->magic));
+    }
+
+    void RoadGraphFileWriter::add_section_bytes(const std::string &name, std::vector<std::byte> data)
+    {
+        if (name.empty() || name.size() >= graph_format::SECTION_NAME_SIZE)
+        {
+            throw std::invalid_argument("Invalid road graph section name: " + name);
+        }
+        for (const Section &section : sections)
+        {
+            if (section.name == name)
+            {
+                throw std::invalid_argument("Duplicate road graph section: " + name);
+            }
+        }
+        sections.push_back(Section{name, std::move(data)});
+    }
+
+    void RoadGraphFileWriter::write(const std::string &path) const
+    {
+        auto align = [](std::uint64_t offset)
+        {
+            return (offset + graph_format::SECTION_ALIGNMENT - 1) / graph_format::SECTION_ALIGNMENT * graph_format::SECTION_ALIGNMENT;
+        };
+
+        graph_format::FileHeader header;
+        std::memcpy(header.magic, magic, sizeof(header.magic));
+        header.version = version;
+        header.sections_count = sections.size();
+
+        std::vector<graph_format::SectionEntry> entries(sections.size());
+        std::uint64_t offset = align(sizeof(header) + entries.size() * sizeof(graph_format::SectionEntry));
+        for (std::size_t i = 0; i < sections.size(); ++i)
+        {
+            std::memset(entries[i].name, 0, sizeof(entries[i].name));
+            std::memcpy(entries[i].name, sections[i].name.data(), sections[i].name.size());
+            entries[i].offset = offset;
+            entries[i].size = sections[i].data.size();
+            offset = align(offset + entries[i].size);
+        }
+
+        std::string temporary_path = path + ".tmp";
+        {
+            std::ofstream out(temporary_path, std::ios::binary | std::ios::trunc);
+            if (!out)
+            {
+                throw std::runtime_error("Failed to open " + temporary_path + " for writing");
+            }
+
+            const char padding[graph_format::SECTION_ALIGNMENT] = {};
+            out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(graph_format::SectionEntry));
+            std::uint64_t written = sizeof(header) + entries.size() * sizeof(graph_format::SectionEntry);
+            for (std::size_t i = 0; i < sections.size(); ++i)
+            {
+                out.write(padding, entries[i].offset - written);
+                out.write(reinterpret_cast<const char *>(sections[i].data.data()), sections[i].data.size());
+                written = entries[i].offset + entries[i].size;
+            }
+            out.write(padding, offset - written); // Keeps offsets of trailing empty sections inside the file
+
+            out.flush();
+            if (!out)
+            {
+                throw std::runtime_error("Failed to write " + temporary_path);
+            }
+        }
+
+        if (std::rename(temporary_path.c_str(), path.c_str()) != 0)
+        {
+            throw std::runtime_error("Failed to rename " + temporary_path + " to " + path);
+        }
+    }
+}
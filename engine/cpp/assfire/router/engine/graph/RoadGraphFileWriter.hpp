@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace assfire::router
+{
+    /**
+     * \brief Writes named sections into a binary road graph file (see RoadGraphFormat.hpp). Sections are written in order of addition.
+     * Other files with the same layout (see SectionedFile) are written by specifying their magic and version
+     */
+    class RoadGraphFileWriter
+    {
+    public:
+        RoadGraphFileWriter();
+        RoadGraphFileWriter(const char (&magic)[8], std::uint32_t version);
+
+        template <typename T>
+        void add_section(const std::string &name, std::span<const T> values)
+        {
+            const std::byte *bytes = reinterpret_cast<const std::byte *>(values.data());
+            add_section_bytes(name, std::vector<std::byte>(bytes, bytes + values.size_bytes()));
+        }
+
+        template <typename T>
+        void add_section(const std::string &name, const std::vector<T> &values)
+        {
+            add_section(name, std::span<const T>(values));
+        }
+
+        /**
+         * \brief Writes file to specified path. File is written to a temporary path and renamed, so processes that have old file mapped keep using it.
+         * Throws std::runtime_error on write errors
+         */
+        void write(const std::string &path) const;
+
+    private:
+        struct Section
+        {
+            std::string name;
+            std::vector<std::byte> data;
+        };
+
+        void add_section_bytes(const std::string &name, std::vector<std::byte> data);
+
+        char magic[8];
+        std::uint32_t version;
+        std::vector<Section> sections;
+    };
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace assfire::router::graph_format
+{
+    /**
+     * \brief Layout of binary road graph file. The file is meant to be memory mapped as is, so all arrays are stored in native (little-endian) byte order
+     * and every section starts at SECTION_ALIGNMENT boundary.
+     *
+     * \details File starts with FileHeader followed by sections_count SectionEntry records. Each entry describes one named section - a plain array
+     * of fixed-size values. Graph is stored in CSR form: outgoing edges of node v are edges [edge_offsets[v], edge_offsets[v + 1]).
+     * Sections that are unknown to the reader are ignored, so new sections may be added without bumping the version
+     */
+    constexpr char MAGIC[8] = {'A', 'S', 'F', 'R', 'G', 'R', 'P', 'H'};
+    constexpr std::uint32_t VERSION = 1;
+    constexpr std::size_t SECTION_ALIGNMENT = 64;
+    constexpr std::size_t SECTION_NAME_SIZE = 48;
+
+    // Edge lengths are stored in decimeters and travel times in deciseconds to keep precision of summed integer values
+    constexpr std::uint32_t LENGTH_UNITS_PER_METER = 10;
+    constexpr std::uint32_t WEIGHT_UNITS_PER_SECOND = 10;
+
+    constexpr const char *NODE_LOCATIONS_SECTION = "node_locations"; // NodeLocation[nodes_count]
+    constexpr const char *EDGE_OFFSETS_SECTION = "edge_offsets";     // uint32[nodes_count + 1]
+    constexpr const char *EDGE_TARGETS_SECTION = "edge_targets";     // uint32[edges_count]
+    constexpr const char *EDGE_LENGTHS_SECTION = "edge_lengths";     // uint32[edges_count], decimeters
+    constexpr const char *WEIGHTS_SECTION_PREFIX = "weights/";       // uint32[edges_count], deciseconds. One section per metric
+
+    // Optional uniform grid over edges used to snap points to the road network. Edge is listed in every cell its bounding box intersects
+    constexpr const char *GRID_SECTION = "grid";                        // GridHeader[1]
+    constexpr const char *GRID_CELL_OFFSETS_SECTION = "grid/offsets";   // uint32[rows * columns + 1]
+    constexpr const char *GRID_CELL_EDGES_SECTION = "grid/edges";       // uint32[], edge ids of each cell
+
+    // Optional metric-independent contraction hierarchy (customizable CH). Nodes are identified by rank, arcs go from lower to higher rank
+    constexpr const char *CCH_RANKS_SECTION = "cch/ranks";               // uint32[nodes_count], rank of each node
+    constexpr const char *CCH_NODES_SECTION = "cch/nodes";               // uint32[nodes_count], node of each rank
+    constexpr const char *CCH_PARENTS_SECTION = "cch/parents";           // uint32[nodes_count], elimination tree parent rank of each rank
+    constexpr const char *CCH_UP_OFFSETS_SECTION = "cch/up_offsets";     // uint32[nodes_count + 1]
+    constexpr const char *CCH_UP_HEADS_SECTION = "cch/up_heads";         // uint32[arcs_count], higher rank of each arc, sorted per rank
+    constexpr const char *CCH_DOWN_OFFSETS_SECTION = "cch/down_offsets"; // uint32[nodes_count + 1]
+    constexpr const char *CCH_DOWN_ARCS_SECTION = "cch/down_arcs";       // uint32[arcs_count], arcs ending at each rank ordered by their lower rank
+    constexpr const char *CCH_EDGE_ARCS_SECTION = "cch/edge_arcs";       // uint32[edges_count], arc of each graph edge, max value for loops
+
+    // Optional time-dependent travel times of a metric. Travel time of an edge is a periodic piecewise linear function of the time the edge is entered at,
+    // given by breakpoints sorted by time of period. Edges with no breakpoints keep static weight of the metric
+    constexpr const char *TRAFFIC_SECTION_PREFIX = "traffic/";          // traffic/<metric>: TrafficHeader[1]
+    constexpr const char *TRAFFIC_OFFSETS_SECTION_SUFFIX = "/offsets";  // traffic/<metric>/offsets: uint32[edges_count + 1]
+    constexpr const char *TRAFFIC_POINTS_SECTION_SUFFIX = "/points";    // traffic/<metric>/points: TrafficPoint[], breakpoints of each edge
+
+    // Optional turn expansion. Intersections with turn restrictions or turn costs are split into a node per road entering them and a node per road leaving them,
+    // connected by zero length turn edges weighted with turn costs. Forbidden turns have no edge. The rest of the graph keeps node-based form,
+    // so expansion only costs memory at intersections that have turn data and the expanded graph is routed and contracted as any other graph
+    constexpr const char *TURN_ORIGINAL_NODES_SECTION = "turns/original_nodes"; // uint32[nodes_count], intersection each node belongs to
+    constexpr const char *TURN_REVERSE_EDGES_SECTION = "turns/reverse_edges";   // uint32[edges_count], edge going back along the same road, max value if none
+
+    constexpr std::uint32_t WEEK_SECONDS = 7 * 24 * 60 * 60;
+    constexpr std::int64_t FIRST_MONDAY_SECONDS = 4 * 24 * 60 * 60; // 1970-01-05 00:00 UTC, start of weekly periods
+
+    struct FileHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t sections_count;
+    };
+
+    struct SectionEntry
+    {
+        char name[SECTION_NAME_SIZE];
+        std::uint64_t offset;
+        std::uint64_t size;
+    };
+
+    struct NodeLocation
+    {
+        std::int32_t lat;
+        std::int32_t lon;
+    };
+
+    struct GridHeader
+    {
+        std::int32_t min_lat; // Fixed point coordinates of the south-west grid corner
+        std::int32_t min_lon;
+        std::uint32_t cell_size; // Fixed point degrees, same for both dimensions
+        std::uint32_t rows;
+        std::uint32_t columns;
+        std::uint32_t reserved;
+    };
+
+    struct TrafficHeader
+    {
+        std::int64_t period_start; // Unix time of the start of any period, seconds
+        std::uint32_t period_seconds;
+        std::uint32_t reserved;
+    };
+
+    struct TrafficPoint
+    {
+        std::uint32_t time; // Seconds since period start
+        std::uint32_t weight;
+    };
+
+    static_assert(sizeof(FileHeader) == 16);
+    static_assert(sizeof(SectionEntry) == 64);
+    static_assert(sizeof(NodeLocation) == 8);
+    static_assert(sizeof(GridHeader) == 24);
+    static_assert(sizeof(TrafficHeader) == 16);
+    static_assert(sizeof(TrafficPoint) == 8);
+}
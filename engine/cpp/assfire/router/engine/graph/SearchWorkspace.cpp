@@ -0,0 +1,31 @@
+#include "SearchWorkspace.hpp"
+
+#include <algorithm>
+
+namespace assfire::router
+{
+    SearchWorkspace &SearchWorkspace::acquire(std::size_t nodes_count)
+    {
+        thread_local SearchWorkspace workspace;
+        workspace.reset(nodes_count);
+        return workspace;
+    }
+
+    void SearchWorkspace::reset(std::size_t nodes_count)
+    {
+        if (stamps.size() < nodes_count)
+        {
+            // Grows only, so a thread serving several graphs keeps the workspace of the biggest one
+            states.resize(nodes_count);
+            stamps.resize(nodes_count, 0);
+        }
+
+        ++current_stamp;
+        if (current_stamp == 0)
+        {
+            std::fill(stamps.begin(), stamps.end(), 0);
+            current_stamp = 1;
+        }
+        _queue.clear();
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "RadixHeap.hpp"
+#include "RoadGraph.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief Per-node state of a graph search (tentative weights, parents, target marks) and its priority queue that are reused between searches.
+     *
+     * \details Instead of clearing O(V) arrays before each search, every node state is stamped with the number of the search it was written by:
+     * state with an outdated stamp is treated as unreached. Arrays are only cleared when stamp counter wraps around.
+     *
+     * Workspace is not thread-safe. Use acquire() to get a workspace of the current thread
+     */
+    class SearchWorkspace
+    {
+    public:
+        using NodeId = RoadGraph::NodeId;
+        using EdgeId = RoadGraph::EdgeId;
+        using Weight = RoadGraph::Weight;
+
+        /**
+         * \brief Returns reset workspace of the current thread big enough for the graph with specified count of nodes.
+         * Previously acquired workspace of the same thread is invalidated, so searches on the same thread must not be interleaved
+         */
+        static SearchWorkspace &acquire(std::size_t nodes_count);
+
+        /**
+         * \brief Makes all nodes unreached and unmarked and clears the queue
+         */
+        void reset(std::size_t nodes_count);
+
+        Weight get_weight(NodeId node) const
+        {
+            return stamps[node] == current_stamp ? states[node].weight : RoadGraph::INFINITE_WEIGHT;
+        }
+
+        NodeId get_parent_node(NodeId node) const
+        {
+            return stamps[node] == current_stamp ? states[node].parent_node : RoadGraph::NO_NODE;
+        }
+
+        EdgeId get_parent_edge(NodeId node) const
+        {
+            return stamps[node] == current_stamp ? states[node].parent_edge : RoadGraph::NO_EDGE;
+        }
+
+        void set_weight(NodeId node, Weight weight, NodeId parent_node, EdgeId parent_edge)
+        {
+            if (stamps[node] != current_stamp)
+            {
+                stamps[node] = current_stamp;
+                states[node].is_target = false;
+            }
+            states[node].weight = weight;
+            states[node].parent_node = parent_node;
+            states[node].parent_edge = parent_edge;
+        }
+
+        /**
+         * \brief Marks node as a search target. Returns false if it was already marked during this search
+         */
+        bool mark_target(NodeId node)
+        {
+            if (stamps[node] != current_stamp)
+            {
+                stamps[node] = current_stamp;
+                states[node] = NodeState();
+            }
+            bool was_target = states[node].is_target;
+            states[node].is_target = true;
+            return !was_target;
+        }
+
+        /**
+         * \brief Removes target mark from the node. Returns false if node wasn't marked
+         */
+        bool unmark_target(NodeId node)
+        {
+            if (stamps[node] != current_stamp || !states[node].is_target)
+            {
+                return false;
+            }
+            states[node].is_target = false;
+            return true;
+        }
+
+        RadixHeap<NodeId> &queue()
+        {
+            return _queue;
+        }
+
+    private:
+        using Stamp = std::uint32_t;
+
+        struct NodeState
+        {
+            Weight weight = RoadGraph::INFINITE_WEIGHT;
+            NodeId parent_node = RoadGraph::NO_NODE;
+            EdgeId parent_edge = RoadGraph::NO_EDGE;
+            bool is_target = false;
+        };
+
+        std::vector<NodeState> states;
+        std::vector<Stamp> stamps;
+        Stamp current_stamp = 0;
+        RadixHeap<NodeId> _queue;
+    };
+}
@@ -0,0 +1,58 @@
+#include "SectionedFile.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace assfire::router
+{
+    SectionedFile::SectionedFile(const std::string &path, const char (&magic)[8], std::uint32_t version, const std::string &description, bool preload)
+        : file(path, MappedFile::AccessPattern::RANDOM, preload),
+          description(description)
+    {
+        if (file.size() < sizeof(graph_format::FileHeader))
+        {
+            throw std::runtime_error("Invalid " + description + " file " + path + ": file is too small");
+        }
+
+        const graph_format::FileHeader *header = reinterpret_cast<const graph_format::FileHeader *>(file.data());
+        if (std::memcmp(header->magic, magic, sizeof(magic)) != 0)
+        {
+            throw std::runtime_error("Invalid " + description + " file " + path + ": wrong magic");
+        }
+        if (header->version != version)
+        {
+            throw std::runtime_error("Unsupported " + description + " file " + path + " version: " + std::to_string(header->version));
+        }
+        if (file.size() < sizeof(graph_format::FileHeader) + std::size_t(header->sections_count) * sizeof(graph_format::SectionEntry))
+        {
+            throw std::runtime_error("Invalid " + description + " file " + path + ": truncated section table");
+        }
+
+        const graph_format::SectionEntry *entries = reinterpret_cast<const graph_format::SectionEntry *>(file.data() + sizeof(graph_format::FileHeader));
+        for (std::uint32_t i = 0; i < header->sections_count; ++i)
+        {
+            const graph_format::SectionEntry &entry = entries[i];
+            std::string name(entry.name, strnlen(entry.name, graph_format::SECTION_NAME_SIZE));
+            if (entry.offset % graph_format::SECTION_ALIGNMENT != 0 || entry.offset > file.size() || entry.size > file.size() - entry.offset)
+            {
+                throw std::runtime_error("Invalid " + description + " file " + path + ": section " + name + " is out of file bounds");
+            }
+            sections.emplace(name, std::span<const std::byte>(file.data() + entry.offset, entry.size));
+            section_names.push_back(name);
+        }
+    }
+
+    std::span<const std::byte> SectionedFile::get_section_bytes(const std::string &name, std::size_t value_size) const
+    {
+        auto iter = sections.find(name);
+        if (iter == sections.end())
+        {
+            throw std::runtime_error("No section " + name + " in " + description + " file " + path());
+        }
+        if (iter->second.size() % value_size != 0)
+        {
+            throw std::runtime_error("Invalid size of section " + name + " in " + description + " file " + path());
+        }
+        return iter->second;
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "MappedFile.hpp"
+#include "RoadGraphFormat.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief Memory mapped file of named sections in the layout of road graph file (see RoadGraphFormat.hpp) with its own magic and version.
+     * Only the section table is validated on opening, section contents are accessed lazily
+     */
+    class SectionedFile
+    {
+    public:
+        /**
+         * \brief Opens and validates the file. Throws std::runtime_error if file can't be mapped, has different magic or version or invalid section table
+         *
+         * \param path Path to the file
+         * \param magic Expected magic of the file
+         * \param version Expected version of the file
+         * \param description File kind used in error messages, e.g. "road graph"
+         * \param preload If true, the whole file is read into page cache in background instead of on first access
+         */
+        SectionedFile(const std::string &path, const char (&magic)[8], std::uint32_t version, const std::string &description, bool preload);
+
+        bool has_section(const std::string &name) const
+        {
+            return sections.contains(name);
+        }
+
+        /**
+         * \brief Returns names of all sections in order they are stored in the file
+         */
+        const std::vector<std::string> &get_section_names() const
+        {
+            return section_names;
+        }
+
+        /**
+         * \brief Returns contents of named section as array of values. Throws std::runtime_error if section is absent or its size doesn't fit value type
+         */
+        template <typename T>
+        std::span<const T> get_section(const std::string &name) const
+        {
+            std::span<const std::byte> section = get_section_bytes(name, sizeof(T));
+            return std::span<const T>(reinterpret_cast<const T *>(section.data()), section.size() / sizeof(T));
+        }
+
+        const std::string &path() const
+        {
+            return file.path();
+        }
+
+    private:
+        std::span<const std::byte> get_section_bytes(const std::string &name, std::size_t value_size) const;
+
+        MappedFile file;
+        std::string description;
+        std::unordered_map<std::string, std::span<const std::byte>> sections;
+        std::vector<std::string> section_names;
+    };
+}
@@ -0,0 +1,49 @@
+#include "ShortcutGeometryCache.hpp"
+
+#include <algorithm>
+
+namespace assfire::router
+{
+    ShortcutGeometryCache::ShortcutGeometryCache(std::size_t capacity_nodes) : shard_capacity_nodes(std::max<std::size_t>(capacity_nodes / SHARDS_COUNT, 1))
+    {
+    }
+
+    ShortcutGeometryCache::Nodes ShortcutGeometryCache::get(ArcId arc, bool is_upward)
+    {
+        Shard &shard = get_shard(arc);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto iter = shard.entry_by_key.find(get_key(arc, is_upward));
+        if (iter == shard.entry_by_key.end())
+        {
+            return nullptr;
+        }
+        shard.entries.splice(shard.entries.begin(), shard.entries, iter->second);
+        return iter->second->second;
+    }
+
+    void ShortcutGeometryCache::put(ArcId arc, bool is_upward, Nodes nodes)
+    {
+        if (!nodes || nodes->size() > shard_capacity_nodes)
+        {
+            return;
+        }
+
+        Shard &shard = get_shard(arc);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        Key key = get_key(arc, is_upward);
+        if (shard.entry_by_key.contains(key))
+        {
+            return; // Unpacked concurrently by another query
+        }
+
+        while (shard.nodes_count + nodes->size() > shard_capacity_nodes)
+        {
+            shard.nodes_count -= shard.entries.back().second->size();
+            shard.entry_by_key.erase(shard.entries.back().first);
+            shard.entries.pop_back();
+        }
+        shard.nodes_count += nodes->size();
+        shard.entries.emplace_front(key, std::move(nodes));
+        shard.entry_by_key.emplace(key, shard.entries.begin());
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "RoadGraph.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief Graph nodes of unpacked contraction hierarchy shortcuts of one customized metric keyed by arc and direction. Shortcuts high in the hierarchy
+     * are passed by most long routes, and unpacking them recursively costs two arc lookups per lower triangle, so their nodes are unpacked once and copied afterwards.
+     *
+     * \details Cache is limited by total count of cached nodes. It is split into shards by arc, each guarded by its own mutex and evicting
+     * its least recently used shortcuts, so concurrent queries rarely wait for each other. Cache is thread-safe
+     */
+    class ShortcutGeometryCache
+    {
+    public:
+        using NodeId = RoadGraph::NodeId;
+        using ArcId = std::uint32_t;
+        using Nodes = std::shared_ptr<const std::vector<NodeId>>;
+
+        static constexpr std::size_t DEFAULT_CAPACITY_NODES = std::size_t(1) << 24;
+
+        /**
+         * \brief Shortcuts with fewer nodes are cheaper to unpack than to look up, so they are not cached
+         */
+        static constexpr std::size_t MIN_CACHED_NODES = 16;
+
+        explicit ShortcutGeometryCache(std::size_t capacity_nodes = DEFAULT_CAPACITY_NODES);
+
+        /**
+         * \brief Returns nodes of the shortcut, excluding its first node, or null if shortcut is not cached
+         */
+        Nodes get(ArcId arc, bool is_upward);
+        void put(ArcId arc, bool is_upward, Nodes nodes);
+
+    private:
+        static constexpr std::size_t SHARDS_COUNT = 16;
+
+        using Key = std::uint64_t;
+        using Entries = std::list<std::pair<Key, Nodes>>; // Most recently used first
+
+        struct Shard
+        {
+            std::mutex mutex;
+            Entries entries;
+            std::unordered_map<Key, Entries::iterator> entry_by_key;
+            std::size_t nodes_count = 0;
+        };
+
+        static Key get_key(ArcId arc, bool is_upward)
+        {
+            return (Key(arc) << 1) | (is_upward ? 1 : 0);
+        }
+
+        Shard &get_shard(ArcId arc)
+        {
+            return shards[arc % SHARDS_COUNT];
+        }
+
+        std::size_t shard_capacity_nodes;
+        std::array<Shard, SHARDS_COUNT> shards;
+    };
+}
@@ -0,0 +1,70 @@
+#include "TrafficWeights.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace assfire::router
+{
+    TrafficWeights::TrafficWeights(const RoadGraph &graph, const std::string &metric) : weights(graph.get_weights(metric))
+    {
+        std::string prefix = graph_format::TRAFFIC_SECTION_PREFIX + metric;
+        std::span<const graph_format::TrafficHeader> headers = graph.get_section<graph_format::TrafficHeader>(prefix);
+        offsets = graph.get_section<std::uint32_t>(prefix + graph_format::TRAFFIC_OFFSETS_SECTION_SUFFIX);
+        points = graph.get_section<graph_format::TrafficPoint>(prefix + graph_format::TRAFFIC_POINTS_SECTION_SUFFIX);
+        if (headers.size() != 1 || headers[0].period_seconds == 0 || offsets.size() != graph.edges_count() + 1 || offsets.back() != points.size())
+        {
+            throw std::runtime_error("Invalid road graph file " + graph.path() + ": inconsistent traffic sections of metric " + metric);
+        }
+        header = headers[0];
+    }
+
+    bool TrafficWeights::is_present(const RoadGraph &graph, const std::string &metric)
+    {
+        return graph.has_section(graph_format::TRAFFIC_SECTION_PREFIX + metric);
+    }
+
+    void TrafficWeights::validate(std::span<const graph_format::TrafficPoint> points, std::uint32_t period_seconds)
+    {
+        for (std::size_t i = 0; i < points.size(); ++i)
+        {
+            const graph_format::TrafficPoint &point = points[i];
+            const graph_format::TrafficPoint &next = points[(i + 1) % points.size()];
+            if (point.time >= period_seconds || (i + 1 < points.size() && next.time <= point.time))
+            {
+                throw std::invalid_argument("Traffic breakpoints must be sorted by time and fit the period");
+            }
+
+            // Travel time may drop by at most the time passed between breakpoints, otherwise entering the edge later would mean leaving it earlier
+            std::int64_t time_delta = (std::int64_t(next.time) - point.time + (i + 1 < points.size() ? 0 : period_seconds)) * graph_format::WEIGHT_UNITS_PER_SECOND;
+            if (std::int64_t(next.weight) - std::int64_t(point.weight) < -time_delta)
+            {
+                throw std::invalid_argument("Traffic travel times must not drop faster than time passes");
+            }
+        }
+    }
+
+    TrafficWeights::Weight TrafficWeights::get_weight(EdgeId edge, std::int64_t time_deciseconds) const
+    {
+        if (!is_time_dependent(edge))
+        {
+            return weights[edge];
+        }
+
+        std::int64_t period = std::int64_t(header.period_seconds) * graph_format::WEIGHT_UNITS_PER_SECOND;
+        std::int64_t time = ((time_deciseconds - header.period_start * graph_format::WEIGHT_UNITS_PER_SECOND) % period + period) % period;
+
+        auto first = points.begin() + offsets[edge];
+        auto last = points.begin() + offsets[edge + 1];
+        auto next = std::upper_bound(first, last, time, [](std::int64_t time, const graph_format::TrafficPoint &point)
+                                     { return time < std::int64_t(point.time) * graph_format::WEIGHT_UNITS_PER_SECOND; });
+
+        // Breakpoints wrap around the period, so time before the first one is interpolated from the last one of the previous period
+        const graph_format::TrafficPoint &before = next == first ? *(last - 1) : *(next - 1);
+        const graph_format::TrafficPoint &after = next == last ? *first : *next;
+        std::int64_t before_time = std::int64_t(before.time) * graph_format::WEIGHT_UNITS_PER_SECOND - (next == first ? period : 0);
+        std::int64_t after_time = std::int64_t(after.time) * graph_format::WEIGHT_UNITS_PER_SECOND + (next == last ? period : 0);
+        double fraction = double(time - before_time) / double(after_time - before_time);
+        return static_cast<Weight>(std::lround(before.weight + (double(after.weight) - before.weight) * fraction));
+    }
+}
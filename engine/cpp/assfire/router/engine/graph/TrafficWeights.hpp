@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include "RoadGraph.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief Time-dependent travel times of one road graph metric: periodic piecewise linear functions of the time edges are entered at.
+     *
+     * \details Functions are validated to have the FIFO property (entering an edge later never means leaving it earlier) when the graph is built,
+     * so time-dependent Dijkstra search that enters every edge as early as possible finds shortest paths. This is a view over memory mapped
+     * graph sections, so it is cheap to create and must not outlive the graph
+     */
+    class TrafficWeights
+    {
+    public:
+        using EdgeId = RoadGraph::EdgeId;
+        using Weight = RoadGraph::Weight;
+
+        /**
+         * \brief Opens time-dependent travel times of the metric. Throws std::runtime_error if graph has no or invalid traffic sections for the metric
+         */
+        TrafficWeights(const RoadGraph &graph, const std::string &metric);
+
+        /**
+         * \brief Tells if graph file contains time-dependent travel times for the metric
+         */
+        static bool is_present(const RoadGraph &graph, const std::string &metric);
+
+        /**
+         * \brief Throws std::invalid_argument if breakpoints of a single edge are not sorted, don't fit the period or violate FIFO property
+         */
+        static void validate(std::span<const graph_format::TrafficPoint> points, std::uint32_t period_seconds);
+
+        /**
+         * \brief Returns travel time of the edge entered at specified time
+         *
+         * \param time_deciseconds Deciseconds since Unix epoch
+         */
+        Weight get_weight(EdgeId edge, std::int64_t time_deciseconds) const;
+
+        bool is_time_dependent(EdgeId edge) const
+        {
+            return offsets[edge] != offsets[edge + 1];
+        }
+
+    private:
+        std::span<const Weight> weights;
+        graph_format::TrafficHeader header;
+        std::span<const std::uint32_t> offsets;
+        std::span<const graph_format::TrafficPoint> points;
+    };
+}
@@ -0,0 +1,312 @@
+#include "ExtendableRouteMatrix.hpp"
+
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+
+namespace assfire::router
+{
+    namespace
+    {
+        constexpr RouteMatrix::GeopointId NO_ID = std::numeric_limits<RouteMatrix::GeopointId>::max();
+        constexpr std::size_t MIN_CAPACITY = 16;
+    }
+
+    ExtendableRouteMatrix::ExtendableRouteMatrix(std::shared_ptr<RoutingStrategy> strategy,
+                                                 TransportProfile transport_profile,
+                                                 double compaction_threshold) : strategy(strategy),
+                                                                                transport_profile(transport_profile),
+                                                                                compaction_threshold(compaction_threshold)
+    {
+        if (!strategy)
+        {
+            throw std::invalid_argument("Extendable route matrix requires routing strategy");
+        }
+    }
+
+    ExtendableRouteMatrix::GeopointIds ExtendableRouteMatrix::extend(const Waypoints &new_waypoints)
+    {
+        GeopointIds result;
+        if (new_waypoints.empty())
+        {
+            return result;
+        }
+
+        std::vector<SlotId> existing_slots;
+        Waypoints existing_waypoints;
+        existing_slots.reserve(size());
+        existing_waypoints.reserve(size());
+        for (SlotId slot = 0; slot < id_by_slot.size(); ++slot)
+        {
+            if (id_by_slot[slot] != NO_ID)
+            {
+                existing_slots.push_back(slot);
+                existing_waypoints.push_back(waypoints[slot]);
+            }
+        }
+
+        Waypoints all_waypoints(existing_waypoints);
+        all_waypoints.insert(all_waypoints.end(), new_waypoints.begin(), new_waypoints.end());
+
+        // Routes are calculated before any bookkeeping is changed, so matrix stays intact if strategy throws
+        std::vector<RouteInfo> new_rows(new_waypoints.size() * all_waypoints.size());
+        std::vector<RouteInfo> new_columns;
+        {
+            RoutingStrategy::MatrixPtr rows_matrix = strategy->calculate_route_matrix(new_waypoints, all_waypoints, transport_profile);
+            for (std::size_t i = 0; i < new_waypoints.size(); ++i)
+            {
+                for (std::size_t j = 0; j < all_waypoints.size(); ++j)
+                {
+                    new_rows[i * all_waypoints.size() + j] = rows_matrix->get_route_info(i, j);
+                }
+            }
+        }
+        if (!strategy->is_symmetric() && !existing_waypoints.empty())
+        {
+            new_columns.resize(existing_waypoints.size() * new_waypoints.size());
+            RoutingStrategy::MatrixPtr columns_matrix = strategy->calculate_route_matrix(existing_waypoints, new_waypoints, transport_profile);
+            for (std::size_t i = 0; i < existing_waypoints.size(); ++i)
+            {
+                for (std::size_t j = 0; j < new_waypoints.size(); ++j)
+                {
+                    new_columns[i * new_waypoints.size() + j] = columns_matrix->get_route_info(i, j);
+                }
+            }
+        }
+
+        std::size_t reused_slots_count = std::min(free_slots.size(), new_waypoints.size());
+        reserve_slots(id_by_slot.size() + new_waypoints.size() - reused_slots_count);
+
+        std::vector<SlotId> new_slots;
+        new_slots.reserve(new_waypoints.size());
+        result.reserve(new_waypoints.size());
+        for (const GeoPoint &waypoint : new_waypoints)
+        {
+            SlotId slot;
+            if (!free_slots.empty())
+            {
+                slot = free_slots.back();
+                free_slots.pop_back();
+                waypoints[slot] = waypoint;
+            }
+            else
+            {
+                slot = id_by_slot.size();
+                id_by_slot.push_back(NO_ID);
+                waypoints.push_back(waypoint);
+            }
+            GeopointId id = slot_by_id.size();
+            slot_by_id.push_back(slot);
+            id_by_slot[slot] = id;
+            new_slots.push_back(slot);
+            result.push_back(id);
+        }
+
+        std::vector<SlotId> all_slots(existing_slots);
+        all_slots.insert(all_slots.end(), new_slots.begin(), new_slots.end());
+        for (std::size_t i = 0; i < new_slots.size(); ++i)
+        {
+            for (std::size_t j = 0; j < all_slots.size(); ++j)
+            {
+                data[new_slots[i] * capacity + all_slots[j]] = new_rows[i * all_slots.size() + j];
+            }
+        }
+        for (std::size_t i = 0; i < existing_slots.size(); ++i)
+        {
+            for (std::size_t j = 0; j < new_slots.size(); ++j)
+            {
+                data[existing_slots[i] * capacity + new_slots[j]] = new_columns.empty() ? data[new_slots[j] * capacity + existing_slots[i]]
+                                                                                        : new_columns[i * new_slots.size() + j];
+            }
+        }
+
+        return result;
+    }
+
+    void ExtendableRouteMatrix::remove(const GeopointIds &ids)
+    {
+        for (GeopointId id : ids)
+        {
+            retrieve_slot(id);
+        }
+
+        for (GeopointId id : ids)
+        {
+            SlotId slot = slot_by_id[id];
+            if (slot == NO_SLOT)
+            {
+                continue; // Duplicate id in the same request
+            }
+            slot_by_id[id] = NO_SLOT;
+            id_by_slot[slot] = NO_ID;
+            free_slots.push_back(slot);
+        }
+
+        if (!free_slots.empty() && free_slots.size() > compaction_threshold * id_by_slot.size())
+        {
+            compact();
+        }
+    }
+
+    void ExtendableRouteMatrix::compact()
+    {
+        if (free_slots.empty())
+        {
+            return;
+        }
+
+        std::vector<SlotId> new_slot_by_old_slot(id_by_slot.size(), NO_SLOT);
+        SlotId next_slot = 0;
+        for (SlotId slot = 0; slot < id_by_slot.size(); ++slot)
+        {
+            if (id_by_slot[slot] != NO_ID)
+            {
+                new_slot_by_old_slot[slot] = next_slot++;
+            }
+        }
+
+        relayout(std::max<std::size_t>(next_slot, MIN_CAPACITY), new_slot_by_old_slot, next_slot);
+        free_slots.clear();
+    }
+
+    bool ExtendableRouteMatrix::contains(GeopointId id) const
+    {
+        return id < slot_by_id.size() && slot_by_id[id] != NO_SLOT;
+    }
+
+    std::size_t ExtendableRouteMatrix::size() const
+    {
+        return id_by_slot.size() - free_slots.size();
+    }
+
+    const GeoPoint &ExtendableRouteMatrix::get_waypoint(GeopointId id) const
+    {
+        return waypoints[retrieve_slot(id)];
+    }
+
+    ExtendableRouteMatrix::GeopointIds ExtendableRouteMatrix::get_waypoint_ids() const
+    {
+        GeopointIds result;
+        result.reserve(size());
+        for (GeopointId id = 0; id < slot_by_id.size(); ++id)
+        {
+            if (slot_by_id[id] != NO_SLOT)
+            {
+                result.push_back(id);
+            }
+        }
+        return result;
+    }
+
+    std::size_t ExtendableRouteMatrix::get_memory_usage_bytes() const
+    {
+        return data.capacity() * sizeof(RouteInfo) +
+               waypoints.capacity() * sizeof(GeoPoint) +
+               (slot_by_id.capacity() + id_by_slot.capacity() + free_slots.capacity()) * sizeof(SlotId);
+    }
+
+    RouteInfo ExtendableRouteMatrix::get_route_info(GeopointId origin, GeopointId destination) const
+    {
+        return retrieve_route_info(origin, destination);
+    }
+
+    RouteInfo::Meters ExtendableRouteMatrix::get_distance_meters(GeopointId origin, GeopointId destination) const
+    {
+        return retrieve_route_info(origin, destination).distance_meters();
+    }
+
+    RouteInfo::Seconds ExtendableRouteMatrix::get_travel_time_seconds(GeopointId origin, GeopointId destination) const
+    {
+        return retrieve_route_info(origin, destination).travel_time_seconds();
+    }
+
+    Route ExtendableRouteMatrix::calculate_route(const GeoPoint &origin, const GeoPoint &destination) const
+    {
+        return strategy->calculate_route(origin, destination, transport_profile);
+    }
+
+    RouteInfo ExtendableRouteMatrix::calculate_route_info(const GeoPoint &origin, const GeoPoint &destination) const
+    {
+        return strategy->calculate_route_info(origin, destination, transport_profile);
+    }
+
+    RouteInfo::Meters ExtendableRouteMatrix::calculate_distance_meters(const GeoPoint &origin, const GeoPoint &destination) const
+    {
+        return strategy->calculate_distance_meters(origin, destination, transport_profile);
+    }
+
+    RouteInfo::Seconds ExtendableRouteMatrix::calculate_travel_time_seconds(const GeoPoint &origin, const GeoPoint &destination) const
+    {
+        return strategy->calculate_travel_time_seconds(origin, destination, transport_profile);
+    }
+
+    void ExtendableRouteMatrix::sync() const
+    {
+        // No-op for this implementation
+    }
+
+    void ExtendableRouteMatrix::reserve_slots(std::size_t slots_count)
+    {
+        if (slots_count <= capacity)
+        {
+            return;
+        }
+
+        std::vector<SlotId> identity(id_by_slot.size());
+        for (SlotId slot = 0; slot < identity.size(); ++slot)
+        {
+            identity[slot] = slot;
+        }
+
+        relayout(std::max({slots_count, capacity * 2, MIN_CAPACITY}), identity, id_by_slot.size());
+    }
+
+    void ExtendableRouteMatrix::relayout(std::size_t new_capacity, const std::vector<SlotId> &new_slot_by_old_slot, std::size_t new_slots_count)
+    {
+        std::vector<RouteInfo> new_data(new_capacity * new_capacity);
+        std::vector<GeopointId> new_id_by_slot(new_slots_count, NO_ID);
+        std::vector<GeoPoint> new_waypoints(new_slots_count);
+
+        for (SlotId origin = 0; origin < new_slot_by_old_slot.size(); ++origin)
+        {
+            SlotId new_origin = new_slot_by_old_slot[origin];
+            if (new_origin == NO_SLOT)
+            {
+                continue;
+            }
+            for (SlotId destination = 0; destination < new_slot_by_old_slot.size(); ++destination)
+            {
+                SlotId new_destination = new_slot_by_old_slot[destination];
+                if (new_destination != NO_SLOT)
+                {
+                    new_data[new_origin * new_capacity + new_destination] = data[origin * capacity + destination];
+                }
+            }
+            new_id_by_slot[new_origin] = id_by_slot[origin];
+            new_waypoints[new_origin] = waypoints[origin];
+            if (id_by_slot[origin] != NO_ID)
+            {
+                slot_by_id[id_by_slot[origin]] = new_origin;
+            }
+        }
+
+        data = std::move(new_data);
+        id_by_slot = std::move(new_id_by_slot);
+        waypoints = std::move(new_waypoints);
+        capacity = new_capacity;
+    }
+
+    ExtendableRouteMatrix::SlotId ExtendableRouteMatrix::retrieve_slot(GeopointId id) const
+    {
+        if (!contains(id))
+        {
+            throw std::invalid_argument("Invalid geopoint id: " + std::to_string(id));
+        }
+        return slot_by_id[id];
+    }
+
+    const RouteInfo &ExtendableRouteMatrix::retrieve_route_info(GeopointId origin, GeopointId destination) const
+    {
+        return data[retrieve_slot(origin) * capacity + retrieve_slot(destination)];
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include "assfire/router/api/RouteMatrix.hpp"
+#include "assfire/router/engine/common/RoutingStrategy.hpp"
+#include "assfire/router/engine/common/TransportProfile.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief This class represents square route matrix over a mutable set of waypoints. Adding waypoints calculates only new rows and columns,
+     * removing waypoints marks them as tombstones which are reused by later additions or dropped by periodic compaction.
+     *
+     * \details Geopoint ids are assigned in order of addition and stay valid until corresponding waypoint is removed - they are never reassigned,
+     * even after compaction.
+     *
+     * Modifications (extend(), remove(), compact()) must not run concurrently with any other calls on the same matrix
+     */
+    class ExtendableRouteMatrix : public RouteMatrix
+    {
+    public:
+        using Waypoints = std::vector<GeoPoint>;
+        using GeopointIds = std::vector<GeopointId>;
+
+        /**
+         * \brief Default share of tombstoned slots after which matrix storage is compacted automatically
+         */
+        static constexpr double DEFAULT_COMPACTION_THRESHOLD = 0.5;
+
+        /**
+         * \brief Construct a new empty ExtendableRouteMatrix object
+         *
+         * \param strategy Strategy to calculate new rows and columns with. Is also used for not indexed locations
+         * \param transport_profile Transport profile associated with this distance matrix. Is passed down to the strategy
+         * \param compaction_threshold Share of tombstoned slots that triggers automatic compaction after remove()
+         */
+        ExtendableRouteMatrix(std::shared_ptr<RoutingStrategy> strategy,
+                              TransportProfile transport_profile,
+                              double compaction_threshold = DEFAULT_COMPACTION_THRESHOLD);
+
+        /**
+         * \brief Adds waypoints to the matrix calculating only routes from and to the added waypoints
+         *
+         * \param waypoints Waypoints to add
+         * \return GeopointIds Ids assigned to the added waypoints in the order of passed waypoints
+         */
+        GeopointIds extend(const Waypoints &waypoints);
+
+        /**
+         * \brief Removes waypoints from the matrix. Removed ids become invalid, their storage is reused by subsequent extend() calls
+         *
+         * \param ids Ids of waypoints to remove
+         */
+        void remove(const GeopointIds &ids);
+
+        /**
+         * \brief Releases storage occupied by removed waypoints. Is called automatically when share of removed slots exceeds compaction threshold
+         */
+        void compact();
+
+        bool contains(GeopointId id) const;
+
+        /**
+         * \brief Returns count of waypoints currently present in the matrix
+         */
+        std::size_t size() const;
+
+        const GeoPoint &get_waypoint(GeopointId id) const;
+
+        /**
+         * \brief Returns ids of all waypoints currently present in the matrix in ascending order
+         */
+        GeopointIds get_waypoint_ids() const;
+
+        /**
+         * \brief Returns approximate count of bytes occupied by matrix storage
+         */
+        std::size_t get_memory_usage_bytes() const;
+
+        virtual RouteInfo get_route_info(GeopointId origin, GeopointId destination) const override;
+        virtual RouteInfo::Meters get_distance_meters(GeopointId origin, GeopointId destination) const override;
+        virtual RouteInfo::Seconds get_travel_time_seconds(GeopointId origin, GeopointId destination) const override;
+        virtual Route calculate_route(const GeoPoint &origin, const GeoPoint &destination) const override;
+        virtual RouteInfo calculate_route_info(const GeoPoint &origin, const GeoPoint &destination) const override;
+        virtual RouteInfo::Meters calculate_distance_meters(const GeoPoint &origin, const GeoPoint &destination) const override;
+        virtual RouteInfo::Seconds calculate_travel_time_seconds(const GeoPoint &origin, const GeoPoint &destination) const override;
+        virtual void sync() const override;
+
+    private:
+        using SlotId = std::uint32_t;
+        static constexpr SlotId NO_SLOT = std::numeric_limits<SlotId>::max();
+
+        void reserve_slots(std::size_t slots_count);
+        void relayout(std::size_t new_capacity, const std::vector<SlotId> &new_slot_by_old_slot, std::size_t new_slots_count);
+        SlotId retrieve_slot(GeopointId id) const;
+        const RouteInfo &retrieve_route_info(GeopointId origin, GeopointId destination) const;
+
+        std::shared_ptr<RoutingStrategy> strategy;
+        TransportProfile transport_profile;
+        double compaction_threshold;
+
+        std::vector<SlotId> slot_by_id;
+        std::vector<GeopointId> id_by_slot;
+        std::vector<GeoPoint> waypoints;
+        std::vector<SlotId> free_slots;
+        std::size_t capacity = 0;
+        std::vector<RouteInfo> data;
+    };
+}
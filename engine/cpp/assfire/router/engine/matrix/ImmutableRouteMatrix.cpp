@@ -11,9 +11,9 @@ namespace assfire::router
                              ImmutableRouteMatrix::RouteInfoSupplier calculate_route)
         {
             data.resize(origins_count * destinations_count);
-            for (int i = 0; i < origins_count; ++i)
+            for (std::size_t i = 0; i < origins_count; ++i)
             {
-                for (int j = 0; j < destinations_count; ++j)
+                for (std::size_t j = 0; j < destinations_count; ++j)
                 {
                     data[i * destinations_count + j] = calculate_route(i, j);
                 }
@@ -82,7 +82,7 @@ namespace assfire::router
 
     void ImmutableRouteMatrix::validate_geopoint_id(GeopointId origin, GeopointId destination) const
     {
-        if (origin < 0 || origin >= origins_count || destination < 0 || destination >= destinations_count)
+        if (origin >= origins_count || destination >= destinations_count)
         {
             throw std::invalid_argument("Invalid geopoint ids: " + std::to_string(origin) + "->" + std::to_string(destination));
         }
@@ -0,0 +1,244 @@
+#include "LazyRouteMatrix.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace assfire::router
+{
+    LazyRouteMatrix::LazyRouteMatrix(WaypointsView origins,
+                                     WaypointsView destinations,
+                                     std::shared_ptr<RoutingStrategy> strategy,
+                                     TransportProfile transport_profile,
+                                     bool prefetch_rows)
+        : origins(origins.begin(), origins.end()),
+          destinations(destinations.begin(), destinations.end()),
+          strategy(std::move(strategy)),
+          transport_profile(std::move(transport_profile)),
+          states(origins.size() * destinations.size()),
+          travel_times(origins.size() * destinations.size()),
+          distances(origins.size() * destinations.size()),
+          prefetch_rows(prefetch_rows),
+          prefetch_requested(prefetch_rows ? origins.size() : 0)
+    {
+        if (!this->strategy)
+        {
+            throw std::invalid_argument("Lazy route matrix requires routing strategy");
+        }
+        if (prefetch_rows)
+        {
+            prefetch_thread = std::thread([this]() { prefetch(); });
+        }
+    }
+
+    LazyRouteMatrix::~LazyRouteMatrix()
+    {
+        if (prefetch_thread.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(prefetch_mutex);
+                stopped = true;
+            }
+            prefetch_ready.notify_all();
+            prefetch_thread.join();
+        }
+    }
+
+    RouteInfo LazyRouteMatrix::get_route_info(GeopointId origin, GeopointId destination) const
+    {
+        std::size_t cell = retrieve_cell(origin, destination);
+        return RouteInfo(distances[cell], travel_times[cell]);
+    }
+
+    RouteInfo::Meters LazyRouteMatrix::get_distance_meters(GeopointId origin, GeopointId destination) const
+    {
+        return distances[retrieve_cell(origin, destination)];
+    }
+
+    RouteInfo::Seconds LazyRouteMatrix::get_travel_time_seconds(GeopointId origin, GeopointId destination) const
+    {
+        return travel_times[retrieve_cell(origin, destination)];
+    }
+
+    Route LazyRouteMatrix::calculate_route(const GeoPoint &origin, const GeoPoint &destination) const
+    {
+        return strategy->calculate_route(origin, destination, transport_profile);
+    }
+
+    RouteInfo LazyRouteMatrix::calculate_route_info(const GeoPoint &origin, const GeoPoint &destination) const
+    {
+        return strategy->calculate_route_info(origin, destination, transport_profile);
+    }
+
+    RouteInfo::Meters LazyRouteMatrix::calculate_distance_meters(const GeoPoint &origin, const GeoPoint &destination) const
+    {
+        return strategy->calculate_distance_meters(origin, destination, transport_profile);
+    }
+
+    RouteInfo::Seconds LazyRouteMatrix::calculate_travel_time_seconds(const GeoPoint &origin, const GeoPoint &destination) const
+    {
+        return strategy->calculate_travel_time_seconds(origin, destination, transport_profile);
+    }
+
+    void LazyRouteMatrix::sync() const
+    {
+        for (GeopointId origin = 0; origin < origins.size(); ++origin)
+        {
+            for (GeopointId destination = 0; destination < destinations.size(); ++destination)
+            {
+                await_cell(origin, destination);
+            }
+        }
+    }
+
+    std::size_t LazyRouteMatrix::retrieve_cell(GeopointId origin, GeopointId destination) const
+    {
+        if (origin >= origins.size() || destination >= destinations.size())
+        {
+            throw std::invalid_argument("Invalid geopoint ids: " + std::to_string(origin) + "->" + std::to_string(destination));
+        }
+        if (prefetch_rows)
+        {
+            request_prefetch(origin);
+        }
+        return await_cell(origin, destination);
+    }
+
+    std::size_t LazyRouteMatrix::await_cell(GeopointId origin, GeopointId destination) const
+    {
+        std::size_t cell = origin * destinations.size() + destination;
+        while (true)
+        {
+            std::uint8_t state = states[cell].load(std::memory_order_acquire);
+            if (state == DONE)
+            {
+                return cell;
+            }
+            if (state == EMPTY)
+            {
+                calculate_cells(origin, destination);
+            }
+            else
+            {
+                states[cell].wait(CALCULATING, std::memory_order_acquire);
+            }
+        }
+    }
+
+    bool LazyRouteMatrix::calculate_cells(GeopointId origin, GeopointId destination) const
+    {
+        std::size_t first = origin * destinations.size() + destination;
+        std::uint8_t expected = EMPTY;
+        if (!states[first].compare_exchange_strong(expected, CALCULATING, std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        std::size_t last = first + 1;
+        std::size_t limit = std::min(first + MAX_BATCH_SIZE, (origin + 1) * destinations.size());
+        while (last < limit)
+        {
+            expected = EMPTY;
+            if (states[last].load(std::memory_order_relaxed) != EMPTY ||
+                !states[last].compare_exchange_strong(expected, CALCULATING, std::memory_order_acquire))
+            {
+                break;
+            }
+            ++last;
+        }
+        std::size_t count = last - first;
+
+        try
+        {
+            if (count == 1)
+            {
+                RouteInfo route_info = strategy->calculate_route_info(origins[origin], destinations[destination], transport_profile);
+                travel_times[first] = route_info.travel_time_seconds();
+                distances[first] = route_info.distance_meters();
+            }
+            else
+            {
+                RoutingStrategy::MatrixPtr matrix = strategy->calculate_route_matrix(WaypointsView(&origins[origin], 1),
+                                                                                     WaypointsView(destinations).subspan(destination, count),
+                                                                                     transport_profile);
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    RouteInfo route_info = matrix->get_route_info(0, i);
+                    travel_times[first + i] = route_info.travel_time_seconds();
+                    distances[first + i] = route_info.distance_meters();
+                }
+            }
+        }
+        catch (...)
+        {
+            for (std::size_t cell = first; cell < last; ++cell)
+            {
+                states[cell].store(EMPTY, std::memory_order_relaxed);
+                states[cell].notify_all();
+            }
+            throw;
+        }
+
+        for (std::size_t cell = first; cell < last; ++cell)
+        {
+            states[cell].store(DONE, std::memory_order_release);
+            states[cell].notify_all();
+        }
+        calculated_count.fetch_add(count, std::memory_order_relaxed);
+        return true;
+    }
+
+    void LazyRouteMatrix::request_prefetch(GeopointId origin) const
+    {
+        if (prefetch_requested[origin].load(std::memory_order_relaxed) || prefetch_requested[origin].exchange(true))
+        {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(prefetch_mutex);
+            prefetch_queue.push_back(origin);
+        }
+        prefetch_ready.notify_one();
+    }
+
+    void LazyRouteMatrix::prefetch() const
+    {
+        while (true)
+        {
+            GeopointId origin;
+            {
+                std::unique_lock<std::mutex> lock(prefetch_mutex);
+                prefetch_ready.wait(lock, [this]() { return stopped || !prefetch_queue.empty(); });
+                if (stopped)
+                {
+                    return;
+                }
+                origin = prefetch_queue.front();
+                prefetch_queue.pop_front();
+            }
+
+            for (GeopointId destination = 0; destination < destinations.size(); ++destination)
+            {
+                if (states[origin * destinations.size() + destination].load(std::memory_order_relaxed) != EMPTY)
+                {
+                    continue;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(prefetch_mutex);
+                    if (stopped)
+                    {
+                        return;
+                    }
+                }
+                try
+                {
+                    calculate_cells(origin, destination);
+                }
+                catch (...)
+                {
+                    // Cells are empty again, so the failure is reported to the thread that accesses them
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "assfire/router/api/RouteMatrix.hpp"
+#include "assfire/router/engine/common/RoutingStrategy.hpp"
+#include "assfire/router/engine/common/TransportProfile.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief This class represents route matrix that calculates routes on first access and keeps them, e.g. for construction heuristics
+     * that only touch a small share of cells.
+     *
+     * \details Each cell has atomic state (empty, calculating, done), so cells that are done are read without locks. Thread that finds an empty cell
+     * claims it together with up to MAX_BATCH_SIZE following empty cells of the same row and calculates them with a single one-to-many call.
+     * Threads that need a cell being calculated by another thread wait for it. If calculation fails, claimed cells become empty again.
+     *
+     * If row prefetching is enabled, first access to a row queues the rest of it for calculation on a background thread, as solvers tend to
+     * read more routes from the same origin. sync() calculates all cells that are still empty on the calling thread
+     */
+    class LazyRouteMatrix : public RouteMatrix
+    {
+    public:
+        using WaypointsView = RoutingStrategy::WaypointsView;
+
+        /**
+         * \brief Max count of cells calculated together
+         */
+        static constexpr std::size_t MAX_BATCH_SIZE = 64;
+
+        /**
+         * \brief Construct a new LazyRouteMatrix object. No routes are calculated until they are accessed
+         *
+         * \param origins Origin waypoints
+         * \param destinations Destination waypoints
+         * \param strategy Strategy to calculate routes with. Is also used for not indexed locations
+         * \param transport_profile Transport profile associated with this matrix. Is passed down to the strategy
+         * \param prefetch_rows If set, rows are calculated in background after their first access
+         */
+        LazyRouteMatrix(WaypointsView origins,
+                        WaypointsView destinations,
+                        std::shared_ptr<RoutingStrategy> strategy,
+                        TransportProfile transport_profile,
+                        bool prefetch_rows = false);
+
+        ~LazyRouteMatrix();
+
+        /**
+         * \brief Returns count of cells calculated so far
+         */
+        std::size_t get_calculated_count() const
+        {
+            return calculated_count.load(std::memory_order_relaxed);
+        }
+
+        virtual RouteInfo get_route_info(GeopointId origin, GeopointId destination) const override;
+        virtual RouteInfo::Meters get_distance_meters(GeopointId origin, GeopointId destination) const override;
+        virtual RouteInfo::Seconds get_travel_time_seconds(GeopointId origin, GeopointId destination) const override;
+        virtual Route calculate_route(const GeoPoint &origin, const GeoPoint &destination) const override;
+        virtual RouteInfo calculate_route_info(const GeoPoint &origin, const GeoPoint &destination) const override;
+        virtual RouteInfo::Meters calculate_distance_meters(const GeoPoint &origin, const GeoPoint &destination) const override;
+        virtual RouteInfo::Seconds calculate_travel_time_seconds(const GeoPoint &origin, const GeoPoint &destination) const override;
+        virtual void sync() const override;
+
+    private:
+        enum CellState : std::uint8_t
+        {
+            EMPTY,
+            CALCULATING,
+            DONE
+        };
+
+        std::size_t retrieve_cell(GeopointId origin, GeopointId destination) const;
+        std::size_t await_cell(GeopointId origin, GeopointId destination) const;
+
+        /**
+         * Claims empty cells of origin starting from destination and calculates them. Returns false if the first cell is not empty
+         */
+        bool calculate_cells(GeopointId origin, GeopointId destination) const;
+        void request_prefetch(GeopointId origin) const;
+        void prefetch() const;
+
+        std::vector<GeoPoint> origins;
+        std::vector<GeoPoint> destinations;
+        std::shared_ptr<RoutingStrategy> strategy;
+        TransportProfile transport_profile;
+
+        mutable std::vector<std::atomic<std::uint8_t>> states; // Cell values are published by release store of DONE state
+        mutable std::vector<RouteInfo::Seconds> travel_times;
+        mutable std::vector<RouteInfo::Meters> distances;
+        mutable std::atomic<std::size_t> calculated_count = 0;
+
+        bool prefetch_rows;
+        mutable std::vector<std::atomic<bool>> prefetch_requested;
+        mutable std::mutex prefetch_mutex;
+        mutable std::condition_variable prefetch_ready;
+        mutable std::deque<GeopointId> prefetch_queue;
+        mutable bool stopped = false; // Guarded by prefetch_mutex
+        std::thread prefetch_thread;
+    };
+}
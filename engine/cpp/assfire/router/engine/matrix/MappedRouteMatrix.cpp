@@ -0,0 +1,336 @@
+#include "MappedRouteMatrix.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include "assfire/router/engine/graph/RoadGraphFileWriter.hpp"
+
+namespace assfire::router
+{
+    namespace
+    {
+        void write_varint(std::uint64_t value, std::vector<std::uint8_t> &out)
+        {
+            while (value >= 0x80)
+            {
+                out.push_back(std::uint8_t(value) | 0x80);
+                value >>= 7;
+            }
+            out.push_back(std::uint8_t(value));
+        }
+
+        std::uint64_t read_varint(std::span<const std::uint8_t> data, std::size_t &position)
+        {
+            std::uint64_t value = 0;
+            for (unsigned shift = 0; shift < 64; shift += 7)
+            {
+                if (position >= data.size())
+                {
+                    break;
+                }
+                std::uint8_t byte = data[position++];
+                value |= std::uint64_t(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0)
+                {
+                    return value;
+                }
+            }
+            throw std::runtime_error("Invalid route matrix block: truncated value");
+        }
+
+        std::uint64_t to_zigzag(std::int64_t value)
+        {
+            return (std::uint64_t(value) << 1) ^ std::uint64_t(value >> 63);
+        }
+
+        std::int64_t from_zigzag(std::uint64_t value)
+        {
+            return std::int64_t(value >> 1) ^ -std::int64_t(value & 1);
+        }
+
+        std::vector<matrix_format::Location> to_locations(RoutingStrategy::WaypointsView waypoints)
+        {
+            std::vector<matrix_format::Location> result;
+            result.reserve(waypoints.size());
+            for (const GeoPoint &waypoint : waypoints)
+            {
+                result.push_back(matrix_format::Location{waypoint.lat(), waypoint.lon()});
+            }
+            return result;
+        }
+
+        std::string to_string(std::span<const char> value)
+        {
+            return std::string(value.begin(), value.end());
+        }
+    }
+
+    MappedRouteMatrix::MappedRouteMatrix(const std::string &path, bool preload)
+        : file(path, matrix_format::MAGIC, matrix_format::VERSION, "route matrix", preload)
+    {
+        std::span<const matrix_format::MatrixHeader> headers = file.get_section<matrix_format::MatrixHeader>(matrix_format::HEADER_SECTION);
+        if (headers.size() != 1)
+        {
+            throw std::runtime_error("Invalid route matrix file " + path + ": wrong header size");
+        }
+        const matrix_format::MatrixHeader &header = headers[0];
+
+        strategy_id = RoutingStrategyId(to_string(file.get_section<char>(matrix_format::STRATEGY_SECTION)));
+        transport_profile_id = TransportProfileId(to_string(file.get_section<char>(matrix_format::PROFILE_SECTION)));
+        origins = file.get_section<matrix_format::Location>(matrix_format::ORIGINS_SECTION);
+        destinations = file.get_section<matrix_format::Location>(matrix_format::DESTINATIONS_SECTION);
+        if (origins.size() != header.origins_count || destinations.size() != header.destinations_count)
+        {
+            throw std::runtime_error("Invalid route matrix file " + path + ": waypoints count doesn't match header");
+        }
+
+        std::size_t cells_count = origins.size() * destinations.size();
+        if (header.layout == matrix_format::DENSE_LAYOUT)
+        {
+            travel_times = file.get_section<RouteInfo::Seconds>(matrix_format::TRAVEL_TIMES_SECTION);
+            distances = file.get_section<RouteInfo::Meters>(matrix_format::DISTANCES_SECTION);
+            if (travel_times.size() != cells_count || distances.size() != cells_count)
+            {
+                throw std::runtime_error("Invalid route matrix file " + path + ": routes count doesn't match header");
+            }
+        }
+        else if (header.layout == matrix_format::COMPRESSED_LAYOUT)
+        {
+            if (header.block_rows == 0)
+            {
+                throw std::runtime_error("Invalid route matrix file " + path + ": empty blocks");
+            }
+            block_rows = header.block_rows;
+            block_offsets = file.get_section<std::uint64_t>(matrix_format::BLOCK_OFFSETS_SECTION);
+            blocks = file.get_section<std::uint8_t>(matrix_format::BLOCKS_SECTION);
+            std::size_t blocks_count = (origins.size() + block_rows - 1) / block_rows;
+            if (block_offsets.size() != blocks_count + 1)
+            {
+                throw std::runtime_error("Invalid route matrix file " + path + ": blocks count doesn't match header");
+            }
+            decoded_blocks.resize(blocks_count);
+            decoded_flags = std::make_unique<std::once_flag[]>(blocks_count);
+        }
+        else
+        {
+            throw std::runtime_error("Unsupported route matrix file " + path + " layout: " + std::to_string(header.layout));
+        }
+    }
+
+    void MappedRouteMatrix::write(const RouteMatrix &matrix, WaypointsView origins, WaypointsView destinations, const std::string &path,
+                                  const WriteOptions &options)
+    {
+        matrix.sync();
+
+        matrix_format::MatrixHeader header{origins.size(), destinations.size(),
+                                           options.block_rows > 0 ? matrix_format::COMPRESSED_LAYOUT : matrix_format::DENSE_LAYOUT, options.block_rows};
+        RoadGraphFileWriter writer(matrix_format::MAGIC, matrix_format::VERSION);
+        writer.add_section(matrix_format::HEADER_SECTION, std::vector<matrix_format::MatrixHeader>{header});
+        writer.add_section(matrix_format::STRATEGY_SECTION, std::vector<char>(options.strategy.value().begin(), options.strategy.value().end()));
+        writer.add_section(matrix_format::PROFILE_SECTION, std::vector<char>(options.profile.value().begin(), options.profile.value().end()));
+        writer.add_section(matrix_format::ORIGINS_SECTION, to_locations(origins));
+        writer.add_section(matrix_format::DESTINATIONS_SECTION, to_locations(destinations));
+
+        if (options.block_rows == 0)
+        {
+            std::vector<RouteInfo::Seconds> travel_times;
+            std::vector<RouteInfo::Meters> distances;
+            travel_times.reserve(origins.size() * destinations.size());
+            distances.reserve(origins.size() * destinations.size());
+            for (GeopointId origin = 0; origin < origins.size(); ++origin)
+            {
+                for (GeopointId destination = 0; destination < destinations.size(); ++destination)
+                {
+                    RouteInfo route_info = matrix.get_route_info(origin, destination);
+                    travel_times.push_back(route_info.travel_time_seconds());
+                    distances.push_back(route_info.distance_meters());
+                }
+            }
+            writer.add_section(matrix_format::TRAVEL_TIMES_SECTION, travel_times);
+            writer.add_section(matrix_format::DISTANCES_SECTION, distances);
+        }
+        else
+        {
+            std::vector<std::uint64_t> block_offsets = {0};
+            std::vector<std::uint8_t> blocks;
+            std::vector<RouteInfo::Meters> block_distances;
+            for (std::size_t first_row = 0; first_row < origins.size(); first_row += options.block_rows)
+            {
+                std::size_t last_row = std::min(first_row + options.block_rows, origins.size());
+                block_distances.clear();
+                for (GeopointId origin = first_row; origin < last_row; ++origin)
+                {
+                    RouteInfo::Seconds previous = 0;
+                    for (GeopointId destination = 0; destination < destinations.size(); ++destination)
+                    {
+                        RouteInfo route_info = matrix.get_route_info(origin, destination);
+                        write_varint(to_zigzag(std::int64_t(route_info.travel_time_seconds()) - previous), blocks);
+                        previous = route_info.travel_time_seconds();
+                        block_distances.push_back(route_info.distance_meters());
+                    }
+                }
+                for (std::size_t row = 0; row < last_row - first_row; ++row)
+                {
+                    std::uint64_t previous = 0;
+                    for (std::size_t destination = 0; destination < destinations.size(); ++destination)
+                    {
+                        std::uint64_t bits = std::bit_cast<std::uint64_t>(block_distances[row * destinations.size() + destination]);
+                        write_varint(bits ^ previous, blocks);
+                        previous = bits;
+                    }
+                }
+                block_offsets.push_back(blocks.size());
+            }
+            writer.add_section(matrix_format::BLOCK_OFFSETS_SECTION, block_offsets);
+            writer.add_section(matrix_format::BLOCKS_SECTION, blocks);
+        }
+
+        writer.write(path);
+    }
+
+    void MappedRouteMatrix::set_strategy(std::shared_ptr<RoutingStrategy> strategy, TransportProfile transport_profile)
+    {
+        this->strategy = std::move(strategy);
+        this->transport_profile = std::move(transport_profile);
+    }
+
+    GeoPoint MappedRouteMatrix::get_origin(GeopointId id) const
+    {
+        if (id >= origins.size())
+        {
+            throw std::invalid_argument("Invalid origin id: " + std::to_string(id));
+        }
+        return GeoPoint(origins[id].lat, origins[id].lon);
+    }
+
+    GeoPoint MappedRouteMatrix::get_destination(GeopointId id) const
+    {
+        if (id >= destinations.size())
+        {
+            throw std::invalid_argument("Invalid destination id: " + std::to_string(id));
+        }
+        return GeoPoint(destinations[id].lat, destinations[id].lon);
+    }
+
+    RouteInfo MappedRouteMatrix::get_route_info(GeopointId origin, GeopointId destination) const
+    {
+        std::size_t cell = get_cell(origin, destination);
+        if (!is_compressed())
+        {
+            return RouteInfo(distances[cell], travel_times[cell]);
+        }
+        const DecodedBlock &block = get_block(origin / block_rows);
+        cell -= std::size_t(origin / block_rows) * block_rows * destinations.size();
+        return RouteInfo(block.distances[cell], block.travel_times[cell]);
+    }
+
+    RouteInfo::Meters MappedRouteMatrix::get_distance_meters(GeopointId origin, GeopointId destination) const
+    {
+        std::size_t cell = get_cell(origin, destination);
+        if (!is_compressed())
+        {
+            return distances[cell];
+        }
+        return get_block(origin / block_rows).distances[cell - std::size_t(origin / block_rows) * block_rows * destinations.size()];
+    }
+
+    RouteInfo::Seconds MappedRouteMatrix::get_travel_time_seconds(GeopointId origin, GeopointId destination) const
+    {
+        std::size_t cell = get_cell(origin, destination);
+        if (!is_compressed())
+        {
+            return travel_times[cell];
+        }
+        return get_block(origin / block_rows).travel_times[cell - std::size_t(origin / block_rows) * block_rows * destinations.size()];
+    }
+
+    Route MappedRouteMatrix::calculate_route(const GeoPoint &origin, const GeoPoint &destination) const
+    {
+        ensure_strategy_present();
+        return strategy->calculate_route(origin, destination, transport_profile);
+    }
+
+    RouteInfo MappedRouteMatrix::calculate_route_info(const GeoPoint &origin, const GeoPoint &destination) const
+    {
+        ensure_strategy_present();
+        return strategy->calculate_route_info(origin, destination, transport_profile);
+    }
+
+    RouteInfo::Meters MappedRouteMatrix::calculate_distance_meters(const GeoPoint &origin, const GeoPoint &destination) const
+    {
+        ensure_strategy_present();
+        return strategy->calculate_distance_meters(origin, destination, transport_profile);
+    }
+
+    RouteInfo::Seconds MappedRouteMatrix::calculate_travel_time_seconds(const GeoPoint &origin, const GeoPoint &destination) const
+    {
+        ensure_strategy_present();
+        return strategy->calculate_travel_time_seconds(origin, destination, transport_profile);
+    }
+
+    void MappedRouteMatrix::sync() const
+    {
+        // No-op for this implementation
+    }
+
+    std::size_t MappedRouteMatrix::get_cell(GeopointId origin, GeopointId destination) const
+    {
+        if (origin >= origins.size() || destination >= destinations.size())
+        {
+            throw std::invalid_argument("Invalid geopoint ids: " + std::to_string(origin) + "->" + std::to_string(destination));
+        }
+        return std::size_t(origin) * destinations.size() + destination;
+    }
+
+    const MappedRouteMatrix::DecodedBlock &MappedRouteMatrix::get_block(std::size_t block) const
+    {
+        std::call_once(decoded_flags[block], [this, block]() { decode_block(block); });
+        return decoded_blocks[block];
+    }
+
+    void MappedRouteMatrix::decode_block(std::size_t block) const
+    {
+        if (block_offsets[block] > block_offsets[block + 1] || block_offsets[block + 1] > blocks.size())
+        {
+            throw std::runtime_error("Invalid route matrix file " + file.path() + ": block " + std::to_string(block) + " is out of file bounds");
+        }
+        std::span<const std::uint8_t> data = blocks.subspan(block_offsets[block], block_offsets[block + 1] - block_offsets[block]);
+        std::size_t rows_count = std::min<std::size_t>(block_rows, origins.size() - block * block_rows);
+
+        DecodedBlock result;
+        result.travel_times.reserve(rows_count * destinations.size());
+        result.distances.reserve(rows_count * destinations.size());
+        std::size_t position = 0;
+        for (std::size_t row = 0; row < rows_count; ++row)
+        {
+            std::int64_t previous = 0;
+            for (std::size_t destination = 0; destination < destinations.size(); ++destination)
+            {
+                previous += from_zigzag(read_varint(data, position));
+                result.travel_times.push_back(RouteInfo::Seconds(previous));
+            }
+        }
+        for (std::size_t row = 0; row < rows_count; ++row)
+        {
+            std::uint64_t previous = 0;
+            for (std::size_t destination = 0; destination < destinations.size(); ++destination)
+            {
+                previous ^= read_varint(data, position);
+                result.distances.push_back(std::bit_cast<RouteInfo::Meters>(previous));
+            }
+        }
+        if (position != data.size())
+        {
+            throw std::runtime_error("Invalid route matrix file " + file.path() + ": block " + std::to_string(block) + " has trailing data");
+        }
+        decoded_blocks[block] = std::move(result);
+    }
+
+    void MappedRouteMatrix::ensure_strategy_present() const
+    {
+        if (!strategy)
+        {
+            throw std::runtime_error("Route calculation is requested at matrix API but no strategy was provided");
+        }
+    }
+}
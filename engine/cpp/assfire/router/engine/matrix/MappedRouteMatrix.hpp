@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+#include "assfire/router/api/RouteMatrix.hpp"
+#include "assfire/router/api/RoutingStrategyId.hpp"
+#include "assfire/router/api/TransportProfileId.hpp"
+#include "assfire/router/engine/common/RoutingStrategy.hpp"
+#include "assfire/router/engine/common/TransportProfile.hpp"
+#include "assfire/router/engine/graph/SectionedFile.hpp"
+#include "RouteMatrixFormat.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief This class represents read-only route matrix stored in a binary file (see RouteMatrixFormat.hpp), e.g. by batch pipelines that solve
+     * the same problem many times.
+     *
+     * \details File is memory mapped, so opening it only validates its section table and pages of routes are loaded by the OS on first access.
+     * Dense matrices are read from the mapping as is. Blocks of compressed matrices are decoded into memory on first access to any of their routes
+     * and are kept until matrix is destroyed
+     */
+    class MappedRouteMatrix : public RouteMatrix
+    {
+    public:
+        using WaypointsView = RoutingStrategy::WaypointsView;
+
+        struct WriteOptions
+        {
+            RoutingStrategyId strategy;   // Stored as metadata
+            TransportProfileId profile;   // Stored as metadata
+            std::uint32_t block_rows = 0; // If positive, matrix is compressed in blocks of this many rows
+        };
+
+        /**
+         * \brief Opens matrix file. Throws std::runtime_error if file can't be mapped or is not a valid matrix file
+         *
+         * \param path Path to the file
+         * \param preload If true, the whole file is read into page cache in background instead of on first access
+         */
+        explicit MappedRouteMatrix(const std::string &path, bool preload = false);
+
+        /**
+         * \brief Writes routes of matrix between origins and destinations to file. File is written to a temporary path and renamed, so processes
+         * that have old file mapped keep using it. Throws std::runtime_error on write errors
+         *
+         * \param matrix Matrix to write, its origin and destination ids are positions in origins and destinations
+         * \param origins Origin waypoints
+         * \param destinations Destination waypoints
+         * \param path Path to the file
+         * \param options Metadata and compression of the file
+         */
+        static void write(const RouteMatrix &matrix, WaypointsView origins, WaypointsView destinations, const std::string &path, const WriteOptions &options);
+
+        /**
+         * \brief Sets strategy for routes between not indexed locations. Should be called before matrix is shared between threads
+         */
+        void set_strategy(std::shared_ptr<RoutingStrategy> strategy, TransportProfile transport_profile);
+
+        std::size_t get_origins_count() const
+        {
+            return origins.size();
+        }
+
+        std::size_t get_destinations_count() const
+        {
+            return destinations.size();
+        }
+
+        GeoPoint get_origin(GeopointId id) const;
+        GeoPoint get_destination(GeopointId id) const;
+
+        const RoutingStrategyId &get_strategy_id() const
+        {
+            return strategy_id;
+        }
+
+        const TransportProfileId &get_transport_profile_id() const
+        {
+            return transport_profile_id;
+        }
+
+        bool is_compressed() const
+        {
+            return block_rows > 0;
+        }
+
+        virtual RouteInfo get_route_info(GeopointId origin, GeopointId destination) const override;
+        virtual RouteInfo::Meters get_distance_meters(GeopointId origin, GeopointId destination) const override;
+        virtual RouteInfo::Seconds get_travel_time_seconds(GeopointId origin, GeopointId destination) const override;
+        virtual Route calculate_route(const GeoPoint &origin, const GeoPoint &destination) const override;
+        virtual RouteInfo calculate_route_info(const GeoPoint &origin, const GeoPoint &destination) const override;
+        virtual RouteInfo::Meters calculate_distance_meters(const GeoPoint &origin, const GeoPoint &destination) const override;
+        virtual RouteInfo::Seconds calculate_travel_time_seconds(const GeoPoint &origin, const GeoPoint &destination) const override;
+        virtual void sync() const override;
+
+    private:
+        struct DecodedBlock
+        {
+            std::vector<RouteInfo::Seconds> travel_times;
+            std::vector<RouteInfo::Meters> distances;
+        };
+
+        std::size_t get_cell(GeopointId origin, GeopointId destination) const;
+        const DecodedBlock &get_block(std::size_t block) const;
+        void decode_block(std::size_t block) const;
+        void ensure_strategy_present() const;
+
+        SectionedFile file;
+        RoutingStrategyId strategy_id;
+        TransportProfileId transport_profile_id;
+        std::span<const matrix_format::Location> origins;
+        std::span<const matrix_format::Location> destinations;
+
+        std::span<const RouteInfo::Seconds> travel_times;
+        std::span<const RouteInfo::Meters> distances;
+
+        std::uint32_t block_rows = 0;
+        std::span<const std::uint64_t> block_offsets;
+        std::span<const std::uint8_t> blocks;
+        mutable std::vector<DecodedBlock> decoded_blocks;
+        mutable std::unique_ptr<std::once_flag[]> decoded_flags;
+
+        std::shared_ptr<RoutingStrategy> strategy;
+        TransportProfile transport_profile;
+    };
+}
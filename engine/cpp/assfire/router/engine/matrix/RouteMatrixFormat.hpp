@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace assfire::router::matrix_format
+{
+    /**
+     * \brief Layout of binary route matrix file. File has the same section table as road graph file (see RoadGraphFormat.hpp) with its own magic.
+     *
+     * \details Header is followed by waypoints, ids of strategy and profile matrix was calculated with and its routes. Dense matrices store travel
+     * times and distances as row-major planes that are memory mapped as is. Compressed matrices split rows into blocks of block_rows rows and store
+     * each block as travel times of its rows followed by their distances. Values are coded per row: travel times as zigzag varints of differences
+     * with previous value, distances as varints of their bits xored with bits of previous value, as routes of neighbouring destinations are alike
+     */
+    constexpr char MAGIC[8] = {'A', 'S', 'F', 'R', 'M', 'T', 'R', 'X'};
+    constexpr std::uint32_t VERSION = 1;
+
+    constexpr const char *HEADER_SECTION = "header";             // MatrixHeader[1]
+    constexpr const char *STRATEGY_SECTION = "strategy";         // char[], routing strategy id
+    constexpr const char *PROFILE_SECTION = "profile";           // char[], transport profile id
+    constexpr const char *ORIGINS_SECTION = "origins";           // Location[origins_count]
+    constexpr const char *DESTINATIONS_SECTION = "destinations"; // Location[destinations_count]
+
+    constexpr const char *TRAVEL_TIMES_SECTION = "travel_times"; // int32[origins_count * destinations_count], dense layout only
+    constexpr const char *DISTANCES_SECTION = "distances";       // double[origins_count * destinations_count], dense layout only
+
+    constexpr const char *BLOCK_OFFSETS_SECTION = "blocks/offsets"; // uint64[blocks_count + 1], byte offsets of blocks, compressed layout only
+    constexpr const char *BLOCKS_SECTION = "blocks/data";           // Coded blocks, compressed layout only
+
+    enum Layout : std::uint32_t
+    {
+        DENSE_LAYOUT = 0,
+        COMPRESSED_LAYOUT = 1
+    };
+
+    struct MatrixHeader
+    {
+        std::uint64_t origins_count;
+        std::uint64_t destinations_count;
+        std::uint32_t layout;
+        std::uint32_t block_rows; // Count of rows in a compressed block
+    };
+
+    struct Location
+    {
+        std::int32_t lat;
+        std::int32_t lon;
+    };
+
+    static_assert(sizeof(MatrixHeader) == 24);
+    static_assert(sizeof(Location) == 8);
+}
@@ -0,0 +1,290 @@
+#include "RouteMatrixPlanes.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include "assfire/router/engine/common/RouteTotal.hpp"
+
+// AVX2 kernels are compiled for their own target and chosen at runtime, so the binary keeps running on CPUs without AVX2
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define ASSFIRE_ROUTE_MATRIX_PLANES_AVX2
+#endif
+
+namespace assfire::router
+{
+    namespace
+    {
+        using GeopointId = RouteMatrixPlanes::GeopointId;
+
+        /**
+         * Sums legs between consecutive ids of tour starting from leg i
+         */
+        RouteTotal sum_legs(const RouteInfo::Seconds *travel_times, const RouteInfo::Meters *distances, std::size_t size, const GeopointId *tour, std::size_t count,
+                            std::size_t i = 0, RouteTotal total = RouteTotal())
+        {
+            for (; i + 1 < count; ++i)
+            {
+                std::size_t cell = std::size_t(tour[i]) * size + tour[i + 1];
+                total.add(RouteInfo(distances[cell], travel_times[cell]));
+            }
+            return total;
+        }
+
+        /**
+         * Writes travel time deltas of inserting stop between consecutive elements of route starting from element i
+         */
+        void calculate_insertion_deltas(const RouteInfo::Seconds *travel_times, std::size_t size, GeopointId stop, const GeopointId *route, std::size_t count,
+                                        RouteInfo::Seconds *deltas, std::size_t i = 0)
+        {
+            for (; i + 1 < count; ++i)
+            {
+                RouteInfo::Seconds to_stop = travel_times[std::size_t(route[i]) * size + stop];
+                RouteInfo::Seconds from_stop = travel_times[std::size_t(stop) * size + route[i + 1]];
+                deltas[i] = to_stop >= RouteInfo::INFINITE_TRAVEL_TIME || from_stop >= RouteInfo::INFINITE_TRAVEL_TIME
+                                ? RouteInfo::INFINITE_TRAVEL_TIME
+                                : to_stop + from_stop - travel_times[std::size_t(route[i]) * size + route[i + 1]];
+            }
+        }
+
+#ifdef ASSFIRE_ROUTE_MATRIX_PLANES_AVX2
+        /**
+         * Sums legs between consecutive ids of tour gathering 8 legs at a time. Cell indices are 32-bit, so planes must have at most INT32_MAX cells
+         */
+        __attribute__((target("avx2"))) RouteTotal sum_legs_avx2(const RouteInfo::Seconds *travel_times, const RouteInfo::Meters *distances, std::size_t size,
+                                                                 const GeopointId *tour, std::size_t count)
+        {
+            std::size_t i = 0;
+            RouteTotal total;
+            if (size * size <= std::size_t(std::numeric_limits<std::int32_t>::max()))
+            {
+                const __m256i row_size = _mm256_set1_epi32(std::int32_t(size));
+                const __m256i max_travel_time = _mm256_set1_epi32(RouteInfo::INFINITE_TRAVEL_TIME - 1);
+                const __m256d all_lanes = _mm256_castsi256_pd(_mm256_set1_epi64x(-1)); // Masked gathers don't read undefined source lanes
+                __m256i seconds_low = _mm256_setzero_si256();
+                __m256i seconds_high = _mm256_setzero_si256();
+                __m256d meters_low = _mm256_setzero_pd();
+                __m256d meters_high = _mm256_setzero_pd();
+                __m256i infinite = _mm256_setzero_si256();
+                for (; i + 8 < count; i += 8)
+                {
+                    __m256i origins = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(tour + i));
+                    __m256i destinations = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(tour + i + 1));
+                    __m256i cells = _mm256_add_epi32(_mm256_mullo_epi32(origins, row_size), destinations);
+
+                    __m256i seconds = _mm256_i32gather_epi32(travel_times, cells, sizeof(RouteInfo::Seconds));
+                    infinite = _mm256_or_si256(infinite, _mm256_cmpgt_epi32(seconds, max_travel_time));
+                    seconds_low = _mm256_add_epi64(seconds_low, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(seconds)));
+                    seconds_high = _mm256_add_epi64(seconds_high, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(seconds, 1)));
+                    meters_low = _mm256_add_pd(meters_low, _mm256_mask_i32gather_pd(_mm256_setzero_pd(), distances, _mm256_castsi256_si128(cells), all_lanes, sizeof(RouteInfo::Meters)));
+                    meters_high = _mm256_add_pd(meters_high, _mm256_mask_i32gather_pd(_mm256_setzero_pd(), distances, _mm256_extracti128_si256(cells, 1), all_lanes, sizeof(RouteInfo::Meters)));
+                }
+
+                alignas(32) std::int64_t seconds_lanes[4];
+                alignas(32) double meters_lanes[4];
+                _mm256_store_si256(reinterpret_cast<__m256i *>(seconds_lanes), _mm256_add_epi64(seconds_low, seconds_high));
+                _mm256_store_pd(meters_lanes, _mm256_add_pd(meters_low, meters_high));
+                // Infinite legs are summed too, but unreachable tour total doesn't depend on sums
+                total = RouteTotal(meters_lanes[0] + meters_lanes[1] + meters_lanes[2] + meters_lanes[3],
+                                   seconds_lanes[0] + seconds_lanes[1] + seconds_lanes[2] + seconds_lanes[3],
+                                   !_mm256_testz_si256(infinite, infinite));
+            }
+            return sum_legs(travel_times, distances, size, tour, count, i, total);
+        }
+
+        /**
+         * Writes travel time deltas of inserting stop between consecutive elements of route gathering 8 insertions at a time
+         */
+        __attribute__((target("avx2"))) void calculate_insertion_deltas_avx2(const RouteInfo::Seconds *travel_times, std::size_t size, GeopointId stop,
+                                                                             const GeopointId *route, std::size_t count, RouteInfo::Seconds *deltas)
+        {
+            std::size_t i = 0;
+            if (size * size <= std::size_t(std::numeric_limits<std::int32_t>::max()))
+            {
+                const __m256i row_size = _mm256_set1_epi32(std::int32_t(size));
+                const __m256i stop_column = _mm256_set1_epi32(std::int32_t(stop));
+                const __m256i stop_row = _mm256_set1_epi32(std::int32_t(stop * size));
+                const __m256i max_travel_time = _mm256_set1_epi32(RouteInfo::INFINITE_TRAVEL_TIME - 1);
+                const __m256i infinite_travel_time = _mm256_set1_epi32(RouteInfo::INFINITE_TRAVEL_TIME);
+                for (; i + 8 < count; i += 8)
+                {
+                    __m256i previous_rows = _mm256_mullo_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(route + i)), row_size);
+                    __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(route + i + 1));
+
+                    __m256i to_stop = _mm256_i32gather_epi32(travel_times, _mm256_add_epi32(previous_rows, stop_column), sizeof(RouteInfo::Seconds));
+                    __m256i from_stop = _mm256_i32gather_epi32(travel_times, _mm256_add_epi32(stop_row, next), sizeof(RouteInfo::Seconds));
+                    __m256i direct = _mm256_i32gather_epi32(travel_times, _mm256_add_epi32(previous_rows, next), sizeof(RouteInfo::Seconds));
+
+                    __m256i delta = _mm256_sub_epi32(_mm256_add_epi32(to_stop, from_stop), direct);
+                    __m256i unreachable = _mm256_cmpgt_epi32(_mm256_max_epi32(to_stop, from_stop), max_travel_time);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(deltas + i), _mm256_blendv_epi8(delta, infinite_travel_time, unreachable));
+                }
+            }
+            calculate_insertion_deltas(travel_times, size, stop, route, count, deltas, i);
+        }
+#endif
+    }
+
+    bool RouteMatrixPlanes::has_vector_instructions()
+    {
+#ifdef ASSFIRE_ROUTE_MATRIX_PLANES_AVX2
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    RouteMatrixPlanes::RouteMatrixPlanes(const RouteMatrix &matrix, std::size_t size, bool use_vector_instructions)
+        : _size(size),
+          vectorized(use_vector_instructions && has_vector_instructions()),
+          present(size, 1),
+          travel_times(size * size),
+          distances(size * size)
+    {
+        for (GeopointId origin = 0; origin < size; ++origin)
+        {
+            for (GeopointId destination = 0; destination < size; ++destination)
+            {
+                RouteInfo info = matrix.get_route_info(origin, destination);
+                travel_times[origin * size + destination] = info.travel_time_seconds();
+                distances[origin * size + destination] = info.distance_meters();
+            }
+        }
+    }
+
+    RouteMatrixPlanes::RouteMatrixPlanes(const RouteMatrix &matrix, std::span<const GeopointId> present_ids, bool use_vector_instructions)
+        : _size(present_ids.empty() ? 0 : std::size_t(*std::max_element(present_ids.begin(), present_ids.end())) + 1),
+          vectorized(use_vector_instructions && has_vector_instructions()),
+          present(_size, 0),
+          travel_times(_size * _size, RouteInfo::INFINITE_TRAVEL_TIME),
+          distances(_size * _size, RouteInfo::INFINITE_DISTANCE)
+    {
+        for (GeopointId id : present_ids)
+        {
+            present[id] = 1;
+        }
+        for (GeopointId origin : present_ids)
+        {
+            for (GeopointId destination : present_ids)
+            {
+                RouteInfo info = matrix.get_route_info(origin, destination);
+                travel_times[std::size_t(origin) * _size + destination] = info.travel_time_seconds();
+                distances[std::size_t(origin) * _size + destination] = info.distance_meters();
+            }
+        }
+    }
+
+    RouteInfo RouteMatrixPlanes::evaluate_tour(std::span<const GeopointId> tour) const
+    {
+        validate(tour);
+        return evaluate_legs(tour.data(), tour.size());
+    }
+
+    std::vector<RouteInfo> RouteMatrixPlanes::evaluate_tours(std::span<const GeopointId> tours, std::span<const std::uint32_t> tour_sizes) const
+    {
+        validate(tours, tour_sizes);
+
+        std::vector<RouteInfo> result;
+        result.reserve(tour_sizes.size());
+        const GeopointId *tour = tours.data();
+        for (std::uint32_t tour_size : tour_sizes)
+        {
+            result.push_back(evaluate_legs(tour, tour_size));
+            tour += tour_size;
+        }
+        return result;
+    }
+
+    void RouteMatrixPlanes::evaluate_insertions(GeopointId stop, std::span<const GeopointId> route, std::span<RouteInfo::Seconds> deltas) const
+    {
+        validate(route);
+        validate(std::span<const GeopointId>(&stop, 1));
+        if (deltas.size() + 1 != std::max<std::size_t>(route.size(), 1))
+        {
+            throw std::invalid_argument("Insertion deltas count doesn't match route size");
+        }
+        calculate_deltas(stop, route.data(), route.size(), deltas.data());
+    }
+
+    std::vector<RouteMatrixPlanes::Insertion> RouteMatrixPlanes::find_best_insertions(std::span<const GeopointId> stops, std::span<const GeopointId> routes,
+                                                                                      std::span<const std::uint32_t> route_sizes) const
+    {
+        validate(routes, route_sizes);
+        validate(stops);
+
+        std::vector<Insertion> result(stops.size() * route_sizes.size());
+        std::vector<RouteInfo::Seconds> deltas;
+        Insertion *insertion = result.data();
+        for (GeopointId stop : stops)
+        {
+            const GeopointId *route = routes.data();
+            for (std::uint32_t route_size : route_sizes)
+            {
+                if (route_size >= 2)
+                {
+                    deltas.resize(route_size - 1);
+                    calculate_deltas(stop, route, route_size, deltas.data());
+                    auto best = std::min_element(deltas.begin(), deltas.end());
+                    if (*best < RouteInfo::INFINITE_TRAVEL_TIME)
+                    {
+                        insertion->position = std::uint32_t(best - deltas.begin()) + 1;
+                        insertion->delta_seconds = *best;
+                    }
+                }
+                route += route_size;
+                ++insertion;
+            }
+        }
+        return result;
+    }
+
+    RouteInfo RouteMatrixPlanes::evaluate_legs(const GeopointId *tour, std::size_t count) const
+    {
+#ifdef ASSFIRE_ROUTE_MATRIX_PLANES_AVX2
+        if (vectorized)
+        {
+            return sum_legs_avx2(travel_times.data(), distances.data(), _size, tour, count).get();
+        }
+#endif
+        return sum_legs(travel_times.data(), distances.data(), _size, tour, count).get();
+    }
+
+    void RouteMatrixPlanes::calculate_deltas(GeopointId stop, const GeopointId *route, std::size_t count, RouteInfo::Seconds *deltas) const
+    {
+#ifdef ASSFIRE_ROUTE_MATRIX_PLANES_AVX2
+        if (vectorized)
+        {
+            calculate_insertion_deltas_avx2(travel_times.data(), _size, stop, route, count, deltas);
+            return;
+        }
+#endif
+        calculate_insertion_deltas(travel_times.data(), _size, stop, route, count, deltas);
+    }
+
+    void RouteMatrixPlanes::validate(std::span<const GeopointId> ids, std::span<const std::uint32_t> sizes) const
+    {
+        std::size_t ids_count = 0;
+        for (std::uint32_t size : sizes)
+        {
+            ids_count += size;
+        }
+        if (ids_count != ids.size())
+        {
+            throw std::invalid_argument("Sizes don't match count of ids");
+        }
+        validate(ids);
+    }
+
+    void RouteMatrixPlanes::validate(std::span<const GeopointId> ids) const
+    {
+        for (GeopointId id : ids)
+        {
+            if (!contains(id))
+            {
+                throw std::invalid_argument("Unknown geopoint id: " + std::to_string(id));
+            }
+        }
+    }
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+#include "assfire/router/api/RouteMatrix.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief Compact copy of square route matrix for evaluating many tours over the same waypoints, e.g. by local search of route optimizers.
+     *
+     * \details Travel times and distances are stored in separate row-major planes, so legs of a tour are gathered from them by vector instructions
+     * where the CPU supports them (AVX2, detected at runtime) instead of per-cell virtual calls. Planes cover ids from zero to the largest present id, rows and columns of absent ids
+     * (e.g. removed from extendable matrix) are not filled and tours through them are rejected. Planes are immutable, so they may be used
+     * from any number of threads
+     */
+    class RouteMatrixPlanes
+    {
+    public:
+        using GeopointId = RouteMatrix::GeopointId;
+
+        static constexpr std::uint32_t NO_POSITION = std::numeric_limits<std::uint32_t>::max();
+
+        /**
+         * \brief Cheapest insertion of a stop into a route: stop becomes route element at position, so it goes between elements position - 1
+         * and position. Routes with less than 2 elements and routes the stop can't be inserted into without unreachable legs have NO_POSITION
+         * and infinite delta
+         */
+        struct Insertion
+        {
+            std::uint32_t position = NO_POSITION;
+            RouteInfo::Seconds delta_seconds = RouteInfo::INFINITE_TRAVEL_TIME;
+        };
+
+        /**
+         * \brief Copies routes between all pairs of ids from 0 to size - 1
+         *
+         * \param use_vector_instructions Whether tours may be evaluated by vector instructions when the CPU supports them, otherwise scalar code is used
+         */
+        RouteMatrixPlanes(const RouteMatrix &matrix, std::size_t size, bool use_vector_instructions = true);
+
+        /**
+         * \brief Copies routes between all pairs of present ids
+         */
+        RouteMatrixPlanes(const RouteMatrix &matrix, std::span<const GeopointId> present_ids, bool use_vector_instructions = true);
+
+        /**
+         * \brief Checks whether this build and CPU support vector instructions planes use
+         */
+        static bool has_vector_instructions();
+
+        /**
+         * \brief Calculates total distance and travel time of legs between consecutive ids of tour (see RouteTotal).
+         * Throws std::invalid_argument if tour has an id planes don't cover
+         */
+        RouteInfo evaluate_tour(std::span<const GeopointId> tour) const;
+
+        /**
+         * \brief Evaluates batch of tours stored one after another
+         *
+         * \param tours Ids of all tours
+         * \param tour_sizes Count of ids of each tour, their sum must be equal to count of ids
+         *
+         * \return Total of each tour in the same order
+         */
+        std::vector<RouteInfo> evaluate_tours(std::span<const GeopointId> tours, std::span<const std::uint32_t> tour_sizes) const;
+
+        /**
+         * \brief Calculates travel time delta of inserting stop between each pair of consecutive route elements:
+         * time(route[i], stop) + time(stop, route[i + 1]) - time(route[i], route[i + 1]). Insertions creating unreachable legs have infinite delta
+         *
+         * \param stop Id of stop to insert
+         * \param route Ids of route elements
+         * \param deltas Receives delta of each insertion, must have route.size() - 1 elements
+         */
+        void evaluate_insertions(GeopointId stop, std::span<const GeopointId> route, std::span<RouteInfo::Seconds> deltas) const;
+
+        /**
+         * \brief Finds cheapest insertion of each stop into each route, e.g. for insertion heuristics. Ties are resolved to the lowest position
+         *
+         * \param stops Ids of stops to insert
+         * \param routes Ids of all routes stored one after another
+         * \param route_sizes Count of ids of each route, their sum must be equal to count of route ids
+         *
+         * \return Cheapest insertion for each pair of stop and route, by stop then by route
+         */
+        std::vector<Insertion> find_best_insertions(std::span<const GeopointId> stops, std::span<const GeopointId> routes,
+                                                    std::span<const std::uint32_t> route_sizes) const;
+
+        std::size_t size() const
+        {
+            return _size;
+        }
+
+        bool contains(GeopointId id) const
+        {
+            return id < _size && present[id];
+        }
+
+        RouteInfo::Seconds get_travel_time_seconds(GeopointId origin, GeopointId destination) const
+        {
+            return travel_times[std::size_t(origin) * _size + destination];
+        }
+
+        RouteInfo::Meters get_distance_meters(GeopointId origin, GeopointId destination) const
+        {
+            return distances[std::size_t(origin) * _size + destination];
+        }
+
+        bool is_vectorized() const
+        {
+            return vectorized;
+        }
+
+        std::size_t get_memory_usage_bytes() const
+        {
+            return present.size() + travel_times.size() * sizeof(RouteInfo::Seconds) + distances.size() * sizeof(RouteInfo::Meters);
+        }
+
+    private:
+        RouteInfo evaluate_legs(const GeopointId *tour, std::size_t count) const;
+        void calculate_deltas(GeopointId stop, const GeopointId *route, std::size_t count, RouteInfo::Seconds *deltas) const;
+        void validate(std::span<const GeopointId> ids) const;
+        void validate(std::span<const GeopointId> ids, std::span<const std::uint32_t> sizes) const;
+
+        std::size_t _size;
+        bool vectorized;
+        std::vector<std::uint8_t> present;
+        std::vector<RouteInfo::Seconds> travel_times; // Row-major, by origin then destination
+        std::vector<RouteInfo::Meters> distances;     // Row-major, by origin then destination
+    };
+}
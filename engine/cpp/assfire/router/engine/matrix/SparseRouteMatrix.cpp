@@ -0,0 +1,362 @@
+#include "SparseRouteMatrix.hpp"
+#include "WaypointsGrid.hpp"
+#include "assfire/router/engine/common/ParallelWorkers.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <string>
+
+namespace assfire::router
+{
+    namespace
+    {
+        using GeopointId = RouteMatrix::GeopointId;
+
+        /**
+         * Origins are split between threads only if each thread gets at least this many of them
+         */
+        constexpr std::size_t MIN_ORIGINS_PER_THREAD = 16;
+
+        /**
+         * Candidates of consecutive rings are calculated together until there are at least this many of them, so strategies with costly searches
+         * don't start a search for each small ring
+         */
+        constexpr std::size_t MIN_CANDIDATES_PER_SEARCH = 32;
+
+        struct Neighbour
+        {
+            GeopointId id;
+            RouteInfo route_info;
+
+            bool operator<(const Neighbour &rhs) const
+            {
+                return route_info.travel_time_seconds() < rhs.route_info.travel_time_seconds() ||
+                       (route_info.travel_time_seconds() == rhs.route_info.travel_time_seconds() && id < rhs.id);
+            }
+        };
+        using Row = std::vector<Neighbour>;
+
+        /**
+         * Finds nearest destinations of origin. Keeps route to destination with the same id as origin (self) if square is set
+         */
+        class NearestDestinationsSearch
+        {
+        public:
+            NearestDestinationsSearch(const RoutingStrategy &strategy, const TransportProfile &profile, SparseRouteMatrix::WaypointsView destinations,
+                                      const WaypointsGrid *grid, const SparseRouteMatrix::Bounds &bounds, bool square)
+                : strategy(strategy),
+                  profile(profile),
+                  destinations(destinations),
+                  grid(grid),
+                  bounds(bounds),
+                  square(square)
+            {
+            }
+
+            Row find(GeopointId origin_id, const GeoPoint &origin)
+            {
+                nearest = {};
+                self.reset();
+                if (!grid)
+                {
+                    candidates.resize(destinations.size());
+                    for (GeopointId id = 0; id < destinations.size(); ++id)
+                    {
+                        candidates[id] = id;
+                    }
+                    calculate(origin_id, origin);
+                }
+                else
+                {
+                    std::size_t rings_count = grid->get_rings_count(origin);
+                    for (std::size_t ring = 0; ring < rings_count; ++ring)
+                    {
+                        if (get_time_bound(grid->get_ring_lower_bound_meters(origin, ring)) > get_cutoff())
+                        {
+                            break; // Rings are ordered by lower bound, so the rest of them can't have closer destinations
+                        }
+                        ring_ids.clear();
+                        grid->collect_ring(origin, ring, ring_ids);
+                        for (GeopointId id : ring_ids)
+                        {
+                            if ((square && id == origin_id) || get_time_bound(WaypointsGrid::get_lower_bound_meters(origin, destinations[id])) <= get_cutoff())
+                            {
+                                candidates.push_back(id);
+                            }
+                        }
+                        if (candidates.size() >= MIN_CANDIDATES_PER_SEARCH || ring + 1 == rings_count)
+                        {
+                            calculate(origin_id, origin);
+                        }
+                    }
+                    calculate(origin_id, origin);
+                }
+
+                Row result;
+                result.reserve(nearest.size() + 1);
+                for (; !nearest.empty(); nearest.pop())
+                {
+                    result.push_back(nearest.top());
+                }
+                if (self)
+                {
+                    result.push_back(*self);
+                }
+                std::sort(result.begin(), result.end(), [](const Neighbour &lhs, const Neighbour &rhs)
+                          { return lhs.id < rhs.id; });
+                return result;
+            }
+
+        private:
+            RouteInfo::Seconds get_time_bound(RouteInfo::Meters distance) const
+            {
+                return profile.calculate_time_to_travel_seconds(distance);
+            }
+
+            /**
+             * Max travel time of routes that still may be kept
+             */
+            RouteInfo::Seconds get_cutoff() const
+            {
+                if (bounds.neighbours_count > 0 && nearest.size() == bounds.neighbours_count)
+                {
+                    return std::min(bounds.max_travel_time_seconds, nearest.top().route_info.travel_time_seconds());
+                }
+                return bounds.max_travel_time_seconds;
+            }
+
+            void calculate(GeopointId origin_id, const GeoPoint &origin)
+            {
+                if (candidates.empty())
+                {
+                    return;
+                }
+                points.clear();
+                for (GeopointId id : candidates)
+                {
+                    points.push_back(destinations[id]);
+                }
+                RoutingStrategy::MatrixPtr matrix = strategy.calculate_route_matrix(SparseRouteMatrix::WaypointsView(&origin, 1), points, profile);
+                for (GeopointId i = 0; i < candidates.size(); ++i)
+                {
+                    Neighbour neighbour{candidates[i], matrix->get_route_info(0, i)};
+                    if (square && neighbour.id == origin_id)
+                    {
+                        self = neighbour;
+                    }
+                    else if (neighbour.route_info.travel_time_seconds() <= bounds.max_travel_time_seconds &&
+                             neighbour.route_info.travel_time_seconds() < RouteInfo::INFINITE_TRAVEL_TIME)
+                    {
+                        nearest.push(neighbour);
+                        if (bounds.neighbours_count > 0 && nearest.size() > bounds.neighbours_count)
+                        {
+                            nearest.pop();
+                        }
+                    }
+                }
+                candidates.clear();
+            }
+
+            const RoutingStrategy &strategy;
+            const TransportProfile &profile;
+            SparseRouteMatrix::WaypointsView destinations;
+            const WaypointsGrid *grid;
+            SparseRouteMatrix::Bounds bounds;
+            bool square;
+
+            std::priority_queue<Neighbour> nearest; // Farthest kept neighbour on top
+            std::optional<Neighbour> self;
+            std::vector<GeopointId> ring_ids;
+            std::vector<GeopointId> candidates;
+            std::vector<GeoPoint> points;
+        };
+
+        std::vector<Row> find_nearest_destinations(const RoutingStrategy &strategy, const TransportProfile &profile, SparseRouteMatrix::WaypointsView origins,
+                                                   SparseRouteMatrix::WaypointsView destinations, const SparseRouteMatrix::Bounds &bounds, bool square)
+        {
+            std::optional<WaypointsGrid> grid;
+            if (strategy.is_bounded_by_crowflight() && profile.speed_meters_per_second() > 0)
+            {
+                grid.emplace(destinations);
+            }
+
+            std::vector<Row> rows(origins.size());
+            std::size_t threads_count = std::min<std::size_t>(ParallelWorkers::get_max_workers_count(), origins.size() / MIN_ORIGINS_PER_THREAD);
+            std::atomic<std::size_t> next_origin = 0;
+            ParallelWorkers::run(threads_count, [&](std::size_t)
+                                 {
+                                     try
+                                     {
+                                         NearestDestinationsSearch search(strategy, profile, destinations, grid ? &*grid : nullptr, bounds, square);
+                                         for (std::size_t i = next_origin++; i < origins.size(); i = next_origin++)
+                                         {
+                                             rows[i] = search.find(i, origins[i]);
+                                         }
+                                     }
+                                     catch (...)
+                                     {
+                                         next_origin = origins.size();
+                                         throw;
+                                     }
+                                 });
+            return rows;
+        }
+
+        std::shared_ptr<SparseRouteMatrix> make_matrix(SparseRouteMatrix::WaypointsView origins, SparseRouteMatrix::WaypointsView destinations,
+                                                       const std::vector<Row> &rows, std::shared_ptr<RoutingStrategy> fallback_strategy,
+                                                       const TransportProfile &profile)
+        {
+            std::vector<std::uint64_t> row_offsets(rows.size() + 1, 0);
+            for (std::size_t i = 0; i < rows.size(); ++i)
+            {
+                row_offsets[i + 1] = row_offsets[i] + rows[i].size();
+            }
+            std::vector<GeopointId> destination_ids;
+            std::vector<RouteInfo::Seconds> travel_times;
+            std::vector<RouteInfo::Meters> distances;
+            destination_ids.reserve(row_offsets.back());
+            travel_times.reserve(row_offsets.back());
+            distances.reserve(row_offsets.back());
+            for (const Row &row : rows)
+            {
+                for (const Neighbour &neighbour : row)
+                {
+                    destination_ids.push_back(neighbour.id);
+                    travel_times.push_back(neighbour.route_info.travel_time_seconds());
+                    distances.push_back(neighbour.route_info.distance_meters());
+                }
+            }
+            return std::make_shared<SparseRouteMatrix>(std::vector<GeoPoint>(origins.begin(), origins.end()),
+                                                       std::vector<GeoPoint>(destinations.begin(), destinations.end()),
+                                                       std::move(row_offsets), std::move(destination_ids), std::move(travel_times), std::move(distances),
+                                                       std::move(fallback_strategy), profile);
+        }
+    }
+
+    SparseRouteMatrix::SparseRouteMatrix(std::vector<GeoPoint> origins,
+                                         std::vector<GeoPoint> destinations,
+                                         std::vector<std::uint64_t> row_offsets,
+                                         std::vector<GeopointId> destination_ids,
+                                         std::vector<RouteInfo::Seconds> travel_times,
+                                         std::vector<RouteInfo::Meters> distances,
+                                         std::shared_ptr<RoutingStrategy> fallback_strategy,
+                                         TransportProfile transport_profile) : origins(std::move(origins)),
+                                                                               destinations(std::move(destinations)),
+                                                                               row_offsets(std::move(row_offsets)),
+                                                                               destination_ids(std::move(destination_ids)),
+                                                                               travel_times(std::move(travel_times)),
+                                                                               distances(std::move(distances)),
+                                                                               fallback_strategy(std::move(fallback_strategy)),
+                                                                               transport_profile(std::move(transport_profile))
+    {
+        if (this->row_offsets.size() != this->origins.size() + 1 || this->row_offsets.back() != this->destination_ids.size() ||
+            this->travel_times.size() != this->destination_ids.size() || this->distances.size() != this->destination_ids.size())
+        {
+            throw std::invalid_argument("Inconsistent sparse route matrix rows");
+        }
+    }
+
+    std::shared_ptr<SparseRouteMatrix> SparseRouteMatrix::calculate_nearest(const RoutingStrategy &strategy, const TransportProfile &profile, WaypointsView waypoints,
+                                                                            const Bounds &bounds, std::shared_ptr<RoutingStrategy> fallback_strategy)
+    {
+        std::vector<Row> rows = find_nearest_destinations(strategy, profile, waypoints, waypoints, bounds, true);
+        return make_matrix(waypoints, waypoints, rows, std::move(fallback_strategy), profile);
+    }
+
+    std::shared_ptr<SparseRouteMatrix> SparseRouteMatrix::calculate_bounded(const RoutingStrategy &strategy, const TransportProfile &profile, WaypointsView origins,
+                                                                            WaypointsView destinations, RouteInfo::Seconds max_travel_time_seconds)
+    {
+        std::vector<Row> rows = find_nearest_destinations(strategy, profile, origins, destinations, Bounds{0, max_travel_time_seconds}, false);
+        return make_matrix(origins, destinations, rows, nullptr, profile);
+    }
+
+    bool SparseRouteMatrix::contains(GeopointId origin, GeopointId destination) const
+    {
+        return find_route(origin, destination) != NO_ROUTE;
+    }
+
+    std::span<const RouteMatrix::GeopointId> SparseRouteMatrix::get_row_destinations(GeopointId origin) const
+    {
+        if (origin >= get_origins_count())
+        {
+            throw std::invalid_argument("Invalid origin id: " + std::to_string(origin));
+        }
+        return std::span<const GeopointId>(destination_ids.data() + row_offsets[origin], destination_ids.data() + row_offsets[origin + 1]);
+    }
+
+    RouteInfo SparseRouteMatrix::get_route_info(GeopointId origin, GeopointId destination) const
+    {
+        std::size_t route = find_route(origin, destination);
+        if (route != NO_ROUTE)
+        {
+            return RouteInfo(distances[route], travel_times[route]);
+        }
+        if (!fallback_strategy)
+        {
+            return RouteInfo(RouteInfo::INFINITE_DISTANCE, RouteInfo::INFINITE_TRAVEL_TIME);
+        }
+        return fallback_strategy->calculate_route_info(origins[origin], destinations[destination], transport_profile);
+    }
+
+    RouteInfo::Meters SparseRouteMatrix::get_distance_meters(GeopointId origin, GeopointId destination) const
+    {
+        return get_route_info(origin, destination).distance_meters();
+    }
+
+    RouteInfo::Seconds SparseRouteMatrix::get_travel_time_seconds(GeopointId origin, GeopointId destination) const
+    {
+        return get_route_info(origin, destination).travel_time_seconds();
+    }
+
+    Route SparseRouteMatrix::calculate_route(const GeoPoint &origin, const GeoPoint &destination) const
+    {
+        ensure_strategy_present();
+        return fallback_strategy->calculate_route(origin, destination, transport_profile);
+    }
+
+    RouteInfo SparseRouteMatrix::calculate_route_info(const GeoPoint &origin, const GeoPoint &destination) const
+    {
+        ensure_strategy_present();
+        return fallback_strategy->calculate_route_info(origin, destination, transport_profile);
+    }
+
+    RouteInfo::Meters SparseRouteMatrix::calculate_distance_meters(const GeoPoint &origin, const GeoPoint &destination) const
+    {
+        ensure_strategy_present();
+        return fallback_strategy->calculate_distance_meters(origin, destination, transport_profile);
+    }
+
+    RouteInfo::Seconds SparseRouteMatrix::calculate_travel_time_seconds(const GeoPoint &origin, const GeoPoint &destination) const
+    {
+        ensure_strategy_present();
+        return fallback_strategy->calculate_travel_time_seconds(origin, destination, transport_profile);
+    }
+
+    void SparseRouteMatrix::sync() const
+    {
+        // No-op for this implementation
+    }
+
+    std::size_t SparseRouteMatrix::find_route(GeopointId origin, GeopointId destination) const
+    {
+        if (origin >= get_origins_count() || destination >= get_destinations_count())
+        {
+            throw std::invalid_argument("Invalid geopoint ids: " + std::to_string(origin) + "->" + std::to_string(destination));
+        }
+        auto row_begin = destination_ids.begin() + row_offsets[origin];
+        auto row_end = destination_ids.begin() + row_offsets[origin + 1];
+        auto iter = std::lower_bound(row_begin, row_end, destination);
+        return iter != row_end && *iter == destination ? iter - destination_ids.begin() : NO_ROUTE;
+    }
+
+    void SparseRouteMatrix::ensure_strategy_present() const
+    {
+        if (!fallback_strategy)
+        {
+            throw std::runtime_error("Route calculation is requested at matrix API but no strategy was provided");
+        }
+    }
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+#include "assfire/router/api/RouteMatrix.hpp"
+#include "assfire/router/engine/common/RoutingStrategy.hpp"
+#include "assfire/router/engine/common/TransportProfile.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief This class represents route matrix that stores only some routes from each origin, e.g. to its nearest destinations, in compressed sparse
+     * row layout. Problems with tens of thousands of waypoints fit in memory this way, while dense matrices of them don't.
+     *
+     * \details Routes of origin i are stored in positions from row_offsets[i] to row_offsets[i + 1] - 1 sorted by destination ids, so a route is looked up
+     * by binary search within its row. Routes that are not stored are calculated by fallback strategy if it is configured, otherwise they are infinite
+     */
+    class SparseRouteMatrix : public RouteMatrix
+    {
+    public:
+        using WaypointsView = RoutingStrategy::WaypointsView;
+
+        /**
+         * \brief Limits of routes calculated from each origin
+         */
+        struct Bounds
+        {
+            std::uint32_t neighbours_count = 0;                                           // Count of nearest destinations to keep, 0 keeps all
+            RouteInfo::Seconds max_travel_time_seconds = RouteInfo::INFINITE_TRAVEL_TIME; // Routes taking longer are not kept
+        };
+
+        /**
+         * \brief Construct a new SparseRouteMatrix object from compressed rows
+         *
+         * \param origins Origin waypoints
+         * \param destinations Destination waypoints
+         * \param row_offsets Offset of routes of each origin, has origins.size() + 1 elements
+         * \param destination_ids Destination of each stored route, sorted within each row
+         * \param travel_times Travel time of each stored route
+         * \param distances Distance of each stored route
+         * \param fallback_strategy Strategy to calculate routes that are not stored and routes between not indexed locations. May be null
+         * \param transport_profile Transport profile associated with this matrix. Is passed down to the fallback strategy
+         */
+        SparseRouteMatrix(std::vector<GeoPoint> origins,
+                          std::vector<GeoPoint> destinations,
+                          std::vector<std::uint64_t> row_offsets,
+                          std::vector<GeopointId> destination_ids,
+                          std::vector<RouteInfo::Seconds> travel_times,
+                          std::vector<RouteInfo::Meters> distances,
+                          std::shared_ptr<RoutingStrategy> fallback_strategy,
+                          TransportProfile transport_profile);
+
+        /**
+         * \brief Calculates routes from each waypoint to its nearest waypoints by travel time within bounds. Route of each waypoint to itself is always kept.
+         * For strategies bounded by crowflight, candidate destinations are enumerated by a spatial grid in order of crowflight lower bound of travel
+         * time and only candidates that can be nearer than already found neighbours are calculated, one-to-many for each ring of grid cells
+         *
+         * \param strategy Strategy to calculate routes with
+         * \param profile Transport profile to calculate routes for
+         * \param waypoints Waypoints of matrix, they are both origins and destinations
+         * \param bounds Neighbours count and max travel time of kept routes
+         * \param fallback_strategy Strategy to calculate routes that are not kept. May be null, then such routes are infinite
+         */
+        static std::shared_ptr<SparseRouteMatrix> calculate_nearest(const RoutingStrategy &strategy, const TransportProfile &profile, WaypointsView waypoints,
+                                                                    const Bounds &bounds, std::shared_ptr<RoutingStrategy> fallback_strategy);
+
+        /**
+         * \brief Calculates only routes that take at most max travel time, the rest of matrix is infinite, e.g. for problems with time windows
+         * that never need far apart pairs. For strategies bounded by crowflight, destinations that can't be reached in time by crowflight bound
+         * are skipped over a spatial grid without calculating their routes
+         *
+         * \param strategy Strategy to calculate routes with
+         * \param profile Transport profile to calculate routes for
+         * \param origins Origin waypoints
+         * \param destinations Destination waypoints
+         * \param max_travel_time_seconds Max travel time of calculated routes
+         */
+        static std::shared_ptr<SparseRouteMatrix> calculate_bounded(const RoutingStrategy &strategy, const TransportProfile &profile, WaypointsView origins,
+                                                                    WaypointsView destinations, RouteInfo::Seconds max_travel_time_seconds);
+
+        /**
+         * \brief Tells if route between origin and destination is stored
+         */
+        bool contains(GeopointId origin, GeopointId destination) const;
+
+        std::size_t get_origins_count() const
+        {
+            return row_offsets.size() - 1;
+        }
+
+        std::size_t get_destinations_count() const
+        {
+            return destinations.size();
+        }
+
+        /**
+         * \brief Ids of destinations of routes stored for origin in ascending order
+         */
+        std::span<const GeopointId> get_row_destinations(GeopointId origin) const;
+
+        /**
+         * \brief Returns count of stored routes
+         */
+        std::size_t get_routes_count() const
+        {
+            return destination_ids.size();
+        }
+
+        virtual RouteInfo get_route_info(GeopointId origin, GeopointId destination) const override;
+        virtual RouteInfo::Meters get_distance_meters(GeopointId origin, GeopointId destination) const override;
+        virtual RouteInfo::Seconds get_travel_time_seconds(GeopointId origin, GeopointId destination) const override;
+        virtual Route calculate_route(const GeoPoint &origin, const GeoPoint &destination) const override;
+        virtual RouteInfo calculate_route_info(const GeoPoint &origin, const GeoPoint &destination) const override;
+        virtual RouteInfo::Meters calculate_distance_meters(const GeoPoint &origin, const GeoPoint &destination) const override;
+        virtual RouteInfo::Seconds calculate_travel_time_seconds(const GeoPoint &origin, const GeoPoint &destination) const override;
+        virtual void sync() const override;
+
+    private:
+        static constexpr std::size_t NO_ROUTE = std::size_t(-1);
+
+        std::size_t find_route(GeopointId origin, GeopointId destination) const;
+        void ensure_strategy_present() const;
+
+        std::vector<GeoPoint> origins;
+        std::vector<GeoPoint> destinations;
+        std::vector<std::uint64_t> row_offsets;
+        std::vector<GeopointId> destination_ids;
+        std::vector<RouteInfo::Seconds> travel_times;
+        std::vector<RouteInfo::Meters> distances;
+        std::shared_ptr<RoutingStrategy> fallback_strategy;
+        TransportProfile transport_profile;
+    };
+}
@@ -0,0 +1,117 @@
+#include "TriangularRouteMatrix.hpp"
+
+#include <string>
+#include <stdexcept>
+#include <utility>
+
+namespace assfire::router
+{
+    namespace
+    {
+        /**
+         * Upper triangle with diagonal (i <= j) is stored row by row: row i starts after sum of lengths of previous rows (size - k for k < i)
+         */
+        std::size_t cell_index(std::size_t size, std::size_t i, std::size_t j)
+        {
+            return i * (2 * size - i + 1) / 2 + (j - i);
+        }
+
+        void initialize_data(std::vector<RouteInfo> &data, std::size_t size, TriangularRouteMatrix::RouteInfoSupplier calculate_route)
+        {
+            data.resize(size * (size + 1) / 2);
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                for (std::size_t j = i; j < size; ++j)
+                {
+                    data[cell_index(size, i, j)] = calculate_route(i, j);
+                }
+            }
+        }
+    }
+
+    TriangularRouteMatrix::TriangularRouteMatrix(std::size_t size,
+                                                 RouteInfoSupplier calculate_route,
+                                                 std::shared_ptr<RoutingStrategy> fallback_strategy,
+                                                 TransportProfile transport_profile) : size(size),
+                                                                                       transport_profile(transport_profile),
+                                                                                       fallback_strategy(fallback_strategy)
+    {
+        initialize_data(data, size, std::move(calculate_route));
+    }
+
+    TriangularRouteMatrix::TriangularRouteMatrix(std::size_t size,
+                                                 RouteInfoSupplier calculate_route) : size(size)
+    {
+        initialize_data(data, size, std::move(calculate_route));
+    }
+
+    RouteInfo TriangularRouteMatrix::get_route_info(GeopointId origin, GeopointId destination) const
+    {
+        return retrieve_route_info(origin, destination);
+    }
+
+    RouteInfo::Meters TriangularRouteMatrix::get_distance_meters(GeopointId origin, GeopointId destination) const
+    {
+        return retrieve_route_info(origin, destination).distance_meters();
+    }
+
+    RouteInfo::Seconds TriangularRouteMatrix::get_travel_time_seconds(GeopointId origin, GeopointId destination) const
+    {
+        return retrieve_route_info(origin, destination).travel_time_seconds();
+    }
+
+    Route TriangularRouteMatrix::calculate_route(const GeoPoint &origin, const GeoPoint &destination) const
+    {
+        ensure_strategy_present();
+        return fallback_strategy->calculate_route(origin, destination, transport_profile);
+    }
+
+    RouteInfo TriangularRouteMatrix::calculate_route_info(const GeoPoint &origin, const GeoPoint &destination) const
+    {
+        ensure_strategy_present();
+        return fallback_strategy->calculate_route_info(origin, destination, transport_profile);
+    }
+
+    RouteInfo::Meters TriangularRouteMatrix::calculate_distance_meters(const GeoPoint &origin, const GeoPoint &destination) const
+    {
+        ensure_strategy_present();
+        return fallback_strategy->calculate_distance_meters(origin, destination, transport_profile);
+    }
+
+    RouteInfo::Seconds TriangularRouteMatrix::calculate_travel_time_seconds(const GeoPoint &origin, const GeoPoint &destination) const
+    {
+        ensure_strategy_present();
+        return fallback_strategy->calculate_travel_time_seconds(origin, destination, transport_profile);
+    }
+
+    void TriangularRouteMatrix::validate_geopoint_id(GeopointId origin, GeopointId destination) const
+    {
+        if (origin >= size || destination >= size)
+        {
+            throw std::invalid_argument("Invalid geopoint ids: " + std::to_string(origin) + "->" + std::to_string(destination));
+        }
+    }
+
+    void TriangularRouteMatrix::ensure_strategy_present() const
+    {
+        if (!fallback_strategy)
+        {
+            throw std::runtime_error("Route calculation is requested at matrix API but no strategy was provided");
+        }
+    }
+
+    RouteInfo TriangularRouteMatrix::retrieve_route_info(GeopointId origin, GeopointId destination) const
+    {
+        validate_geopoint_id(origin, destination);
+        if (origin > destination)
+        {
+            std::swap(origin, destination);
+        }
+        return data[cell_index(size, origin, destination)];
+    }
+
+    void TriangularRouteMatrix::sync() const
+    {
+        // No-op for this implementation
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include "assfire/router/api/RouteMatrix.hpp"
+#include "assfire/router/engine/common/RoutingStrategy.hpp"
+#include "assfire/router/engine/common/TransportProfile.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief This class represents square route matrix for symmetric routing strategies. Only routes from i-th to j-th location with i <= j
+     * are calculated and stored and routes with i > j are mirrored. Diagonal is calculated as well since strategies may not consider routes to the same location empty
+     *
+     */
+    class TriangularRouteMatrix : public RouteMatrix
+    {
+    public:
+        using RouteInfoSupplier = std::function<RouteInfo(std::size_t, std::size_t)>;
+
+        /**
+         * \brief Construct a new TriangularRouteMatrix object
+         *
+         * \param size Count of locations to generate matrix for
+         * \param calculate_route Function to calculate route between i-th and j-th location. Is only called for i <= j
+         * \param fallback_strategy Strategy to use when calculating routes between not indexed locations
+         * \param transport_profile Transport profile associated with this distance matrix. Is passed down to the fallback strategy
+         */
+        TriangularRouteMatrix(std::size_t size,
+                              RouteInfoSupplier calculate_route,
+                              std::shared_ptr<RoutingStrategy> fallback_strategy,
+                              TransportProfile transport_profile);
+
+        /**
+         * \brief Construct a new TriangularRouteMatrix object without any fallback strategy configured. If this constructor was used to create matrix,
+         * any call for not indexed locations will fail with exception
+         *
+         * \param size Count of locations to generate matrix for
+         * \param calculate_route Function to calculate route between i-th and j-th location. Is only called for i <= j
+         */
+        TriangularRouteMatrix(std::size_t size,
+                              RouteInfoSupplier calculate_route);
+
+        virtual RouteInfo get_route_info(GeopointId origin, GeopointId destination) const override;
+        virtual RouteInfo::Meters get_distance_meters(GeopointId origin, GeopointId destination) const override;
+        virtual RouteInfo::Seconds get_travel_time_seconds(GeopointId origin, GeopointId destination) const override;
+        virtual Route calculate_route(const GeoPoint &origin, const GeoPoint &destination) const override;
+        virtual RouteInfo calculate_route_info(const GeoPoint &origin, const GeoPoint &destination) const override;
+        virtual RouteInfo::Meters calculate_distance_meters(const GeoPoint &origin, const GeoPoint &destination) const override;
+        virtual RouteInfo::Seconds calculate_travel_time_seconds(const GeoPoint &origin, const GeoPoint &destination) const override;
+        virtual void sync() const override;
+
+    private:
+        void validate_geopoint_id(GeopointId origin, GeopointId destination) const;
+        void ensure_strategy_present() const;
+        RouteInfo retrieve_route_info(GeopointId origin, GeopointId destination) const;
+
+        std::size_t size;
+        TransportProfile transport_profile;
+        std::shared_ptr<RoutingStrategy> fallback_strategy;
+        std::vector<RouteInfo> data;
+    };
+}
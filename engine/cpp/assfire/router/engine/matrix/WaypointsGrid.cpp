@@ -0,0 +1,144 @@
+#include "WaypointsGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace assfire::router
+{
+    namespace
+    {
+        constexpr double RADIANS_PER_UNIT = std::numbers::pi / 180 / 1e6;
+        constexpr std::int64_t HALF_TURN_UNITS = 180000000;
+        constexpr RouteInfo::Meters ROUNDING_SLACK_METERS = 1.0; // Covers rounding errors of crowflight formulas at short distances
+    }
+
+    WaypointsGrid::WaypointsGrid(std::span<const GeoPoint> waypoints, double waypoints_per_cell)
+    {
+        if (waypoints.empty())
+        {
+            return;
+        }
+
+        GeoPoint::FixedPointCoordinate max_lat = waypoints.front().lat();
+        GeoPoint::FixedPointCoordinate max_lon = waypoints.front().lon();
+        min_lat = max_lat;
+        min_lon = max_lon;
+        for (const GeoPoint &point : waypoints)
+        {
+            min_lat = std::min(min_lat, point.lat());
+            max_lat = std::max(max_lat, point.lat());
+            min_lon = std::min(min_lon, point.lon());
+            max_lon = std::max(max_lon, point.lon());
+        }
+        std::int64_t lat_span = std::int64_t(max_lat) - min_lat + 1;
+        std::int64_t lon_span = std::int64_t(max_lon) - min_lon + 1;
+        bounded = lon_span <= HALF_TURN_UNITS;
+        max_lon_cos = std::cos(std::max(std::abs(double(min_lat)), std::abs(double(max_lat))) * RADIANS_PER_UNIT);
+
+        // Cells are kept square, but not thinner than the longer span divided by cells count, so strip-like sets don't get too many empty cells
+        double cells_count = std::max(1.0, waypoints.size() / waypoints_per_cell);
+        cell_size = std::max<std::int64_t>({std::int64_t(std::ceil(std::sqrt(double(lat_span) * double(lon_span) / cells_count))),
+                                            std::int64_t(std::ceil(std::max(lat_span, lon_span) / cells_count)),
+                                            1});
+        rows_count = (lat_span - 1) / cell_size + 1;
+        columns_count = (lon_span - 1) / cell_size + 1;
+
+        cell_offsets.assign(rows_count * columns_count + 1, 0);
+        for (const GeoPoint &point : waypoints)
+        {
+            ++cell_offsets[get_row(point) * columns_count + get_column(point) + 1];
+        }
+        for (std::size_t i = 1; i < cell_offsets.size(); ++i)
+        {
+            cell_offsets[i] += cell_offsets[i - 1];
+        }
+        ids.resize(waypoints.size());
+        std::vector<std::uint32_t> positions(cell_offsets.begin(), cell_offsets.end() - 1);
+        for (WaypointId id = 0; id < waypoints.size(); ++id)
+        {
+            ids[positions[get_row(waypoints[id]) * columns_count + get_column(waypoints[id])]++] = id;
+        }
+    }
+
+    std::size_t WaypointsGrid::get_rings_count(const GeoPoint &point) const
+    {
+        if (ids.empty())
+        {
+            return 0;
+        }
+        std::int64_t row = get_row(point);
+        std::int64_t column = get_column(point);
+        return std::max({row, rows_count - 1 - row, column, columns_count - 1 - column}) + 1;
+    }
+
+    void WaypointsGrid::collect_ring(const GeoPoint &point, std::size_t ring, std::vector<WaypointId> &result) const
+    {
+        if (ids.empty())
+        {
+            return;
+        }
+        std::int64_t center_row = get_row(point);
+        std::int64_t center_column = get_column(point);
+        std::int64_t r = ring;
+        auto collect_cell = [&](std::int64_t row, std::int64_t column)
+        {
+            if (row >= 0 && row < rows_count && column >= 0 && column < columns_count)
+            {
+                std::size_t cell = row * columns_count + column;
+                result.insert(result.end(), ids.begin() + cell_offsets[cell], ids.begin() + cell_offsets[cell + 1]);
+            }
+        };
+
+        if (r == 0)
+        {
+            collect_cell(center_row, center_column);
+            return;
+        }
+        for (std::int64_t column = std::max<std::int64_t>(center_column - r, 0); column <= std::min(center_column + r, columns_count - 1); ++column)
+        {
+            collect_cell(center_row - r, column);
+            collect_cell(center_row + r, column);
+        }
+        for (std::int64_t row = std::max(center_row - r + 1, std::int64_t(0)); row <= std::min(center_row + r - 1, rows_count - 1); ++row)
+        {
+            collect_cell(row, center_column - r);
+            collect_cell(row, center_column + r);
+        }
+    }
+
+    RouteInfo::Meters WaypointsGrid::get_ring_lower_bound_meters(const GeoPoint &point, std::size_t ring) const
+    {
+        // Points outside the grid are in border cells, they are only farther from the other cells than the cells are
+        std::int64_t max_lon = std::int64_t(min_lon) + columns_count * cell_size;
+        if (ring <= 1 || !bounded || point.lon() < max_lon - HALF_TURN_UNITS || point.lon() > min_lon + HALF_TURN_UNITS)
+        {
+            return 0;
+        }
+        // Waypoints in ring r are more than r - 1 cells away along latitude or longitude, shorter longitude bound (haversine with
+        // the smallest cosine of latitude) bounds both
+        double lon_cos = std::min(max_lon_cos, std::cos(std::abs(point.lat_double()) * std::numbers::pi / 180));
+        double half_angle = std::min(double(ring - 1) * cell_size * RADIANS_PER_UNIT, std::numbers::pi) / 2;
+        double distance = 2 * LOWER_BOUND_EARTH_RADIUS * std::asin(std::min(1.0, lon_cos * std::sin(half_angle)));
+        return std::max(distance - ROUNDING_SLACK_METERS, 0.0);
+    }
+
+    RouteInfo::Meters WaypointsGrid::get_lower_bound_meters(const GeoPoint &origin, const GeoPoint &destination)
+    {
+        double lat_sin = std::sin((destination.lat() - double(origin.lat())) * RADIANS_PER_UNIT / 2);
+        double lon_sin = std::sin((destination.lon() - double(origin.lon())) * RADIANS_PER_UNIT / 2);
+        double h = lat_sin * lat_sin + std::cos(origin.lat() * RADIANS_PER_UNIT) * std::cos(destination.lat() * RADIANS_PER_UNIT) * lon_sin * lon_sin;
+        double distance = 2 * LOWER_BOUND_EARTH_RADIUS * std::asin(std::min(1.0, std::sqrt(h)));
+        return std::max(distance - ROUNDING_SLACK_METERS, 0.0);
+    }
+
+    std::int64_t WaypointsGrid::get_row(const GeoPoint &point) const
+    {
+        return std::clamp<std::int64_t>((std::int64_t(point.lat()) - min_lat) / cell_size, 0, rows_count - 1);
+    }
+
+    std::int64_t WaypointsGrid::get_column(const GeoPoint &point) const
+    {
+        return std::clamp<std::int64_t>((std::int64_t(point.lon()) - min_lon) / cell_size, 0, columns_count - 1);
+    }
+}
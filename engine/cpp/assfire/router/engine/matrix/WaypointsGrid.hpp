@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "assfire/router/api/GeoPoint.hpp"
+#include "assfire/router/api/RouteInfo.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief Uniform grid over waypoints for enumerating them in order of growing lower bound of crowflight distance from a point.
+     *
+     * \details Waypoints are bucketed into square cells of the same size in degrees. Cells of ring r around a point are cells that are r cells away
+     * from cell of the point along latitude or longitude, so all waypoints in rings from r onwards are at least get_ring_lower_bound_meters(point, r) away.
+     * Points outside the grid are treated as points of the nearest border cells.
+     * Bounds are computed by haversine formula over the smallest Earth radius, so they never exceed crowflight or road distance between the same points.
+     * Grids spanning more than 180 degrees of longitude don't handle antimeridian and bound rings by zero
+     */
+    class WaypointsGrid
+    {
+    public:
+        using WaypointId = std::uint32_t;
+
+        /**
+         * \brief Radius used for lower bounds. It is slightly less than the polar radius, so spherical distances over it don't exceed ellipsoidal ones
+         */
+        static constexpr double LOWER_BOUND_EARTH_RADIUS = 6356000.0;
+
+        /**
+         * \brief Construct a new WaypointsGrid object with about waypoints_per_cell waypoints in an average non-empty cell
+         */
+        explicit WaypointsGrid(std::span<const GeoPoint> waypoints, double waypoints_per_cell = 2.0);
+
+        /**
+         * \brief Count of rings around point that cover the whole grid
+         */
+        std::size_t get_rings_count(const GeoPoint &point) const;
+
+        /**
+         * \brief Appends ids of waypoints in ring around point
+         */
+        void collect_ring(const GeoPoint &point, std::size_t ring, std::vector<WaypointId> &ids) const;
+
+        /**
+         * \brief Lower bound of crowflight distance from point to waypoints in rings around it from ring onwards
+         */
+        RouteInfo::Meters get_ring_lower_bound_meters(const GeoPoint &point, std::size_t ring) const;
+
+        /**
+         * \brief Lower bound of crowflight distance between points
+         */
+        static RouteInfo::Meters get_lower_bound_meters(const GeoPoint &origin, const GeoPoint &destination);
+
+    private:
+        std::int64_t get_row(const GeoPoint &point) const;
+        std::int64_t get_column(const GeoPoint &point) const;
+
+        GeoPoint::FixedPointCoordinate min_lat = 0;
+        GeoPoint::FixedPointCoordinate min_lon = 0;
+        std::int64_t cell_size = 1; // In fixed point coordinate units
+        std::int64_t rows_count = 0;
+        std::int64_t columns_count = 0;
+        double max_lon_cos = 1;     // Cosine of latitude closest to a pole, meridians converge there most
+        bool bounded = true;
+        std::vector<std::uint32_t> cell_offsets; // Ids of waypoints of cell i are ids[cell_offsets[i]] ... ids[cell_offsets[i + 1] - 1]
+        std::vector<WaypointId> ids;
+    };
+}
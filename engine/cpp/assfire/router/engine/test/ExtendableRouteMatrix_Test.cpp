@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <stdexcept>
+#include "assfire/router/engine/matrix/ExtendableRouteMatrix.hpp"
+#include "assfire/router/engine/algorithms/BasicRoutingStrategy.hpp"
+
+using namespace assfire::router;
+
+namespace
+{
+    class CountingRoutingStrategy : public BasicRoutingStrategy
+    {
+    public:
+        virtual Route calculate_route(const GeoPoint &origin, const GeoPoint &destination, const TransportProfile &profile) const override
+        {
+            return Route(calculate_route_info(origin, destination, profile));
+        }
+
+        virtual RouteInfo calculate_route_info(const GeoPoint &origin, const GeoPoint &destination, const TransportProfile &) const override
+        {
+            if (failing)
+            {
+                throw std::runtime_error("Routing failed");
+            }
+            ++calls_count;
+            return RouteInfo(origin.lat() * 1000 + destination.lat(), origin.lat() * 1000 + destination.lat());
+        }
+
+        virtual std::shared_ptr<RoutingStrategy> clone() const override
+        {
+            return std::make_shared<CountingRoutingStrategy>();
+        }
+
+        mutable int calls_count = 0;
+        bool failing = false;
+    };
+
+    std::vector<GeoPoint> make_waypoints(int from, int to)
+    {
+        std::vector<GeoPoint> result;
+        for (int i = from; i < to; ++i)
+        {
+            result.emplace_back(i, 0);
+        }
+        return result;
+    }
+
+    void expect_consistent(const ExtendableRouteMatrix &matrix)
+    {
+        for (RouteMatrix::GeopointId origin : matrix.get_waypoint_ids())
+        {
+            for (RouteMatrix::GeopointId destination : matrix.get_waypoint_ids())
+            {
+                RouteInfo::Seconds expected = matrix.get_waypoint(origin).lat() * 1000 + matrix.get_waypoint(destination).lat();
+                EXPECT_EQ(matrix.get_travel_time_seconds(origin, destination), expected);
+            }
+        }
+    }
+}
+
+TEST(ExtendableRouteMatrixTest, CalculatesOnlyNewRowsAndColumns)
+{
+    std::shared_ptr<CountingRoutingStrategy> strategy = std::make_shared<CountingRoutingStrategy>();
+    ExtendableRouteMatrix matrix(strategy, TransportProfile(10));
+
+    ExtendableRouteMatrix::GeopointIds initial_ids = matrix.extend(make_waypoints(1, 11));
+    EXPECT_EQ(initial_ids.size(), 10);
+    EXPECT_EQ(strategy->calls_count, 100);
+
+    ExtendableRouteMatrix::GeopointIds new_ids = matrix.extend(make_waypoints(11, 12));
+    ASSERT_EQ(new_ids.size(), 1);
+    EXPECT_EQ(new_ids[0], 10);
+    EXPECT_EQ(strategy->calls_count, 100 + 2 * 10 + 1);
+
+    EXPECT_EQ(matrix.size(), 11);
+    expect_consistent(matrix);
+}
+
+TEST(ExtendableRouteMatrixTest, RemovedIdsAreInvalidAndSlotsAreReused)
+{
+    std::shared_ptr<CountingRoutingStrategy> strategy = std::make_shared<CountingRoutingStrategy>();
+    ExtendableRouteMatrix matrix(strategy, TransportProfile(10), 1.0);
+
+    matrix.extend(make_waypoints(1, 6));
+    matrix.remove({1, 3});
+
+    EXPECT_EQ(matrix.size(), 3);
+    EXPECT_FALSE(matrix.contains(1));
+    EXPECT_THROW(matrix.get_route_info(1, 0), std::invalid_argument);
+    EXPECT_THROW(matrix.remove({42}), std::invalid_argument);
+
+    ExtendableRouteMatrix::GeopointIds new_ids = matrix.extend(make_waypoints(6, 9));
+    EXPECT_EQ(new_ids, ExtendableRouteMatrix::GeopointIds({5, 6, 7}));
+    EXPECT_EQ(matrix.size(), 6);
+    expect_consistent(matrix);
+}
+
+TEST(ExtendableRouteMatrixTest, CompactionKeepsIds)
+{
+    std::shared_ptr<CountingRoutingStrategy> strategy = std::make_shared<CountingRoutingStrategy>();
+    ExtendableRouteMatrix matrix(strategy, TransportProfile(10), 0.25);
+
+    matrix.extend(make_waypoints(1, 41));
+    matrix.remove({0, 5, 10, 15, 20, 25, 30, 35, 36, 37, 38});
+
+    EXPECT_EQ(matrix.size(), 29);
+    EXPECT_EQ(matrix.get_waypoint(39).lat(), 40);
+    expect_consistent(matrix);
+
+    matrix.extend(make_waypoints(100, 140));
+    EXPECT_EQ(matrix.size(), 69);
+    expect_consistent(matrix);
+}
+
+TEST(ExtendableRouteMatrixTest, FailedExtensionKeepsMatrixIntact)
+{
+    std::shared_ptr<CountingRoutingStrategy> strategy = std::make_shared<CountingRoutingStrategy>();
+    ExtendableRouteMatrix matrix(strategy, TransportProfile(10), 1.0);
+
+    matrix.extend(make_waypoints(1, 6));
+    matrix.remove({1, 3});
+    ExtendableRouteMatrix::GeopointIds ids = matrix.get_waypoint_ids();
+
+    strategy->failing = true;
+    EXPECT_THROW(matrix.extend(make_waypoints(6, 9)), std::runtime_error);
+    EXPECT_EQ(matrix.get_waypoint_ids(), ids);
+    EXPECT_EQ(matrix.size(), 3);
+    expect_consistent(matrix);
+
+    strategy->failing = false;
+    EXPECT_EQ(matrix.extend(make_waypoints(6, 9)), ExtendableRouteMatrix::GeopointIds({5, 6, 7})) << "Failed extension assigns no ids";
+    EXPECT_EQ(matrix.size(), 6);
+    expect_consistent(matrix);
+}
@@ -0,0 +1,830 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include "assfire/router/engine/algorithms/GraphRoutingStrategy.hpp"
+#include "assfire/router/engine/algorithms/InfinityRoutingStrategy.hpp"
+#include "assfire/router/engine/algorithms/WaypointsSimplification.hpp"
+#include "assfire/router/engine/graph/HubLabels.hpp"
+#include "assfire/router/engine/graph/RoadGraphBuilder.hpp"
+#include "assfire/router/engine/graph/ShortcutGeometryCache.hpp"
+#include "assfire/router/engine/graph/TrafficWeights.hpp"
+
+using namespace assfire::router;
+
+namespace
+{
+    const int GRID_SIZE = 4;
+
+    GeoPoint grid_location(int row, int column)
+    {
+        return GeoPoint(row * 1000, column * 1000);
+    }
+
+    /**
+     * Builds GRID_SIZE x GRID_SIZE grid with two-way roads of 100 meters and 10 seconds ("car") or 20 seconds ("truck")
+     * and one isolated node outside the grid that can only be left by a one-way road
+     */
+    std::string build_test_graph()
+    {
+        RoadGraphBuilder builder({"car", "truck"});
+        for (int row = 0; row < GRID_SIZE; ++row)
+        {
+            for (int column = 0; column < GRID_SIZE; ++column)
+            {
+                builder.add_node(grid_location(row, column));
+            }
+        }
+
+        std::vector<double> times = {10, 20};
+        for (int row = 0; row < GRID_SIZE; ++row)
+        {
+            for (int column = 0; column < GRID_SIZE; ++column)
+            {
+                RoadGraph::NodeId node = row * GRID_SIZE + column;
+                if (column + 1 < GRID_SIZE)
+                {
+                    builder.add_edge(node, node + 1, 100, times);
+                    builder.add_edge(node + 1, node, 100, times);
+                }
+                if (row + 1 < GRID_SIZE)
+                {
+                    builder.add_edge(node, node + GRID_SIZE, 100, times);
+                    builder.add_edge(node + GRID_SIZE, node, 100, times);
+                }
+            }
+        }
+
+        RoadGraph::NodeId isolated = builder.add_node(grid_location(-5, 2));
+        builder.add_edge(isolated, 0, 100, times);
+
+        std::string path = testing::TempDir() + "graph_routing_strategy_test.graph";
+        builder.write(path);
+        return path;
+    }
+
+    class GraphRoutingStrategyTest : public testing::Test
+    {
+    protected:
+        static void SetUpTestSuite()
+        {
+            graph = std::make_shared<RoadGraph>(build_test_graph());
+        }
+
+        static void TearDownTestSuite()
+        {
+            std::remove(graph->path().c_str());
+            graph.reset();
+        }
+
+        static std::shared_ptr<RoadGraph> graph;
+    };
+
+    std::shared_ptr<RoadGraph> GraphRoutingStrategyTest::graph;
+
+    const TransportProfile::Timestamp MONDAY = 1704067200; // 2024-01-01 00:00 UTC
+    const TransportProfile::Timestamp HOUR = 60 * 60;
+
+    /**
+     * Builds road (0, 0) - (0, 1) - (0, 2) of 10 second edges and detour (0, 0) - (2, 1) - (0, 2) of 30 second edges. On weekdays' mornings
+     * "car" travel time of edge (0, 1) -> (0, 2) rises from 10 seconds at 7:00 to 60 seconds at 8:00 and drops back by 9:00, "truck" has no traffic
+     */
+    std::string build_traffic_graph()
+    {
+        RoadGraphBuilder builder({"car", "truck"});
+        RoadGraph::NodeId start = builder.add_node(grid_location(0, 0));
+        RoadGraph::NodeId middle = builder.add_node(grid_location(0, 1));
+        RoadGraph::NodeId end = builder.add_node(grid_location(0, 2));
+        RoadGraph::NodeId detour = builder.add_node(grid_location(2, 1));
+
+        std::vector<double> times = {10, 10};
+        std::vector<double> detour_times = {30, 30};
+        builder.add_edge(start, middle, 100, times);
+        std::size_t congested_edge = builder.add_edge(middle, end, 100, times);
+        builder.add_edge(start, detour, 300, detour_times);
+        builder.add_edge(detour, end, 300, detour_times);
+
+        std::vector<std::uint32_t> rush_times;
+        std::vector<double> rush_travel_times;
+        for (int day = 0; day < 5; ++day)
+        {
+            for (auto [hour, travel_time] : {std::pair{7, 10.0}, std::pair{8, 60.0}, std::pair{9, 10.0}})
+            {
+                rush_times.push_back(day * 24 * HOUR + hour * HOUR);
+                rush_travel_times.push_back(travel_time);
+            }
+        }
+        builder.set_edge_traffic(congested_edge, "car", rush_times, rush_travel_times);
+
+        std::string path = testing::TempDir() + "traffic_test.graph";
+        builder.write(path);
+        return path;
+    }
+
+    TransportProfile departing_at(TransportProfile::Timestamp departure_time)
+    {
+        TransportProfile profile;
+        profile.set_departure_time(departure_time);
+        return profile;
+    }
+
+    /**
+     * Builds GRID_SIZE x GRID_SIZE grid of test graph without isolated node. Going straight through (0, 1) eastwards costs extra 100 seconds
+     * for "car" and nothing for "truck", going straight through (2, 1) eastwards is forbidden
+     */
+    std::string build_turns_graph()
+    {
+        RoadGraphBuilder builder({"car", "truck"});
+        for (int row = 0; row < GRID_SIZE; ++row)
+        {
+            for (int column = 0; column < GRID_SIZE; ++column)
+            {
+                builder.add_node(grid_location(row, column));
+            }
+        }
+
+        std::map<std::pair<RoadGraph::NodeId, RoadGraph::NodeId>, std::size_t> edge_by_nodes;
+        std::vector<double> times = {10, 20};
+        auto add_road = [&](RoadGraph::NodeId from, RoadGraph::NodeId to)
+        {
+            edge_by_nodes[{from, to}] = builder.add_edge(from, to, 100, times);
+            edge_by_nodes[{to, from}] = builder.add_edge(to, from, 100, times);
+        };
+        for (int row = 0; row < GRID_SIZE; ++row)
+        {
+            for (int column = 0; column < GRID_SIZE; ++column)
+            {
+                RoadGraph::NodeId node = row * GRID_SIZE + column;
+                if (column + 1 < GRID_SIZE)
+                {
+                    add_road(node, node + 1);
+                }
+                if (row + 1 < GRID_SIZE)
+                {
+                    add_road(node, node + GRID_SIZE);
+                }
+            }
+        }
+
+        std::vector<double> straight_costs = {100, 0};
+        builder.add_turn_cost(edge_by_nodes.at({0, 1}), edge_by_nodes.at({1, 2}), straight_costs);
+        builder.add_turn_restriction(edge_by_nodes.at({2 * GRID_SIZE, 2 * GRID_SIZE + 1}), edge_by_nodes.at({2 * GRID_SIZE + 1, 2 * GRID_SIZE + 2}));
+        EXPECT_THROW(builder.add_turn_restriction(edge_by_nodes.at({0, 1}), edge_by_nodes.at({2, 3})), std::invalid_argument);
+
+        std::string path = testing::TempDir() + "turns_test.graph";
+        builder.write(path);
+        return path;
+    }
+}
+
+TEST_F(GraphRoutingStrategyTest, OpensGraphFile)
+{
+    EXPECT_EQ(graph->nodes_count(), GRID_SIZE * GRID_SIZE + 1);
+    EXPECT_EQ(graph->edges_count(), 4 * GRID_SIZE * (GRID_SIZE - 1) + 1);
+    EXPECT_EQ(graph->get_metrics(), std::vector<std::string>({"car", "truck"}));
+    EXPECT_EQ(graph->get_node_location(GRID_SIZE + 2), grid_location(1, 2));
+    EXPECT_THROW(graph->get_weights("bicycle"), std::invalid_argument);
+}
+
+TEST_F(GraphRoutingStrategyTest, CalculatesShortestRoutes)
+{
+    GraphRoutingStrategy strategy(graph, "car");
+
+    Route route = strategy.calculate_route(grid_location(0, 0), grid_location(2, 3), TransportProfile());
+    EXPECT_DOUBLE_EQ(route.distance_meters(), 500);
+    EXPECT_EQ(route.travel_time_seconds(), 50);
+    ASSERT_GE(route.waypoints().size(), 8); // Origin, its snap, at least 4 graph nodes, destination snap and destination
+    EXPECT_EQ(route.waypoints().front(), grid_location(0, 0));
+    EXPECT_EQ(route.waypoints().back(), grid_location(2, 3));
+
+    EXPECT_EQ(GraphRoutingStrategy(graph, "truck").calculate_travel_time_seconds(grid_location(0, 0), grid_location(2, 3), TransportProfile()), 100);
+}
+
+TEST_F(GraphRoutingStrategyTest, SimplifiesRouteGeometry)
+{
+    std::shared_ptr<const EdgeSpatialIndex> index = std::make_shared<EdgeSpatialIndex>(graph);
+    std::shared_ptr<CchMetricCache> hierarchy = std::make_shared<CchMetricCache>(std::make_shared<CchTopology>(graph));
+    GraphRoutingStrategy hierarchy_strategy(graph, index, "car", GraphRoutingStrategy::DEFAULT_MAX_SNAPPING_DISTANCE_METERS, hierarchy);
+    GraphRoutingStrategy dijkstra_strategy(graph, index, "car", GraphRoutingStrategy::DEFAULT_MAX_SNAPPING_DISTANCE_METERS, nullptr);
+
+    Route full = hierarchy_strategy.calculate_route(grid_location(0, 0), grid_location(3, 3), TransportProfile());
+    EXPECT_EQ(hierarchy_strategy.calculate_route(grid_location(0, 0), grid_location(3, 3), TransportProfile()), full); // Unpacked from cache
+    EXPECT_EQ(dijkstra_strategy.calculate_route(grid_location(0, 0), grid_location(3, 3), TransportProfile()).summary(), full.summary());
+
+    TransportProfile preview;
+    preview.set_geometry_tolerance_meters(1000); // Whole route is within a kilometer from its chord
+    Route simplified = hierarchy_strategy.calculate_route(grid_location(0, 0), grid_location(3, 3), preview);
+    EXPECT_EQ(simplified.summary(), full.summary());
+    EXPECT_EQ(simplified.waypoints(), Route::Waypoints({grid_location(0, 0), grid_location(3, 3)}));
+
+    preview.set_geometry_tolerance_meters(1);
+    simplified = hierarchy_strategy.calculate_route(grid_location(0, 0), grid_location(3, 3), preview);
+    EXPECT_LT(simplified.waypoints().size(), full.waypoints().size()); // Duplicate snap points and straight road nodes are dropped
+    EXPECT_GE(simplified.waypoints().size(), 3);                       // Turns are kept
+}
+
+TEST(WaypointsSimplificationTest, KeepsPointsBeyondTolerance)
+{
+    std::vector<GeoPoint> line = {GeoPoint(0, 0), GeoPoint(0, 1000), GeoPoint(10, 2000), GeoPoint(0, 3000)};
+    EXPECT_EQ(simplify_waypoints(line, 10), Route::Waypoints({GeoPoint(0, 0), GeoPoint(0, 3000)})); // Bump of 10 micro-degrees is about a meter
+    EXPECT_EQ(simplify_waypoints(line, 0.5), Route::Waypoints({GeoPoint(0, 0), GeoPoint(0, 1000), GeoPoint(10, 2000), GeoPoint(0, 3000)}));
+    EXPECT_EQ(simplify_waypoints(line, 0), Route::Waypoints(line.begin(), line.end()));
+
+    std::vector<GeoPoint> corner = {GeoPoint(0, 0), GeoPoint(0, 500), GeoPoint(0, 1000), GeoPoint(500, 1000), GeoPoint(1000, 1000)};
+    EXPECT_EQ(simplify_waypoints(corner, 1), Route::Waypoints({GeoPoint(0, 0), GeoPoint(0, 1000), GeoPoint(1000, 1000)}));
+}
+
+TEST(ShortcutGeometryCacheTest, EvictsLeastRecentlyUsedShortcuts)
+{
+    // Capacity is split between shards, arcs with the same remainder share a shard
+    ShortcutGeometryCache cache(16 * 40);
+    auto nodes = [](std::size_t count)
+    {
+        return std::make_shared<const std::vector<RoadGraph::NodeId>>(count, 1);
+    };
+    cache.put(0, true, nodes(20));
+    cache.put(16, true, nodes(20));
+    ASSERT_NE(cache.get(0, true), nullptr);
+    EXPECT_EQ(cache.get(0, false), nullptr);
+    cache.put(32, true, nodes(20));
+    EXPECT_NE(cache.get(0, true), nullptr);
+    EXPECT_EQ(cache.get(16, true), nullptr);
+    EXPECT_NE(cache.get(32, true), nullptr);
+    EXPECT_NE(cache.get(0, true), nullptr) << "Other shards are not affected";
+    cache.put(1, true, nodes(41));
+    EXPECT_EQ(cache.get(1, true), nullptr);
+}
+
+TEST_F(GraphRoutingStrategyTest, RoutesFromAndToMiddleOfRoad)
+{
+    GraphRoutingStrategy strategy(graph, "car");
+
+    // 100 units north of the middle of the road between (0, 0) and (0, 1)
+    RouteInfo from_road_middle = strategy.calculate_route_info(GeoPoint(100, 500), grid_location(0, 1), TransportProfile());
+    EXPECT_NEAR(from_road_middle.distance_meters(), 50 + 11.1, 0.1);
+    EXPECT_EQ(from_road_middle.travel_time_seconds(), 5);
+
+    RouteInfo along_same_road = strategy.calculate_route_info(GeoPoint(0, 200), GeoPoint(0, 800), TransportProfile());
+    EXPECT_NEAR(along_same_road.distance_meters(), 60, 0.1);
+    EXPECT_EQ(along_same_road.travel_time_seconds(), 6);
+}
+
+TEST_F(GraphRoutingStrategyTest, FallsBackToCrowflightFarFromRoads)
+{
+    GraphRoutingStrategy strategy(graph, "car");
+    GeoPoint far_away = grid_location(100, 100);
+
+    EXPECT_EQ(strategy.calculate_route_info(grid_location(0, 0), far_away, TransportProfile(10)),
+              CrowflightRoutingStrategy().calculate_route_info(grid_location(0, 0), far_away, TransportProfile(10)));
+}
+
+TEST_F(GraphRoutingStrategyTest, LimitsTravelTimeWithProfileSpeed)
+{
+    GraphRoutingStrategy strategy(graph, "car");
+
+    EXPECT_EQ(strategy.calculate_travel_time_seconds(grid_location(0, 0), grid_location(0, 1), TransportProfile(20)), 10);
+    EXPECT_EQ(strategy.calculate_travel_time_seconds(grid_location(0, 0), grid_location(0, 1), TransportProfile(5)), 20);
+}
+
+TEST_F(GraphRoutingStrategyTest, RespectsOneWayRoads)
+{
+    GraphRoutingStrategy strategy(graph, "car");
+    GeoPoint isolated = grid_location(-5, 2);
+
+    EXPECT_EQ(strategy.calculate_travel_time_seconds(isolated, grid_location(0, 1), TransportProfile()), 20);
+    EXPECT_EQ(strategy.calculate_travel_time_seconds(grid_location(0, 1), isolated, TransportProfile()), RouteInfo::INFINITE_TRAVEL_TIME);
+}
+
+TEST_F(GraphRoutingStrategyTest, MatrixMatchesSingleRoutes)
+{
+    GraphRoutingStrategy strategy(graph, "car");
+    std::vector<GeoPoint> waypoints;
+    for (RoadGraph::NodeId node = 0; node < graph->nodes_count(); ++node)
+    {
+        waypoints.push_back(graph->get_node_location(node));
+    }
+
+    RoutingStrategy::MatrixPtr matrix = strategy.calculate_route_matrix(waypoints, TransportProfile());
+    for (std::size_t i = 0; i < waypoints.size(); ++i)
+    {
+        for (std::size_t j = 0; j < waypoints.size(); ++j)
+        {
+            EXPECT_EQ(matrix->get_route_info(i, j), strategy.calculate_route_info(waypoints[i], waypoints[j], TransportProfile()));
+        }
+    }
+}
+
+TEST_F(GraphRoutingStrategyTest, RoutesVectorLegsArriveInOrder)
+{
+    GraphRoutingStrategy strategy(graph, "car");
+    std::vector<GeoPoint> tour;
+    for (int i = 0; i < 200; ++i)
+    {
+        tour.push_back(graph->get_node_location((i * 7) % (GRID_SIZE * GRID_SIZE)));
+    }
+
+    std::vector<Route> routes = strategy.calculate_routes_vector(tour, TransportProfile());
+    std::vector<RouteInfo> route_infos = strategy.calculate_route_infos_vector(tour, TransportProfile());
+    ASSERT_EQ(routes.size(), tour.size() - 1);
+    ASSERT_EQ(route_infos.size(), tour.size() - 1);
+    for (std::size_t i = 0; i + 1 < tour.size(); ++i)
+    {
+        EXPECT_EQ(routes[i], strategy.calculate_route(tour[i], tour[i + 1], TransportProfile()));
+        EXPECT_EQ(route_infos[i], routes[i].summary());
+    }
+    RouteInfo total;
+    for (const RouteInfo &route_info : route_infos)
+    {
+        total += route_info;
+    }
+    EXPECT_EQ(strategy.calculate_routes_vector_total(tour, TransportProfile()), total);
+    EXPECT_EQ(strategy.calculate_routes_vector_total(std::span(tour).first(1), TransportProfile()), RouteInfo(0, 0));
+    EXPECT_EQ(InfinityRoutingStrategy().calculate_routes_vector_total(tour, TransportProfile()),
+              RouteInfo(RouteInfo::INFINITE_DISTANCE, RouteInfo::INFINITE_TRAVEL_TIME));
+
+    std::size_t consumed = 0;
+    EXPECT_THROW(strategy.calculate_routes_vector(
+                     tour, [&](Route)
+                     {
+                         if (++consumed == 10)
+                         {
+                             throw std::runtime_error("Consumer failed");
+                         }
+                     },
+                     TransportProfile()),
+                 std::runtime_error);
+    EXPECT_EQ(consumed, 10);
+    EXPECT_TRUE(strategy.calculate_routes_vector(std::vector<GeoPoint>(), TransportProfile()).empty());
+}
+
+TEST_F(GraphRoutingStrategyTest, HierarchyMatchesDijkstra)
+{
+    std::shared_ptr<const EdgeSpatialIndex> index = std::make_shared<EdgeSpatialIndex>(graph);
+    std::shared_ptr<CchMetricCache> hierarchy = std::make_shared<CchMetricCache>(std::make_shared<CchTopology>(graph));
+    GraphRoutingStrategy hierarchy_strategy(graph, index, "car", GraphRoutingStrategy::DEFAULT_MAX_SNAPPING_DISTANCE_METERS, hierarchy);
+    GraphRoutingStrategy dijkstra_strategy(graph, index, "car", GraphRoutingStrategy::DEFAULT_MAX_SNAPPING_DISTANCE_METERS, nullptr);
+
+    std::vector<GeoPoint> waypoints;
+    for (int i = 0; i < 40; ++i)
+    {
+        waypoints.push_back(GeoPoint((i * 379) % 3400 - 200, (i * 917) % 3400 - 200));
+    }
+    waypoints.push_back(grid_location(-5, 2));
+
+    for (const TransportProfile &profile : {TransportProfile(), TransportProfile(5), TransportProfile(0, "truck")})
+    {
+        RoutingStrategy::MatrixPtr matrix = hierarchy_strategy.calculate_route_matrix(waypoints, profile);
+        for (std::size_t i = 0; i < waypoints.size(); ++i)
+        {
+            for (std::size_t j = 0; j < waypoints.size(); ++j)
+            {
+                RouteInfo expected = dijkstra_strategy.calculate_route_info(waypoints[i], waypoints[j], profile);
+                EXPECT_EQ(hierarchy_strategy.calculate_route_info(waypoints[i], waypoints[j], profile), expected);
+                EXPECT_EQ(matrix->get_route_info(i, j), expected);
+
+                Route route = hierarchy_strategy.calculate_route(waypoints[i], waypoints[j], profile);
+                EXPECT_EQ(route.waypoints().size() > 0, expected.travel_time_seconds() != RouteInfo::INFINITE_TRAVEL_TIME);
+            }
+        }
+    }
+}
+
+TEST_F(GraphRoutingStrategyTest, WideMatrixSweepMatchesDijkstra)
+{
+    std::shared_ptr<const EdgeSpatialIndex> index = std::make_shared<EdgeSpatialIndex>(graph);
+    std::shared_ptr<CchMetricCache> hierarchy = std::make_shared<CchMetricCache>(std::make_shared<CchTopology>(graph));
+    GraphRoutingStrategy hierarchy_strategy(graph, index, "car", GraphRoutingStrategy::DEFAULT_MAX_SNAPPING_DISTANCE_METERS, hierarchy);
+    GraphRoutingStrategy dijkstra_strategy(graph, index, "car", GraphRoutingStrategy::DEFAULT_MAX_SNAPPING_DISTANCE_METERS, nullptr);
+
+    std::vector<GeoPoint> origins;
+    for (int i = 0; i < 19; ++i) // Not a multiple of sweep lanes count
+    {
+        origins.push_back(GeoPoint((i * 379) % 3400 - 200, (i * 917) % 3400 - 200));
+    }
+    origins.push_back(grid_location(-5, 2));
+    std::vector<GeoPoint> destinations;
+    for (int i = 0; i < int(CchMetric::ONE_TO_MANY_TARGETS_THRESHOLD) + 10; ++i)
+    {
+        destinations.push_back(GeoPoint((i * 571) % 3400 - 200, (i * 313) % 3400 - 200));
+    }
+    destinations.push_back(grid_location(-5, 2));
+
+    for (const TransportProfile &profile : {TransportProfile(), TransportProfile(5)})
+    {
+        RoutingStrategy::MatrixPtr matrix = hierarchy_strategy.calculate_route_matrix(origins, destinations, profile);
+        for (std::size_t i = 0; i < origins.size(); ++i)
+        {
+            for (std::size_t j = 0; j < destinations.size(); ++j)
+            {
+                EXPECT_EQ(matrix->get_route_info(i, j), dijkstra_strategy.calculate_route_info(origins[i], destinations[j], profile));
+            }
+        }
+    }
+}
+
+TEST_F(GraphRoutingStrategyTest, CalculatesIsochrones)
+{
+    std::shared_ptr<const EdgeSpatialIndex> index = std::make_shared<EdgeSpatialIndex>(graph);
+    std::shared_ptr<CchMetricCache> hierarchy = std::make_shared<CchMetricCache>(std::make_shared<CchTopology>(graph));
+    GraphRoutingStrategy hierarchy_strategy(graph, index, "car", GraphRoutingStrategy::DEFAULT_MAX_SNAPPING_DISTANCE_METERS, hierarchy);
+    GraphRoutingStrategy dijkstra_strategy(graph, index, "car", GraphRoutingStrategy::DEFAULT_MAX_SNAPPING_DISTANCE_METERS, nullptr);
+
+    auto sorted_points = [](const Isochrone &isochrone)
+    {
+        Isochrone::Points points = isochrone.points();
+        std::sort(points.begin(), points.end(), [](const Isochrone::Point &lhs, const Isochrone::Point &rhs)
+                  { return std::make_pair(lhs.location.lat(), lhs.location.lon()) < std::make_pair(rhs.location.lat(), rhs.location.lon()); });
+        return points;
+    };
+
+    // Nodes at most 2 roads away from the corner
+    Isochrone isochrone = hierarchy_strategy.calculate_isochrone(grid_location(0, 0), 25, TransportProfile());
+    Isochrone::Points points = sorted_points(isochrone);
+    ASSERT_EQ(points.size(), 6);
+    EXPECT_EQ(points.front(), (Isochrone::Point{grid_location(0, 0), RouteInfo(0, 0)}));
+    EXPECT_EQ(points.back(), (Isochrone::Point{grid_location(2, 0), RouteInfo(200, 20)}));
+
+    for (const GeoPoint &origin : {grid_location(0, 0), GeoPoint(1500, 1000), grid_location(-5, 2)})
+    {
+        for (RouteInfo::Seconds max_travel_time : {0, 15, 45, 1000})
+        {
+            for (const TransportProfile &profile : {TransportProfile(), TransportProfile(5)})
+            {
+                EXPECT_EQ(sorted_points(hierarchy_strategy.calculate_isochrone(origin, max_travel_time, profile)),
+                          sorted_points(dijkstra_strategy.calculate_isochrone(origin, max_travel_time, profile)));
+            }
+        }
+    }
+    EXPECT_EQ(hierarchy_strategy.calculate_isochrone(grid_location(-5, 2), 1000, TransportProfile()).points().size(), graph->nodes_count());
+    EXPECT_TRUE(hierarchy_strategy.calculate_isochrone(grid_location(100, 100), 1000, TransportProfile()).points().empty());
+    EXPECT_THROW(CrowflightRoutingStrategy().calculate_isochrone(grid_location(0, 0), 1000, TransportProfile()), std::invalid_argument);
+}
+
+TEST_F(GraphRoutingStrategyTest, UsesTransportProfileMetric)
+{
+    GraphRoutingStrategy strategy(graph, "car");
+
+    EXPECT_EQ(strategy.calculate_travel_time_seconds(grid_location(0, 0), grid_location(2, 3), TransportProfile(0, "truck")), 100);
+    EXPECT_EQ(strategy.calculate_travel_time_seconds(grid_location(0, 0), grid_location(2, 3), TransportProfile(0, "car")), 50);
+    EXPECT_THROW(strategy.calculate_route_info(grid_location(0, 0), grid_location(2, 3), TransportProfile(0, "bicycle")), std::invalid_argument);
+}
+
+TEST_F(GraphRoutingStrategyTest, CustomizesHierarchyInParallel)
+{
+    std::shared_ptr<const CchTopology> topology = std::make_shared<CchTopology>(graph);
+    for (CchTopology::Rank rank = 0; rank < topology->ranks_count(); ++rank)
+    {
+        EXPECT_EQ(topology->get_rank(topology->get_node(rank)), rank);
+        for (CchTopology::ArcId arc = topology->up_arcs_begin(rank); arc < topology->up_arcs_end(rank); ++arc)
+        {
+            EXPECT_GT(topology->get_arc_head(arc), rank);
+            EXPECT_EQ(topology->get_arc_tail(arc), rank);
+        }
+    }
+
+    CchMetric sequential(topology, "car", 0, 1);
+    CchMetric parallel(topology, "car", 0, 4);
+    for (RoadGraph::NodeId from = 0; from < graph->nodes_count(); ++from)
+    {
+        for (RoadGraph::NodeId to = 0; to < graph->nodes_count(); ++to)
+        {
+            CchMetric::Seed source{from, 0, 0};
+            CchMetric::Seed target{to, 0, 0};
+            std::vector<RoadGraph::NodeId> nodes;
+            CchMetric::Path path = parallel.find_path({&source, 1}, {&target, 1}, &nodes);
+            EXPECT_EQ(path.weight, sequential.find_path({&source, 1}, {&target, 1}, nullptr).weight);
+            if (path.exists())
+            {
+                EXPECT_EQ(nodes.front(), from);
+                EXPECT_EQ(nodes.back(), to);
+                EXPECT_EQ(path.length, (nodes.size() - 1) * 1000); // All roads are 100 meters long
+            }
+        }
+    }
+}
+
+TEST_F(GraphRoutingStrategyTest, SimplifiesShortcutsWhileUnpacking)
+{
+    CchMetric metric(std::make_shared<CchTopology>(graph), "car", 0);
+    std::size_t full_nodes_count = 0;
+    std::size_t simplified_nodes_count = 0;
+    for (RoadGraph::NodeId from = 0; from < GRID_SIZE * GRID_SIZE; ++from)
+    {
+        for (RoadGraph::NodeId to = 0; to < GRID_SIZE * GRID_SIZE; ++to)
+        {
+            CchMetric::Seed source{from, 0, 0};
+            CchMetric::Seed target{to, 0, 0};
+            std::vector<RoadGraph::NodeId> full;
+            std::vector<RoadGraph::NodeId> simplified;
+            metric.find_path({&source, 1}, {&target, 1}, &full);
+            metric.find_path({&source, 1}, {&target, 1}, &simplified, 1000);
+            EXPECT_EQ(simplified.front(), from);
+            EXPECT_EQ(simplified.back(), to);
+            EXPECT_TRUE(std::includes(full.begin(), full.end(), simplified.begin(), simplified.end(), [&](RoadGraph::NodeId lhs, RoadGraph::NodeId rhs)
+                                      { return std::find(full.begin(), full.end(), lhs) < std::find(full.begin(), full.end(), rhs); }))
+                << "Simplified path keeps a subsequence of path nodes";
+            full_nodes_count += full.size();
+            simplified_nodes_count += simplified.size();
+        }
+    }
+    EXPECT_LT(simplified_nodes_count, full_nodes_count) << "Shortcuts within tolerance are not unpacked";
+}
+
+TEST_F(GraphRoutingStrategyTest, HubLabelsMatchHierarchy)
+{
+    std::shared_ptr<const CchTopology> topology = std::make_shared<CchTopology>(graph);
+    CchMetric metric(topology, "car", 0);
+    std::string path = testing::TempDir() + "graph_routing_strategy_test.labels";
+    HubLabels::write(metric, path, 4);
+    std::shared_ptr<const HubLabels> labels = std::make_shared<HubLabels>(graph, path);
+    EXPECT_EQ(labels->get_metric(), "car");
+
+    for (RoadGraph::NodeId from = 0; from < graph->nodes_count(); ++from)
+    {
+        for (RoadGraph::NodeId to = 0; to < graph->nodes_count(); ++to)
+        {
+            CchMetric::Seed source{from, 0, 0};
+            CchMetric::Seed target{to, 0, 0};
+            CchMetric::Path expected = metric.find_path({&source, 1}, {&target, 1}, nullptr);
+            CchMetric::Path actual = labels->find_path({&source, 1}, {&target, 1});
+            EXPECT_EQ(actual.weight, expected.weight);
+            EXPECT_EQ(actual.length, expected.length);
+        }
+    }
+
+    std::shared_ptr<const EdgeSpatialIndex> index = std::make_shared<EdgeSpatialIndex>(graph);
+    std::shared_ptr<CchMetricCache> hierarchy = std::make_shared<CchMetricCache>(topology);
+    GraphRoutingStrategy labeled_strategy(graph, index, "car", GraphRoutingStrategy::DEFAULT_MAX_SNAPPING_DISTANCE_METERS, hierarchy, labels);
+    GraphRoutingStrategy hierarchy_strategy(graph, index, "car", GraphRoutingStrategy::DEFAULT_MAX_SNAPPING_DISTANCE_METERS, hierarchy);
+
+    std::vector<GeoPoint> waypoints;
+    for (int i = 0; i < 40; ++i)
+    {
+        waypoints.push_back(GeoPoint((i * 379) % 3400 - 200, (i * 917) % 3400 - 200));
+    }
+    waypoints.push_back(grid_location(-5, 2));
+
+    // Labels are only used for unlimited speed profile of their metric, others fall back to hierarchy
+    for (const TransportProfile &profile : {TransportProfile(), TransportProfile(5), TransportProfile(0, "truck")})
+    {
+        RoutingStrategy::MatrixPtr matrix = labeled_strategy.calculate_route_matrix(waypoints, profile);
+        for (std::size_t i = 0; i < waypoints.size(); ++i)
+        {
+            for (std::size_t j = 0; j < waypoints.size(); ++j)
+            {
+                RouteInfo expected = hierarchy_strategy.calculate_route_info(waypoints[i], waypoints[j], profile);
+                EXPECT_EQ(labeled_strategy.calculate_route_info(waypoints[i], waypoints[j], profile), expected);
+                EXPECT_EQ(matrix->get_route_info(i, j), expected);
+            }
+        }
+    }
+
+    labels.reset();
+    std::remove(path.c_str());
+}
+
+TEST_F(GraphRoutingStrategyTest, HubLabelsResumeFromCheckpoint)
+{
+    CchMetric metric(std::make_shared<CchTopology>(graph), "car", 0);
+    std::string expected_path = testing::TempDir() + "expected.labels";
+    std::string path = testing::TempDir() + "resumed.labels";
+    std::string checkpoint_path = path + ".checkpoint";
+    HubLabels::write(metric, expected_path, 1);
+
+    // Interrupted in the middle of computation after saving a checkpoint on every level
+    HubLabels::WriteOptions options;
+    options.threads_count = 2;
+    options.checkpoint_path = checkpoint_path;
+    options.checkpoint_interval = std::chrono::seconds(0);
+    options.on_progress = [&](std::size_t ranks_done, std::size_t ranks_count)
+    {
+        if (ranks_done * 2 >= ranks_count)
+        {
+            throw std::runtime_error("Interrupted");
+        }
+    };
+    EXPECT_THROW(HubLabels::write(metric, path, options), std::runtime_error);
+    EXPECT_TRUE(std::filesystem::exists(checkpoint_path));
+
+    std::vector<std::size_t> progress;
+    options.on_progress = [&](std::size_t ranks_done, std::size_t)
+    {
+        progress.push_back(ranks_done);
+    };
+    HubLabels::write(metric, path, options);
+    ASSERT_FALSE(progress.empty());
+    EXPECT_GT(progress.front(), graph->nodes_count() / 2); // Levels from checkpoint are not computed again
+    EXPECT_EQ(progress.back(), graph->nodes_count());
+    EXPECT_FALSE(std::filesystem::exists(checkpoint_path));
+
+    auto read = [](const std::string &path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    };
+    EXPECT_EQ(read(path), read(expected_path));
+    std::remove(path.c_str());
+    std::remove(expected_path.c_str());
+}
+
+TEST_F(GraphRoutingStrategyTest, RejectsLabelsOfAnotherGraph)
+{
+    std::string path = testing::TempDir() + "graph_routing_strategy_test.graph";
+    EXPECT_THROW(HubLabels labels(graph, path), std::runtime_error);
+
+    RoadGraphBuilder builder({"car"});
+    builder.add_node(grid_location(0, 0));
+    builder.add_node(grid_location(0, 1));
+    std::vector<double> times = {10};
+    builder.add_edge(0, 1, 100, times);
+    std::string other_graph_path = testing::TempDir() + "other.graph";
+    builder.write(other_graph_path);
+    std::string labels_path = testing::TempDir() + "other.labels";
+    {
+        std::shared_ptr<const RoadGraph> other_graph = std::make_shared<RoadGraph>(other_graph_path);
+        HubLabels::write(CchMetric(std::make_shared<CchTopology>(other_graph), "car", 0), labels_path);
+    }
+    EXPECT_THROW(HubLabels labels(graph, labels_path), std::runtime_error);
+    std::remove(labels_path.c_str());
+    std::remove(other_graph_path.c_str());
+}
+
+TEST_F(GraphRoutingStrategyTest, BatchedSnappingMatchesSingleSnapping)
+{
+    EdgeSpatialIndex index(graph);
+    std::vector<GeoPoint> points;
+    for (int i = 0; i < 3 * int(EdgeSpatialIndex::PARALLEL_SNAPPING_THRESHOLD); ++i)
+    {
+        points.push_back(GeoPoint((i * 37) % 4000 - 200, (i * 91) % 4000 - 200));
+    }
+    points.push_back(points.front());
+
+    std::vector<EdgeSpatialIndex::Snap> snaps = index.snap(points, 100);
+    ASSERT_EQ(snaps.size(), points.size());
+    for (std::size_t i = 0; i < points.size(); ++i)
+    {
+        EdgeSpatialIndex::Snap snap = index.snap(points[i], 100);
+        EXPECT_EQ(snaps[i].edge, snap.edge);
+        EXPECT_EQ(snaps[i].location, snap.location);
+    }
+    EXPECT_FALSE(index.snap(grid_location(100, 100), 100).is_valid());
+}
+
+TEST(TimeDependentRoutingTest, DependsOnDepartureTime)
+{
+    std::shared_ptr<const RoadGraph> graph = std::make_shared<RoadGraph>(build_traffic_graph());
+    GraphRoutingStrategy strategy(graph, "car");
+    ASSERT_TRUE(TrafficWeights::is_present(*graph, "car"));
+    ASSERT_FALSE(TrafficWeights::is_present(*graph, "truck"));
+
+    EXPECT_EQ(strategy.calculate_travel_time_seconds(grid_location(0, 0), grid_location(0, 2), TransportProfile()), 20);
+    EXPECT_EQ(strategy.calculate_travel_time_seconds(grid_location(0, 0), grid_location(0, 2), departing_at(MONDAY + 3 * HOUR)), 20);
+    EXPECT_NEAR(strategy.calculate_travel_time_seconds(grid_location(0, 0), grid_location(0, 2), departing_at(MONDAY + 7 * HOUR + HOUR / 2)), 45, 1);
+    EXPECT_EQ(strategy.calculate_travel_time_seconds(grid_location(0, 0), grid_location(0, 2), departing_at(MONDAY + 8 * HOUR)), 60); // Takes the detour
+    EXPECT_EQ(strategy.calculate_travel_time_seconds(grid_location(0, 0), grid_location(0, 2), departing_at(MONDAY + 5 * 24 * HOUR + 8 * HOUR)), 20); // Saturday
+
+    // Departures within one bucket share a cached route info
+    EXPECT_EQ(strategy.calculate_route_info(grid_location(0, 0), grid_location(0, 2), departing_at(MONDAY + 8 * HOUR + 10)),
+              strategy.calculate_route_info(grid_location(0, 0), grid_location(0, 2), departing_at(MONDAY + 8 * HOUR)));
+    EXPECT_EQ(strategy.calculate_route(grid_location(0, 0), grid_location(0, 2), departing_at(MONDAY + 8 * HOUR)).travel_time_seconds(), 60);
+
+    // Second leg departs when the first one arrives, which is at rush hour
+    std::vector<GeoPoint> waypoints = {grid_location(0, 0), grid_location(0, 1), grid_location(0, 2)};
+    std::vector<RouteInfo> legs = strategy.calculate_route_infos_vector(waypoints, departing_at(MONDAY + 8 * HOUR - 10));
+    ASSERT_EQ(legs.size(), 2);
+    EXPECT_EQ(legs[0].travel_time_seconds(), 10);
+    EXPECT_EQ(legs[1].travel_time_seconds(), 60);
+
+    std::remove(graph->path().c_str());
+}
+
+TEST(TimeDependentRoutingTest, DepartureSlicesMatchSingleDepartures)
+{
+    std::shared_ptr<const RoadGraph> graph = std::make_shared<RoadGraph>(build_traffic_graph());
+    std::vector<GeoPoint> waypoints = {grid_location(0, 0), grid_location(0, 1), GeoPoint(0, 1500), grid_location(0, 2), grid_location(2, 1), grid_location(100, 100)};
+    std::vector<TransportProfile::Timestamp> departure_times;
+    for (int minutes = 6 * 60; minutes <= 10 * 60; minutes += 25)
+    {
+        departure_times.push_back(MONDAY + minutes * 60);
+    }
+
+    for (const char *metric : {"car", "truck"})
+    {
+        GraphRoutingStrategy strategy(graph, metric);
+        std::vector<RoutingStrategy::MatrixPtr> matrices = strategy.calculate_route_matrices(waypoints, waypoints, departure_times, TransportProfile());
+        ASSERT_EQ(matrices.size(), departure_times.size());
+        for (std::size_t slice = 0; slice < departure_times.size(); ++slice)
+        {
+            RoutingStrategy::MatrixPtr matrix = strategy.calculate_route_matrix(waypoints, waypoints, departing_at(departure_times[slice]));
+            for (std::size_t i = 0; i < waypoints.size(); ++i)
+            {
+                for (std::size_t j = 0; j < waypoints.size(); ++j)
+                {
+                    RouteInfo expected = strategy.calculate_route_info(waypoints[i], waypoints[j], departing_at(departure_times[slice]));
+                    EXPECT_EQ(matrices[slice]->get_route_info(i, j), expected) << metric << " " << slice << " " << i << " " << j;
+                    EXPECT_EQ(matrix->get_route_info(i, j), expected) << metric << " " << slice << " " << i << " " << j;
+                }
+            }
+        }
+    }
+
+    std::vector<TransportProfile::Timestamp> too_many_departures(GraphRoutingStrategy::MAX_DEPARTURE_SLICES + 1, MONDAY);
+    EXPECT_THROW(GraphRoutingStrategy(graph, "car").calculate_route_matrices(waypoints, waypoints, too_many_departures, TransportProfile()), std::invalid_argument);
+    std::remove(graph->path().c_str());
+}
+
+TEST(TimeDependentRoutingTest, RejectsTrafficViolatingFifo)
+{
+    RoadGraphBuilder builder({"car"});
+    builder.add_node(grid_location(0, 0));
+    builder.add_node(grid_location(0, 1));
+    std::vector<double> times = {10};
+    std::size_t edge = builder.add_edge(0, 1, 100, times);
+
+    std::vector<std::uint32_t> breakpoints = {0, 60};
+    std::vector<double> dropping_too_fast = {100, 10}; // Entering a minute later would mean leaving 30 seconds earlier
+    std::vector<double> dropping_slowly = {100, 50};
+    EXPECT_THROW(builder.set_edge_traffic(edge, "car", breakpoints, dropping_too_fast), std::invalid_argument);
+    EXPECT_NO_THROW(builder.set_edge_traffic(edge, "car", breakpoints, dropping_slowly));
+
+    std::vector<std::uint32_t> unsorted_breakpoints = {60, 0};
+    EXPECT_THROW(builder.set_edge_traffic(edge, "car", unsorted_breakpoints, dropping_slowly), std::invalid_argument);
+    EXPECT_THROW(builder.set_edge_traffic(edge, "truck", breakpoints, dropping_slowly), std::invalid_argument);
+    EXPECT_THROW(builder.set_traffic_period(0, 30), std::invalid_argument);
+}
+
+TEST(TurnsRoutingTest, RespectsTurnCostsAndRestrictions)
+{
+    std::shared_ptr<const RoadGraph> graph = std::make_shared<RoadGraph>(build_turns_graph());
+    ASSERT_TRUE(graph->is_turn_expanded());
+    EXPECT_GT(graph->nodes_count(), GRID_SIZE * GRID_SIZE);
+    for (RoadGraph::EdgeId edge = 0; edge < graph->edges_count(); ++edge)
+    {
+        RoadGraph::EdgeId reverse_edge = graph->get_reverse_edge(edge);
+        if (reverse_edge != RoadGraph::NO_EDGE)
+        {
+            EXPECT_EQ(graph->get_original_node(graph->get_edge_source(reverse_edge)), graph->get_original_node(graph->get_edge_target(edge)));
+            EXPECT_EQ(graph->get_original_node(graph->get_edge_target(reverse_edge)), graph->get_original_node(graph->get_edge_source(edge)));
+        }
+    }
+
+    GraphRoutingStrategy car(graph, "car");
+    GraphRoutingStrategy truck(graph, "truck");
+
+    // Costly straight turn is bypassed by car only
+    Route car_route = car.calculate_route(grid_location(0, 0), grid_location(0, 2), TransportProfile());
+    EXPECT_DOUBLE_EQ(car_route.distance_meters(), 400);
+    EXPECT_EQ(car_route.travel_time_seconds(), 40);
+    for (std::size_t i = 2; i + 2 < car_route.waypoints().size(); ++i)
+    {
+        EXPECT_NE(car_route.waypoints()[i], car_route.waypoints()[i - 1]); // Intersection is passed once
+    }
+    EXPECT_EQ(truck.calculate_route_info(grid_location(0, 0), grid_location(0, 2), TransportProfile()), RouteInfo(200, 40));
+
+    // Forbidden turn is bypassed by both, the other way is free
+    EXPECT_EQ(car.calculate_route_info(grid_location(2, 0), grid_location(2, 2), TransportProfile()), RouteInfo(400, 40));
+    EXPECT_EQ(truck.calculate_route_info(grid_location(2, 2), grid_location(2, 0), TransportProfile()), RouteInfo(200, 40));
+
+    std::vector<GeoPoint> waypoints;
+    for (int row = 0; row < GRID_SIZE; ++row)
+    {
+        for (int column = 0; column < GRID_SIZE; ++column)
+        {
+            waypoints.push_back(grid_location(row, column));
+        }
+    }
+    waypoints.push_back(GeoPoint(2000, 500));
+
+    std::shared_ptr<const EdgeSpatialIndex> index = std::make_shared<EdgeSpatialIndex>(graph);
+    std::shared_ptr<CchMetricCache> hierarchy = std::make_shared<CchMetricCache>(std::make_shared<CchTopology>(graph));
+    GraphRoutingStrategy hierarchy_strategy(graph, index, "car", GraphRoutingStrategy::DEFAULT_MAX_SNAPPING_DISTANCE_METERS, hierarchy);
+    RoutingStrategy::MatrixPtr matrix = hierarchy_strategy.calculate_route_matrix(waypoints, TransportProfile());
+    for (std::size_t i = 0; i < waypoints.size(); ++i)
+    {
+        for (std::size_t j = 0; j < waypoints.size(); ++j)
+        {
+            EXPECT_EQ(matrix->get_route_info(i, j), car.calculate_route_info(waypoints[i], waypoints[j], TransportProfile())) << i << " " << j;
+        }
+    }
+
+    // Intersections are reached at several expanded nodes, but make one point each
+    EXPECT_EQ(car.calculate_isochrone(grid_location(0, 0), 1000, TransportProfile()).points().size(), GRID_SIZE * GRID_SIZE);
+    EXPECT_EQ(hierarchy_strategy.calculate_isochrone(grid_location(0, 0), 1000, TransportProfile()).points().size(), GRID_SIZE * GRID_SIZE);
+    std::remove(graph->path().c_str());
+}
+
+TEST(RoadGraphTest, RejectsInvalidFile)
+{
+    std::string path = testing::TempDir() + "invalid.graph";
+    std::ofstream(path) << "not a graph file";
+    EXPECT_THROW(RoadGraph graph(path), std::runtime_error);
+    std::remove(path.c_str());
+
+    EXPECT_THROW(RoadGraph graph(testing::TempDir() + "missing.graph"), std::runtime_error);
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "assfire/router/engine/algorithms/CrowflightRoutingStrategy.hpp"
+#include "assfire/router/engine/matrix/LazyRouteMatrix.hpp"
+#include "RoutingTestUtils.hpp"
+
+using namespace assfire::router;
+using namespace assfire::router::test;
+
+TEST(LazyRouteMatrixTest, CalculatesRoutesOnFirstAccess)
+{
+    std::vector<GeoPoint> origins = make_random_waypoints(20, 1);
+    std::vector<GeoPoint> destinations = make_random_waypoints(200, 2);
+    TransportProfile profile(10);
+    auto strategy = std::make_shared<CountingCrowflightRoutingStrategy>();
+    LazyRouteMatrix matrix(origins, destinations, strategy, profile);
+
+    EXPECT_EQ(matrix.get_calculated_count(), 0);
+    EXPECT_EQ(matrix.get_route_info(3, 100), CrowflightRoutingStrategy().calculate_route_info(origins[3], destinations[100], profile));
+    EXPECT_EQ(matrix.get_calculated_count(), LazyRouteMatrix::MAX_BATCH_SIZE) << "Following cells of the row are calculated together";
+    EXPECT_EQ(matrix.get_calculated_count(), strategy->calls_count);
+
+    matrix.get_travel_time_seconds(3, 120);
+    EXPECT_EQ(matrix.get_calculated_count(), LazyRouteMatrix::MAX_BATCH_SIZE) << "Calculated cells are not calculated again";
+    matrix.get_travel_time_seconds(3, 90);
+    EXPECT_EQ(matrix.get_calculated_count(), LazyRouteMatrix::MAX_BATCH_SIZE + 10) << "Batch stops at calculated cells";
+    matrix.get_distance_meters(3, 190);
+    EXPECT_EQ(matrix.get_calculated_count(), LazyRouteMatrix::MAX_BATCH_SIZE + 20) << "Batch stops at the end of row";
+    EXPECT_EQ(strategy->matrices_count, 3);
+
+    matrix.sync();
+    EXPECT_EQ(matrix.get_calculated_count(), origins.size() * destinations.size());
+    EXPECT_EQ(strategy->calls_count, origins.size() * destinations.size());
+    for (RouteMatrix::GeopointId origin = 0; origin < origins.size(); ++origin)
+    {
+        for (RouteMatrix::GeopointId destination = 0; destination < destinations.size(); destination += 7)
+        {
+            EXPECT_EQ(matrix.get_route_info(origin, destination), CrowflightRoutingStrategy().calculate_route_info(origins[origin], destinations[destination], profile));
+        }
+    }
+    EXPECT_THROW(matrix.get_route_info(origins.size(), 0), std::invalid_argument);
+}
+
+TEST(LazyRouteMatrixTest, CalculatesEachRouteOnceForConcurrentReaders)
+{
+    std::vector<GeoPoint> waypoints = make_random_waypoints(100, 3);
+    TransportProfile profile(10);
+    auto strategy = std::make_shared<CountingCrowflightRoutingStrategy>();
+    LazyRouteMatrix matrix(waypoints, waypoints, strategy, profile);
+
+    std::vector<std::thread> readers;
+    std::atomic<std::size_t> mismatches_count = 0;
+    for (unsigned seed = 0; seed < 4; ++seed)
+    {
+        readers.emplace_back([&, seed]()
+                             {
+                                 std::mt19937 random(seed);
+                                 std::uniform_int_distribution<RouteMatrix::GeopointId> id(0, waypoints.size() - 1);
+                                 for (int i = 0; i < 5000; ++i)
+                                 {
+                                     RouteMatrix::GeopointId origin = id(random);
+                                     RouteMatrix::GeopointId destination = id(random);
+                                     if (matrix.get_route_info(origin, destination) !=
+                                         CrowflightRoutingStrategy().calculate_route_info(waypoints[origin], waypoints[destination], profile))
+                                     {
+                                         ++mismatches_count;
+                                     }
+                                 }
+                             });
+    }
+    for (std::thread &reader : readers)
+    {
+        reader.join();
+    }
+
+    EXPECT_EQ(mismatches_count, 0);
+    EXPECT_EQ(strategy->calls_count, matrix.get_calculated_count());
+    EXPECT_LE(matrix.get_calculated_count(), waypoints.size() * waypoints.size());
+}
+
+TEST(LazyRouteMatrixTest, RecalculatesRoutesAfterFailure)
+{
+    std::vector<GeoPoint> waypoints = make_random_waypoints(10, 4);
+    TransportProfile profile(10);
+    auto strategy = std::make_shared<CountingCrowflightRoutingStrategy>();
+    LazyRouteMatrix matrix(waypoints, waypoints, strategy, profile);
+
+    strategy->failing = true;
+    EXPECT_THROW(matrix.get_route_info(2, 5), std::runtime_error);
+    EXPECT_EQ(matrix.get_calculated_count(), 0);
+
+    strategy->failing = false;
+    EXPECT_EQ(matrix.get_route_info(2, 5), CrowflightRoutingStrategy().calculate_route_info(waypoints[2], waypoints[5], profile));
+}
+
+TEST(LazyRouteMatrixTest, PrefetchesAccessedRows)
+{
+    std::vector<GeoPoint> waypoints = make_random_waypoints(300, 5);
+    TransportProfile profile(10);
+    auto strategy = std::make_shared<CountingCrowflightRoutingStrategy>();
+    LazyRouteMatrix matrix(waypoints, waypoints, strategy, profile, true);
+
+    matrix.get_route_info(7, 0);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (matrix.get_calculated_count() < waypoints.size() && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(matrix.get_calculated_count(), waypoints.size()) << "Only the accessed row is prefetched";
+    EXPECT_EQ(matrix.get_route_info(7, 299), CrowflightRoutingStrategy().calculate_route_info(waypoints[7], waypoints[299], profile));
+    EXPECT_EQ(strategy->calls_count, waypoints.size());
+}
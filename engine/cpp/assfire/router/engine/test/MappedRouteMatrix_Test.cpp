@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "assfire/router/engine/algorithms/CrowflightRoutingStrategy.hpp"
+#include "assfire/router/engine/matrix/MappedRouteMatrix.hpp"
+#include "RoutingTestUtils.hpp"
+
+using namespace assfire::router;
+using namespace assfire::router::test;
+
+namespace
+{
+    void expect_same_routes(const RouteMatrix &expected, const MappedRouteMatrix &actual)
+    {
+        for (RouteMatrix::GeopointId origin = 0; origin < actual.get_origins_count(); ++origin)
+        {
+            for (RouteMatrix::GeopointId destination = 0; destination < actual.get_destinations_count(); ++destination)
+            {
+                ASSERT_EQ(actual.get_route_info(origin, destination), expected.get_route_info(origin, destination)) << origin << "->" << destination;
+                ASSERT_EQ(actual.get_travel_time_seconds(origin, destination), expected.get_travel_time_seconds(origin, destination));
+                ASSERT_EQ(actual.get_distance_meters(origin, destination), expected.get_distance_meters(origin, destination));
+            }
+        }
+    }
+}
+
+TEST(MappedRouteMatrixTest, ReadsWrittenMatrix)
+{
+    std::vector<GeoPoint> origins = make_random_waypoints(37, 1);
+    std::vector<GeoPoint> destinations = make_random_waypoints(53, 2);
+    origins[5] = GeoPoint(-33.9, 151.2); // Far away routes keep big values
+    TransportProfile profile(10);
+    RoutingStrategy::MatrixPtr expected = CrowflightRoutingStrategy().calculate_route_matrix(origins, destinations, profile);
+
+    std::string dense_path = testing::TempDir() + "dense_route_matrix.matrix";
+    std::string compressed_path = testing::TempDir() + "compressed_route_matrix.matrix";
+    MappedRouteMatrix::write(*expected, origins, destinations, dense_path, {RoutingStrategyId("crowflight"), TransportProfileId("car")});
+    MappedRouteMatrix::write(*expected, origins, destinations, compressed_path, {RoutingStrategyId("crowflight"), TransportProfileId("car"), 8});
+    EXPECT_LT(std::filesystem::file_size(compressed_path), std::filesystem::file_size(dense_path));
+
+    for (const std::string &path : {dense_path, compressed_path})
+    {
+        MappedRouteMatrix matrix(path);
+        EXPECT_EQ(matrix.is_compressed(), path == compressed_path);
+        EXPECT_EQ(matrix.get_strategy_id().value(), "crowflight");
+        EXPECT_EQ(matrix.get_transport_profile_id().value(), "car");
+        ASSERT_EQ(matrix.get_origins_count(), origins.size());
+        ASSERT_EQ(matrix.get_destinations_count(), destinations.size());
+        EXPECT_EQ(matrix.get_origin(5), origins[5]);
+        EXPECT_EQ(matrix.get_destination(52), destinations[52]);
+        expect_same_routes(*expected, matrix);
+
+        EXPECT_THROW(matrix.get_route_info(origins.size(), 0), std::invalid_argument);
+        EXPECT_THROW(matrix.calculate_route_info(origins[0], destinations[0]), std::runtime_error);
+        matrix.set_strategy(std::make_shared<CrowflightRoutingStrategy>(), profile);
+        EXPECT_EQ(matrix.calculate_route_info(origins[0], destinations[0]), expected->get_route_info(0, 0));
+    }
+}
+
+TEST(MappedRouteMatrixTest, RejectsInvalidFiles)
+{
+    std::string path = testing::TempDir() + "invalid_route_matrix.matrix";
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << "ASFRGRPH and some bytes that are not a matrix";
+    }
+    EXPECT_THROW(MappedRouteMatrix matrix(path), std::runtime_error);
+    EXPECT_THROW(MappedRouteMatrix matrix(testing::TempDir() + "missing_route_matrix.matrix"), std::runtime_error);
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "assfire/router/engine/common/ParallelWorkers.hpp"
+
+using namespace assfire::router;
+
+TEST(ParallelWorkersTest, ProcessesAllItemsAndRethrowsFirstError)
+{
+    std::vector<std::atomic<int>> processed(1000);
+    std::atomic<std::size_t> next_item = 0;
+    ParallelWorkers::run(8, [&](std::size_t)
+                         {
+                             for (std::size_t i = next_item++; i < processed.size(); i = next_item++)
+                             {
+                                 ++processed[i];
+                             }
+                         });
+    for (const std::atomic<int> &count : processed)
+    {
+        EXPECT_EQ(count, 1);
+    }
+
+    EXPECT_THROW(ParallelWorkers::run(4, [](std::size_t worker_index)
+                                      {
+                                          if (worker_index == 0)
+                                          {
+                                              throw std::runtime_error("Failed");
+                                          }
+                                      }),
+                 std::runtime_error);
+}
+
+TEST(ParallelWorkersTest, LimitsExtraThreadsOfConcurrentCalls)
+{
+    const std::size_t callers_count = 4;
+    std::atomic<std::size_t> running = 0;
+    std::atomic<std::size_t> max_running = 0;
+    std::vector<std::thread> callers;
+    for (std::size_t c = 0; c < callers_count; ++c)
+    {
+        callers.emplace_back([&]()
+                             {
+                                 ParallelWorkers::run(ParallelWorkers::get_max_workers_count() * 2, [&](std::size_t)
+                                                      {
+                                                          std::size_t now_running = ++running;
+                                                          std::size_t observed = max_running;
+                                                          while (observed < now_running && !max_running.compare_exchange_weak(observed, now_running))
+                                                          {
+                                                          }
+                                                          std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                                                          --running;
+                                                      });
+                             });
+    }
+    for (std::thread &caller : callers)
+    {
+        caller.join();
+    }
+    EXPECT_LE(max_running, ParallelWorkers::get_max_workers_count() + callers_count); // Calling threads always work themselves
+}
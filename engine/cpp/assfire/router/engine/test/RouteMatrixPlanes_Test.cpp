@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include "assfire/router/engine/matrix/ExtendableRouteMatrix.hpp"
+#include "assfire/router/engine/matrix/RouteMatrixPlanes.hpp"
+#include "assfire/router/engine/algorithms/BasicRoutingStrategy.hpp"
+
+using namespace assfire::router;
+
+namespace
+{
+    /**
+     * Routes to waypoints with negative latitude are unreachable
+     */
+    class PlanesRoutingStrategy : public BasicRoutingStrategy
+    {
+    public:
+        virtual Route calculate_route(const GeoPoint &origin, const GeoPoint &destination, const TransportProfile &profile) const override
+        {
+            return Route(calculate_route_info(origin, destination, profile));
+        }
+
+        virtual RouteInfo calculate_route_info(const GeoPoint &origin, const GeoPoint &destination, const TransportProfile &) const override
+        {
+            if (destination.lat() < 0)
+            {
+                return RouteInfo(RouteInfo::INFINITE_DISTANCE, RouteInfo::INFINITE_TRAVEL_TIME);
+            }
+            return RouteInfo(origin.lat() * 100 + destination.lat() + 0.5, std::abs(origin.lat() - destination.lat()) * 10 + origin.lat() * destination.lat() % 7);
+        }
+
+        virtual std::shared_ptr<RoutingStrategy> clone() const override
+        {
+            return std::make_shared<PlanesRoutingStrategy>();
+        }
+    };
+
+    std::vector<GeoPoint> make_waypoints(int count)
+    {
+        std::vector<GeoPoint> result;
+        for (int i = 0; i < count; ++i)
+        {
+            result.emplace_back(i, 0);
+        }
+        return result;
+    }
+}
+
+TEST(RouteMatrixPlanesTest, EvaluatesToursLikeMatrix)
+{
+    ExtendableRouteMatrix matrix(std::make_shared<PlanesRoutingStrategy>(), TransportProfile(10));
+    matrix.extend(make_waypoints(30));
+
+    std::vector<RouteMatrix::GeopointId> tours;
+    std::vector<std::uint32_t> tour_sizes;
+    std::vector<RouteInfo> expected;
+    for (std::uint32_t tour_size : {0u, 1u, 2u, 9u, 10u, 17u, 29u})
+    {
+        RouteInfo::Meters meters = 0;
+        RouteInfo::Seconds seconds = 0;
+        for (std::uint32_t i = 0; i < tour_size; ++i)
+        {
+            RouteMatrix::GeopointId id = (i * 7 + tour_size) % 30;
+            if (i > 0)
+            {
+                meters += matrix.get_distance_meters(tours.back(), id);
+                seconds += matrix.get_travel_time_seconds(tours.back(), id);
+            }
+            tours.push_back(id);
+        }
+        tour_sizes.push_back(tour_size);
+        expected.emplace_back(meters, seconds);
+    }
+
+    for (bool vectorized : {false, true})
+    {
+        SCOPED_TRACE(vectorized ? "Vectorized" : "Scalar");
+        RouteMatrixPlanes planes(matrix, matrix.size(), vectorized);
+        std::vector<RouteInfo> totals = planes.evaluate_tours(tours, tour_sizes);
+        ASSERT_EQ(totals.size(), expected.size());
+        for (std::size_t i = 0; i < totals.size(); ++i)
+        {
+            EXPECT_EQ(totals[i].travel_time_seconds(), expected[i].travel_time_seconds()) << "Tour " << i;
+            EXPECT_DOUBLE_EQ(totals[i].distance_meters(), expected[i].distance_meters()) << "Tour " << i;
+        }
+        EXPECT_THROW(planes.evaluate_tours(tours, std::vector<std::uint32_t>{1}), std::invalid_argument);
+    }
+}
+
+TEST(RouteMatrixPlanesTest, UsesVectorInstructionsOnlyWhereSupported)
+{
+    ExtendableRouteMatrix matrix(std::make_shared<PlanesRoutingStrategy>(), TransportProfile(10));
+    matrix.extend(make_waypoints(3));
+
+    EXPECT_EQ(RouteMatrixPlanes(matrix, matrix.size()).is_vectorized(), RouteMatrixPlanes::has_vector_instructions());
+    EXPECT_FALSE(RouteMatrixPlanes(matrix, matrix.size(), false).is_vectorized());
+}
+
+TEST(RouteMatrixPlanesTest, RejectsRemovedIdsAndReportsUnreachableTours)
+{
+    ExtendableRouteMatrix matrix(std::make_shared<PlanesRoutingStrategy>(), TransportProfile(10));
+    matrix.extend(make_waypoints(12));
+    matrix.extend({GeoPoint(-1, 0)});
+    matrix.remove({3});
+    ExtendableRouteMatrix::GeopointIds ids = matrix.get_waypoint_ids();
+
+    for (bool vectorized : {false, true})
+    {
+        SCOPED_TRACE(vectorized ? "Vectorized" : "Scalar");
+        RouteMatrixPlanes planes(matrix, ids, vectorized);
+
+        EXPECT_EQ(planes.size(), 13);
+        EXPECT_FALSE(planes.contains(3));
+        EXPECT_THROW(planes.evaluate_tour(std::vector<RouteMatrix::GeopointId>{1, 3}), std::invalid_argument);
+        EXPECT_THROW(planes.evaluate_tour(std::vector<RouteMatrix::GeopointId>{1, 13}), std::invalid_argument);
+
+        std::vector<RouteMatrix::GeopointId> unreachable = {0, 1, 12, 2, 4, 5, 6, 7, 8, 9, 10, 11};
+        EXPECT_EQ(planes.evaluate_tour(unreachable).travel_time_seconds(), RouteInfo::INFINITE_TRAVEL_TIME);
+        EXPECT_EQ(planes.evaluate_tour(unreachable).distance_meters(), RouteInfo::INFINITE_DISTANCE);
+        EXPECT_EQ(planes.evaluate_tour(std::vector<RouteMatrix::GeopointId>{11, 12}).travel_time_seconds(), RouteInfo::INFINITE_TRAVEL_TIME);
+        EXPECT_LT(planes.evaluate_tour(std::vector<RouteMatrix::GeopointId>{12, 11}).travel_time_seconds(), RouteInfo::INFINITE_TRAVEL_TIME);
+    }
+}
+
+TEST(RouteMatrixPlanesTest, FindsBestInsertions)
+{
+    ExtendableRouteMatrix matrix(std::make_shared<PlanesRoutingStrategy>(), TransportProfile(10));
+    matrix.extend(make_waypoints(40));
+    matrix.extend({GeoPoint(-1, 0)});
+
+    std::vector<RouteMatrix::GeopointId> routes;
+    std::vector<std::uint32_t> route_sizes = {0, 1, 2, 9, 20};
+    for (std::uint32_t route_size : route_sizes)
+    {
+        for (std::uint32_t i = 0; i < route_size; ++i)
+        {
+            routes.push_back((i * 11 + route_size) % 40);
+        }
+    }
+    std::vector<RouteMatrix::GeopointId> stops = {3, 17, 38, 40};
+
+    for (bool vectorized : {false, true})
+    {
+        SCOPED_TRACE(vectorized ? "Vectorized" : "Scalar");
+        RouteMatrixPlanes planes(matrix, matrix.size(), vectorized);
+
+        std::vector<RouteMatrixPlanes::Insertion> insertions = planes.find_best_insertions(stops, routes, route_sizes);
+        ASSERT_EQ(insertions.size(), stops.size() * route_sizes.size());
+        for (std::size_t s = 0; s < stops.size(); ++s)
+        {
+            const RouteMatrix::GeopointId *route = routes.data();
+            for (std::size_t r = 0; r < route_sizes.size(); ++r)
+            {
+                RouteMatrixPlanes::Insertion expected;
+                for (std::uint32_t i = 0; i + 1 < route_sizes[r] && stops[s] != 40; ++i)
+                {
+                    RouteInfo::Seconds delta = matrix.get_travel_time_seconds(route[i], stops[s]) + matrix.get_travel_time_seconds(stops[s], route[i + 1]) -
+                                               matrix.get_travel_time_seconds(route[i], route[i + 1]);
+                    if (delta < expected.delta_seconds)
+                    {
+                        expected.position = i + 1;
+                        expected.delta_seconds = delta;
+                    }
+                }
+                const RouteMatrixPlanes::Insertion &insertion = insertions[s * route_sizes.size() + r];
+                EXPECT_EQ(insertion.position, expected.position) << "Stop " << stops[s] << ", route " << r;
+                EXPECT_EQ(insertion.delta_seconds, expected.delta_seconds) << "Stop " << stops[s] << ", route " << r;
+                route += route_sizes[r];
+            }
+        }
+
+        std::vector<RouteInfo::Seconds> deltas(19);
+        planes.evaluate_insertions(40, std::span<const RouteMatrix::GeopointId>(routes).last(20), deltas);
+        EXPECT_EQ(deltas, std::vector<RouteInfo::Seconds>(19, RouteInfo::INFINITE_TRAVEL_TIME));
+        EXPECT_THROW(planes.evaluate_insertions(3, std::span<const RouteMatrix::GeopointId>(routes).last(20), std::span(deltas).first(10)), std::invalid_argument);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include "assfire/router/engine/BasicRoutingStrategyProvider.hpp"
+#include "assfire/router/engine/BasicTransportProfileProvider.hpp"
+#include "assfire/router/engine/RouterEngine.hpp"
+#include "assfire/router/engine/RoutingRegistry.hpp"
+#include "assfire/router/engine/algorithms/CrowflightRoutingStrategy.hpp"
+
+using namespace assfire::router;
+
+namespace
+{
+    /**
+     * Crowflight strategy that reports entering route calculation and waits until it is released
+     */
+    class GatedCrowflightRoutingStrategy : public CrowflightRoutingStrategy
+    {
+    public:
+        virtual RouteInfo calculate_route_info(const GeoPoint &origin, const GeoPoint &destination, const TransportProfile &profile) const override
+        {
+            entered.set_value();
+            released.wait();
+            return CrowflightRoutingStrategy::calculate_route_info(origin, destination, profile);
+        }
+
+        mutable std::promise<void> entered;
+        std::shared_future<void> released;
+    };
+
+    class SingleRoutingStrategyProvider : public RoutingStrategyProvider
+    {
+    public:
+        explicit SingleRoutingStrategyProvider(std::shared_ptr<RoutingStrategy> strategy) : strategy(std::move(strategy))
+        {
+        }
+
+        virtual std::shared_ptr<RoutingStrategy> get_routing_strategy(const RoutingStrategyId &) const override
+        {
+            return strategy;
+        }
+
+        virtual const std::vector<RoutingStrategyId> &get_available_strategies() const override
+        {
+            return available_strategies;
+        }
+
+    private:
+        std::shared_ptr<RoutingStrategy> strategy;
+        std::vector<RoutingStrategyId> available_strategies;
+    };
+}
+
+TEST(RoutingRegistryTest, InternsIdsToStableHandles)
+{
+    std::shared_ptr<BasicTransportProfileProvider> profiles = std::make_shared<BasicTransportProfileProvider>();
+    profiles->add_transport_profile(TransportProfileId("walk"), TransportProfile(1));
+    RoutingRegistry registry(std::make_shared<BasicRoutingStrategyProvider>(), profiles);
+
+    RoutingRegistry::Handle walk = registry.get_profile_handle(TransportProfileId("walk"));
+    EXPECT_NE(walk, RoutingRegistry::DEFAULT_HANDLE);
+    EXPECT_EQ(registry.get_profile_handle(TransportProfileId()), RoutingRegistry::DEFAULT_HANDLE);
+    EXPECT_EQ(registry.get_strategy_handle(RoutingStrategyId(BasicRoutingStrategyProvider::CROWFLIGHT)),
+              registry.get_strategy_handle(RoutingStrategyId(BasicRoutingStrategyProvider::CROWFLIGHT)));
+    EXPECT_THROW(registry.get_profile_handle(TransportProfileId("fly")), std::invalid_argument);
+    EXPECT_THROW(registry.resolve(TransportProfileId(), RoutingStrategyId("Teleport")), std::invalid_argument);
+    EXPECT_THROW(registry.resolve(walk + 1, RoutingRegistry::DEFAULT_HANDLE), std::out_of_range);
+
+    RoutingRegistry::Resolution before = registry.resolve(TransportProfileId("walk"), RoutingStrategyId());
+    EXPECT_EQ(before.get_profile_handle(), walk);
+    EXPECT_EQ(before.profile(), TransportProfile(1));
+
+    registry.set_transport_profile(TransportProfileId("walk"), TransportProfile(2));
+    registry.set_transport_profile(TransportProfileId("run"), TransportProfile(4));
+    EXPECT_EQ(before.profile(), TransportProfile(1)) << "Resolved profile stays in its snapshot";
+    EXPECT_EQ(registry.get_profile_handle(TransportProfileId("walk")), walk);
+    EXPECT_EQ(registry.resolve(walk, RoutingRegistry::DEFAULT_HANDLE).profile(), TransportProfile(2));
+    EXPECT_EQ(registry.resolve(TransportProfileId("run"), RoutingStrategyId()).profile(), TransportProfile(4));
+}
+
+TEST(RoutingRegistryTest, UpdatesProfilesWhileRouting)
+{
+    std::shared_ptr<BasicTransportProfileProvider> profiles = std::make_shared<BasicTransportProfileProvider>();
+    profiles->add_transport_profile(TransportProfileId("car"), TransportProfile(10));
+    RouterEngine engine(std::make_shared<BasicRoutingStrategyProvider>(), profiles);
+    GeoPoint origin(0, 0);
+    GeoPoint destination(1000000, 0);
+    RouteInfo::Seconds slow = engine.calculate_travel_time_seconds(origin, destination, TransportProfileId("car"), RoutingStrategyId());
+
+    std::thread writer([&]
+                       {
+                           for (int i = 0; i < 1000; ++i)
+                           {
+                               engine.get_registry()->set_transport_profile(TransportProfileId("car"), TransportProfile(i % 2 == 0 ? 20 : 10));
+                           }
+                       });
+    for (int i = 0; i < 1000; ++i)
+    {
+        RouteInfo::Seconds time = engine.calculate_travel_time_seconds(origin, destination, TransportProfileId("car"), RoutingStrategyId());
+        EXPECT_TRUE(time == slow || time == slow / 2 || time == (slow + 1) / 2);
+    }
+    writer.join();
+}
+
+TEST(RoutingRegistryTest, ReloadsProvidersKeepingHandles)
+{
+    std::shared_ptr<BasicTransportProfileProvider> profiles = std::make_shared<BasicTransportProfileProvider>();
+    profiles->add_transport_profile(TransportProfileId("car"), TransportProfile(10));
+    profiles->add_transport_profile(TransportProfileId("bike"), TransportProfile(5));
+    RoutingRegistry registry(std::make_shared<BasicRoutingStrategyProvider>(), profiles);
+    RoutingRegistry::Handle car = registry.get_profile_handle(TransportProfileId("car"));
+    RoutingRegistry::Handle bike = registry.get_profile_handle(TransportProfileId("bike"));
+    RoutingRegistry::Handle crowflight = registry.get_strategy_handle(RoutingStrategyId(BasicRoutingStrategyProvider::CROWFLIGHT));
+    RoutingRegistry::Resolution in_flight = registry.resolve(bike, crowflight);
+
+    std::shared_ptr<BasicTransportProfileProvider> reloaded = std::make_shared<BasicTransportProfileProvider>();
+    reloaded->add_transport_profile(TransportProfileId("truck"), TransportProfile(8));
+    reloaded->add_transport_profile(TransportProfileId("car"), TransportProfile(12));
+    registry.reload(nullptr, reloaded);
+
+    EXPECT_EQ(registry.get_snapshot()->version, 1);
+    EXPECT_EQ(registry.get_snapshot()->available_profiles, std::vector<TransportProfileId>({TransportProfileId("truck"), TransportProfileId("car")}));
+    EXPECT_EQ(registry.get_profile_handle(TransportProfileId("car")), car);
+    EXPECT_EQ(registry.resolve(car, crowflight).profile(), TransportProfile(12));
+    EXPECT_EQ(registry.resolve(TransportProfileId("truck"), RoutingStrategyId()).profile(), TransportProfile(8));
+    EXPECT_THROW(registry.resolve(bike, crowflight), std::out_of_range);
+    EXPECT_THROW(registry.resolve(TransportProfileId("bike"), RoutingStrategyId()), std::invalid_argument);
+    EXPECT_EQ(in_flight.profile(), TransportProfile(5)) << "In-flight request keeps its snapshot";
+    EXPECT_EQ(registry.resolve(car, crowflight).strategy_ptr(), in_flight.strategy_ptr()) << "Strategies are kept when only profiles are reloaded";
+
+    reloaded->add_transport_profile(TransportProfileId("bike"), TransportProfile(6));
+    EXPECT_EQ(registry.get_profile_handle(TransportProfileId("bike")), bike) << "Id supported again gets its handle back";
+}
+
+TEST(RoutingRegistryTest, KeepsSnapshotsOfRegistriesApart)
+{
+    std::shared_ptr<BasicTransportProfileProvider> slow_profiles = std::make_shared<BasicTransportProfileProvider>();
+    slow_profiles->add_transport_profile(TransportProfileId("car"), TransportProfile(10));
+    std::shared_ptr<BasicTransportProfileProvider> fast_profiles = std::make_shared<BasicTransportProfileProvider>();
+    fast_profiles->add_transport_profile(TransportProfileId("car"), TransportProfile(20));
+
+    for (int i = 0; i < 3; ++i)
+    {
+        RoutingRegistry slow(std::make_shared<BasicRoutingStrategyProvider>(), slow_profiles);
+        RoutingRegistry fast(std::make_shared<BasicRoutingStrategyProvider>(), fast_profiles);
+        EXPECT_EQ(slow.resolve(TransportProfileId("car"), RoutingStrategyId()).profile(), TransportProfile(10));
+        EXPECT_EQ(fast.resolve(TransportProfileId("car"), RoutingStrategyId()).profile(), TransportProfile(20));
+
+        std::thread other([&]
+                          { fast.set_transport_profile(TransportProfileId("car"), TransportProfile(30)); });
+        other.join();
+        EXPECT_EQ(fast.resolve(TransportProfileId("car"), RoutingStrategyId()).profile(), TransportProfile(30)) << "Publish of other thread is seen";
+        EXPECT_EQ(slow.resolve(TransportProfileId("car"), RoutingStrategyId()).profile(), TransportProfile(10));
+    }
+}
+
+TEST(RoutingRegistryTest, InFlightRequestFinishesWithSwappedOutProviders)
+{
+    std::shared_ptr<BasicTransportProfileProvider> profiles = std::make_shared<BasicTransportProfileProvider>();
+    profiles->add_transport_profile(TransportProfileId("car"), TransportProfile(10));
+    std::shared_ptr<GatedCrowflightRoutingStrategy> gated = std::make_shared<GatedCrowflightRoutingStrategy>();
+    std::promise<void> release;
+    gated->released = release.get_future().share();
+    std::future<void> entered = gated->entered.get_future();
+    std::weak_ptr<RoutingStrategy> swapped_out = gated;
+    RouterEngine engine(std::make_shared<SingleRoutingStrategyProvider>(std::move(gated)), profiles);
+
+    GeoPoint origin(0, 0);
+    GeoPoint destination(1000000, 0);
+    std::future<RouteInfo::Seconds> in_flight = std::async(std::launch::async, [&]
+                                                           { return engine.calculate_travel_time_seconds(origin, destination, TransportProfileId("car"), RoutingStrategyId()); });
+    entered.wait();
+
+    std::shared_ptr<BasicTransportProfileProvider> faster_profiles = std::make_shared<BasicTransportProfileProvider>();
+    faster_profiles->add_transport_profile(TransportProfileId("car"), TransportProfile(20));
+    engine.get_registry()->reload(std::make_shared<SingleRoutingStrategyProvider>(std::make_shared<CrowflightRoutingStrategy>()), faster_profiles);
+    RouteInfo::Seconds fast = engine.calculate_travel_time_seconds(origin, destination, TransportProfileId("car"), RoutingStrategyId());
+    EXPECT_FALSE(swapped_out.expired()) << "Snapshot of in-flight request is kept alive";
+
+    release.set_value();
+    RouteInfo::Seconds slow = in_flight.get();
+    EXPECT_NEAR(slow, 2 * fast, 1) << "In-flight request finishes with the profile it resolved";
+    EXPECT_EQ(engine.calculate_travel_time_seconds(origin, destination, TransportProfileId("car"), RoutingStrategyId()), fast);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "assfire/router/engine/algorithms/CrowflightRoutingStrategy.hpp"
+
+namespace assfire::router::test
+{
+    /**
+     * \brief Crowflight strategy counting routes and matrices it calculates. Fails route calculations while failing is set
+     */
+    class CountingCrowflightRoutingStrategy : public CrowflightRoutingStrategy
+    {
+    public:
+        virtual RouteInfo calculate_route_info(const GeoPoint &origin, const GeoPoint &destination, const TransportProfile &profile) const override
+        {
+            if (failing)
+            {
+                throw std::runtime_error("Routing failed");
+            }
+            ++calls_count;
+            return CrowflightRoutingStrategy::calculate_route_info(origin, destination, profile);
+        }
+
+        virtual MatrixPtr calculate_route_matrix(WaypointsView origins, WaypointsView destinations, const TransportProfile &profile) const override
+        {
+            ++matrices_count;
+            return CrowflightRoutingStrategy::calculate_route_matrix(origins, destinations, profile);
+        }
+
+        mutable std::atomic<std::size_t> calls_count = 0;
+        mutable std::atomic<std::size_t> matrices_count = 0;
+        std::atomic<bool> failing = false;
+    };
+
+    /**
+     * \brief Generates reproducible random waypoints scattered over a city-sized area
+     */
+    inline std::vector<GeoPoint> make_random_waypoints(std::size_t count, unsigned seed)
+    {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<double> lat(55.5, 56.0);
+        std::uniform_real_distribution<double> lon(37.3, 38.0);
+        std::vector<GeoPoint> result;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            result.emplace_back(lat(random), lon(random));
+        }
+        return result;
+    }
+}
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include "assfire/router/engine/graph/RadixHeap.hpp"
+#include "assfire/router/engine/graph/SearchWorkspace.hpp"
+
+using namespace assfire::router;
+
+TEST(RadixHeapTest, PopsInKeyOrderWithMonotonePushes)
+{
+    RadixHeap<int> heap;
+    std::mt19937 random_engine(42);
+    std::vector<RadixHeap<int>::Key> popped;
+
+    for (int i = 0; i < 100; ++i)
+    {
+        heap.push(random_engine() % 1000, i);
+    }
+    while (!heap.empty())
+    {
+        auto [key, value] = heap.pop();
+        popped.push_back(key);
+        if (popped.size() < 500)
+        {
+            heap.push(key + random_engine() % 1000, 0); // Keys pushed during search are never less than the last popped one
+        }
+    }
+
+    EXPECT_TRUE(std::is_sorted(popped.begin(), popped.end()));
+    EXPECT_EQ(popped.size(), 100 + 499);
+}
+
+TEST(SearchWorkspaceTest, ResetForgetsPreviousSearch)
+{
+    SearchWorkspace &workspace = SearchWorkspace::acquire(10);
+    workspace.set_weight(3, 42, 2, 7);
+    EXPECT_TRUE(workspace.mark_target(5));
+    EXPECT_FALSE(workspace.mark_target(5));
+    EXPECT_EQ(workspace.get_weight(3), 42);
+    EXPECT_EQ(workspace.get_parent_node(3), 2);
+    EXPECT_EQ(workspace.get_parent_edge(3), 7);
+
+    SearchWorkspace &next_workspace = SearchWorkspace::acquire(20);
+    EXPECT_EQ(&next_workspace, &workspace);
+    EXPECT_EQ(next_workspace.get_weight(3), RoadGraph::INFINITE_WEIGHT);
+    EXPECT_EQ(next_workspace.get_parent_node(3), RoadGraph::NO_NODE);
+    EXPECT_FALSE(next_workspace.unmark_target(5));
+    EXPECT_EQ(next_workspace.get_weight(19), RoadGraph::INFINITE_WEIGHT);
+}
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include "assfire/router/engine/algorithms/CrowflightRoutingStrategy.hpp"
+#include "assfire/router/engine/matrix/SparseRouteMatrix.hpp"
+#include "assfire/router/engine/matrix/WaypointsGrid.hpp"
+#include "RoutingTestUtils.hpp"
+
+using namespace assfire::router;
+using namespace assfire::router::test;
+
+namespace
+{
+    /**
+     * Nearest waypoints by brute force, sorted by id
+     */
+    std::vector<RouteMatrix::GeopointId> find_nearest(const std::vector<GeoPoint> &waypoints, RouteMatrix::GeopointId origin, const SparseRouteMatrix::Bounds &bounds,
+                                                      const TransportProfile &profile)
+    {
+        std::vector<std::pair<RouteInfo::Seconds, RouteMatrix::GeopointId>> routes;
+        for (RouteMatrix::GeopointId destination = 0; destination < waypoints.size(); ++destination)
+        {
+            RouteInfo::Seconds time = CrowflightRoutingStrategy().calculate_travel_time_seconds(waypoints[origin], waypoints[destination], profile);
+            if (destination != origin && time <= bounds.max_travel_time_seconds)
+            {
+                routes.emplace_back(time, destination);
+            }
+        }
+        std::sort(routes.begin(), routes.end());
+        if (bounds.neighbours_count > 0 && routes.size() > bounds.neighbours_count)
+        {
+            routes.resize(bounds.neighbours_count);
+        }
+        std::vector<RouteMatrix::GeopointId> result = {origin};
+        for (const auto &route : routes)
+        {
+            result.push_back(route.second);
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+}
+
+TEST(WaypointsGridTest, RingBoundsDontExceedCrowflightDistances)
+{
+    std::vector<GeoPoint> waypoints = make_random_waypoints(500, 1);
+    WaypointsGrid grid(waypoints);
+    std::vector<GeoPoint> origins = {waypoints[0], waypoints[123], GeoPoint(54.0, 37.5), GeoPoint(55.7, 39.0)};
+    std::size_t collected_count = 0;
+    for (const GeoPoint &origin : origins)
+    {
+        collected_count = 0;
+        for (std::size_t ring = 0; ring < grid.get_rings_count(origin); ++ring)
+        {
+            std::vector<WaypointsGrid::WaypointId> ids;
+            grid.collect_ring(origin, ring, ids);
+            collected_count += ids.size();
+            for (WaypointsGrid::WaypointId id : ids)
+            {
+                RouteInfo::Meters distance = CrowflightRoutingStrategy().calculate_distance_meters(origin, waypoints[id], TransportProfile(10));
+                EXPECT_LE(grid.get_ring_lower_bound_meters(origin, ring), distance);
+                EXPECT_LE(WaypointsGrid::get_lower_bound_meters(origin, waypoints[id]), distance);
+            }
+        }
+        EXPECT_EQ(collected_count, waypoints.size()) << "Rings cover all waypoints exactly once";
+    }
+}
+
+TEST(SparseRouteMatrixTest, KeepsNearestNeighbours)
+{
+    std::vector<GeoPoint> waypoints = make_random_waypoints(400, 2);
+    TransportProfile profile(10);
+    CountingCrowflightRoutingStrategy strategy;
+    SparseRouteMatrix::Bounds bounds{5};
+    std::shared_ptr<SparseRouteMatrix> matrix = SparseRouteMatrix::calculate_nearest(strategy, profile, waypoints, bounds, nullptr);
+
+    ASSERT_EQ(matrix->get_origins_count(), waypoints.size());
+    EXPECT_EQ(matrix->get_routes_count(), waypoints.size() * 6);
+    EXPECT_LT(strategy.calls_count, waypoints.size() * waypoints.size() / 4) << "Far candidates are pruned by crowflight bounds";
+    for (RouteMatrix::GeopointId origin = 0; origin < waypoints.size(); origin += 7)
+    {
+        std::vector<RouteMatrix::GeopointId> expected = find_nearest(waypoints, origin, bounds, profile);
+        std::span<const RouteMatrix::GeopointId> row = matrix->get_row_destinations(origin);
+        EXPECT_EQ(std::vector<RouteMatrix::GeopointId>(row.begin(), row.end()), expected) << "Origin " << origin;
+        for (RouteMatrix::GeopointId destination : row)
+        {
+            EXPECT_EQ(matrix->get_route_info(origin, destination), CrowflightRoutingStrategy().calculate_route_info(waypoints[origin], waypoints[destination], profile));
+        }
+    }
+}
+
+TEST(SparseRouteMatrixTest, KeepsRoutesWithinTravelTime)
+{
+    std::vector<GeoPoint> waypoints = make_random_waypoints(300, 3);
+    TransportProfile profile(10);
+    SparseRouteMatrix::Bounds bounds{0, 400};
+    std::shared_ptr<SparseRouteMatrix> matrix = SparseRouteMatrix::calculate_nearest(CrowflightRoutingStrategy(), profile, waypoints, bounds, nullptr);
+    std::shared_ptr<SparseRouteMatrix> with_fallback = SparseRouteMatrix::calculate_nearest(CrowflightRoutingStrategy(), profile, waypoints, bounds,
+                                                                                            std::make_shared<CrowflightRoutingStrategy>());
+
+    for (RouteMatrix::GeopointId origin = 0; origin < waypoints.size(); origin += 5)
+    {
+        std::vector<RouteMatrix::GeopointId> expected = find_nearest(waypoints, origin, bounds, profile);
+        std::span<const RouteMatrix::GeopointId> row = matrix->get_row_destinations(origin);
+        EXPECT_EQ(std::vector<RouteMatrix::GeopointId>(row.begin(), row.end()), expected) << "Origin " << origin;
+
+        for (RouteMatrix::GeopointId destination = 0; destination < waypoints.size(); destination += 11)
+        {
+            RouteInfo route = CrowflightRoutingStrategy().calculate_route_info(waypoints[origin], waypoints[destination], profile);
+            EXPECT_EQ(with_fallback->get_route_info(origin, destination), route);
+            if (!matrix->contains(origin, destination))
+            {
+                EXPECT_GT(route.travel_time_seconds(), bounds.max_travel_time_seconds);
+                EXPECT_EQ(matrix->get_travel_time_seconds(origin, destination), RouteInfo::INFINITE_TRAVEL_TIME);
+            }
+        }
+    }
+    EXPECT_THROW(matrix->get_route_info(0, waypoints.size()), std::invalid_argument);
+}
+
+TEST(SparseRouteMatrixTest, CalculatesOnlyRoutesWithinBound)
+{
+    std::vector<GeoPoint> origins = make_random_waypoints(150, 4);
+    std::vector<GeoPoint> destinations = make_random_waypoints(250, 5);
+    TransportProfile profile(10);
+    CountingCrowflightRoutingStrategy strategy;
+    std::shared_ptr<SparseRouteMatrix> matrix = SparseRouteMatrix::calculate_bounded(strategy, profile, origins, destinations, 300);
+
+    EXPECT_LT(strategy.calls_count, origins.size() * destinations.size() / 4) << "Pairs farther than the bound are skipped";
+    for (RouteMatrix::GeopointId origin = 0; origin < origins.size(); ++origin)
+    {
+        for (RouteMatrix::GeopointId destination = 0; destination < destinations.size(); ++destination)
+        {
+            RouteInfo route = CrowflightRoutingStrategy().calculate_route_info(origins[origin], destinations[destination], profile);
+            if (route.travel_time_seconds() <= 300)
+            {
+                EXPECT_EQ(matrix->get_route_info(origin, destination), route);
+            }
+            else
+            {
+                EXPECT_EQ(matrix->get_travel_time_seconds(origin, destination), RouteInfo::INFINITE_TRAVEL_TIME);
+            }
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include "assfire/router/engine/matrix/TriangularRouteMatrix.hpp"
+#include "assfire/router/engine/algorithms/CrowflightRoutingStrategy.hpp"
+#include "assfire/router/engine/algorithms/InfinityRoutingStrategy.hpp"
+
+using namespace assfire::router;
+
+TEST(TriangularRouteMatrixTest, CalculatesOnlyUpperTriangle)
+{
+    int calls_count = 0;
+    TriangularRouteMatrix matrix(5, [&](std::size_t i, std::size_t j)
+                                 {
+                                     EXPECT_LE(i, j);
+                                     ++calls_count;
+                                     return RouteInfo(i * 10 + j, i * 10 + j); });
+
+    EXPECT_EQ(calls_count, 15);
+    for (RouteMatrix::GeopointId i = 0; i < 5; ++i)
+    {
+        for (RouteMatrix::GeopointId j = i; j < 5; ++j)
+        {
+            EXPECT_EQ(matrix.get_travel_time_seconds(i, j), i * 10 + j);
+            EXPECT_EQ(matrix.get_travel_time_seconds(j, i), i * 10 + j);
+        }
+    }
+    EXPECT_THROW(matrix.get_route_info(0, 5), std::invalid_argument);
+}
+
+TEST(TriangularRouteMatrixTest, CrowflightSquareMatrixIsSymmetric)
+{
+    CrowflightRoutingStrategy strategy;
+    TransportProfile profile(10);
+    std::vector<GeoPoint> waypoints{GeoPoint(55.75, 37.61), GeoPoint(59.93, 30.33), GeoPoint(56.32, 44.00), GeoPoint(55.79, 49.12)};
+
+    RoutingStrategy::MatrixPtr matrix = strategy.calculate_route_matrix(waypoints, profile);
+
+    ASSERT_NE(std::dynamic_pointer_cast<TriangularRouteMatrix>(matrix), nullptr);
+    for (RouteMatrix::GeopointId i = 0; i < waypoints.size(); ++i)
+    {
+        for (RouteMatrix::GeopointId j = 0; j < waypoints.size(); ++j)
+        {
+            RouteInfo expected = strategy.calculate_route_info(waypoints[i], waypoints[j], profile);
+            EXPECT_NEAR(matrix->get_distance_meters(i, j), expected.distance_meters(), 1e-3);
+            EXPECT_NEAR(matrix->get_travel_time_seconds(i, j), expected.travel_time_seconds(), 1);
+        }
+    }
+}
+
+TEST(TriangularRouteMatrixTest, InfinitySquareMatrixDiagonalMatchesStrategy)
+{
+    InfinityRoutingStrategy strategy;
+    TransportProfile profile(10);
+    std::vector<GeoPoint> waypoints{GeoPoint(55.75, 37.61), GeoPoint(59.93, 30.33), GeoPoint(56.32, 44.00)};
+
+    RoutingStrategy::MatrixPtr matrix = strategy.calculate_route_matrix(waypoints, profile);
+
+    for (RouteMatrix::GeopointId i = 0; i < waypoints.size(); ++i)
+    {
+        EXPECT_EQ(matrix->get_route_info(i, i), strategy.calculate_route_info(waypoints[i], waypoints[i], profile));
+        EXPECT_EQ(matrix->get_distance_meters(i, i), RouteInfo::INFINITE_DISTANCE);
+        EXPECT_EQ(matrix->get_travel_time_seconds(i, i), RouteInfo::INFINITE_TRAVEL_TIME);
+    }
+}
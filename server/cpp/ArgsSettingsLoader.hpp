@@ -1,12 +1,44 @@
 #pragma once
 
+#include <algorithm>
+#include <stdexcept>
+#include <string>
 #include "SettingsLoader.hpp"
 
 namespace assfire::router {
+    /**
+     * \brief Loads settings from command line arguments of form --name=value or --name value, where name is a setting name
+     * with dashes or underscores, e.g. --road-graph-path=/data/graph.bin
+     */
     class ArgsSettingsLoader : public SettingsLoader {
         public:
+            ArgsSettingsLoader(int argc, char **argv) : argc(argc), argv(argv) {}
+
             void load_settings(Settings& settings) override {
-                // [TODO]
+                for (int i = 1; i < argc; ++i) {
+                    std::string arg = argv[i];
+                    if (arg.rfind("--", 0) != 0) {
+                        throw std::invalid_argument("Unexpected argument: " + arg);
+                    }
+                    std::string name;
+                    std::string value;
+                    std::size_t separator = arg.find('=');
+                    if (separator != std::string::npos) {
+                        name = arg.substr(2, separator - 2);
+                        value = arg.substr(separator + 1);
+                    } else if (i + 1 < argc) {
+                        name = arg.substr(2);
+                        value = argv[++i];
+                    } else {
+                        throw std::invalid_argument("No value for argument: " + arg);
+                    }
+                    std::replace(name.begin(), name.end(), '-', '_');
+                    apply_setting(settings, name, value);
+                }
             };
+
+        private:
+            int argc;
+            char **argv;
     };
-}
\ No newline at end of file
+}
@@ -1,12 +1,22 @@
 #include "ConfigurationServiceImpl.hpp"
+#include "assfire/router/engine/BasicRoutingStrategyProvider.hpp"
+#include "assfire/router/engine/BasicTransportProfileProvider.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
 
 namespace assfire::router
 {
 
-    ConfigurationServiceImpl::ConfigurationServiceImpl(std::shared_ptr<RoutingStrategyProvider> routing_strategies_provider,
-                                                       std::shared_ptr<TransportProfileProvider> transport_profiles_provider)
-        : routing_strategies_provider(routing_strategies_provider),
-          transport_profiles_provider(transport_profiles_provider)
+    ConfigurationServiceImpl::ConfigurationServiceImpl(std::shared_ptr<RoutingRegistry> registry, std::string road_graph_path, std::string hub_labels_path,
+                                                       std::string reload_directory)
+        : registry(registry),
+          road_graph_path(std::move(road_graph_path)),
+          hub_labels_path(std::move(hub_labels_path)),
+          reload_directory(std::move(reload_directory))
     {
     }
 
@@ -14,7 +24,7 @@ namespace assfire::router
                                                                     const ::assfire::api::v1::router::GetAvailableStrategiesRequest *request,
                                                                     ::assfire::api::v1::router::GetAvailableStrategiesResponse *response)
     {
-        for (const RoutingStrategyId &strategy : routing_strategies_provider->get_available_strategies())
+        for (const RoutingStrategyId &strategy : registry->get_snapshot()->available_strategies)
         {
             response->add_strategies(strategy.value());
         }
@@ -26,7 +36,7 @@ namespace assfire::router
                                                                            const ::assfire::api::v1::router::GetAvailableTransportProfilesRequest *request,
                                                                            ::assfire::api::v1::router::GetAvailableTransportProfilesResponse *response)
     {
-        for (const TransportProfileId &profile : transport_profiles_provider->get_available_profiles())
+        for (const TransportProfileId &profile : registry->get_snapshot()->available_profiles)
         {
             response->add_transport_profiles(profile.value());
         }
@@ -34,4 +44,118 @@ namespace assfire::router
         return ::grpc::Status::OK;
     }
 
-}
\ No newline at end of file
+    ::grpc::Status ConfigurationServiceImpl::ReloadConfiguration(::grpc::ServerContext *context,
+                                                                 const ::assfire::api::v1::router::ReloadConfigurationRequest *request,
+                                                                 ::assfire::api::v1::router::ReloadConfigurationResponse *response)
+    {
+        if (request->road_graph_path().empty() && !request->hub_labels_path().empty())
+        {
+            return ::grpc::Status(::grpc::StatusCode::INVALID_ARGUMENT, "Hub labels can only be reloaded together with their road graph");
+        }
+        for (const auto &profile : request->transport_profiles())
+        {
+            if (profile.id().empty() || !(profile.speed_meters_per_second() > 0))
+            {
+                return ::grpc::Status(::grpc::StatusCode::INVALID_ARGUMENT, "Transport profile requires id and positive speed: " + profile.id());
+            }
+        }
+        // Request that changes only profiles keeps strategies with their warm caches, otherwise the graph is reloaded
+        bool reloads_strategies = !request->road_graph_path().empty() || (request->transport_profiles().empty() && !request->replace_transport_profiles());
+
+        std::lock_guard<std::mutex> lock(reload_mutex);
+        std::string new_road_graph_path = road_graph_path;
+        std::string new_hub_labels_path = hub_labels_path;
+        if (!request->road_graph_path().empty())
+        {
+            ::grpc::Status status = resolve_reload_path(request->road_graph_path(), new_road_graph_path);
+            if (!status.ok())
+            {
+                return status;
+            }
+            new_hub_labels_path.clear();
+            if (!request->hub_labels_path().empty())
+            {
+                status = resolve_reload_path(request->hub_labels_path(), new_hub_labels_path);
+                if (!status.ok())
+                {
+                    return status;
+                }
+            }
+        }
+        try
+        {
+            std::shared_ptr<BasicTransportProfileProvider> profile_provider;
+            if (request->replace_transport_profiles())
+            {
+                profile_provider = std::make_shared<BasicTransportProfileProvider>();
+                for (const auto &profile : request->transport_profiles())
+                {
+                    profile_provider->add_transport_profile(TransportProfileId(profile.id()), TransportProfile(profile.speed_meters_per_second(), profile.metric()));
+                }
+            }
+            // Graph is mapped and customized while requests are still served by the previous snapshot, replaced profiles are published with it
+            if (reloads_strategies || profile_provider)
+            {
+                registry->reload(reloads_strategies ? std::make_shared<BasicRoutingStrategyProvider>(new_road_graph_path, new_hub_labels_path) : nullptr,
+                                 profile_provider);
+            }
+            if (!profile_provider)
+            {
+                for (const auto &profile : request->transport_profiles())
+                {
+                    registry->set_transport_profile(TransportProfileId(profile.id()), TransportProfile(profile.speed_meters_per_second(), profile.metric()));
+                }
+            }
+        }
+        catch (const std::invalid_argument &e)
+        {
+            return ::grpc::Status(::grpc::StatusCode::INVALID_ARGUMENT, e.what());
+        }
+        catch (const std::exception &e)
+        {
+            return ::grpc::Status(::grpc::StatusCode::FAILED_PRECONDITION, e.what());
+        }
+        road_graph_path = std::move(new_road_graph_path);
+        hub_labels_path = std::move(new_hub_labels_path);
+
+        std::shared_ptr<const RoutingRegistry::Snapshot> snapshot = registry->get_snapshot();
+        for (const RoutingStrategyId &strategy : snapshot->available_strategies)
+        {
+            response->add_strategies(strategy.value());
+        }
+        for (const TransportProfileId &profile : snapshot->available_profiles)
+        {
+            response->add_transport_profiles(profile.value());
+        }
+        response->set_version(snapshot->version);
+        return ::grpc::Status::OK;
+    }
+
+    ::grpc::Status ConfigurationServiceImpl::resolve_reload_path(const std::string &requested_path, std::string &resolved_path) const
+    {
+        if (reload_directory.empty())
+        {
+            return ::grpc::Status(::grpc::StatusCode::PERMISSION_DENIED, "Reload directory is not configured, only current files can be reloaded");
+        }
+        // Paths are compared after resolving symlinks and dot segments, so requests can't reach files outside of reload directory through them
+        std::error_code error;
+        std::filesystem::path directory = std::filesystem::canonical(reload_directory, error);
+        if (error)
+        {
+            return ::grpc::Status(::grpc::StatusCode::FAILED_PRECONDITION, "Reload directory is not available: " + error.message());
+        }
+        std::filesystem::path path = std::filesystem::canonical(directory / requested_path, error);
+        if (error)
+        {
+            return ::grpc::Status(::grpc::StatusCode::NOT_FOUND, "File " + requested_path + " is not available: " + error.message());
+        }
+        auto [directory_end, path_iter] = std::mismatch(directory.begin(), directory.end(), path.begin(), path.end());
+        if (directory_end != directory.end() || path_iter == path.end())
+        {
+            return ::grpc::Status(::grpc::StatusCode::PERMISSION_DENIED, "File " + requested_path + " is outside of reload directory");
+        }
+        resolved_path = path.string();
+        return ::grpc::Status::OK;
+    }
+
+}
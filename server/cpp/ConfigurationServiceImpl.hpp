@@ -1,17 +1,26 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
+#include <string>
 #include "assfire/api/v1/router/router.grpc.pb.h"
-#include "assfire/router/engine/RoutingStrategyProvider.hpp"
-#include "assfire/router/engine/TransportProfileProvider.hpp"
+#include "assfire/router/engine/RoutingRegistry.hpp"
 
 namespace assfire::router
 {
     class ConfigurationServiceImpl : public assfire::api::v1::router::ConfigurationService::Service
     {
     public:
-        ConfigurationServiceImpl(std::shared_ptr<RoutingStrategyProvider> routing_strategies_provider,
-                                 std::shared_ptr<TransportProfileProvider> transport_profiles_provider);
+        /**
+         * \brief Construct a new ConfigurationServiceImpl object
+         *
+         * \param registry Registry router service resolves strategies and profiles with. Reloads publish new snapshots into it,
+         * in-flight requests finish with previous ones
+         * \param road_graph_path Path to road graph file strategies are currently provided for
+         * \param hub_labels_path Path to hub labels file of the road graph
+         * \param reload_directory Directory reloads may load new road graph and hub labels files from. If empty, reloads can only reload current files
+         */
+        ConfigurationServiceImpl(std::shared_ptr<RoutingRegistry> registry, std::string road_graph_path, std::string hub_labels_path, std::string reload_directory);
 
         virtual ::grpc::Status GetAvailableStrategies(::grpc::ServerContext *context,
                                                       const ::assfire::api::v1::router::GetAvailableStrategiesRequest *request,
@@ -19,9 +28,17 @@ namespace assfire::router
         virtual ::grpc::Status GetAvailableTransportProfiles(::grpc::ServerContext *context,
                                                              const ::assfire::api::v1::router::GetAvailableTransportProfilesRequest *request,
                                                              ::assfire::api::v1::router::GetAvailableTransportProfilesResponse *response) override;
+        virtual ::grpc::Status ReloadConfiguration(::grpc::ServerContext *context,
+                                                   const ::assfire::api::v1::router::ReloadConfigurationRequest *request,
+                                                   ::assfire::api::v1::router::ReloadConfigurationResponse *response) override;
 
     private:
-        std::shared_ptr<RoutingStrategyProvider> routing_strategies_provider;
-        std::shared_ptr<TransportProfileProvider> transport_profiles_provider;
+        ::grpc::Status resolve_reload_path(const std::string &requested_path, std::string &resolved_path) const;
+
+        std::shared_ptr<RoutingRegistry> registry;
+        std::mutex reload_mutex; // Graphs are loaded by one reload at a time
+        std::string road_graph_path;
+        std::string hub_labels_path;
+        std::string reload_directory;
     };
-}
\ No newline at end of file
+}
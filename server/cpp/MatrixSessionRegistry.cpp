@@ -0,0 +1,239 @@
+#include "MatrixSessionRegistry.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+namespace assfire::router
+{
+    MatrixSession::MatrixSession(RouterEngine::ExtendableMatrixPtr matrix) : _matrix(std::move(matrix)),
+                                                                             _revision(0),
+                                                                             retained_removed_ids_count(0),
+                                                                             _memory_usage_bytes(0),
+                                                                             _last_access(std::chrono::steady_clock::now())
+    {
+        GeopointIds ids = _matrix->get_waypoint_ids();
+        history.push_back(RevisionRecord{ids.empty() ? 0 : ids.back() + 1, {}});
+        update_memory_usage();
+    }
+
+    void MatrixSession::record_extension(const GeopointIds &added_ids)
+    {
+        RouteMatrix::GeopointId watermark = history.back().ids_watermark;
+        for (RouteMatrix::GeopointId id : added_ids)
+        {
+            watermark = std::max(watermark, id + 1);
+        }
+        record_revision(watermark, {});
+    }
+
+    void MatrixSession::record_removal(const GeopointIds &removed_ids)
+    {
+        record_revision(history.back().ids_watermark, removed_ids);
+    }
+
+    void MatrixSession::record_revision(RouteMatrix::GeopointId ids_watermark, GeopointIds removed_ids)
+    {
+        ++_revision;
+        retained_removed_ids_count += removed_ids.size();
+        history.push_back(RevisionRecord{ids_watermark, std::move(removed_ids)});
+        while (history.size() > 1 && (history.size() > MAX_RETAINED_REVISIONS || retained_removed_ids_count > MAX_RETAINED_REMOVED_IDS))
+        {
+            retained_removed_ids_count -= history.front().removed_ids.size();
+            history.pop_front();
+        }
+        _planes.reset();
+        update_memory_usage();
+    }
+
+    void MatrixSession::update_memory_usage()
+    {
+        _memory_usage_bytes = _matrix->get_memory_usage_bytes() +
+                              (_planes ? _planes->get_memory_usage_bytes() : 0) +
+                              history.size() * sizeof(RevisionRecord) + retained_removed_ids_count * sizeof(RouteMatrix::GeopointId);
+    }
+
+    std::shared_ptr<const RouteMatrixPlanes> MatrixSession::planes()
+    {
+        if (!_planes)
+        {
+            GeopointIds ids = _matrix->get_waypoint_ids();
+            _planes = std::make_shared<const RouteMatrixPlanes>(*_matrix, ids);
+        }
+        update_memory_usage();
+        return _planes;
+    }
+
+    MatrixSession::Changes MatrixSession::get_changes_since(Revision since_revision) const
+    {
+        Changes result;
+        since_revision = std::min(since_revision, revision());
+        if (since_revision >= 0 && since_revision < oldest_retained_revision())
+        {
+            throw std::out_of_range("Matrix session revision " + std::to_string(since_revision) + " is not retained anymore");
+        }
+
+        RouteMatrix::GeopointId watermark = since_revision < 0 ? 0 : history[since_revision - oldest_retained_revision()].ids_watermark;
+        for (RouteMatrix::GeopointId id : _matrix->get_waypoint_ids())
+        {
+            if (id >= watermark)
+            {
+                result.added_ids.push_back(id);
+            }
+        }
+
+        if (since_revision < 0)
+        {
+            return result; // Client knows no waypoints to remove
+        }
+        for (Revision r = since_revision + 1; r <= revision(); ++r)
+        {
+            for (RouteMatrix::GeopointId id : history[r - oldest_retained_revision()].removed_ids)
+            {
+                if (id < watermark) // Waypoints added and removed after known revision were never seen by the client
+                {
+                    result.removed_ids.push_back(id);
+                }
+            }
+        }
+
+        return result;
+    }
+
+    MatrixSessionRegistry::MatrixSessionRegistry(std::chrono::milliseconds ttl, std::size_t memory_limit_bytes, std::chrono::milliseconds sweep_interval)
+        : ttl(ttl),
+          memory_limit_bytes(memory_limit_bytes),
+          sweep_interval(sweep_interval),
+          stopping(false),
+          sweeper([this] { sweep_periodically(); })
+    {
+    }
+
+    MatrixSessionRegistry::~MatrixSessionRegistry()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        sweep_condition.notify_all();
+        sweeper.join();
+    }
+
+    std::string MatrixSessionRegistry::add_session(SessionPtr session)
+    {
+        std::string id;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            do
+            {
+                id = generate_id();
+            } while (entry_by_id.contains(id));
+            entries.push_front(Entry{id, std::move(session)});
+            entry_by_id.emplace(id, entries.begin());
+        }
+        enforce_limits();
+        return id;
+    }
+
+    MatrixSessionRegistry::SessionPtr MatrixSessionRegistry::get_session(const std::string &id)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto iter = entry_by_id.find(id);
+        if (iter == entry_by_id.end())
+        {
+            return nullptr;
+        }
+
+        Entries::iterator entry = iter->second;
+        if (is_expired(*entry->session, std::chrono::steady_clock::now()))
+        {
+            entries.erase(entry);
+            entry_by_id.erase(iter);
+            return nullptr;
+        }
+
+        entry->session->touch();
+        entries.splice(entries.begin(), entries, entry);
+        return entry->session;
+    }
+
+    bool MatrixSessionRegistry::remove_session(const std::string &id)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto iter = entry_by_id.find(id);
+        if (iter == entry_by_id.end())
+        {
+            return false;
+        }
+        entries.erase(iter->second);
+        entry_by_id.erase(iter);
+        return true;
+    }
+
+    void MatrixSessionRegistry::enforce_limits()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        enforce_limits_locked();
+    }
+
+    std::size_t MatrixSessionRegistry::size()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return entries.size();
+    }
+
+    void MatrixSessionRegistry::sweep_periodically()
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        while (!sweep_condition.wait_for(guard, sweep_interval, [this] { return stopping; }))
+        {
+            enforce_limits_locked();
+        }
+    }
+
+    void MatrixSessionRegistry::enforce_limits_locked()
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+        std::size_t total_memory_usage_bytes = 0;
+        for (Entries::iterator iter = entries.begin(); iter != entries.end();)
+        {
+            if (is_expired(*iter->session, now))
+            {
+                entry_by_id.erase(iter->id);
+                iter = entries.erase(iter);
+            }
+            else
+            {
+                total_memory_usage_bytes += iter->session->memory_usage_bytes();
+                ++iter;
+            }
+        }
+
+        // The most recently used session is kept even if it alone exceeds the limit
+        while (total_memory_usage_bytes > memory_limit_bytes && entries.size() > 1)
+        {
+            total_memory_usage_bytes -= entries.back().session->memory_usage_bytes();
+            entry_by_id.erase(entries.back().id);
+            entries.pop_back();
+        }
+    }
+
+    std::string MatrixSessionRegistry::generate_id()
+    {
+        // 128 bits drawn directly from the CSPRNG, so observed ids tell nothing about other ones
+        char buffer[33];
+        std::snprintf(buffer, sizeof(buffer), "%08x%08x%08x%08x",
+                      static_cast<unsigned int>(random_source()),
+                      static_cast<unsigned int>(random_source()),
+                      static_cast<unsigned int>(random_source()),
+                      static_cast<unsigned int>(random_source()));
+        return buffer;
+    }
+
+    bool MatrixSessionRegistry::is_expired(const MatrixSession &session, std::chrono::steady_clock::time_point now) const
+    {
+        return now - session.last_access() > ttl;
+    }
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "assfire/router/engine/RouterEngine.hpp"
+
+namespace assfire::router
+{
+    /**
+     * \brief Server-side route matrix that is kept between requests. Access to the matrix and modification history must be guarded by the session lock
+     *
+     * \details Every modification of the matrix increments session revision. Clients that know matrix state at some revision may request only
+     * changes made after it: ids of added and removed waypoints. Since ids are assigned in ascending order, added waypoints are exactly the ones
+     * with ids not less than the ids watermark of the known revision. Only history of the latest revisions is retained, so long-lived sessions
+     * don't grow with churn: clients that know older revisions have to fetch the whole matrix again
+     */
+    class MatrixSession
+    {
+    public:
+        using Revision = std::int64_t;
+        using GeopointIds = RouterEngine::GeopointIds;
+
+        static constexpr std::size_t MAX_RETAINED_REVISIONS = 1024;
+        static constexpr std::size_t MAX_RETAINED_REMOVED_IDS = std::size_t(1) << 20; // Older revisions are dropped earlier if they removed too many waypoints
+
+        struct Changes
+        {
+            GeopointIds added_ids;
+            GeopointIds removed_ids;
+        };
+
+        MatrixSession(RouterEngine::ExtendableMatrixPtr matrix);
+
+        std::mutex &lock()
+        {
+            return _lock;
+        }
+
+        ExtendableRouteMatrix &matrix()
+        {
+            return *_matrix;
+        }
+
+        Revision revision() const
+        {
+            return _revision;
+        }
+
+        /**
+         * \brief Returns the oldest revision changes may be collected since
+         */
+        Revision oldest_retained_revision() const
+        {
+            return _revision - Revision(history.size()) + 1;
+        }
+
+        void record_extension(const GeopointIds &added_ids);
+        void record_removal(const GeopointIds &removed_ids);
+
+        /**
+         * \brief Returns compact copy of the matrix for evaluating tours. Copy is made on first call after each modification and is shared
+         * by calls until the next one, so it may be used after the session lock is released
+         */
+        std::shared_ptr<const RouteMatrixPlanes> planes();
+
+        bool has_planes() const
+        {
+            return _planes != nullptr;
+        }
+
+        /**
+         * \brief Collects changes made after specified revision. Only waypoints that are still present are reported as added.
+         * Negative revision means that nothing is known, so all present waypoints are reported. Throws std::out_of_range for non-negative revisions
+         * older than the oldest retained one
+         */
+        Changes get_changes_since(Revision revision) const;
+
+        std::size_t memory_usage_bytes() const
+        {
+            return _memory_usage_bytes;
+        }
+
+        std::chrono::steady_clock::time_point last_access() const
+        {
+            return _last_access;
+        }
+
+        void touch()
+        {
+            _last_access = std::chrono::steady_clock::now();
+        }
+
+    private:
+        struct RevisionRecord
+        {
+            RouteMatrix::GeopointId ids_watermark;
+            GeopointIds removed_ids;
+        };
+
+        void record_revision(RouteMatrix::GeopointId ids_watermark, GeopointIds removed_ids);
+        void update_memory_usage();
+
+        std::mutex _lock;
+        RouterEngine::ExtendableMatrixPtr _matrix;
+        Revision _revision;
+        std::deque<RevisionRecord> history; // From the oldest retained revision to the current one
+        std::size_t retained_removed_ids_count;
+        std::shared_ptr<const RouteMatrixPlanes> _planes; // Dropped by modifications
+        std::atomic<std::size_t> _memory_usage_bytes;
+        std::atomic<std::chrono::steady_clock::time_point> _last_access;
+    };
+
+    /**
+     * \brief Keeps matrix sessions under randomly generated ids. Sessions not accessed during ttl are expired and least recently used sessions are
+     * evicted when total memory used by sessions exceeds configured limit. Limits are enforced when sessions grow and by a background sweep, so
+     * memory of idle sessions is released even if no requests come
+     */
+    class MatrixSessionRegistry
+    {
+    public:
+        using SessionPtr = std::shared_ptr<MatrixSession>;
+
+        static constexpr std::chrono::seconds DEFAULT_TTL = std::chrono::minutes(10);
+        static constexpr std::size_t DEFAULT_MEMORY_LIMIT_BYTES = std::size_t(1) << 30;
+        static constexpr std::chrono::seconds DEFAULT_SWEEP_INTERVAL = std::chrono::minutes(1);
+
+        MatrixSessionRegistry(std::chrono::milliseconds ttl = DEFAULT_TTL, std::size_t memory_limit_bytes = DEFAULT_MEMORY_LIMIT_BYTES,
+                              std::chrono::milliseconds sweep_interval = DEFAULT_SWEEP_INTERVAL);
+        ~MatrixSessionRegistry();
+
+        MatrixSessionRegistry(const MatrixSessionRegistry &rhs) = delete;
+        MatrixSessionRegistry &operator=(const MatrixSessionRegistry &rhs) = delete;
+
+        std::string add_session(SessionPtr session);
+
+        /**
+         * \brief Returns session associated with specified id or nullptr if there is no such session or it is expired. Prolongs session lifetime
+         */
+        SessionPtr get_session(const std::string &id);
+
+        bool remove_session(const std::string &id);
+
+        /**
+         * \brief Drops expired sessions and evicts least recently used ones until total memory usage fits the limit
+         */
+        void enforce_limits();
+
+        std::size_t size();
+
+    private:
+        struct Entry
+        {
+            std::string id;
+            SessionPtr session;
+        };
+        using Entries = std::list<Entry>;
+
+        std::string generate_id();
+        bool is_expired(const MatrixSession &session, std::chrono::steady_clock::time_point now) const;
+        void enforce_limits_locked();
+        void sweep_periodically();
+
+        std::chrono::milliseconds ttl;
+        std::size_t memory_limit_bytes;
+        std::chrono::milliseconds sweep_interval;
+
+        std::mutex lock;
+        Entries entries; // Most recently used first
+        std::unordered_map<std::string, Entries::iterator> entry_by_id;
+        std::random_device random_source; // Operating system CSPRNG, ids are the only capability protecting sessions so they must not be predictable
+        std::condition_variable sweep_condition;
+        bool stopping;
+        std::thread sweeper; // Started last, when the rest of the registry is constructed
+    };
+}
@@ -1,12 +1,30 @@
 #pragma once
 
+#include <cctype>
+#include <cstdlib>
+#include <string>
 #include "SettingsLoader.hpp"
 
 namespace assfire::router {
+    /**
+     * \brief Loads settings from environment properties named after settings with ASSFIRE_ROUTER_ prefix in upper case,
+     * e.g. ASSFIRE_ROUTER_ROAD_GRAPH_PATH. Properties that are not set keep current values
+     */
     class PropsSettingsLoader : public SettingsLoader {
         public:
+            static constexpr const char *PREFIX = "ASSFIRE_ROUTER_";
+
             void load_settings(Settings& settings) override {
-                // [TODO]
+                for (const char *name : {"bind_address", "bind_port", "log_level", "matrix_session_ttl_seconds", "matrix_sessions_memory_limit_bytes",
+                                         "road_graph_path", "hub_labels_path", "reload_directory"}) {
+                    std::string property = PREFIX;
+                    for (const char *c = name; *c; ++c) {
+                        property.push_back(std::toupper(static_cast<unsigned char>(*c)));
+                    }
+                    if (const char *value = std::getenv(property.c_str())) {
+                        apply_setting(settings, name, value);
+                    }
+                }
             };
     };
-}
\ No newline at end of file
+}
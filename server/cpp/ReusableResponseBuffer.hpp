@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <google/protobuf/arena.h>
+
+namespace assfire::router
+{
+    /**
+     * \brief Arena backed storage for a response message that is written many times during a single streaming call.
+     *
+     * \details Arena starts with a preallocated block big enough for a typical response, so filling the first response doesn't hit the allocator.
+     * Response message is reused between writes: repeated fields keep their elements, so subsequent writes only overwrite values.
+     * Buffer is intended to be kept per worker thread - acquire() resets the arena, invalidating previously acquired response
+     */
+    template <typename Response>
+    class ReusableResponseBuffer
+    {
+    public:
+        ReusableResponseBuffer(std::size_t initial_block_size) : initial_block(new char[initial_block_size]),
+                                                                 arena(make_options(initial_block.get(), initial_block_size))
+        {
+        }
+
+        ReusableResponseBuffer(const ReusableResponseBuffer &rhs) = delete;
+        ReusableResponseBuffer &operator=(const ReusableResponseBuffer &rhs) = delete;
+
+        Response &acquire()
+        {
+            arena.Reset();
+            response = google::protobuf::Arena::CreateMessage<Response>(&arena);
+            return *response;
+        }
+
+    private:
+        static google::protobuf::ArenaOptions make_options(char *initial_block, std::size_t initial_block_size)
+        {
+            google::protobuf::ArenaOptions options;
+            options.initial_block = initial_block;
+            options.initial_block_size = initial_block_size;
+            return options;
+        }
+
+        std::unique_ptr<char[]> initial_block;
+        google::protobuf::Arena arena;
+        Response *response = nullptr;
+    };
+
+    /**
+     * \brief Sets count of elements in repeated message field reusing already allocated elements
+     */
+    template <typename RepeatedField>
+    void resize_repeated_field(RepeatedField *field, int size)
+    {
+        while (field->size() > size)
+        {
+            field->RemoveLast();
+        }
+        while (field->size() < size)
+        {
+            field->Add();
+        }
+    }
+}
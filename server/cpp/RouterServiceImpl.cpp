@@ -1,13 +1,128 @@
 #include "RouterServiceImpl.hpp"
 
 #include "assfire/router/api/proto/ProtoSerialization.hpp"
+#include "ReusableResponseBuffer.hpp"
+#include "assfire/router/engine/common/RouteTotal.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
 
 namespace assfire::router
 {
+    namespace
+    {
+        const int BATCH_SIZE = 10;
+
+        // Sparse matrix responses are flushed once they have this many routes, rows are never split between responses
+        const std::size_t SPARSE_MATRIX_RESPONSE_ROUTES = 1 << 16;
+
+        // Full tile of indexed route infos with nested route infos plus arena bookkeeping overhead
+        const std::size_t BATCH_RESPONSE_BLOCK_SIZE = BATCH_SIZE * BATCH_SIZE *
+                                                          (sizeof(assfire::api::v1::router::IndexedRouteInfo) + sizeof(assfire::api::v1::router::RouteInfo)) * 2 +
+                                                      4096;
+
+        /**
+         * Returns response message of the current worker thread to be reused for all tiles of a single call
+         */
+        assfire::api::v1::router::GetRoutesBatchResponse &acquire_batch_response()
+        {
+            thread_local ReusableResponseBuffer<assfire::api::v1::router::GetRoutesBatchResponse> buffer(BATCH_RESPONSE_BLOCK_SIZE);
+            return buffer.acquire();
+        }
+
+        /**
+         * Visits rows and columns of newly added waypoints. Ids are assigned in ascending order so every id below the first new one is an old one
+         */
+        template <typename Consumer>
+        void for_each_new_cell(const ExtendableRouteMatrix &matrix, const RouterEngine::GeopointIds &new_ids, Consumer consume)
+        {
+            if (new_ids.empty())
+            {
+                return;
+            }
+
+            RouterEngine::GeopointIds all_ids = matrix.get_waypoint_ids();
+            for (RouteMatrix::GeopointId origin : new_ids)
+            {
+                for (RouteMatrix::GeopointId destination : all_ids)
+                {
+                    consume(origin, destination);
+                }
+            }
+            for (RouteMatrix::GeopointId origin : all_ids)
+            {
+                if (origin >= new_ids.front())
+                {
+                    break;
+                }
+                for (RouteMatrix::GeopointId destination : new_ids)
+                {
+                    consume(origin, destination);
+                }
+            }
+        }
+
+        void add_route_info(const RouteMatrix &matrix, RouteMatrix::GeopointId origin, RouteMatrix::GeopointId destination,
+                            assfire::api::v1::router::IndexedRouteInfo *route_info)
+        {
+            route_info->set_origin_id(origin);
+            route_info->set_destination_id(destination);
+            route_info->set_departure_index(0); // Batch responses are reused, so cells may keep departure index of a previous call
+            to_proto(matrix.get_route_info(origin, destination), route_info->mutable_route_info());
+        }
+
+        template <typename Response>
+        void write_new_route_infos(const ExtendableRouteMatrix &matrix, const RouterEngine::GeopointIds &new_ids, Response *response)
+        {
+            for_each_new_cell(matrix, new_ids, [&](RouteMatrix::GeopointId origin, RouteMatrix::GeopointId destination)
+                              { add_route_info(matrix, origin, destination, response->add_route_infos()); });
+        }
+
+        RouterEngine::GeopointIds resolve_session_ids(const ExtendableRouteMatrix &matrix, const google::protobuf::RepeatedField<std::int32_t> &ids)
+        {
+            if (ids.empty())
+            {
+                return matrix.get_waypoint_ids();
+            }
+            RouterEngine::GeopointIds result(ids.begin(), ids.end());
+            for (RouteMatrix::GeopointId id : result)
+            {
+                if (!matrix.contains(id))
+                {
+                    throw std::invalid_argument("Invalid geopoint id: " + std::to_string(id));
+                }
+            }
+            return result;
+        }
+
+        std::vector<GeoPoint> parse_waypoints(const google::protobuf::RepeatedPtrField<assfire::api::v1::router::GeoPoint> &waypoints)
+        {
+            std::vector<GeoPoint> result;
+            parse_geo_points(waypoints, result);
+            return result;
+        }
+
+        /**
+         * Zero departure time of requests means no departure time, so routing is time-independent
+         */
+        std::optional<TransportProfile::Timestamp> parse_departure_time(std::int64_t departure_time)
+        {
+            return departure_time != 0 ? std::optional<TransportProfile::Timestamp>(departure_time) : std::nullopt;
+        }
+    }
+
     RouterServiceImpl::RouterServiceImpl(std::unique_ptr<RouterEngine> engine) : engine(std::move(engine))
     {
     }
 
+    RouterServiceImpl::RouterServiceImpl(std::unique_ptr<RouterEngine> engine,
+                                         std::chrono::seconds matrix_session_ttl,
+                                         std::size_t matrix_sessions_memory_limit_bytes) : engine(std::move(engine)),
+                                                                                           matrix_sessions(matrix_session_ttl, matrix_sessions_memory_limit_bytes)
+    {
+    }
+
     grpc::Status RouterServiceImpl::GetRoutesBatch(::grpc::ServerContext *context,
                                                    const ::assfire::api::v1::router::GetRoutesBatchRequest *request,
                                                    ::grpc::ServerWriter<::assfire::api::v1::router::GetRoutesBatchResponse> *writer)
@@ -21,45 +136,224 @@ namespace assfire::router
         }
         */
 
+        if (request->max_travel_time_seconds() < 0)
+        {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Max travel time must not be negative");
+        }
+        if (!request->session_id().empty())
+        {
+            if (!request->departure_times().empty() || request->max_travel_time_seconds() > 0)
+            {
+                return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Matrix sessions don't support departure times and max travel time");
+            }
+            return get_session_routes_batch(request, writer);
+        }
+        if (!request->departure_times().empty())
+        {
+            if (request->max_travel_time_seconds() > 0)
+            {
+                return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Max travel time is not supported with departure times");
+            }
+            return get_departure_routes_batch(request, writer);
+        }
+        if (request->max_travel_time_seconds() > 0)
+        {
+            return get_bounded_routes_batch(request, writer);
+        }
+
         TransportProfileId transport_profile(request->transport_profile());
         RoutingStrategyId routing_strategy(request->routing_strategy());
 
-        const int BATCH_SIZE = 10;
-
+        // Points are parsed only once, tiles are calculated over views of the parsed buffers
         std::vector<GeoPoint> origins;
         std::vector<GeoPoint> destinations;
+        parse_geo_points(request->origins(), origins);
+        parse_geo_points(request->destinations(), destinations);
+        RouterEngine::WaypointsView origins_view(origins);
+        RouterEngine::WaypointsView destinations_view(destinations);
+
+        assfire::api::v1::router::GetRoutesBatchResponse &response = acquire_batch_response();
         for (int i = 0; i < request->origins().size(); i += BATCH_SIZE)
         {
             for (int j = 0; j < request->destinations().size(); j += BATCH_SIZE)
             {
+                RouterEngine::MatrixPtr matrix = engine->calculate_route_matrix(origins_view.subspan(i, std::min<std::size_t>(BATCH_SIZE, origins.size() - i)),
+                                                                                destinations_view.subspan(j, std::min<std::size_t>(BATCH_SIZE, destinations.size() - j)),
+                                                                                transport_profile, routing_strategy);
 
-                for (int ii = i; ii < request->origins().size() && ii < i + BATCH_SIZE; ++ii)
-                {
-                    origins.emplace_back(parse_geo_point(request->origins()[ii]));
-                }
-                for (int jj = j; jj < request->destinations().size() && jj < j + BATCH_SIZE; ++jj)
-                {
-                    destinations.emplace_back(parse_geo_point(request->destinations()[jj]));
-                }
-
-                RouterEngine::MatrixPtr matrix = engine->calculate_route_matrix(origins, destinations, transport_profile, routing_strategy);
+                int tile_origins_count = std::min<int>(BATCH_SIZE, origins.size() - i);
+                int tile_destinations_count = std::min<int>(BATCH_SIZE, destinations.size() - j);
+                resize_repeated_field(response.mutable_route_infos(), tile_origins_count * tile_destinations_count);
 
-                assfire::api::v1::router::GetRoutesBatchResponse response;
+                int cell = 0;
                 for (int ii = i; ii < request->origins().size() && ii < i + BATCH_SIZE; ++ii)
                 {
                     for (int jj = j; jj < request->destinations().size() && jj < j + BATCH_SIZE; ++jj)
                     {
                         RouteInfo route = matrix->get_route_info(ii - i, jj - j);
-                        assfire::api::v1::router::IndexedRouteInfo *route_info = response.add_route_infos();
+                        assfire::api::v1::router::IndexedRouteInfo *route_info = response.mutable_route_infos(cell++);
                         route_info->set_origin_id(ii);
                         route_info->set_destination_id(jj);
+                        route_info->set_departure_index(0);
                         to_proto(route, route_info->mutable_route_info());
                     }
                 }
                 writer->Write(response); // [TODO] writeLast?
+            }
+        }
+
+        return grpc::Status::OK;
+    }
+
+    grpc::Status RouterServiceImpl::get_departure_routes_batch(const ::assfire::api::v1::router::GetRoutesBatchRequest *request,
+                                                               ::grpc::ServerWriter<::assfire::api::v1::router::GetRoutesBatchResponse> *writer)
+    {
+        TransportProfileId transport_profile(request->transport_profile());
+        RoutingStrategyId routing_strategy(request->routing_strategy());
+        std::vector<TransportProfile::Timestamp> departure_times(request->departure_times().begin(), request->departure_times().end());
+
+        std::vector<GeoPoint> origins;
+        std::vector<GeoPoint> destinations;
+        parse_geo_points(request->origins(), origins);
+        parse_geo_points(request->destinations(), destinations);
+        RouterEngine::WaypointsView origins_view(origins);
+        RouterEngine::WaypointsView destinations_view(destinations);
+
+        // Each tile is calculated for all departure times at once and written as a separate response per departure time
+        assfire::api::v1::router::GetRoutesBatchResponse &response = acquire_batch_response();
+        for (int i = 0; i < request->origins().size(); i += BATCH_SIZE)
+        {
+            for (int j = 0; j < request->destinations().size(); j += BATCH_SIZE)
+            {
+                int tile_origins_count = std::min<int>(BATCH_SIZE, origins.size() - i);
+                int tile_destinations_count = std::min<int>(BATCH_SIZE, destinations.size() - j);
+
+                std::vector<RouterEngine::MatrixPtr> matrices;
+                try
+                {
+                    matrices = engine->calculate_route_matrices(origins_view.subspan(i, tile_origins_count), destinations_view.subspan(j, tile_destinations_count),
+                                                                departure_times, transport_profile, routing_strategy);
+                }
+                catch (const std::invalid_argument &e)
+                {
+                    return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+                }
+
+                for (int slice = 0; slice < matrices.size(); ++slice)
+                {
+                    resize_repeated_field(response.mutable_route_infos(), tile_origins_count * tile_destinations_count);
+                    int cell = 0;
+                    for (int ii = i; ii < i + tile_origins_count; ++ii)
+                    {
+                        for (int jj = j; jj < j + tile_destinations_count; ++jj)
+                        {
+                            assfire::api::v1::router::IndexedRouteInfo *route_info = response.mutable_route_infos(cell++);
+                            route_info->set_origin_id(ii);
+                            route_info->set_destination_id(jj);
+                            route_info->set_departure_index(slice);
+                            to_proto(matrices[slice]->get_route_info(ii - i, jj - j), route_info->mutable_route_info());
+                        }
+                    }
+                    writer->Write(response);
+                }
+            }
+        }
+
+        return grpc::Status::OK;
+    }
+
+    grpc::Status RouterServiceImpl::get_bounded_routes_batch(const ::assfire::api::v1::router::GetRoutesBatchRequest *request,
+                                                             ::grpc::ServerWriter<::assfire::api::v1::router::GetRoutesBatchResponse> *writer)
+    {
+        std::vector<GeoPoint> origins;
+        std::vector<GeoPoint> destinations;
+        parse_geo_points(request->origins(), origins);
+        parse_geo_points(request->destinations(), destinations);
+
+        // Bounded matrix is calculated at once, so far apart pairs are skipped for all origins, then it is written by the same tiles as dense matrices
+        RouterEngine::SparseMatrixPtr matrix;
+        try
+        {
+            matrix = engine->calculate_bounded_route_matrix(origins, destinations, request->max_travel_time_seconds(),
+                                                            TransportProfileId(request->transport_profile()), RoutingStrategyId(request->routing_strategy()));
+        }
+        catch (const std::invalid_argument &e)
+        {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+        }
+
+        assfire::api::v1::router::GetRoutesBatchResponse &response = acquire_batch_response();
+        for (int i = 0; i < origins.size(); i += BATCH_SIZE)
+        {
+            for (int j = 0; j < destinations.size(); j += BATCH_SIZE)
+            {
+                int tile_origins_count = std::min<int>(BATCH_SIZE, origins.size() - i);
+                int tile_destinations_count = std::min<int>(BATCH_SIZE, destinations.size() - j);
+                resize_repeated_field(response.mutable_route_infos(), tile_origins_count * tile_destinations_count);
+
+                int cell = 0;
+                for (int ii = i; ii < i + tile_origins_count; ++ii)
+                {
+                    for (int jj = j; jj < j + tile_destinations_count; ++jj)
+                    {
+                        add_route_info(*matrix, ii, jj, response.mutable_route_infos(cell++));
+                    }
+                }
+                writer->Write(response);
+            }
+        }
+
+        return grpc::Status::OK;
+    }
+
+    grpc::Status RouterServiceImpl::get_session_routes_batch(const ::assfire::api::v1::router::GetRoutesBatchRequest *request,
+                                                             ::grpc::ServerWriter<::assfire::api::v1::router::GetRoutesBatchResponse> *writer)
+    {
+        MatrixSessionRegistry::SessionPtr session = matrix_sessions.get_session(request->session_id());
+        if (!session)
+        {
+            return grpc::Status(grpc::StatusCode::NOT_FOUND, "Unknown matrix session: " + request->session_id());
+        }
+
+        RouterEngine::GeopointIds origin_ids;
+        RouterEngine::GeopointIds destination_ids;
+        try
+        {
+            std::lock_guard<std::mutex> guard(session->lock());
+            origin_ids = resolve_session_ids(session->matrix(), request->origin_ids());
+            destination_ids = resolve_session_ids(session->matrix(), request->destination_ids());
+        }
+        catch (const std::invalid_argument &e)
+        {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+        }
+
+        assfire::api::v1::router::GetRoutesBatchResponse &response = acquire_batch_response();
+        for (int i = 0; i < origin_ids.size(); i += BATCH_SIZE)
+        {
+            for (int j = 0; j < destination_ids.size(); j += BATCH_SIZE)
+            {
+                int tile_origins_count = std::min<int>(BATCH_SIZE, origin_ids.size() - i);
+                int tile_destinations_count = std::min<int>(BATCH_SIZE, destination_ids.size() - j);
+                resize_repeated_field(response.mutable_route_infos(), tile_origins_count * tile_destinations_count);
 
-                origins.clear();
-                destinations.clear();
+                int cell = 0;
+                {
+                    // Session is only locked while a tile is copied so concurrent modifications are not blocked by slow readers
+                    std::lock_guard<std::mutex> guard(session->lock());
+                    for (int ii = i; ii < origin_ids.size() && ii < i + BATCH_SIZE; ++ii)
+                    {
+                        for (int jj = j; jj < destination_ids.size() && jj < j + BATCH_SIZE; ++jj)
+                        {
+                            if (!session->matrix().contains(origin_ids[ii]) || !session->matrix().contains(destination_ids[jj]))
+                            {
+                                return grpc::Status(grpc::StatusCode::ABORTED, "Matrix session waypoints were removed concurrently");
+                            }
+                            add_route_info(session->matrix(), origin_ids[ii], destination_ids[jj], response.mutable_route_infos(cell++));
+                        }
+                    }
+                }
+                writer->Write(response);
             }
         }
 
@@ -79,30 +373,43 @@ namespace assfire::router
         }
         */
 
-        std::vector<GeoPoint> waypoints;
-        for (const assfire::api::v1::router::GeoPoint &wp : request->waypoints())
-        {
-            waypoints.emplace_back(parse_geo_point(wp));
-        }
+        std::vector<GeoPoint> waypoints = parse_waypoints(request->waypoints());
         TransportProfileId transport_profile(request->transport_profile());
         RoutingStrategyId routing_strategy(request->routing_strategy());
+        std::optional<TransportProfile::Timestamp> departure_time = parse_departure_time(request->departure_time());
 
-        if (request->get_waypoints())
+        RouteTotal total;
+        if (request->totals_only())
+        {
+            total.add(engine->calculate_routes_vector_total(waypoints, transport_profile, routing_strategy, departure_time));
+        }
+        else if (request->get_waypoints())
         {
             engine->calculate_routes_vector(
                 waypoints, [&](Route route)
-                { to_proto(route, response->add_route_infos()); },
+                {
+                    total.add(route.summary());
+                    to_proto(route, response->add_route_infos());
+                },
                 transport_profile,
-                routing_strategy);
+                routing_strategy,
+                departure_time,
+                request->geometry_tolerance_meters());
         }
         else
         {
             engine->calculate_route_infos_vector(
                 waypoints, [&](RouteInfo route)
-                { to_proto(route, response->add_route_infos()); },
+                {
+                    total.add(route);
+                    to_proto(route, response->add_route_infos());
+                },
                 transport_profile,
-                routing_strategy);
+                routing_strategy,
+                departure_time);
         }
+        response->set_total_duration_seconds(total.get().travel_time_seconds());
+        response->set_total_distance_meters(total.get().distance_meters());
 
         return grpc::Status::OK;
     }
@@ -124,18 +431,354 @@ namespace assfire::router
         GeoPoint destination = parse_geo_point(request->destination());
         TransportProfileId transport_profile(request->transport_profile());
         RoutingStrategyId routing_strategy(request->routing_strategy());
+        std::optional<TransportProfile::Timestamp> departure_time = parse_departure_time(request->departure_time());
 
         if (request->get_waypoints())
         {
-            Route route = engine->calculate_route(origin, destination, transport_profile, routing_strategy);
+            Route route = engine->calculate_route(origin, destination, transport_profile, routing_strategy, departure_time, request->geometry_tolerance_meters());
             to_proto(route, response->mutable_route_info());
         }
         else
         {
-            RouteInfo summary = engine->calculate_route_info(origin, destination, transport_profile, routing_strategy);
+            RouteInfo summary = engine->calculate_route_info(origin, destination, transport_profile, routing_strategy, departure_time);
             to_proto(summary, response->mutable_route_info());
         }
 
         return grpc::Status::OK;
     }
+
+    grpc::Status RouterServiceImpl::GetIsochrone(::grpc::ServerContext *context,
+                                                 const ::assfire::api::v1::router::GetIsochroneRequest *request,
+                                                 ::assfire::api::v1::router::GetIsochroneResponse *response)
+    {
+        if (request->max_travel_time_seconds() < 0)
+        {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Max travel time must not be negative");
+        }
+
+        try
+        {
+            Isochrone isochrone = engine->calculate_isochrone(parse_geo_point(request->origin()), request->max_travel_time_seconds(),
+                                                              TransportProfileId(request->transport_profile()), RoutingStrategyId(request->routing_strategy()));
+            to_proto(isochrone, response);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+        }
+
+        return grpc::Status::OK;
+    }
+
+    grpc::Status RouterServiceImpl::EvaluateTours(::grpc::ServerContext *context,
+                                                  const ::assfire::api::v1::router::EvaluateToursRequest *request,
+                                                  ::assfire::api::v1::router::EvaluateToursResponse *response)
+    {
+        RouterEngine::GeopointIds tour_ids(request->tour_ids().begin(), request->tour_ids().end());
+        std::span<const std::uint32_t> tour_sizes(request->tour_sizes().data(), request->tour_sizes().size());
+
+        std::vector<RouteInfo> totals;
+        try
+        {
+            if (!request->session_id().empty())
+            {
+                std::shared_ptr<const RouteMatrixPlanes> planes = get_session_planes(request->session_id());
+                if (!planes)
+                {
+                    return grpc::Status(grpc::StatusCode::NOT_FOUND, "Unknown matrix session: " + request->session_id());
+                }
+                totals = planes->evaluate_tours(tour_ids, tour_sizes);
+            }
+            else
+            {
+                std::vector<GeoPoint> waypoints = parse_waypoints(request->waypoints());
+                totals = engine->evaluate_tours(waypoints, tour_ids, tour_sizes, TransportProfileId(request->transport_profile()),
+                                                RoutingStrategyId(request->routing_strategy()));
+            }
+        }
+        catch (const std::invalid_argument &e)
+        {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+        }
+
+        response->mutable_total_duration_seconds()->Reserve(totals.size());
+        response->mutable_total_distance_meters()->Reserve(totals.size());
+        for (const RouteInfo &total : totals)
+        {
+            response->add_total_duration_seconds(total.travel_time_seconds());
+            response->add_total_distance_meters(total.distance_meters());
+        }
+        return grpc::Status::OK;
+    }
+
+    grpc::Status RouterServiceImpl::FindBestInsertions(::grpc::ServerContext *context,
+                                                       const ::assfire::api::v1::router::FindBestInsertionsRequest *request,
+                                                       ::assfire::api::v1::router::FindBestInsertionsResponse *response)
+    {
+        RouterEngine::GeopointIds stop_ids(request->stop_ids().begin(), request->stop_ids().end());
+        RouterEngine::GeopointIds route_ids(request->route_ids().begin(), request->route_ids().end());
+        std::span<const std::uint32_t> route_sizes(request->route_sizes().data(), request->route_sizes().size());
+
+        std::vector<RouteMatrixPlanes::Insertion> insertions;
+        try
+        {
+            if (!request->session_id().empty())
+            {
+                std::shared_ptr<const RouteMatrixPlanes> planes = get_session_planes(request->session_id());
+                if (!planes)
+                {
+                    return grpc::Status(grpc::StatusCode::NOT_FOUND, "Unknown matrix session: " + request->session_id());
+                }
+                insertions = planes->find_best_insertions(stop_ids, route_ids, route_sizes);
+            }
+            else
+            {
+                std::vector<GeoPoint> waypoints = parse_waypoints(request->waypoints());
+                insertions = engine->find_best_insertions(waypoints, stop_ids, route_ids, route_sizes, TransportProfileId(request->transport_profile()),
+                                                          RoutingStrategyId(request->routing_strategy()));
+            }
+        }
+        catch (const std::invalid_argument &e)
+        {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+        }
+
+        response->mutable_positions()->Reserve(insertions.size());
+        response->mutable_delta_seconds()->Reserve(insertions.size());
+        for (const RouteMatrixPlanes::Insertion &insertion : insertions)
+        {
+            response->add_positions(insertion.position == RouteMatrixPlanes::NO_POSITION ? -1 : std::int32_t(insertion.position));
+            response->add_delta_seconds(insertion.delta_seconds);
+        }
+        return grpc::Status::OK;
+    }
+
+    std::shared_ptr<const RouteMatrixPlanes> RouterServiceImpl::get_session_planes(const std::string &session_id)
+    {
+        MatrixSessionRegistry::SessionPtr session = matrix_sessions.get_session(session_id);
+        if (!session)
+        {
+            return nullptr;
+        }
+        std::shared_ptr<const RouteMatrixPlanes> planes;
+        bool built;
+        {
+            std::lock_guard<std::mutex> guard(session->lock());
+            built = !session->has_planes();
+            planes = session->planes(); // Planes are immutable, so they are used after the session lock is released
+        }
+        if (built)
+        {
+            matrix_sessions.enforce_limits(); // New planes count in session memory usage
+        }
+        return planes;
+    }
+
+    grpc::Status RouterServiceImpl::GetSparseRouteMatrix(::grpc::ServerContext *context,
+                                                         const ::assfire::api::v1::router::GetSparseRouteMatrixRequest *request,
+                                                         ::grpc::ServerWriter<::assfire::api::v1::router::GetSparseRouteMatrixResponse> *writer)
+    {
+        if (request->max_travel_time_seconds() < 0)
+        {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Max travel time must not be negative");
+        }
+        SparseRouteMatrix::Bounds bounds;
+        bounds.neighbours_count = request->neighbours_count();
+        if (request->max_travel_time_seconds() > 0) // Zero means no limit
+        {
+            bounds.max_travel_time_seconds = request->max_travel_time_seconds();
+        }
+
+        RouterEngine::SparseMatrixPtr matrix;
+        try
+        {
+            std::vector<GeoPoint> waypoints = parse_waypoints(request->waypoints());
+            matrix = engine->calculate_sparse_route_matrix(waypoints, bounds, TransportProfileId(request->transport_profile()),
+                                                           RoutingStrategyId(request->routing_strategy()));
+        }
+        catch (const std::invalid_argument &e)
+        {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+        }
+
+        assfire::api::v1::router::GetSparseRouteMatrixResponse response;
+        for (RouteMatrix::GeopointId origin = 0; origin < matrix->get_origins_count(); ++origin)
+        {
+            if (response.routes_counts().empty())
+            {
+                response.set_first_origin_id(origin);
+            }
+            std::span<const RouteMatrix::GeopointId> destinations = matrix->get_row_destinations(origin);
+            response.add_routes_counts(destinations.size());
+            for (RouteMatrix::GeopointId destination : destinations)
+            {
+                RouteInfo route = matrix->get_route_info(origin, destination);
+                response.add_destination_ids(destination);
+                response.add_travel_times_seconds(route.travel_time_seconds());
+                response.add_distances_meters(route.distance_meters());
+            }
+            if (response.destination_ids().size() >= SPARSE_MATRIX_RESPONSE_ROUTES || origin + 1 == matrix->get_origins_count())
+            {
+                writer->Write(response);
+                response.Clear();
+            }
+        }
+
+        return grpc::Status::OK;
+    }
+
+    grpc::Status RouterServiceImpl::CreateMatrixSession(::grpc::ServerContext *context,
+                                                        const ::assfire::api::v1::router::CreateMatrixSessionRequest *request,
+                                                        ::assfire::api::v1::router::CreateMatrixSessionResponse *response)
+    {
+        TransportProfileId transport_profile(request->transport_profile());
+        RoutingStrategyId routing_strategy(request->routing_strategy());
+
+        RouterEngine::ExtendableMatrixPtr matrix;
+        try
+        {
+            matrix = engine->calculate_extendable_route_matrix(parse_waypoints(request->waypoints()), transport_profile, routing_strategy);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+        }
+
+        RouterEngine::GeopointIds ids = matrix->get_waypoint_ids();
+        for (RouteMatrix::GeopointId id : ids)
+        {
+            response->add_waypoint_ids(id);
+        }
+        write_new_route_infos(*matrix, ids, response);
+
+        std::shared_ptr<MatrixSession> session = std::make_shared<MatrixSession>(std::move(matrix));
+        response->set_revision(session->revision());
+        response->set_session_id(matrix_sessions.add_session(std::move(session)));
+
+        return grpc::Status::OK;
+    }
+
+    grpc::Status RouterServiceImpl::ExtendMatrixSession(::grpc::ServerContext *context,
+                                                        const ::assfire::api::v1::router::ExtendMatrixSessionRequest *request,
+                                                        ::assfire::api::v1::router::ExtendMatrixSessionResponse *response)
+    {
+        MatrixSessionRegistry::SessionPtr session = matrix_sessions.get_session(request->session_id());
+        if (!session)
+        {
+            return grpc::Status(grpc::StatusCode::NOT_FOUND, "Unknown matrix session: " + request->session_id());
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(session->lock());
+            RouterEngine::GeopointIds ids;
+            try
+            {
+                ids = engine->extend_route_matrix(session->matrix(), parse_waypoints(request->waypoints()));
+            }
+            catch (const std::invalid_argument &e)
+            {
+                return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+            }
+            session->record_extension(ids);
+            for (RouteMatrix::GeopointId id : ids)
+            {
+                response->add_waypoint_ids(id);
+            }
+            write_new_route_infos(session->matrix(), ids, response);
+            response->set_revision(session->revision());
+        }
+        matrix_sessions.enforce_limits();
+
+        return grpc::Status::OK;
+    }
+
+    grpc::Status RouterServiceImpl::RemoveMatrixSessionWaypoints(::grpc::ServerContext *context,
+                                                                 const ::assfire::api::v1::router::RemoveMatrixSessionWaypointsRequest *request,
+                                                                 ::assfire::api::v1::router::RemoveMatrixSessionWaypointsResponse *response)
+    {
+        MatrixSessionRegistry::SessionPtr session = matrix_sessions.get_session(request->session_id());
+        if (!session)
+        {
+            return grpc::Status(grpc::StatusCode::NOT_FOUND, "Unknown matrix session: " + request->session_id());
+        }
+
+        RouterEngine::GeopointIds ids(request->waypoint_ids().begin(), request->waypoint_ids().end());
+
+        std::lock_guard<std::mutex> guard(session->lock());
+        try
+        {
+            engine->remove_from_route_matrix(session->matrix(), ids);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+        }
+        session->record_removal(ids);
+        response->set_revision(session->revision());
+
+        return grpc::Status::OK;
+    }
+
+    grpc::Status RouterServiceImpl::GetMatrixSessionUpdates(::grpc::ServerContext *context,
+                                                            const ::assfire::api::v1::router::GetMatrixSessionUpdatesRequest *request,
+                                                            ::grpc::ServerWriter<::assfire::api::v1::router::GetMatrixSessionUpdatesResponse> *writer)
+    {
+        MatrixSessionRegistry::SessionPtr session = matrix_sessions.get_session(request->session_id());
+        if (!session)
+        {
+            return grpc::Status(grpc::StatusCode::NOT_FOUND, "Unknown matrix session: " + request->session_id());
+        }
+
+        std::vector<assfire::api::v1::router::GetMatrixSessionUpdatesResponse> responses(1);
+        {
+            std::lock_guard<std::mutex> guard(session->lock());
+            if (request->since_revision() > session->revision())
+            {
+                return grpc::Status(grpc::StatusCode::OUT_OF_RANGE, "Unknown matrix session revision: " + std::to_string(request->since_revision()));
+            }
+            if (request->since_revision() >= 0 && request->since_revision() < session->oldest_retained_revision())
+            {
+                return grpc::Status(grpc::StatusCode::OUT_OF_RANGE, "Matrix session revision " + std::to_string(request->since_revision()) +
+                                                                        " is not retained anymore, request all waypoints with negative since_revision");
+            }
+
+            MatrixSession::Changes changes = session->get_changes_since(request->since_revision());
+            responses.front().set_revision(session->revision());
+            for (RouteMatrix::GeopointId id : changes.added_ids)
+            {
+                responses.front().add_added_waypoint_ids(id);
+            }
+            for (RouteMatrix::GeopointId id : changes.removed_ids)
+            {
+                responses.front().add_removed_waypoint_ids(id);
+            }
+
+            for_each_new_cell(session->matrix(), changes.added_ids, [&](RouteMatrix::GeopointId origin, RouteMatrix::GeopointId destination)
+                              {
+                                  if (responses.back().route_infos_size() >= BATCH_SIZE * BATCH_SIZE)
+                                  {
+                                      responses.emplace_back();
+                                  }
+                                  add_route_info(session->matrix(), origin, destination, responses.back().add_route_infos()); });
+        }
+
+        for (const auto &response : responses)
+        {
+            writer->Write(response);
+        }
+
+        return grpc::Status::OK;
+    }
+
+    grpc::Status RouterServiceImpl::CloseMatrixSession(::grpc::ServerContext *context,
+                                                       const ::assfire::api::v1::router::CloseMatrixSessionRequest *request,
+                                                       ::assfire::api::v1::router::CloseMatrixSessionResponse *response)
+    {
+        if (!matrix_sessions.remove_session(request->session_id()))
+        {
+            return grpc::Status(grpc::StatusCode::NOT_FOUND, "Unknown matrix session: " + request->session_id());
+        }
+
+        return grpc::Status::OK;
+    }
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <memory>
 #include "assfire/api/v1/router/router.grpc.pb.h"
 #include "assfire/router/engine/RouterEngine.hpp"
+#include "MatrixSessionRegistry.hpp"
 
 namespace assfire::router
 {
@@ -10,6 +11,9 @@ namespace assfire::router
     {
     public:
         RouterServiceImpl(std::unique_ptr<RouterEngine> engine);
+        RouterServiceImpl(std::unique_ptr<RouterEngine> engine,
+                          std::chrono::seconds matrix_session_ttl,
+                          std::size_t matrix_sessions_memory_limit_bytes);
 
         ::grpc::Status GetSingleRoute(::grpc::ServerContext *context,
                                       const ::assfire::api::v1::router::GetSingleRouteRequest *request,
@@ -23,7 +27,53 @@ namespace assfire::router
                                       const ::assfire::api::v1::router::GetRoutesBatchRequest *request,
                                       ::grpc::ServerWriter<::assfire::api::v1::router::GetRoutesBatchResponse> *writer);
 
+        ::grpc::Status CreateMatrixSession(::grpc::ServerContext *context,
+                                           const ::assfire::api::v1::router::CreateMatrixSessionRequest *request,
+                                           ::assfire::api::v1::router::CreateMatrixSessionResponse *response);
+
+        ::grpc::Status ExtendMatrixSession(::grpc::ServerContext *context,
+                                           const ::assfire::api::v1::router::ExtendMatrixSessionRequest *request,
+                                           ::assfire::api::v1::router::ExtendMatrixSessionResponse *response);
+
+        ::grpc::Status RemoveMatrixSessionWaypoints(::grpc::ServerContext *context,
+                                                    const ::assfire::api::v1::router::RemoveMatrixSessionWaypointsRequest *request,
+                                                    ::assfire::api::v1::router::RemoveMatrixSessionWaypointsResponse *response);
+
+        ::grpc::Status GetMatrixSessionUpdates(::grpc::ServerContext *context,
+                                               const ::assfire::api::v1::router::GetMatrixSessionUpdatesRequest *request,
+                                               ::grpc::ServerWriter<::assfire::api::v1::router::GetMatrixSessionUpdatesResponse> *writer);
+
+        ::grpc::Status CloseMatrixSession(::grpc::ServerContext *context,
+                                          const ::assfire::api::v1::router::CloseMatrixSessionRequest *request,
+                                          ::assfire::api::v1::router::CloseMatrixSessionResponse *response);
+
+        ::grpc::Status GetIsochrone(::grpc::ServerContext *context,
+                                    const ::assfire::api::v1::router::GetIsochroneRequest *request,
+                                    ::assfire::api::v1::router::GetIsochroneResponse *response);
+
+        ::grpc::Status EvaluateTours(::grpc::ServerContext *context,
+                                     const ::assfire::api::v1::router::EvaluateToursRequest *request,
+                                     ::assfire::api::v1::router::EvaluateToursResponse *response);
+
+        ::grpc::Status FindBestInsertions(::grpc::ServerContext *context,
+                                          const ::assfire::api::v1::router::FindBestInsertionsRequest *request,
+                                          ::assfire::api::v1::router::FindBestInsertionsResponse *response);
+
+        ::grpc::Status GetSparseRouteMatrix(::grpc::ServerContext *context,
+                                            const ::assfire::api::v1::router::GetSparseRouteMatrixRequest *request,
+                                            ::grpc::ServerWriter<::assfire::api::v1::router::GetSparseRouteMatrixResponse> *writer);
+
     private:
+        std::shared_ptr<const RouteMatrixPlanes> get_session_planes(const std::string &session_id);
+
+        ::grpc::Status get_departure_routes_batch(const ::assfire::api::v1::router::GetRoutesBatchRequest *request,
+                                                  ::grpc::ServerWriter<::assfire::api::v1::router::GetRoutesBatchResponse> *writer);
+        ::grpc::Status get_bounded_routes_batch(const ::assfire::api::v1::router::GetRoutesBatchRequest *request,
+                                                ::grpc::ServerWriter<::assfire::api::v1::router::GetRoutesBatchResponse> *writer);
+        ::grpc::Status get_session_routes_batch(const ::assfire::api::v1::router::GetRoutesBatchRequest *request,
+                                                ::grpc::ServerWriter<::assfire::api::v1::router::GetRoutesBatchResponse> *writer);
+
         std::unique_ptr<RouterEngine> engine;
+        MatrixSessionRegistry matrix_sessions;
     };
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <cstddef>
 
 namespace assfire::router
 {
@@ -19,7 +20,9 @@ namespace assfire::router
     public:
         Settings() : _bind_address("0.0.0.0"),
                      _bind_port(50051),
-                     _log_level(LogLevel::INFO_LOG)
+                     _log_level(LogLevel::INFO_LOG),
+                     _matrix_session_ttl_seconds(600),
+                     _matrix_sessions_memory_limit_bytes(std::size_t(1) << 30)
         {
         }
 
@@ -43,6 +46,31 @@ namespace assfire::router
             return _log_level;
         }
 
+        int matrix_session_ttl_seconds() const
+        {
+            return _matrix_session_ttl_seconds;
+        }
+
+        std::size_t matrix_sessions_memory_limit_bytes() const
+        {
+            return _matrix_sessions_memory_limit_bytes;
+        }
+
+        const std::string &road_graph_path() const
+        {
+            return _road_graph_path;
+        }
+
+        const std::string &hub_labels_path() const
+        {
+            return _hub_labels_path;
+        }
+
+        const std::string &reload_directory() const
+        {
+            return _reload_directory;
+        }
+
         void set_bind_address(const std::string &bind_address)
         {
             _bind_address = bind_address;
@@ -58,9 +86,39 @@ namespace assfire::router
             _log_level = log_level;
         }
 
+        void set_matrix_session_ttl_seconds(int ttl_seconds)
+        {
+            _matrix_session_ttl_seconds = ttl_seconds;
+        }
+
+        void set_matrix_sessions_memory_limit_bytes(std::size_t memory_limit_bytes)
+        {
+            _matrix_sessions_memory_limit_bytes = memory_limit_bytes;
+        }
+
+        void set_road_graph_path(const std::string &road_graph_path)
+        {
+            _road_graph_path = road_graph_path;
+        }
+
+        void set_hub_labels_path(const std::string &hub_labels_path)
+        {
+            _hub_labels_path = hub_labels_path;
+        }
+
+        void set_reload_directory(const std::string &reload_directory)
+        {
+            _reload_directory = reload_directory;
+        }
+
     private:
         std::string _bind_address;
         int _bind_port;
         LogLevel _log_level;
+        int _matrix_session_ttl_seconds;
+        std::size_t _matrix_sessions_memory_limit_bytes;
+        std::string _road_graph_path; // Graph strategies are disabled when empty
+        std::string _hub_labels_path; // Hub labels are not used when empty
+        std::string _reload_directory; // Only files of this directory can be loaded by configuration reloads, new files can't be loaded when empty
     };
 }
\ No newline at end of file
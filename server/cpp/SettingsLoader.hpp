@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstddef>
+#include <stdexcept>
+#include <string>
 #include "Settings.hpp"
 
 namespace assfire::router
@@ -7,6 +10,82 @@ namespace assfire::router
     class SettingsLoader
     {
     public:
+        virtual ~SettingsLoader() = default;
+
         virtual void load_settings(Settings &out_settings) = 0;
+
+    protected:
+        /**
+         * \brief Sets setting by its snake case name, e.g. road_graph_path. Throws std::invalid_argument for unknown names and malformed values
+         */
+        static void apply_setting(Settings &settings, const std::string &name, const std::string &value)
+        {
+            if (name == "bind_address")
+            {
+                settings.set_bind_address(value);
+            }
+            else if (name == "bind_port")
+            {
+                settings.set_bind_port(static_cast<int>(parse_number(name, value)));
+            }
+            else if (name == "log_level")
+            {
+                settings.set_log_level(parse_log_level(value));
+            }
+            else if (name == "matrix_session_ttl_seconds")
+            {
+                settings.set_matrix_session_ttl_seconds(static_cast<int>(parse_number(name, value)));
+            }
+            else if (name == "matrix_sessions_memory_limit_bytes")
+            {
+                settings.set_matrix_sessions_memory_limit_bytes(parse_number(name, value));
+            }
+            else if (name == "road_graph_path")
+            {
+                settings.set_road_graph_path(value);
+            }
+            else if (name == "hub_labels_path")
+            {
+                settings.set_hub_labels_path(value);
+            }
+            else if (name == "reload_directory")
+            {
+                settings.set_reload_directory(value);
+            }
+            else
+            {
+                throw std::invalid_argument("Unknown setting: " + name);
+            }
+        }
+
+    private:
+        static std::size_t parse_number(const std::string &name, const std::string &value)
+        {
+            std::size_t parsed_length = 0;
+            unsigned long long result = 0;
+            try
+            {
+                result = std::stoull(value, &parsed_length);
+            }
+            catch (const std::logic_error &)
+            {
+            }
+            if (parsed_length == 0 || parsed_length != value.size())
+            {
+                throw std::invalid_argument("Invalid value of setting " + name + ": " + value);
+            }
+            return result;
+        }
+
+        static LogLevel parse_log_level(const std::string &value)
+        {
+            if (value == "trace") return LogLevel::TRACE_LOG;
+            if (value == "debug") return LogLevel::DEBUG_LOG;
+            if (value == "info") return LogLevel::INFO_LOG;
+            if (value == "warn") return LogLevel::WARN_LOG;
+            if (value == "error") return LogLevel::ERROR_LOG;
+            if (value == "critical") return LogLevel::CRITICAL_LOG;
+            throw std::invalid_argument("Unknown log level: " + value);
+        }
     };
-}
\ No newline at end of file
+}
@@ -8,6 +8,7 @@
 #include "assfire/router/engine/BasicTransportProfileProvider.hpp"
 
 #include <iostream>
+#include <stdexcept>
 
 using namespace assfire::router;
 
@@ -40,16 +41,29 @@ int main(int argc, char **argv)
     init_sockets();
 
     Settings settings;
-    ArgsSettingsLoader().load_settings(settings);
-    PropsSettingsLoader().load_settings(settings);
+    try
+    {
+        // Arguments override environment properties
+        PropsSettingsLoader().load_settings(settings);
+        ArgsSettingsLoader(argc, argv).load_settings(settings);
+    }
+    catch (const std::invalid_argument &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
 
     std::cout << "Creating service" << std::endl;
 
-    std::shared_ptr<RoutingStrategyProvider> routing_strategy_provider = std::make_shared<BasicRoutingStrategyProvider>();
+    std::shared_ptr<RoutingStrategyProvider> routing_strategy_provider = std::make_shared<BasicRoutingStrategyProvider>(settings.road_graph_path(), settings.hub_labels_path());
     std::shared_ptr<TransportProfileProvider> transport_profile_provider = std::make_shared<BasicTransportProfileProvider>();
 
-    RouterServiceImpl router_service(std::make_unique<RouterEngine>(routing_strategy_provider, transport_profile_provider));
-    ConfigurationServiceImpl configuration_service(routing_strategy_provider, transport_profile_provider);
+    std::shared_ptr<RoutingRegistry> registry = std::make_shared<RoutingRegistry>(routing_strategy_provider, transport_profile_provider);
+
+    RouterServiceImpl router_service(std::make_unique<RouterEngine>(registry),
+                                     std::chrono::seconds(settings.matrix_session_ttl_seconds()),
+                                     settings.matrix_sessions_memory_limit_bytes());
+    ConfigurationServiceImpl configuration_service(registry, settings.road_graph_path(), settings.hub_labels_path(), settings.reload_directory());
 
     std::cout << "Creating server" << std::endl;
 
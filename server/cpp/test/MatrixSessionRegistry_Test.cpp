@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include "assfire/router/engine/algorithms/CrowflightRoutingStrategy.hpp"
+#include "server/cpp/MatrixSessionRegistry.hpp"
+
+using namespace assfire::router;
+
+namespace
+{
+    std::shared_ptr<MatrixSession> make_session(int waypoints_count)
+    {
+        auto matrix = std::make_shared<ExtendableRouteMatrix>(std::make_shared<CrowflightRoutingStrategy>(), TransportProfile(10));
+        ExtendableRouteMatrix::Waypoints waypoints;
+        for (int i = 0; i < waypoints_count; ++i)
+        {
+            waypoints.emplace_back(i, i);
+        }
+        matrix->extend(waypoints);
+        return std::make_shared<MatrixSession>(matrix);
+    }
+}
+
+TEST(MatrixSessionTest, CollectsChangesSinceRevision)
+{
+    std::shared_ptr<MatrixSession> session = make_session(3);
+    EXPECT_EQ(session->revision(), 0);
+
+    MatrixSession::GeopointIds added = session->matrix().extend({GeoPoint(10, 10), GeoPoint(11, 11)});
+    session->record_extension(added);
+    session->matrix().remove({1, added[0]});
+    session->record_removal({1, added[0]});
+    EXPECT_EQ(session->revision(), 2);
+
+    MatrixSession::Changes everything = session->get_changes_since(-1);
+    EXPECT_EQ(everything.added_ids, (MatrixSession::GeopointIds{0, 2, added[1]}));
+    EXPECT_TRUE(everything.removed_ids.empty());
+
+    MatrixSession::Changes since_creation = session->get_changes_since(0);
+    EXPECT_EQ(since_creation.added_ids, (MatrixSession::GeopointIds{added[1]}));
+    EXPECT_EQ(since_creation.removed_ids, (MatrixSession::GeopointIds{1})); // Waypoint added and removed later was never seen
+
+    MatrixSession::Changes since_extension = session->get_changes_since(1);
+    EXPECT_TRUE(since_extension.added_ids.empty());
+    EXPECT_EQ(since_extension.removed_ids, (MatrixSession::GeopointIds{1, added[0]}));
+
+    EXPECT_TRUE(session->get_changes_since(2).removed_ids.empty());
+    EXPECT_TRUE(session->get_changes_since(5).added_ids.empty());
+}
+
+TEST(MatrixSessionTest, TrimsHistory)
+{
+    std::shared_ptr<MatrixSession> session = make_session(1);
+    for (int i = 0; i < int(MatrixSession::MAX_RETAINED_REVISIONS) + 10; ++i)
+    {
+        session->record_extension(session->matrix().extend({GeoPoint(i, 0)}));
+    }
+
+    EXPECT_EQ(session->revision(), MatrixSession::Revision(MatrixSession::MAX_RETAINED_REVISIONS + 10));
+    EXPECT_EQ(session->oldest_retained_revision(), session->revision() - MatrixSession::Revision(MatrixSession::MAX_RETAINED_REVISIONS) + 1);
+    EXPECT_THROW(session->get_changes_since(session->oldest_retained_revision() - 1), std::out_of_range);
+    EXPECT_EQ(session->get_changes_since(session->oldest_retained_revision()).added_ids.size(), MatrixSession::MAX_RETAINED_REVISIONS - 1);
+}
+
+TEST(MatrixSessionTest, CountsPlanesInMemoryUsage)
+{
+    std::shared_ptr<MatrixSession> session = make_session(20);
+    std::size_t matrix_only = session->memory_usage_bytes();
+    EXPECT_FALSE(session->has_planes());
+
+    std::shared_ptr<const RouteMatrixPlanes> planes = session->planes();
+    EXPECT_TRUE(session->has_planes());
+    EXPECT_EQ(session->planes(), planes);
+    EXPECT_EQ(session->memory_usage_bytes(), matrix_only + planes->get_memory_usage_bytes());
+
+    session->record_extension(session->matrix().extend({GeoPoint(30, 30)}));
+    EXPECT_FALSE(session->has_planes());
+}
+
+TEST(MatrixSessionRegistryTest, ExpiresSessionsAfterTtl)
+{
+    MatrixSessionRegistry registry(std::chrono::milliseconds(50));
+    std::string id = registry.add_session(make_session(2));
+    EXPECT_NE(registry.get_session(id), nullptr);
+    EXPECT_EQ(registry.get_session("unknown"), nullptr);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(registry.get_session(id), nullptr);
+    EXPECT_EQ(registry.size(), 0);
+}
+
+TEST(MatrixSessionRegistryTest, SweepsExpiredSessionsWithoutRequests)
+{
+    MatrixSessionRegistry registry(std::chrono::milliseconds(20), MatrixSessionRegistry::DEFAULT_MEMORY_LIMIT_BYTES, std::chrono::milliseconds(10));
+    registry.add_session(make_session(2));
+    registry.add_session(make_session(2));
+
+    for (int i = 0; i < 100 && registry.size() > 0; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(registry.size(), 0);
+}
+
+TEST(MatrixSessionRegistryTest, EvictsLeastRecentlyUsedSessions)
+{
+    std::size_t session_bytes = make_session(10)->memory_usage_bytes();
+    MatrixSessionRegistry registry(MatrixSessionRegistry::DEFAULT_TTL, session_bytes * 2);
+    std::string first = registry.add_session(make_session(10));
+    std::string second = registry.add_session(make_session(10));
+    ASSERT_NE(registry.get_session(first), nullptr); // Second becomes the least recently used
+
+    std::string third = registry.add_session(make_session(10));
+    EXPECT_EQ(registry.get_session(second), nullptr);
+    EXPECT_NE(registry.get_session(first), nullptr);
+    EXPECT_NE(registry.get_session(third), nullptr);
+    EXPECT_NE(first, third);
+
+    // Planes of the most recently used session push the least recently used one out
+    registry.get_session(third)->planes();
+    registry.enforce_limits();
+    EXPECT_EQ(registry.get_session(first), nullptr);
+    EXPECT_NE(registry.get_session(third), nullptr);
+    EXPECT_TRUE(registry.remove_session(third));
+    EXPECT_FALSE(registry.remove_session(third));
+    EXPECT_EQ(registry.size(), 0);
+}
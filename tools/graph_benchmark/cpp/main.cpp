@@ -0,0 +1,98 @@
+#include "assfire/router/engine/algorithms/GraphRoutingStrategy.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace assfire::router;
+
+/**
+ * Measures query times of graph routing strategy over road graph files, e.g. a node-based graph and the same network built with turns.
+ * Waypoints are random graph nodes picked with fixed seed, so runs over the same graph are comparable. For each graph reports
+ * single route info queries with Dijkstra searches and with contraction hierarchy, and one square matrix with contraction hierarchy
+ */
+namespace
+{
+    constexpr std::size_t QUERIES_COUNT = 1000;
+    constexpr std::size_t MATRIX_SIZE = 100;
+    constexpr unsigned SEED = 42;
+
+    std::vector<GeoPoint> pick_waypoints(const RoadGraph &graph, std::size_t count)
+    {
+        std::mt19937 random(SEED);
+        std::uniform_int_distribution<RoadGraph::NodeId> node(0, RoadGraph::NodeId(graph.nodes_count() - 1));
+        std::vector<GeoPoint> result;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            result.push_back(graph.get_node_location(graph.get_original_node(node(random))));
+        }
+        return result;
+    }
+
+    template <typename Function>
+    double measure_microseconds(std::size_t repeats, Function &&function)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < repeats; ++i)
+        {
+            function(i);
+        }
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / repeats;
+    }
+
+    void run(const std::string &path, const std::string &metric)
+    {
+        std::shared_ptr<const RoadGraph> graph = std::make_shared<RoadGraph>(path);
+        std::shared_ptr<const EdgeSpatialIndex> index = std::make_shared<EdgeSpatialIndex>(graph);
+        std::shared_ptr<CchMetricCache> hierarchy = std::make_shared<CchMetricCache>(std::make_shared<CchTopology>(graph));
+        GraphRoutingStrategy dijkstra(graph, index, metric);
+        GraphRoutingStrategy contracted(graph, index, metric, GraphRoutingStrategy::DEFAULT_MAX_SNAPPING_DISTANCE_METERS, hierarchy);
+
+        TransportProfile profile;
+        contracted.customize(profile);
+        std::vector<GeoPoint> waypoints = pick_waypoints(*graph, 2 * QUERIES_COUNT);
+        std::vector<GeoPoint> matrix_waypoints(waypoints.begin(), waypoints.begin() + MATRIX_SIZE);
+
+        double dijkstra_time = measure_microseconds(QUERIES_COUNT, [&](std::size_t i)
+                                                    { dijkstra.calculate_route_info(waypoints[2 * i], waypoints[2 * i + 1], profile); });
+        double contracted_time = measure_microseconds(QUERIES_COUNT, [&](std::size_t i)
+                                                      { contracted.calculate_route_info(waypoints[2 * i], waypoints[2 * i + 1], profile); });
+        double matrix_time = measure_microseconds(1, [&](std::size_t)
+                                                  { contracted.calculate_route_matrix(RoutingStrategy::WaypointsView(matrix_waypoints), profile); });
+
+        std::cout << path << (graph->is_turn_expanded() ? " (turns)" : " (nodes)") << ": "
+                  << graph->nodes_count() << " nodes, " << graph->edges_count() << " edges" << std::endl
+                  << std::fixed << std::setprecision(1)
+                  << "  dijkstra route info: " << dijkstra_time << " us" << std::endl
+                  << "  hierarchy route info: " << contracted_time << " us" << std::endl
+                  << "  hierarchy matrix " << MATRIX_SIZE << "x" << MATRIX_SIZE << ": " << matrix_time / 1000 << " ms" << std::endl;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <metric> <graph file>..." << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        for (int i = 2; i < argc; ++i)
+        {
+            run(argv[i], argv[1]);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Benchmark failed: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,222 @@
+#include "assfire/router/engine/graph/HubLabels.hpp"
+#include "assfire/router/engine/graph/RoadGraphBuilder.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace assfire::router;
+
+/**
+ * Converts road network exported to CSV files into binary road graph file that is memory mapped by the router at startup.
+ *
+ * Nodes file columns: id,lat,lon (ids are arbitrary integers, coordinates are in degrees).
+ * Edges file columns: from,to,length_meters,<metric>... where every metric column contains directed edge travel time in seconds and
+ * its header is used as metric name. Both files must start with a header line.
+ * Optionally writes hub labels file for one metric of the built graph.
+ * Optional traffic file (--traffic) columns: edge,metric,time_seconds,travel_time_seconds where edge is 0-based number of edge line in edges file
+ * and time is seconds since Monday 00:00 UTC. Breakpoints of an edge make its weekly time-dependent travel times for the metric
+ * Optional turns file (--turns) columns: from_edge,to_edge[,<metric>...] where edges are 0-based numbers of edge lines in edges file.
+ * Line with travel time of the turn for each metric sets turn cost, line with edges only forbids the turn
+ */
+namespace
+{
+    std::vector<std::string> split(const std::string &line)
+    {
+        std::vector<std::string> result;
+        std::stringstream stream(line);
+        std::string value;
+        while (std::getline(stream, value, ','))
+        {
+            result.push_back(value);
+        }
+        return result;
+    }
+
+    std::ifstream open(const std::string &path, std::vector<std::string> &header)
+    {
+        std::ifstream in(path);
+        std::string line;
+        if (!in || !std::getline(in, line))
+        {
+            throw std::runtime_error("Failed to read " + path);
+        }
+        header = split(line);
+        return in;
+    }
+
+    void read_nodes(const std::string &path, RoadGraphBuilder &builder, std::unordered_map<std::int64_t, RoadGraph::NodeId> &node_by_id)
+    {
+        std::vector<std::string> header;
+        std::ifstream in = open(path, header);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::vector<std::string> values = split(line);
+            if (values.size() < 3)
+            {
+                throw std::runtime_error("Invalid node line: " + line);
+            }
+            node_by_id.emplace(std::stoll(values[0]), builder.add_node(GeoPoint(std::stod(values[1]), std::stod(values[2]))));
+        }
+    }
+
+    void read_edges(const std::string &path, RoadGraphBuilder &builder, const std::unordered_map<std::int64_t, RoadGraph::NodeId> &node_by_id)
+    {
+        std::vector<std::string> header;
+        std::ifstream in = open(path, header);
+        std::size_t metrics_count = header.size() - 3;
+        std::vector<double> travel_times(metrics_count);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::vector<std::string> values = split(line);
+            if (values.size() != header.size())
+            {
+                throw std::runtime_error("Invalid edge line: " + line);
+            }
+            for (std::size_t m = 0; m < metrics_count; ++m)
+            {
+                travel_times[m] = std::stod(values[3 + m]);
+            }
+            builder.add_edge(node_by_id.at(std::stoll(values[0])), node_by_id.at(std::stoll(values[1])), std::stod(values[2]), travel_times);
+        }
+    }
+
+    void read_traffic(const std::string &path, RoadGraphBuilder &builder)
+    {
+        struct Breakpoints
+        {
+            std::vector<std::uint32_t> times_seconds;
+            std::vector<double> travel_times_seconds;
+        };
+
+        std::vector<std::string> header;
+        std::ifstream in = open(path, header);
+        std::map<std::pair<std::size_t, std::string>, Breakpoints> breakpoints;
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::vector<std::string> values = split(line);
+            if (values.size() != 4)
+            {
+                throw std::runtime_error("Invalid traffic line: " + line);
+            }
+            Breakpoints &edge_breakpoints = breakpoints[{std::stoull(values[0]), values[1]}];
+            edge_breakpoints.times_seconds.push_back(std::stoul(values[2]));
+            edge_breakpoints.travel_times_seconds.push_back(std::stod(values[3]));
+        }
+
+        for (const auto &[edge_metric, edge_breakpoints] : breakpoints)
+        {
+            builder.set_edge_traffic(edge_metric.first, edge_metric.second, edge_breakpoints.times_seconds, edge_breakpoints.travel_times_seconds);
+        }
+    }
+
+    void read_turns(const std::string &path, RoadGraphBuilder &builder, std::size_t metrics_count)
+    {
+        std::vector<std::string> header;
+        std::ifstream in = open(path, header);
+        std::vector<double> travel_times(metrics_count);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::vector<std::string> values = split(line);
+            if (values.size() != 2 && values.size() != 2 + metrics_count)
+            {
+                throw std::runtime_error("Invalid turn line: " + line);
+            }
+            if (values.size() == 2)
+            {
+                builder.add_turn_restriction(std::stoull(values[0]), std::stoull(values[1]));
+                continue;
+            }
+            for (std::size_t m = 0; m < metrics_count; ++m)
+            {
+                travel_times[m] = std::stod(values[2 + m]);
+            }
+            builder.add_turn_cost(std::stoull(values[0]), std::stoull(values[1]), travel_times);
+        }
+    }
+
+    std::vector<std::string> read_metrics(const std::string &edges_path)
+    {
+        std::vector<std::string> header;
+        open(edges_path, header);
+        if (header.size() < 4)
+        {
+            throw std::runtime_error("Edges file must contain from, to, length and at least one metric column");
+        }
+        return std::vector<std::string>(header.begin() + 3, header.end());
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *program = argv[0];
+    std::string traffic_path;
+    std::string turns_path;
+    while (argc > 2 && (std::string(argv[1]) == "--traffic" || std::string(argv[1]) == "--turns"))
+    {
+        (std::string(argv[1]) == "--traffic" ? traffic_path : turns_path) = argv[2];
+        argv += 2; // Positional arguments keep their indices
+        argc -= 2;
+    }
+
+    if (argc != 4 && argc != 6)
+    {
+        std::cerr << "Usage: " << program << " [--traffic <traffic.csv>] [--turns <turns.csv>] <nodes.csv> <edges.csv> <output graph file> [<labels metric> <output labels file>]" << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        std::vector<std::string> metrics = read_metrics(argv[2]);
+        RoadGraphBuilder builder(metrics);
+        std::unordered_map<std::int64_t, RoadGraph::NodeId> node_by_id;
+        read_nodes(argv[1], builder, node_by_id);
+        read_edges(argv[2], builder, node_by_id);
+        if (!traffic_path.empty())
+        {
+            read_traffic(traffic_path, builder);
+        }
+        if (!turns_path.empty())
+        {
+            read_turns(turns_path, builder, metrics.size());
+        }
+
+        std::cout << "Read " << builder.nodes_count() << " nodes and " << builder.edges_count() << " edges" << std::endl;
+
+        builder.write(argv[3]);
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "Written " << argv[3] << " in " << elapsed.count() << "s" << std::endl;
+
+        if (argc == 6)
+        {
+            start = std::chrono::steady_clock::now();
+
+            std::shared_ptr<const RoadGraph> graph = std::make_shared<RoadGraph>(argv[3]);
+            CchMetric metric(std::make_shared<CchTopology>(graph), argv[4], 0);
+            HubLabels::write(metric, argv[5]);
+
+            elapsed = std::chrono::steady_clock::now() - start;
+            std::cout << "Written " << argv[5] << " in " << elapsed.count() << "s" << std::endl;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Failed to build road graph: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
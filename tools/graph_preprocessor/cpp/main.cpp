@@ -0,0 +1,198 @@
+#include "assfire/router/engine/graph/HubLabels.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace assfire::router;
+
+/**
+ * Runs heavy offline preprocessing over road graph file written by graph builder, using all cores:
+ * - adds contraction hierarchy topology if the graph has none. Halves of nested dissection are ordered and contracted in parallel;
+ * - customizes hierarchy for each requested metric and writes its hub labels file. Ranks of each elimination tree level are labeled in parallel.
+ *
+ * Labels computation saves checkpoints next to labels files (or into --checkpoint-dir) every --checkpoint-interval seconds, so a rerun after
+ * interruption resumes from the last checkpoint. Topology is not rebuilt if present, so after interruption the same command may simply be rerun.
+ * Outputs are the memory mapped files read by graph routing strategies
+ */
+namespace
+{
+    struct Options
+    {
+        std::size_t threads_count = 0;
+        std::string checkpoint_dir;
+        std::chrono::seconds checkpoint_interval = HubLabels::DEFAULT_CHECKPOINT_INTERVAL;
+        std::string graph_path;
+        std::vector<std::pair<std::string, std::string>> labels; // Metric and labels file path
+    };
+
+    Options parse_options(int argc, char **argv)
+    {
+        Options result;
+        int i = 1;
+        for (; i + 1 < argc && std::string(argv[i]).starts_with("--"); i += 2)
+        {
+            std::string name = argv[i];
+            if (name == "--threads")
+            {
+                result.threads_count = std::stoul(argv[i + 1]);
+            }
+            else if (name == "--checkpoint-dir")
+            {
+                result.checkpoint_dir = argv[i + 1];
+            }
+            else if (name == "--checkpoint-interval")
+            {
+                result.checkpoint_interval = std::chrono::seconds(std::stoul(argv[i + 1]));
+            }
+            else
+            {
+                throw std::invalid_argument("Unknown option " + name);
+            }
+        }
+        if (i >= argc || (argc - i - 1) % 2 != 0)
+        {
+            throw std::invalid_argument("Graph file and pairs of metric and labels file are expected");
+        }
+
+        result.graph_path = argv[i++];
+        for (; i < argc; i += 2)
+        {
+            result.labels.emplace_back(argv[i], argv[i + 1]);
+        }
+        return result;
+    }
+
+    std::string get_checkpoint_path(const Options &options, const std::string &labels_path)
+    {
+        if (options.checkpoint_dir.empty())
+        {
+            return labels_path + ".checkpoint";
+        }
+        std::size_t name_begin = labels_path.find_last_of('/');
+        return options.checkpoint_dir + "/" + labels_path.substr(name_begin == std::string::npos ? 0 : name_begin + 1) + ".checkpoint";
+    }
+
+    /**
+     * Prints stage progress whenever it advances by a percent
+     */
+    class ProgressReporter
+    {
+    public:
+        explicit ProgressReporter(std::string stage) : stage(std::move(stage)), start(std::chrono::steady_clock::now())
+        {
+            std::cout << this->stage << ": started" << std::endl;
+        }
+
+        void report(std::size_t done, std::size_t total)
+        {
+            int percent = total > 0 ? int(done * 100 / total) : 100;
+            if (percent != last_percent)
+            {
+                last_percent = percent;
+                std::cout << stage << ": " << percent << "% (" << done << "/" << total << ") after " << std::fixed << std::setprecision(1)
+                          << elapsed_seconds() << "s" << std::endl;
+            }
+        }
+
+        void finish()
+        {
+            std::cout << stage << ": done in " << std::fixed << std::setprecision(1) << elapsed_seconds() << "s" << std::endl;
+        }
+
+    private:
+        double elapsed_seconds() const
+        {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        std::string stage;
+        std::chrono::steady_clock::time_point start;
+        int last_percent = -1;
+    };
+
+    void add_topology(const std::string &graph_path, std::size_t threads_count)
+    {
+        RoadGraphFileWriter writer;
+        {
+            RoadGraph graph(graph_path, false);
+            if (CchTopology::is_present(graph))
+            {
+                std::cout << "Topology: already present in " << graph_path << std::endl;
+                return;
+            }
+
+            ProgressReporter progress("Topology");
+            for (const std::string &name : graph.get_section_names())
+            {
+                writer.add_section(name, graph.get_section<std::byte>(name));
+            }
+            CchTopology::build(graph.get_section<graph_format::NodeLocation>(graph_format::NODE_LOCATIONS_SECTION),
+                               graph.get_section<RoadGraph::EdgeId>(graph_format::EDGE_OFFSETS_SECTION),
+                               graph.get_section<RoadGraph::NodeId>(graph_format::EDGE_TARGETS_SECTION),
+                               writer, threads_count);
+            progress.finish();
+        }
+        writer.write(graph_path);
+    }
+
+    void write_labels(std::shared_ptr<const CchTopology> topology, const std::string &metric_name, const std::string &labels_path, const Options &options)
+    {
+        ProgressReporter customization("Customization of " + metric_name);
+        CchMetric metric(topology, metric_name, 0, options.threads_count);
+        customization.finish();
+
+        ProgressReporter labeling("Labels of " + metric_name);
+        HubLabels::WriteOptions write_options;
+        write_options.threads_count = options.threads_count;
+        write_options.checkpoint_path = get_checkpoint_path(options, labels_path);
+        write_options.checkpoint_interval = options.checkpoint_interval;
+        write_options.on_progress = [&](std::size_t ranks_done, std::size_t ranks_count)
+        {
+            labeling.report(ranks_done, ranks_count);
+        };
+        HubLabels::write(metric, labels_path, write_options);
+        labeling.finish();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    try
+    {
+        options = parse_options(argc, argv);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl
+                  << "Usage: " << argv[0] << " [--threads <count>] [--checkpoint-dir <dir>] [--checkpoint-interval <seconds>] <graph file> "
+                  << "[<metric> <output labels file>]..." << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        add_topology(options.graph_path, options.threads_count);
+
+        std::shared_ptr<const RoadGraph> graph = std::make_shared<RoadGraph>(options.graph_path);
+        std::shared_ptr<const CchTopology> topology = std::make_shared<CchTopology>(graph);
+        for (const auto &[metric, labels_path] : options.labels)
+        {
+            write_labels(topology, metric, labels_path, options);
+            std::cout << "Written " << labels_path << std::endl;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Failed to preprocess road graph: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}